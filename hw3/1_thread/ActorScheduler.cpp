@@ -0,0 +1,463 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		ActorScheduler.cpp					---*
+ *---									---*
+ *---	    This file defines a class that runs the Train instances of	---*
+ *---	a MassTransit system in real time as actors on a few worker	---*
+ *---	pthreads, instead of one pthread each.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To return the CPU time used so far by this process, in
+//	nanoseconds.  No parameters.
+static
+unsigned long long
+		getProcessCpuNsecs
+				()
+{
+  struct timespec	now;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&now);
+  return( (unsigned long long)now.tv_sec * NSECS_PER_SEC + now.tv_nsec );
+}
+
+
+//  PURPOSE:  To initialize '*this' to run the Train instances of
+//	'newMassTransit', which must be placed and have no pthreads, on
+//	'newNumWorkers' worker pthreads.  No return value.
+ActorScheduler::ActorScheduler	(MassTransit&	newMassTransit,
+				 uint		newNumWorkers
+				)
+				throw(const char*) :
+				massTransit(newMassTransit),
+				numWorkers(newNumWorkers),
+				workerArray(NULL),
+				numStartedWorkers(0),
+				isRunning(false),
+				startNsecs(0),
+				stopNsecs(0),
+				startCpuNsecs(0),
+				stopCpuNsecs(0)
+{
+  //  I.  Application validity check:
+  if  (numWorkers == 0)
+    throw "An ActorScheduler needs at least one worker";
+
+  if  (massTransit.getActorSchedulerPtr() != NULL)
+    throw "The Train instances are already run by an ActorScheduler";
+
+  //  II.  Initialize members:
+  pthread_condattr_t	attr;
+
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr,CLOCK_MONOTONIC);
+  workerArray	= new ActorWorker[numWorkers];
+
+  for  (uint i = 0;  i < numWorkers;  i++)
+  {
+    workerArray[i].schedulerPtr	= this;
+    workerArray[i].isIdle	= false;
+    workerArray[i].numSteps	= 0;
+    pthread_mutex_init(&workerArray[i].lock,NULL);
+    pthread_cond_init(&workerArray[i].cond,&attr);
+  }
+
+  pthread_condattr_destroy(&attr);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To release resources.  No parameters.  No return value.
+ActorScheduler::~ActorScheduler	()
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Release resources:
+  stop();
+
+  for  (uint i = 0;  i < numWorkers;  i++)
+  {
+    pthread_cond_destroy(&workerArray[i].cond);
+    pthread_mutex_destroy(&workerArray[i].lock);
+  }
+
+  delete[](workerArray);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To return the number of steps run so far.  Approximate while
+//	the workers run.  No parameters.
+unsigned long long
+		ActorScheduler::getNumSteps
+				()
+				const
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Return value:
+  unsigned long long	sum	= 0;
+
+  for  (uint i = 0;  i < numWorkers;  i++)
+    sum	+= workerArray[i].numSteps;
+
+  return(sum);
+}
+
+
+//  PURPOSE:  To have '*trainPtr' pause for a random time, then be stepped.
+//	No return value.
+void		ActorScheduler::pause	(Train*		trainPtr
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  ActorWorker&		worker		= getWorker(trainPtr);
+  unsigned long long	nowNsecs	= getMonotonicNsecs();
+  ActorTimer		timer;
+
+  //  II.  Set timer, waking the worker if it sleeps past it:
+  trainPtr->setActorState(ACTOR_PAUSING,nowNsecs);
+  timer.nsecs	 = nowNsecs
+		   + (unsigned long long)massTransit.getRandomPauseUsecs(*trainPtr)
+		     * (NSECS_PER_SEC / USECS_PER_SEC);
+  timer.trainPtr = trainPtr;
+
+  pthread_mutex_lock(&worker.lock);
+  worker.timerQueue.push(timer);
+
+  if  ( worker.isIdle  &&  (worker.timerQueue.top().trainPtr == trainPtr) )
+    pthread_cond_signal(&worker.cond);
+
+  pthread_mutex_unlock(&worker.lock);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To run '*trainPtr' from where it last stopped until it must
+//	pause or wait, as one pass of the loop of 'simulateTrain()' does.
+//	No return value.
+void		ActorScheduler::step	(Train*		trainPtr
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  TrainLocation*	currentPtr	= trainPtr->getLocPtr();
+
+  if  ( (currentPtr == NULL)  ||  !massTransit.getShouldContinue() )
+    return;
+
+  //  II.  Step '*trainPtr':
+  //  II.A.  End the pause or wait it was in.  After a pause it must be
+  //	     allowed to leave, or else park until it is:
+  TrainLocation*	nextPtr		= NULL;
+
+  switch  (trainPtr->getActorState())
+  {
+  case ACTOR_PAUSING :
+    if  ( massTransit.getIsTracing() )
+      massTransit.traceEvent(trainPtr,
+			     TRACE_PAUSE,
+			     currentPtr->getIndex(),
+			     trainPtr->getActorSinceNsecs(),
+			     getMonotonicNsecs(),
+			     0
+			    );
+
+    if  ( !currentPtr->parkUntilCanLeave(trainPtr) )
+      return;
+
+    break;
+
+  case ACTOR_WAITING_FOR_HEAD :
+    currentPtr->noteUnparked(trainPtr);
+    break;
+
+  case ACTOR_WAITING_FOR_ROOM :
+    nextPtr	= trainPtr->getActorNextPtr();
+    nextPtr->noteUnparked(trainPtr);
+    break;
+  }
+
+  //  II.B.  Hold room at the next location before leaving the current one,
+  //	     unless the Train that freed some already holds it for
+  //	     '*trainPtr', or park until one does:
+  if  (nextPtr == NULL)
+  {
+    nextPtr	= currentPtr->nextLocPtr(trainPtr);
+    trainPtr->setActorNextPtr(nextPtr);
+
+    if  ( !nextPtr->reserveOrPark(trainPtr) )
+      return;
+  }
+
+  //  II.C.  Move, then pause:
+  currentPtr->leave(trainPtr);
+  nextPtr->occupy(trainPtr);
+  trainPtr->noteMove();
+  pause(trainPtr);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To be the function that each worker pthread runs: steps the
+//	Train instances of '*(ActorWorker*)vPtr' as they become ready until
+//	told to stop.  Returns 'NULL'.
+void*		ActorScheduler::work	(void*		vPtr
+				)
+{
+  //  I.  Application validity check:
+  ActorWorker*		workerPtr	= (ActorWorker*)vPtr;
+  ActorScheduler*	schedulerPtr	= workerPtr->schedulerPtr;
+  std::vector<Train*>	stepVector;
+
+  //  II.  Step ready Train instances, else sleep until the next timer or
+  //	   until resumed:
+  pthread_mutex_lock(&workerPtr->lock);
+
+  while  ( __atomic_load_n(&schedulerPtr->isRunning,__ATOMIC_ACQUIRE) )
+  {
+    //  II.A.  Make the Train instances whose pauses are over ready:
+    unsigned long long	nowNsecs	= getMonotonicNsecs();
+
+    while  ( !workerPtr->timerQueue.empty()  &&
+	     (workerPtr->timerQueue.top().nsecs <= nowNsecs)
+	   )
+    {
+      workerPtr->readyVector.push_back(workerPtr->timerQueue.top().trainPtr);
+      workerPtr->timerQueue.pop();
+    }
+
+    //  II.B.  Step every ready Train without the lock, so that others may
+    //	     resume Train instances meanwhile:
+    if  ( !workerPtr->readyVector.empty() )
+    {
+      stepVector.swap(workerPtr->readyVector);
+      pthread_mutex_unlock(&workerPtr->lock);
+
+      for  (size_t i = 0;  i < stepVector.size();  i++)
+	schedulerPtr->step(stepVector[i]);
+
+      workerPtr->numSteps	+= stepVector.size();
+      stepVector.clear();
+      pthread_mutex_lock(&workerPtr->lock);
+      continue;
+    }
+
+    //  II.C.  Sleep until the next timer, or until resumed or stopped:
+    workerPtr->isIdle	= true;
+
+    if  ( workerPtr->timerQueue.empty() )
+      pthread_cond_wait(&workerPtr->cond,&workerPtr->lock);
+    else
+    {
+      unsigned long long	timerNsecs
+				= workerPtr->timerQueue.top().nsecs;
+      struct timespec		deadline;
+
+      deadline.tv_sec	= timerNsecs / NSECS_PER_SEC;
+      deadline.tv_nsec	= timerNsecs % NSECS_PER_SEC;
+      pthread_cond_timedwait(&workerPtr->cond,&workerPtr->lock,&deadline);
+    }
+
+    workerPtr->isIdle	= false;
+  }
+
+  pthread_mutex_unlock(&workerPtr->lock);
+
+  //  III.  Finished:
+  return(NULL);
+}
+
+
+//  PURPOSE:  To make parked '*trainPtr' ready to step again.  May be called
+//	from any worker.  No return value.
+void		ActorScheduler::resume	(Train*		trainPtr
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  ActorWorker&	worker	= getWorker(trainPtr);
+
+  //  II.  Make '*trainPtr' ready, waking its worker if it sleeps:
+  pthread_mutex_lock(&worker.lock);
+  worker.readyVector.push_back(trainPtr);
+
+  if  (worker.isIdle)
+    pthread_cond_signal(&worker.cond);
+
+  pthread_mutex_unlock(&worker.lock);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To start the workers, each Train first pausing as in
+//	'simulateTrain()'.  No parameters.  No return value.
+void		ActorScheduler::start	()
+				throw(const char*)
+{
+  //  I.  Application validity check:
+  if  (numStartedWorkers > 0)
+    throw "ActorScheduler::start() may only be called once";
+
+  //  II.  Start workers:
+  massTransit.setActorSchedulerPtr(this);
+
+  for  (uint i = 0;  i < massTransit.getNumTrains();  i++)
+    pause(massTransit.getTrainPtr(i));
+
+  startNsecs	= getMonotonicNsecs();
+  startCpuNsecs	= getProcessCpuNsecs();
+  __atomic_store_n(&isRunning,true,__ATOMIC_RELEASE);
+
+  for  ( ;  numStartedWorkers < numWorkers;  numStartedWorkers++)
+    if  (pthread_create(&workerArray[numStartedWorkers].threadId,
+			NULL,
+			work,
+			(void*)&workerArray[numStartedWorkers]
+		       )
+	 != 0
+	)
+    {
+      stop();
+      throw "Could not create a pthread for every ActorScheduler worker";
+    }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To stop the workers, wait for them, and take each Train off of
+//	the system.  No parameters.  No return value.
+void		ActorScheduler::stop	()
+				throw()
+{
+  //  I.  Application validity check:
+  if  ( !__atomic_load_n(&isRunning,__ATOMIC_ACQUIRE) )
+    return;
+
+  //  II.  Stop:
+  //  II.A.  Tell the Train instances, then the workers, and wait for them:
+  massTransit.stopTrains();
+  __atomic_store_n(&isRunning,false,__ATOMIC_RELEASE);
+
+  for  (uint i = 0;  i < numStartedWorkers;  i++)
+  {
+    pthread_mutex_lock(&workerArray[i].lock);
+    pthread_cond_signal(&workerArray[i].cond);
+    pthread_mutex_unlock(&workerArray[i].lock);
+  }
+
+  for  (uint i = 0;  i < numStartedWorkers;  i++)
+    pthread_join(workerArray[i].threadId,NULL);
+
+  stopNsecs	= getMonotonicNsecs();
+  stopCpuNsecs	= getProcessCpuNsecs();
+
+  //  II.B.  Forget the parked Train instances, and the room held for them,
+  //	     then take each Train off of the system as 'simulateTrain()'
+  //	     does when it stops:
+  massTransit.setActorSchedulerPtr(NULL);
+
+  for  (uint i = 0;  i < massTransit.getNumTrains();  i++)
+  {
+    Train*	trainPtr	= massTransit.getTrainPtr(i);
+
+    pthread_mutex_lock(trainPtr->getHeadLockPtr());
+    trainPtr->setIsWaitingForHead(false);
+    pthread_mutex_unlock(trainPtr->getHeadLockPtr());
+  }
+
+  for  (uint i = 0;  i < massTransit.getNumTracks();  i++)
+    massTransit.getTrackPtr(i)->clearParked();
+
+  for  (uint i = 0;  i < massTransit.getNumTrains();  i++)
+  {
+    Train*	trainPtr	= massTransit.getTrainPtr(i);
+
+    if  (trainPtr->getLocPtr() != NULL)
+      trainPtr->getLocPtr()->leave(trainPtr);
+  }
+
+  for  (uint i = 0;  i < numWorkers;  i++)
+  {
+    workerArray[i].readyVector.clear();
+
+    while  ( !workerArray[i].timerQueue.empty() )
+      workerArray[i].timerQueue.pop();
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To run the Train instances for 'numSecs' seconds, recording
+//	the statistics, EventLog and TraceLog, and running the invariant
+//	checks, that their MassTransit asks for.  No return value.
+void		ActorScheduler::run	(uint		numSecs
+				)
+				throw(const char*)
+{
+  //  I.  Application validity check:
+
+  //  II.  Run.  Stop checking first, as stopped Train instances leave the
+  //	   system:
+  massTransit.beginRecording();
+  start();
+  sleep(numSecs);
+  massTransit.stopChecking();
+  stop();
+  massTransit.endRecording(getRunSecs());
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To print a summary of the last run to 'filePtr'.  No return
+//	value.
+void		ActorScheduler::printSummary
+				(FILE*		filePtr
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+  double		secs		= getRunSecs();
+  double		cpuSecs		= (double)(stopCpuNsecs - startCpuNsecs)
+					  / NSECS_PER_SEC;
+  unsigned long long	numMoves	= massTransit.getNumMoves();
+  double		waitSecs	= (double)massTransit.getLockWaitNsecs()
+					  / NSECS_PER_SEC;
+
+  //  II.  Print summary:
+  fprintf(filePtr,
+	  "%u trains as actors on %u workers for %.1f secs: %llu train moves "
+	  "(%.1f/sec), %.1f usecs wait per move, %llu steps, %.0f%% CPU\n",
+	  massTransit.getNumTrains(),
+	  numWorkers,
+	  secs,
+	  numMoves,
+	  (secs > 0.0) ? (numMoves / secs) : 0.0,
+	  (numMoves > 0) ? (waitSecs * 1e6 / numMoves) : 0.0,
+	  getNumSteps(),
+	  (secs > 0.0) ? (100.0 * cpuSecs / secs) : 0.0
+	 );
+  massTransit.printClassSummary(filePtr,secs);
+  massTransit.printCheckSummary(filePtr);
+
+  //  III.  Finished:
+}
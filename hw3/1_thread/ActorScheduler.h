@@ -0,0 +1,215 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		ActorScheduler.h					---*
+ *---									---*
+ *---	    This file declares a class that runs the Train instances of	---*
+ *---	a MassTransit system in real time as actors on a few worker	---*
+ *---	pthreads, instead of one pthread each.  Each Train is a		---*
+ *---	resumable state machine whose state lives in the Train itself,	---*
+ *---	so it needs no stack of its own.  Where a Train pthread would	---*
+ *---	sleep, the actor sets a timer; where it would wait to be the	---*
+ *---	first Train at its Station or for room on a Track, it parks	---*
+ *---	there, and the Train that leaves resumes it.  Train 'i' always	---*
+ *---	runs on worker 'i % numWorkers', so what only its thread may	---*
+ *---	touch is still touched by one thread at a time.			---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To tell that 'trainPtr' ends its pause at 'nsecs' on the
+//	monotonic clock.
+struct	ActorTimer
+{
+  //  PURPOSE:  To tell when the pause ends.
+  unsigned long long		nsecs;
+
+  //  PURPOSE:  To tell the Train that pauses.
+  Train*			trainPtr;
+
+  //  PURPOSE:  To return 'true' if '*this' ends after 'rhs', or 'false'
+  //	otherwise.  (Makes std::priority_queue pop the earliest timer.)
+  bool		operator>	(const ActorTimer&	rhs
+				)
+				const
+				throw()
+				{ return(nsecs > rhs.nsecs); }
+};
+
+
+//  PURPOSE:  To hold what one worker pthread of an ActorScheduler runs: the
+//	Train instances it owns that are ready to step, and the timers of
+//	those that pause.
+struct	ActorWorker
+{
+  //  PURPOSE:  To refer to the ActorScheduler of which '*this' is part.
+  ActorScheduler*		schedulerPtr;
+
+  //  PURPOSE:  To hold the Train instances ready to step, and the pending
+  //	timers, earliest first.  Protected by 'lock'.
+  std::vector<Train*>		readyVector;
+  std::priority_queue<ActorTimer,
+		      std::vector<ActorTimer>,
+		      std::greater<ActorTimer>
+		     >
+				timerQueue;
+
+  //  PURPOSE:  To hold 'true' while the pthread waits on 'cond' for work,
+  //	so that only then need it be signalled.  Protected by 'lock'.
+  bool				isIdle;
+
+  //  PURPOSE:  To count the steps run.  Only written by the pthread.
+  unsigned long long		numSteps;
+
+  //  PURPOSE:  To hold the pthread.
+  pthread_t			threadId;
+
+  //  PURPOSE:  To protect the members above, and to let Train instances
+  //	run by other workers wake the pthread.  'cond' uses the monotonic
+  //	clock.
+  pthread_mutex_t		lock;
+  pthread_cond_t		cond;
+};
+
+
+class	ActorScheduler
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To refer to the MassTransit system whose Train instances
+  //	'*this' runs.
+  MassTransit&			massTransit;
+
+  //  PURPOSE:  To hold the worker pthreads.
+  uint				numWorkers;
+  ActorWorker*			workerArray;
+
+  //  PURPOSE:  To tell how many worker pthreads were started.
+  uint				numStartedWorkers;
+
+  //  PURPOSE:  To hold 'true' while the workers should run, or 'false'
+  //	otherwise.  Only changed atomically.
+  bool				isRunning;
+
+  //  PURPOSE:  To tell when 'start()' and 'stop()' were called, on the
+  //	monotonic clock in nanoseconds, and the CPU time the process had
+  //	used by then.
+  unsigned long long		startNsecs;
+  unsigned long long		stopNsecs;
+  unsigned long long		startCpuNsecs;
+  unsigned long long		stopCpuNsecs;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  ActorScheduler		();
+
+  //  No copy constructor:
+  ActorScheduler		(const ActorScheduler&);
+
+  //  No copy assignment op:
+  ActorScheduler&		operator=
+				(const ActorScheduler&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To return the worker that runs '*trainPtr'.
+  ActorWorker&	getWorker	(const Train*	trainPtr
+				)
+				const
+				throw()
+  { return(workerArray[(uint)trainPtr->getIdentity() % numWorkers]); }
+
+  //  PURPOSE:  To have '*trainPtr' pause for a random time, then be
+  //	stepped.  No return value.
+  void		pause		(Train*		trainPtr
+				)
+				throw();
+
+  //  PURPOSE:  To run '*trainPtr' from where it last stopped until it must
+  //	pause or wait, as one pass of the loop of 'simulateTrain()' does.
+  //	No return value.
+  void		step		(Train*		trainPtr
+				)
+				throw();
+
+  //  PURPOSE:  To be the function that each worker pthread runs: steps
+  //	the Train instances of '*(ActorWorker*)vPtr' as they become ready
+  //	until told to stop.  Returns 'NULL'.
+  static
+  void*		work		(void*		vPtr
+				);
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to run the Train instances of
+  //	'newMassTransit', which must be placed and have no pthreads, on
+  //	'newNumWorkers' worker pthreads.  No return value.
+  ActorScheduler		(MassTransit&	newMassTransit,
+				 uint		newNumWorkers
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~ActorScheduler		()
+				throw();
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of worker pthreads.  No parameters.
+  uint		getNumWorkers	()
+				const
+				throw()
+				{ return(numWorkers); }
+
+  //  PURPOSE:  To return the number of steps run so far.  Approximate
+  //	while the workers run.  No parameters.
+  unsigned long long
+		getNumSteps	()
+				const
+				throw();
+
+  //  PURPOSE:  To return how many seconds the last run lasted, or 0 if
+  //	none has finished.  No parameters.
+  double	getRunSecs	()
+				const
+				throw()
+  { return( (stopNsecs > startNsecs)
+	    ? ((double)(stopNsecs - startNsecs) / NSECS_PER_SEC)
+	    : 0.0
+	  );
+  }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To make parked '*trainPtr' ready to step again.  May be
+  //	called from any worker.  No return value.
+  void		resume		(Train*		trainPtr
+				)
+				throw();
+
+  //  PURPOSE:  To start the workers, each Train first pausing as in
+  //	'simulateTrain()'.  No parameters.  No return value.
+  void		start		()
+				throw(const char*);
+
+  //  PURPOSE:  To stop the workers, wait for them, and take each Train off
+  //	of the system.  No parameters.  No return value.
+  void		stop		()
+				throw();
+
+  //  PURPOSE:  To run the Train instances for 'numSecs' seconds, recording
+  //	the statistics, EventLog and TraceLog, and running the invariant
+  //	checks, that their MassTransit asks for.  No return value.
+  void		run		(uint		numSecs
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To print a summary of the last run to 'filePtr'.  No return
+  //	value.
+  void		printSummary	(FILE*		filePtr
+				)
+				const
+				throw();
+
+};
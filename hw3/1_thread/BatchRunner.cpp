@@ -0,0 +1,323 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		BatchRunner.cpp						---*
+ *---									---*
+ *---	    This file defines a class that runs many seeded scenarios	---*
+ *---	of one MassTransit system in virtual time on worker pthreads	---*
+ *---	and summarizes them as confidence intervals.			---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To tell the two-sided 95% critical values of Student's t
+//	distribution for 1 to 30 degrees of freedom.  Beyond that the normal
+//	value 'T_95_LARGE' is close enough.
+static
+const double	T_95_TABLE[]	=
+{
+  12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static
+const double	T_95_LARGE	= 1.960;
+
+
+//  PURPOSE:  To initialize '*this' to run 'numScenarios' scenarios of
+//	'newNumSecs' virtual seconds each of 'newTopology' with
+//	'newNumTrains' Train instances, 'newTrackCapacity' per Track
+//	(admitted in arrival order if 'newIsFairAdmission', and heading one
+//	way at a time if 'newIsBlockSignalled') and pauses of up to
+//	'newMaxPauseUsecs', with seeds from 'newFirstSeed' on, on
+//	'newNumWorkers' pthreads.  No return value.
+BatchRunner::BatchRunner	(const TopologyFile&	newTopology,
+				 uint			numScenarios,
+				 uint			newNumTrains,
+				 uint			newTrackCapacity,
+				 uint			newMaxPauseUsecs,
+				 bool			newIsFairAdmission,
+				 bool			newIsBlockSignalled,
+				 uint			newNumSecs,
+				 uint			newFirstSeed,
+				 uint			newNumWorkers
+				)
+				throw(const char*) :
+				topology(newTopology),
+				numTrains(newNumTrains),
+				trackCapacity(newTrackCapacity),
+				maxPauseUsecs(newMaxPauseUsecs),
+				isFairAdmission(newIsFairAdmission),
+				isBlockSignalled(newIsBlockSignalled),
+				numSecs(newNumSecs),
+				firstSeed(newFirstSeed),
+				numWorkers(newNumWorkers),
+				nextScenario(0),
+				resultVector(numScenarios),
+				wallSecs(0.0)
+{
+  //  I.  Application validity check:
+  if  (numScenarios == 0)
+    throw "The number of scenarios must be positive";
+
+  if  ( (numWorkers == 0)  ||  (numSecs == 0) )
+    throw "The number of workers and of seconds must be positive";
+
+  //  II.  Initialize members:
+  if  (numWorkers > numScenarios)
+    numWorkers	= numScenarios;
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To be the function that each worker pthread runs: runs
+//	scenarios for '*(BatchRunner*)vPtr' until none are left.  Returns
+//	'NULL'.
+void*		BatchRunner::work
+				(void*		vPtr
+				)
+{
+  //  I.  Application validity check:
+  if  (vPtr == NULL)
+    return(NULL);
+
+  //  II.  Run scenarios:
+  BatchRunner*	runnerPtr	= (BatchRunner*)vPtr;
+  uint		numScenarios	= runnerPtr->getNumScenarios();
+  uint		i;
+
+  while  ( (i = __sync_fetch_and_add(&runnerPtr->nextScenario,1))
+	   < numScenarios
+	 )
+    runnerPtr->runScenario(i);
+
+  //  III.  Finished:
+  return(NULL);
+}
+
+
+//  PURPOSE:  To run scenario 'i' and to note what it measured in
+//	'resultVector[i]'.  No return value.
+void		BatchRunner::runScenario
+				(uint		i
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Run scenario:
+  MassTransit		cta(topology,
+			    numTrains,
+			    trackCapacity,
+			    maxPauseUsecs,
+			    isFairAdmission,
+			    isBlockSignalled,
+			    firstSeed + i
+			   );
+  EventSimulator	simulator(cta);
+  ScenarioResult&	result		= resultVector[i];
+  double		virtualSecs	= (double)numSecs;
+
+  simulator.run(numSecs);
+
+  result.movesPerHour		= simulator.getNumMoves() * 3600.0 / virtualSecs;
+  result.trackUtilization	= simulator.getTrackUtilization();
+  result.lineDelayVector.resize(cta.getNumLines());
+
+  for  (line_t line = 0;  line < cta.getNumLines();  line++)
+  {
+    unsigned long long	numMoves	= simulator.getLineNumMoves(line);
+
+    result.lineDelayVector[line]
+	= (numMoves == 0)
+	  ? 0.0
+	  : (double)simulator.getLineDelayUsecs(line) / USECS_PER_SEC / numMoves;
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To return the 95% confidence interval of the mean of
+//	'valueVector'.
+ConfidenceInterval
+		BatchRunner::getInterval
+				(const std::vector<double>&	valueVector
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  ConfidenceInterval	interval;
+  size_t		n		= valueVector.size();
+
+  interval.mean		= 0.0;
+  interval.halfWidth	= 0.0;
+
+  if  (n == 0)
+    return(interval);
+
+  //  II.  Compute interval:
+  //  II.A.  Get mean and sample variance in one pass (Welford):
+  double	sumSquares	= 0.0;
+
+  for  (size_t i = 0;  i < n;  i++)
+  {
+    double	delta	= valueVector[i] - interval.mean;
+
+    interval.mean	+= delta / (i + 1);
+    sumSquares		+= delta * (valueVector[i] - interval.mean);
+  }
+
+  //  II.B.  Widen the standard error by the critical value of t:
+  if  (n > 1)
+  {
+    size_t	degrees		= n - 1;
+    double	t		= (degrees <= sizeof(T_95_TABLE)/sizeof(double))
+				  ? T_95_TABLE[degrees-1]
+				  : T_95_LARGE;
+
+    interval.halfWidth	= t * sqrt(sumSquares / degrees / n);
+  }
+
+  //  III.  Finished:
+  return(interval);
+}
+
+
+//  PURPOSE:  To run every scenario.  No parameters.  No return value.
+void		BatchRunner::run()
+				throw(const char*)
+{
+  //  I.  Application validity check:
+  unsigned long long	startNsecs	= getMonotonicNsecs();
+
+  nextScenario	= 0;
+
+  //  II.  Run scenarios:
+  //	Each worker takes the next scenario as it finishes one, so long and
+  //	short scenarios balance out:
+  std::vector<pthread_t>	threadVector(numWorkers);
+  uint				numStarted	= 0;
+
+  for  (  ;  numStarted < numWorkers;  numStarted++)
+    if  ( pthread_create(&threadVector[numStarted],NULL,work,this) != 0 )
+      break;
+
+  for  (uint i = 0;  i < numStarted;  i++)
+    pthread_join(threadVector[i],NULL);
+
+  if  (numStarted == 0)
+    throw "Could not start any batch worker";
+
+  wallSecs	= (double)(getMonotonicNsecs() - startNsecs) / NSECS_PER_SEC;
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To print the confidence intervals of the last 'run()' to
+//	'filePtr'.  No return value.
+void		BatchRunner::printSummary
+				(FILE*		filePtr
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+  uint			numScenarios	= getNumScenarios();
+
+  //  II.  Print summary:
+  //  II.A.  Print how the batch ran:
+  fprintf(filePtr,
+	  "Ran %u scenarios (seeds %u to %u) of %u virtual secs on %u "
+	  "pthreads in %.3f wall secs (%.1f scenarios/sec)\n"
+	  "95%% confidence intervals of the mean over scenarios:\n",
+	  numScenarios,
+	  firstSeed,
+	  firstSeed + numScenarios - 1,
+	  numSecs,
+	  numWorkers,
+	  wallSecs,
+	  (wallSecs > 0.0) ? (numScenarios / wallSecs) : 0.0
+	 );
+
+  //  II.B.  Print system-wide intervals:
+  std::vector<double>	valueVector(numScenarios);
+  ConfidenceInterval	interval;
+
+  for  (uint i = 0;  i < numScenarios;  i++)
+    valueVector[i]	= resultVector[i].movesPerHour;
+
+  interval	= getInterval(valueVector);
+  fprintf(filePtr,"  %-28s %12.1f +- %-10.1f moves/virtual hour\n",
+	  "throughput",interval.mean,interval.halfWidth
+	 );
+
+  for  (uint i = 0;  i < numScenarios;  i++)
+    valueVector[i]	= 100.0 * resultVector[i].trackUtilization;
+
+  interval	= getInterval(valueVector);
+  fprintf(filePtr,"  %-28s %12.2f +- %-10.2f %% of track room\n",
+	  "track utilization",interval.mean,interval.halfWidth
+	 );
+
+  //  II.C.  Print per-line intervals:
+  for  (uint line = 0;  line < topology.getNumLines();  line++)
+  {
+    char	label[2*MAX_STRING_LEN];
+
+    for  (uint i = 0;  i < numScenarios;  i++)
+      valueVector[i]	= resultVector[i].lineDelayVector[line];
+
+    interval	= getInterval(valueVector);
+    snprintf(label,sizeof(label),"delay on %s",topology.getLine(line).name);
+    fprintf(filePtr,"  %-28s %12.3f +- %-10.3f virtual secs/move\n",
+	    label,interval.mean,interval.halfWidth
+	   );
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To write what each scenario of the last 'run()' measured to
+//	'filePtr' as CSV, one row per scenario.  No return value.
+void		BatchRunner::writeResults
+				(FILE*		filePtr
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Write results:
+  fprintf(filePtr,"seed,movesPerHour,trackUtilization");
+
+  for  (uint line = 0;  line < topology.getNumLines();  line++)
+    fprintf(filePtr,",\"delay %s\"",topology.getLine(line).name);
+
+  fputc('\n',filePtr);
+
+  for  (uint i = 0;  i < getNumScenarios();  i++)
+  {
+    const ScenarioResult&	result	= resultVector[i];
+
+    fprintf(filePtr,"%u,%.3f,%.6f",
+	    firstSeed + i,result.movesPerHour,result.trackUtilization
+	   );
+
+    for  (size_t line = 0;  line < result.lineDelayVector.size();  line++)
+      fprintf(filePtr,",%.6f",result.lineDelayVector[line]);
+
+    fputc('\n',filePtr);
+  }
+
+  //  III.  Finished:
+}
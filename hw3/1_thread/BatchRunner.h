@@ -0,0 +1,170 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		BatchRunner.h						---*
+ *---									---*
+ *---	    This file declares a class that runs many seeded scenarios	---*
+ *---	of one MassTransit system in virtual time, several at once on	---*
+ *---	worker pthreads and without ncurses, and that summarizes their	---*
+ *---	throughput, per-line delay and Track utilization as 95%		---*
+ *---	confidence intervals over the scenarios.  Scenario 'i' uses	---*
+ *---	seed 'firstSeed + i', so a batch is repeatable whatever the	---*
+ *---	number of workers.						---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To hold what one scenario of a BatchRunner measured.
+struct	ScenarioResult
+{
+  //  PURPOSE:  To tell the moves made per virtual hour.
+  double			movesPerHour;
+
+  //  PURPOSE:  To tell the fraction of the room on all Track instances that
+  //	was taken.
+  double			trackUtilization;
+
+  //  PURPOSE:  To tell, for each line, the virtual seconds that its Train
+  //	instances waited per move.
+  std::vector<double>		lineDelayVector;
+};
+
+
+//  PURPOSE:  To describe a 95% confidence interval of a mean.
+struct	ConfidenceInterval
+{
+  double			mean;
+  double			halfWidth;
+};
+
+
+class	BatchRunner
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To describe the MassTransit system of every scenario.
+  const TopologyFile&		topology;
+  uint				numTrains;
+  uint				trackCapacity;
+  uint				maxPauseUsecs;
+  bool				isFairAdmission;
+  bool				isBlockSignalled;
+
+  //  PURPOSE:  To tell the virtual seconds that each scenario runs.
+  uint				numSecs;
+
+  //  PURPOSE:  To tell the seed of the first scenario.
+  uint				firstSeed;
+
+  //  PURPOSE:  To tell the number of worker pthreads.
+  uint				numWorkers;
+
+  //  PURPOSE:  To tell the index of the next scenario that a worker should
+  //	take.  Only changed with '__sync_fetch_and_add()'.
+  uint				nextScenario;
+
+  //  PURPOSE:  To hold what each scenario measured, indexed by scenario.
+  std::vector<ScenarioResult>	resultVector;
+
+  //  PURPOSE:  To tell how many wall-clock seconds 'run()' took.
+  double			wallSecs;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  BatchRunner			();
+
+  //  No copy constructor:
+  BatchRunner			(const BatchRunner&);
+
+  //  No copy assignment op:
+  BatchRunner&			operator=
+				(const BatchRunner&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To be the function that each worker pthread runs: runs
+  //	scenarios for '*(BatchRunner*)vPtr' until none are left.  Returns
+  //	'NULL'.
+  static
+  void*		work		(void*		vPtr
+				);
+
+  //  PURPOSE:  To run scenario 'i' and to note what it measured in
+  //	'resultVector[i]'.  No return value.
+  void		runScenario	(uint		i
+				)
+				throw();
+
+  //  PURPOSE:  To return the 95% confidence interval of the mean of
+  //	'valueVector'.
+  static
+  ConfidenceInterval
+		getInterval	(const std::vector<double>&	valueVector
+				)
+				throw();
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to run 'numScenarios' scenarios of
+  //	'newNumSecs' virtual seconds each of 'newTopology' with
+  //	'newNumTrains' Train instances, 'newTrackCapacity' per Track
+  //	(admitted in arrival order if 'newIsFairAdmission', and heading one
+  //	way at a time if 'newIsBlockSignalled') and pauses of up to
+  //	'newMaxPauseUsecs', with seeds from 'newFirstSeed' on, on
+  //	'newNumWorkers' pthreads.  No return value.
+  BatchRunner			(const TopologyFile&	newTopology,
+				 uint			numScenarios,
+				 uint			newNumTrains,
+				 uint			newTrackCapacity,
+				 uint			newMaxPauseUsecs,
+				 bool			newIsFairAdmission,
+				 bool			newIsBlockSignalled,
+				 uint			newNumSecs,
+				 uint			newFirstSeed,
+				 uint			newNumWorkers
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~BatchRunner			()
+				throw()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of scenarios.  No parameters.
+  uint		getNumScenarios	()
+				const
+				throw()
+				{ return(resultVector.size()); }
+
+  //  PURPOSE:  To return what scenario 'i' measured.
+  const ScenarioResult&
+		getResult	(uint		i
+				)
+				const
+				throw()
+				{ return(resultVector[i]); }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To run every scenario.  No parameters.  No return value.
+  void		run		()
+				throw(const char*);
+
+  //  PURPOSE:  To print the confidence intervals of the last 'run()' to
+  //	'filePtr'.  No return value.
+  void		printSummary	(FILE*		filePtr
+				)
+				const
+				throw();
+
+  //  PURPOSE:  To write what each scenario of the last 'run()' measured to
+  //	'filePtr' as CSV, one row per scenario.  No return value.
+  void		writeResults	(FILE*		filePtr
+				)
+				const
+				throw();
+
+};
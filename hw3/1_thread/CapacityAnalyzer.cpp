@@ -0,0 +1,539 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		CapacityAnalyzer.cpp					---*
+ *---									---*
+ *---	    This file defines a class that computes, from the Station	---*
+ *---	and Track topology of a MassTransit system alone, how many	---*
+ *---	trains per hour each line could carry each way, and compares	---*
+ *---	that with what a simulation of it carried.			---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To tell the rate below which a Track or a fleet is taken to be
+//	used up when sharing the network, in Train instances a second.
+static
+const double	RATE_EPSILON		= 1e-12;
+
+
+//  PURPOSE:  To add to the residual graph of 'computeMaxFlow()' an edge
+//	from node 'from' to node 'to' with room 'room', and its reverse with
+//	room 'reverseRoom'.  No return value.
+static
+void		addEdge		(std::vector<uint>&	headVector,
+				 std::vector<double>&	roomVector,
+				 std::vector<std::vector<uint> >&
+							edgesOfNodeVector,
+				 uint			from,
+				 uint			to,
+				 double			room,
+				 double			reverseRoom
+				)
+{
+  edgesOfNodeVector[from].push_back(headVector.size());
+  headVector.push_back(to);
+  roomVector.push_back(room);
+  edgesOfNodeVector[to].push_back(headVector.size());
+  headVector.push_back(from);
+  roomVector.push_back(reverseRoom);
+}
+
+
+//  PURPOSE:  To initialize '*this' to the capacity of 'newMassTransit',
+//	whose Train instances must already be placed.  No return value.
+CapacityAnalyzer::CapacityAnalyzer
+				(const MassTransit&	newMassTransit
+				)
+				throw() :
+				massTransit(newMassTransit),
+				meanStaySecs(0.0),
+				trackRateVector(newMassTransit.getNumTracks(),0.0),
+				lineNumTrainsVector(newMassTransit.getNumLines(),0),
+				lineNumTracksVector(newMassTransit.getNumLines(),0),
+				fleetBoundVector(newMassTransit.getNumLines(),0.0),
+				soloBoundVector(newMassTransit.getNumLines(),0.0),
+				soloBottleneckVector(newMassTransit.getNumLines(),~0U),
+				fairShareVector(newMassTransit.getNumLines(),0.0),
+				fairShareBottleneckVector
+					(newMassTransit.getNumLines(),~0U),
+				maxBoundVector(newMassTransit.getNumLines(),0.0),
+				maxBottleneckVector(newMassTransit.getNumLines(),~0U),
+				maxFlow(0.0),
+				minCutVector()
+{
+  //  I.  Application validity check:
+
+  //  II.  Analyze:
+  //  II.A.  Get the mean pause exactly as 'getRandomPauseUsecs()' draws it:
+  unsigned long long	sumUsecs	= 0;
+
+  for  (uint i = 0;  i < 1000;  i++)
+    sumUsecs	+= (unsigned long long)i * massTransit.getMaxPauseUsecs() / 1000;
+
+  meanStaySecs	= (double)sumUsecs / 1000 / USECS_PER_SEC;
+
+  //  II.B.  A Train crossing a Track holds one place there for a stay, and a
+  //	     line carrying 'r' Train instances a second each way crosses it
+  //	     '2r' times a second:
+  for  (uint i = 0;  i < massTransit.getNumTracks();  i++)
+    trackRateVector[i]	= (meanStaySecs > 0.0)
+			  ? (massTransit.getTrackPtr(i)->getCapacity()
+			     / (2.0 * meanStaySecs)
+			    )
+			  : HUGE_VAL;
+
+  computeLineBounds();
+  computeFairShares();
+  computeMaxFlow();
+  computeMaxBounds();
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To compute the fleet bound and the solo bound of each line.
+//	No parameters.  No return value.
+void		CapacityAnalyzer::computeLineBounds
+				()
+				throw()
+{
+  //  I.  Application validity check:
+  uint		numStations	= massTransit.getNumStations();
+
+  for  (uint i = 0;  i < massTransit.getNumTrains();  i++)
+    lineNumTrainsVector[massTransit.getTrainPtr(i)->getLine()]++;
+
+  //  II.  Bound each line:
+  for  (line_t line = 0;  line < massTransit.getNumLines();  line++)
+  {
+    //  II.A.  The line can carry no more than its narrowest Track:
+    soloBoundVector[line]	= HUGE_VAL;
+
+    for  (uint i = 0;  i < massTransit.getNumTracks();  i++)
+    {
+      if  ( !massTransit.isOnLine(numStations + i,line) )
+	continue;
+
+      lineNumTracksVector[line]++;
+
+      if  (soloBoundVector[line] > trackRateVector[i])
+      {
+	soloBoundVector[line]		= trackRateVector[i];
+	soloBottleneckVector[line]	= i;
+      }
+    }
+
+    //  II.B.  A round trip over 'k' Track instances is '4k' stays, in which
+    //	     each Train passes every point of the line once each way:
+    uint	numStays	= 4 * lineNumTracksVector[line];
+
+    fleetBoundVector[line]	= ( (numStays == 0)  ||  (meanStaySecs <= 0.0) )
+				  ? HUGE_VAL
+				  : (lineNumTrainsVector[line]
+				     / (numStays * meanStaySecs)
+				    );
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To compute the fair share of each line by raising the
+//	rates of all lines together until a Track or a fleet stops each.
+//	No parameters.  No return value.
+void		CapacityAnalyzer::computeFairShares
+				()
+				throw()
+{
+  //  I.  Application validity check:
+  uint			numLines	= massTransit.getNumLines();
+  uint			numTracks	= massTransit.getNumTracks();
+  uint			numStations	= massTransit.getNumStations();
+  std::vector<double>	roomVector(trackRateVector);
+  std::vector<bool>	isRisingVector(numLines,false);
+  uint			numRising	= 0;
+
+  for  (line_t line = 0;  line < numLines;  line++)
+    if  ( (lineNumTracksVector[line] > 0)  &&  (fleetBoundVector[line] > 0.0) )
+    {
+      isRisingVector[line]	= true;
+      numRising++;
+    }
+
+  //  II.  Fill:
+  while  (numRising > 0)
+  {
+    //  II.A.  Find how far every rising line may rise before a Track or a
+    //	     fleet is used up:
+    double		step		= HUGE_VAL;
+    std::vector<uint>	numUsersVector(numTracks,0);
+
+    for  (line_t line = 0;  line < numLines;  line++)
+    {
+      if  ( !isRisingVector[line] )
+	continue;
+
+      step	= std::min(step,fleetBoundVector[line] - fairShareVector[line]);
+
+      for  (uint i = 0;  i < numTracks;  i++)
+	if  ( massTransit.isOnLine(numStations + i,line) )
+	  numUsersVector[i]++;
+    }
+
+    for  (uint i = 0;  i < numTracks;  i++)
+      if  (numUsersVector[i] > 0)
+	step	= std::min(step,roomVector[i] / numUsersVector[i]);
+
+    if  (step == HUGE_VAL)
+      break;
+
+    //  II.B.  Rise, then stop each line whose fleet or some Track of which
+    //	     is used up:
+    for  (uint i = 0;  i < numTracks;  i++)
+      roomVector[i]	-= step * numUsersVector[i];
+
+    for  (line_t line = 0;  line < numLines;  line++)
+    {
+      if  ( !isRisingVector[line] )
+	continue;
+
+      fairShareVector[line]	+= step;
+
+      if  (fleetBoundVector[line] - fairShareVector[line] <= RATE_EPSILON)
+      {
+	isRisingVector[line]	= false;
+	numRising--;
+	continue;
+      }
+
+      for  (uint i = 0;  i < numTracks;  i++)
+	if  ( massTransit.isOnLine(numStations + i,line)  &&
+	      (roomVector[i] <= RATE_EPSILON)
+	    )
+	{
+	  fairShareBottleneckVector[line]	= i;
+	  isRisingVector[line]		= false;
+	  numRising--;
+	  break;
+	}
+    }
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To compute 'maxFlow' and 'minCutVector' with Edmonds-Karp
+//	over the Station instances, each Track an edge both ways.  The
+//	residual graph is kept as lists of edges, so it takes space and
+//	each search takes time in proportion to the Track instances.  No
+//	parameters.  No return value.
+void		CapacityAnalyzer::computeMaxFlow
+				()
+				throw()
+{
+  //  I.  Application validity check:
+  uint		numStations	= massTransit.getNumStations();
+  uint		numTracks	= massTransit.getNumTracks();
+  uint		source		= numStations;
+  uint		sink		= numStations + 1;
+  uint		numNodes	= numStations + 2;
+  double	totalRate	= 0.0;
+
+  if  (meanStaySecs <= 0.0)
+  {
+    maxFlow	= HUGE_VAL;
+    return;
+  }
+
+  //  II.  Compute max-flow:
+  //  II.A.  Join the Station instances by their Track instances.  Edge 'e'
+  //	     and its reverse 'e ^ 1' are added together: 'headVector[e]' is
+  //	     the node it leads to, 'roomVector[e]' how much more it may
+  //	     carry, and 'edgesOfNodeVector[n]' the edges leading from 'n':
+  std::vector<uint>		headVector;
+  std::vector<double>		roomVector;
+  std::vector<std::vector<uint> >
+				edgesOfNodeVector(numNodes);
+
+  headVector.reserve(2 * (numTracks + numStations));
+  roomVector.reserve(2 * (numTracks + numStations));
+
+  for  (uint i = 0;  i < numTracks;  i++)
+  {
+    const Track*	trackPtr	= massTransit.getTrackPtr(i);
+    uint		north		= trackPtr->getTerminus(NORTH).getIndex();
+    uint		south		= trackPtr->getTerminus(SOUTH).getIndex();
+
+    addEdge(headVector,roomVector,edgesOfNodeVector,
+	    north,south,trackRateVector[i],trackRateVector[i]
+	   );
+    totalRate	+= trackRateVector[i];
+  }
+
+  //  II.B.  Feed the north terminus of each line, and drain the south one.
+  //	     A Station that ends lines at both ends is left out, as it
+  //	     would let flow bypass every Track:
+  std::vector<bool>	isFedVector(numStations,false);
+  std::vector<bool>	isDrainedVector(numStations,false);
+
+  for  (line_t line = 0;  line < massTransit.getNumLines();  line++)
+    for  (uint i = 0;  i < numStations;  i++)
+    {
+      const Station*	stationPtr	= massTransit.getStationPtr(i);
+      bool		hasNorth	= (stationPtr->getTrackPtr(line,NORTH) != NULL);
+      bool		hasSouth	= (stationPtr->getTrackPtr(line,SOUTH) != NULL);
+
+      if  (hasSouth  &&  !hasNorth)
+	isFedVector[i]		= true;
+      else
+      if  (hasNorth  &&  !hasSouth)
+	isDrainedVector[i]	= true;
+    }
+
+  for  (uint i = 0;  i < numStations;  i++)
+    if  (isFedVector[i]  &&  !isDrainedVector[i])
+      addEdge(headVector,roomVector,edgesOfNodeVector,
+	      source,i,totalRate,0.0
+	     );
+    else
+    if  (isDrainedVector[i]  &&  !isFedVector[i])
+      addEdge(headVector,roomVector,edgesOfNodeVector,
+	      i,sink,totalRate,0.0
+	     );
+
+  //  II.C.  Push flow along shortest augmenting paths until none is left.
+  //	     'parentEdgeVector[n]' is the edge by which the search reached
+  //	     node 'n', or '~0U' if it did not:
+  std::vector<uint>	parentEdgeVector(numNodes);
+
+  maxFlow	= 0.0;
+
+  while  (true)
+  {
+    std::queue<uint>	nodeQueue;
+
+    std::fill(parentEdgeVector.begin(),parentEdgeVector.end(),~0U);
+    parentEdgeVector[source]	= 0;
+    nodeQueue.push(source);
+
+    while  ( !nodeQueue.empty()  &&  (parentEdgeVector[sink] == ~0U) )
+    {
+      uint	node	= nodeQueue.front();
+
+      nodeQueue.pop();
+
+      for  (size_t k = 0;  k < edgesOfNodeVector[node].size();  k++)
+      {
+	uint	edge	= edgesOfNodeVector[node][k];
+	uint	next	= headVector[edge];
+
+	if  ( (parentEdgeVector[next] == ~0U)  &&
+	      (roomVector[edge] > RATE_EPSILON)
+	    )
+	{
+	  parentEdgeVector[next]	= edge;
+	  nodeQueue.push(next);
+	}
+      }
+    }
+
+    if  (parentEdgeVector[sink] == ~0U)
+      break;
+
+    double	pathRoom	= HUGE_VAL;
+
+    for  (uint node = sink;  node != source;
+	  node = headVector[parentEdgeVector[node] ^ 1]
+	 )
+      pathRoom	= std::min(pathRoom,roomVector[parentEdgeVector[node]]);
+
+    for  (uint node = sink;  node != source;
+	  node = headVector[parentEdgeVector[node] ^ 1]
+	 )
+    {
+      roomVector[parentEdgeVector[node]]	-= pathRoom;
+      roomVector[parentEdgeVector[node] ^ 1]	+= pathRoom;
+    }
+
+    maxFlow	+= pathRoom;
+  }
+
+  //  II.D.  The min cut is every Track leaving what the source still
+  //	     reaches, which the last search marked:
+  minCutVector.clear();
+
+  for  (uint i = 0;  i < numTracks;  i++)
+  {
+    const Track*	trackPtr	= massTransit.getTrackPtr(i);
+    uint		north		= trackPtr->getTerminus(NORTH).getIndex();
+    uint		south		= trackPtr->getTerminus(SOUTH).getIndex();
+    bool		isNorthReached	= (parentEdgeVector[north] != ~0U);
+    bool		isSouthReached	= (parentEdgeVector[south] != ~0U);
+
+    if  (isNorthReached != isSouthReached)
+      minCutVector.push_back(i);
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To compute the most each line can carry, from its fleet
+//	bound, its solo bound and 'maxFlow', which must be computed first.
+//	No parameters.  No return value.
+void		CapacityAnalyzer::computeMaxBounds
+				()
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Bound each line by its fleet, its narrowest Track, and what the
+  //	   max-flow leaves once the other lines get the least they need.
+  //	   That least is nothing, as an unfair Track may hold their Train
+  //	   instances back for good, so the max-flow itself caps each line.
+  //	   On a tie the min cut is named, as it limits the other lines too:
+  for  (line_t line = 0;  line < massTransit.getNumLines();  line++)
+  {
+    maxBoundVector[line]		= fleetBoundVector[line];
+    maxBottleneckVector[line]	= ~0U;
+
+    if  (maxBoundVector[line] > soloBoundVector[line])
+    {
+      maxBoundVector[line]		= soloBoundVector[line];
+      maxBottleneckVector[line]	= soloBottleneckVector[line];
+    }
+
+    if  ( (maxBoundVector[line] >= maxFlow)  &&  !minCutVector.empty() )
+    {
+      maxBoundVector[line]		= maxFlow;
+      maxBottleneckVector[line]	= minCutVector[0];
+    }
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To print the bounds of each line and of the network to
+//	'filePtr', next to what a run of 'secs' seconds in which the Train
+//	instances of line 'i' moved 'lineNumMovesVector[i]' times carried,
+//	and to tell whether the topology or the admission of Train
+//	instances holds throughput back.  No return value.
+void		CapacityAnalyzer::printComparison
+				(FILE*		filePtr,
+				 const std::vector<unsigned long long>&
+						lineNumMovesVector,
+				 double		secs
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+  if  (secs <= 0.0)
+    return;
+
+  //  II.  Print comparison:
+  //  II.A.  Print each line.  A Train of a line over 'k' Track instances
+  //	     moves '4k' times per round trip, passing each point once each
+  //	     way:
+  double	sumBound	= 0.0;
+  double	totalSimulated	= 0.0;
+  bool		isTrackBound	= false;
+
+  fprintf(filePtr,
+	  "Capacity, in trains/hour each way, with a mean stay of %.4g secs:\n"
+	  "  %-8s %6s %10s %10s %10s %10s %10s %7s  %s\n",
+	  meanStaySecs,
+	  "line","trains","fleet","alone","fair share","max","simulated",
+	  "of max","limited by"
+	 );
+
+  for  (line_t line = 0;  line < massTransit.getNumLines();  line++)
+  {
+    uint	numStays	= 4 * lineNumTracksVector[line];
+    double	simulated	= (numStays == 0)
+				  ? 0.0
+				  : (lineNumMovesVector[line] * 3600.0
+				     / (numStays * secs)
+				    );
+    double	bound		= maxBoundVector[line] * 3600.0;
+    uint	bottleneck	= maxBottleneckVector[line];
+
+    sumBound		+= bound;
+    totalSimulated	+= simulated;
+
+    if  (bottleneck != ~0U)
+      isTrackBound	= true;
+
+    fprintf(filePtr,
+	    "  %-8s %6u %10.1f %10.1f %10.1f %10.1f %10.1f %6.1f%%  %s\n",
+	    massTransit.getLineNameCPtr(line),
+	    lineNumTrainsVector[line],
+	    fleetBoundVector[line] * 3600.0,
+	    soloBoundVector[line] * 3600.0,
+	    fairShareVector[line] * 3600.0,
+	    bound,
+	    simulated,
+	    (bound > 0.0) ? (100.0 * simulated / bound) : 0.0,
+	    (bottleneck == ~0U)
+	    ? "its fleet"
+	    : massTransit.getTrackPtr(bottleneck)->getNameCPtr()
+	   );
+  }
+
+  //  II.B.  Print the network bound and what limits it:
+  fprintf(filePtr,
+	  "Network max-flow north to south: %.1f trains/hour each way, "
+	  "simulated %.1f (%.1f%%); min cut:",
+	  maxFlow * 3600.0,
+	  totalSimulated,
+	  (maxFlow > 0.0) ? (100.0 * totalSimulated / (maxFlow * 3600.0)) : 0.0
+	 );
+
+  for  (size_t i = 0;  i < minCutVector.size();  i++)
+    fprintf(filePtr,"%s %s",
+	    (i == 0) ? "" : ",",
+	    massTransit.getTrackPtr(minCutVector[i])->getNameCPtr()
+	   );
+
+  fputc('\n',filePtr);
+
+  //  II.C.  Tell what to fix, from the most the lines can carry together:
+  //	     no more than each can alone, nor than the max-flow:
+  double	totalBound	= std::min(sumBound,maxFlow * 3600.0);
+  double	fraction	= (totalBound > 0.0)
+				  ? (totalSimulated / totalBound)
+				  : 0.0;
+
+  if  (totalBound < sumBound)
+    isTrackBound	= true;
+
+  if  (fraction < CAPACITY_REACHED_FRACTION)
+    fprintf(filePtr,
+	    "Verdict: the scheduler: the lines carry %.1f%% of what the "
+	    "topology and fleet allow; the rest is lost to waits\n",
+	    100.0 * fraction
+	   );
+  else
+  if  (isTrackBound)
+    fprintf(filePtr,
+	    "Verdict: the topology: the lines carry %.1f%% of what it allows; "
+	    "widen the Track instances that limit them\n",
+	    100.0 * fraction
+	   );
+  else
+    fprintf(filePtr,
+	    "Verdict: the fleet: the lines carry %.1f%% of what their Train "
+	    "instances could if none ever waited; add Train instances\n",
+	    100.0 * fraction
+	   );
+
+  //  III.  Finished:
+}
@@ -0,0 +1,163 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		CapacityAnalyzer.h					---*
+ *---									---*
+ *---	    This file declares a class that computes, from the Station	---*
+ *---	and Track topology of a MassTransit system alone, how many	---*
+ *---	trains per hour each line could carry each way, and compares	---*
+ *---	that with what a simulation of it carried.  A Train stays at	---*
+ *---	each place for its pause, so a Track of capacity 'c' passes at	---*
+ *---	most 'c / meanPause' Train instances a second, shared by both	---*
+ *---	directions and by every line through it.  The network bound is	---*
+ *---	the max-flow from the north termini to the south termini, whose	---*
+ *---	min cut names the Track instances to widen.  The per-line	---*
+ *---	bound is the most a line can carry: no more than its fleet	---*
+ *---	carries when no Train ever waits, than its narrowest Track	---*
+ *---	passes, or than the max-flow leaves once the other lines get	---*
+ *---	the least they need.  Beside it is the fair share of each line	---*
+ *---	when every Track is shared evenly (progressive filling), which	---*
+ *---	a line may well exceed by taking room others leave.  A		---*
+ *---	simulation that reaches its bound is held back by the		---*
+ *---	topology; one that falls short is held back by how Train	---*
+ *---	instances are admitted and ordered.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+class	CapacityAnalyzer
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To refer to the MassTransit system to analyze.
+  const MassTransit&		massTransit;
+
+  //  PURPOSE:  To tell how long a Train stays at each place on average, in
+  //	seconds, if it never waits: its mean pause.
+  double			meanStaySecs;
+
+  //  PURPOSE:  To tell, for each Track, how many Train instances a second it
+  //	can pass each way, summed over the lines through it.
+  std::vector<double>		trackRateVector;
+
+  //  PURPOSE:  To tell, for each line, how many Train instances serve it
+  //	and how many Track instances it runs over.
+  std::vector<uint>		lineNumTrainsVector;
+  std::vector<uint>		lineNumTracksVector;
+
+  //  PURPOSE:  To tell, for each line, how many Train instances a second it
+  //	carries each way if none ever waits.
+  std::vector<double>		fleetBoundVector;
+
+  //  PURPOSE:  To tell, for each line, how many Train instances a second it
+  //	could carry each way if it had the network to itself, and the
+  //	index of the Track that limits it.
+  std::vector<double>		soloBoundVector;
+  std::vector<uint>		soloBottleneckVector;
+
+  //  PURPOSE:  To tell, for each line, how many Train instances a second it
+  //	gets each way when every Track is shared fairly among the lines
+  //	through it, and the index of the Track that stops it, or '~0U' if
+  //	its fleet does.  Not a bound: a line may take room others leave.
+  std::vector<double>		fairShareVector;
+  std::vector<uint>		fairShareBottleneckVector;
+
+  //  PURPOSE:  To tell, for each line, the most Train instances a second it
+  //	can carry each way, and the index of the Track that limits it, or
+  //	'~0U' if its fleet does.
+  std::vector<double>		maxBoundVector;
+  std::vector<uint>		maxBottleneckVector;
+
+  //  PURPOSE:  To tell the most Train instances a second that the network
+  //	can carry from its north termini to its south termini, and the
+  //	indices of the Track instances of a min cut that limits it.
+  double			maxFlow;
+  std::vector<uint>		minCutVector;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  CapacityAnalyzer		();
+
+  //  No copy constructor:
+  CapacityAnalyzer		(const CapacityAnalyzer&);
+
+  //  No copy assignment op:
+  CapacityAnalyzer&		operator=
+				(const CapacityAnalyzer&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To compute the fleet bound and the solo bound of each line.
+  //	No parameters.  No return value.
+  void		computeLineBounds
+				()
+				throw();
+
+  //  PURPOSE:  To compute the fair share of each line by raising the
+  //	rates of all lines together until a Track or a fleet stops each.
+  //	No parameters.  No return value.
+  void		computeFairShares
+				()
+				throw();
+
+  //  PURPOSE:  To compute 'maxFlow' and 'minCutVector' with Edmonds-Karp
+  //	over the Station instances, each Track an edge both ways.  No
+  //	parameters.  No return value.
+  void		computeMaxFlow	()
+				throw();
+
+  //  PURPOSE:  To compute the most each line can carry, from its fleet
+  //	bound, its solo bound and 'maxFlow', which must be computed first.
+  //	No parameters.  No return value.
+  void		computeMaxBounds	()
+				throw();
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to the capacity of 'newMassTransit',
+  //	whose Train instances must already be placed.  No return value.
+  CapacityAnalyzer		(const MassTransit&	newMassTransit
+				)
+				throw();
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~CapacityAnalyzer		()
+				throw()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the most Train instances per hour that the
+  //	network can carry each way.  No parameters.
+  double	getMaxFlowPerHour
+				()
+				const
+				throw()
+				{ return(maxFlow * 3600.0); }
+
+  //  PURPOSE:  To return the most Train instances per hour that line
+  //	'line' can carry each way.
+  double	getLineBoundPerHour
+				(line_t		line
+				)
+				const
+				throw()
+				{ return(maxBoundVector[line] * 3600.0); }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To print the bounds of each line and of the network to
+  //	'filePtr', next to what a run of 'secs' seconds in which the Train
+  //	instances of line 'i' moved 'lineNumMovesVector[i]' times carried,
+  //	and to tell whether the topology or the admission of Train
+  //	instances holds throughput back.  No return value.
+  void		printComparison	(FILE*		filePtr,
+				 const std::vector<unsigned long long>&
+						lineNumMovesVector,
+				 double		secs
+				)
+				const
+				throw();
+
+};
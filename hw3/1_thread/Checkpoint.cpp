@@ -0,0 +1,169 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Checkpoint.cpp						---*
+ *---									---*
+ *---	    This file defines a class that maps a checkpoint image: a	---*
+ *---	binary copy of the state of an EventSimulator and of every	---*
+ *---	Train and TrainLocation of its MassTransit system, from which	---*
+ *---	the run may be resumed.						---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To hold the text of the last error thrown by a Checkpoint.
+static
+char		errorText[MAX_STRING_LEN];
+
+
+//  PURPOSE:  To return 'true' if the 'numRecords' records of 'recordSize'
+//	bytes at 'offset' lie, 8-byte aligned, within an image of 'numBytes'
+//	bytes, or 'false' otherwise.
+static
+bool		isWithin	(unsigned long long	offset,
+				 unsigned long long	numRecords,
+				 size_t			recordSize,
+				 size_t			numBytes
+				)
+{
+  return( (offset % sizeof(unsigned long long) == 0)  &&
+	  (offset <= numBytes)  &&
+	  (numRecords <= (numBytes - offset) / recordSize)
+	);
+}
+
+
+//  PURPOSE:  To map the checkpoint image in file 'pathCPtr' read-only,
+//	after checking that it is one and that every array it claims lies
+//	within it.  No return value.
+Checkpoint::Checkpoint		(const char*	pathCPtr
+				)
+				throw(const char*) :
+				imageCPtr(NULL),
+				numBytes(0)
+{
+  //  I.  Application validity check:
+  int		fd	= open(pathCPtr,O_RDONLY);
+  struct stat	status;
+
+  if  (fd < 0)
+  {
+    snprintf(errorText,MAX_STRING_LEN,"Cannot open checkpoint %s",pathCPtr);
+    throw (const char*)errorText;
+  }
+
+  if  ( (fstat(fd,&status) != 0)  ||
+	((size_t)status.st_size < sizeof(CheckpointHeader))
+      )
+  {
+    close(fd);
+    snprintf(errorText,MAX_STRING_LEN,"%s is not a massTransit checkpoint",
+	     pathCPtr
+	    );
+    throw (const char*)errorText;
+  }
+
+  //  II.  Map image:
+  void*		vPtr	= mmap(NULL,status.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+
+  close(fd);
+
+  if  (vPtr == MAP_FAILED)
+  {
+    snprintf(errorText,MAX_STRING_LEN,"Cannot map checkpoint %s",pathCPtr);
+    throw (const char*)errorText;
+  }
+
+  imageCPtr	= (const char*)vPtr;
+  numBytes	= status.st_size;
+
+  //  III.  Check image:
+  const CheckpointHeader&	header	= getHeader();
+  const char*			problemCPtr	= NULL;
+
+  if  (memcmp(header.magic,CHECKPOINT_MAGIC,sizeof(header.magic)) != 0)
+    problemCPtr	= "is not a massTransit checkpoint";
+  else
+  if  (header.version != CHECKPOINT_VERSION)
+    problemCPtr	= "was written by another version of massTransit";
+  else
+  if  ( (header.numBytes != numBytes)					||
+	!isWithin(header.trainOffset,header.numTrains,
+		  sizeof(CheckpointTrain),numBytes
+		 )							||
+	!isWithin(header.lineOffset,header.numLines,
+		  sizeof(CheckpointLine),numBytes
+		 )							||
+	!isWithin(header.locationOffset,
+		  (unsigned long long)header.numStations + header.numTracks,
+		  sizeof(CheckpointLocation),numBytes
+		 )							||
+	!isWithin(header.eventOffset,header.numPendingEvents,
+		  sizeof(CheckpointEvent),numBytes
+		 )							||
+	!isWithin(header.idOffset,header.numIds,sizeof(uint),numBytes)
+      )
+    problemCPtr	= "is truncated or corrupt";
+
+  if  (problemCPtr != NULL)
+  {
+    munmap((void*)imageCPtr,numBytes);
+    imageCPtr	= NULL;
+    snprintf(errorText,MAX_STRING_LEN,"Checkpoint %s %s",pathCPtr,problemCPtr);
+    throw (const char*)errorText;
+  }
+
+  //  IV.  Finished:
+}
+
+
+//  PURPOSE:  To release resources.  No parameters.  No return value.
+Checkpoint::~Checkpoint		()
+				throw()
+{
+  //  I.  Application validity check:
+  if  (imageCPtr == NULL)
+    return;
+
+  //  II.  Unmap image:
+  munmap((void*)imageCPtr,numBytes);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To write to file 'pathCPtr' the image of 'numImageBytes'
+//	bytes at 'imagePtr', as built by 'EventSimulator::writeCheckpoint()'.
+//	No return value.
+void		Checkpoint::write
+				(const char*	pathCPtr,
+				 const void*	imagePtr,
+				 size_t		numImageBytes
+				)
+				throw(const char*)
+{
+  //  I.  Application validity check:
+  FILE*	filePtr	= fopen(pathCPtr,"wb");
+
+  if  (filePtr == NULL)
+  {
+    snprintf(errorText,MAX_STRING_LEN,"Cannot write checkpoint %s",pathCPtr);
+    throw (const char*)errorText;
+  }
+
+  //  II.  Write image:
+  size_t	numWritten	= fwrite(imagePtr,1,numImageBytes,filePtr);
+
+  if  ( (fclose(filePtr) != 0)  ||  (numWritten != numImageBytes) )
+  {
+    snprintf(errorText,MAX_STRING_LEN,"Cannot write checkpoint %s",pathCPtr);
+    throw (const char*)errorText;
+  }
+
+  //  III.  Finished:
+}
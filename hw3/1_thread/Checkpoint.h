@@ -0,0 +1,217 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Checkpoint.h						---*
+ *---									---*
+ *---	    This file declares a class that maps a checkpoint image: a	---*
+ *---	binary copy of the state of an EventSimulator and of every	---*
+ *---	Train and TrainLocation of its MassTransit system, from which	---*
+ *---	the run may be resumed, as it was or with another seed or	---*
+ *---	pause, any number of times.  The image is a header followed by	---*
+ *---	arrays of fixed-size records at 8-byte aligned offsets that	---*
+ *---	the header gives, so once mapped it is used where it lies,	---*
+ *---	without parsing or copying.  Images are only read back on the	---*
+ *---	machine kind that wrote them.					---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To describe the run that a checkpoint image holds, and where
+//	in the image each array of records starts, in bytes.
+struct	CheckpointHeader
+{
+  char				magic[8];
+  uint				version;
+  uint				seed;
+  uint				numTrains;
+  uint				trackCapacity;
+  uint				isFairAdmission;
+  uint				isBlockSignalled;
+  uint				maxPauseUsecs;
+  uint				expressPercent;
+  uint				numStations;
+  uint				numTracks;
+  uint				numLines;
+  uint				numPendingEvents;
+  uint				numIds;
+  simTime_t			now;
+  unsigned long long		nextSequence;
+  unsigned long long		numEvents;
+  unsigned long long		numMoves;
+  unsigned long long		numTrackWaits;
+  simTime_t			trackBusyUsecs;
+  unsigned long long		trainOffset;
+  unsigned long long		lineOffset;
+  unsigned long long		locationOffset;
+  unsigned long long		eventOffset;
+  unsigned long long		idOffset;
+  unsigned long long		numBytes;
+};
+
+
+//  PURPOSE:  To hold, for one Train, its line, where it is and which way
+//	it heads, how many random numbers it has drawn, when it got where it
+//	is and when it started waiting, how long it waited and how often it
+//	moved in all, and whether it waits to become the first Train at its
+//	Station.
+struct	CheckpointTrain
+{
+  unsigned long long		randomCounter;
+  simTime_t			arrivalTime;
+  simTime_t			waitStart;
+  simTime_t			delayUsecs;
+  unsigned long long		numMoves;
+  uint				locIndex;
+  uint				direction;
+  uint				isHeadWaiter;
+  uint				line;
+};
+
+
+//  PURPOSE:  To hold, for one line, how long its Train instances waited
+//	and how often they moved.
+struct	CheckpointLine
+{
+  simTime_t			delayUsecs;
+  unsigned long long		numMoves;
+};
+
+
+//  PURPOSE:  To tell, for one TrainLocation, where in the id array its
+//	Train instances, first one first, start, followed by those waiting
+//	to get onto it, longest-waiting first, and, for a Track, how many
+//	express Train instances in a row got onto it while a local one
+//	waited.
+struct	CheckpointLocation
+{
+  uint				firstId;
+  uint				numTrains;
+  uint				numWaiters;
+  uint				numExpressPasses;
+};
+
+
+//  PURPOSE:  To hold one pending event of the EventSimulator.
+struct	CheckpointEvent
+{
+  simTime_t			time;
+  unsigned long long		sequence;
+  uint				trainId;
+  uint				padding;
+};
+
+
+class	Checkpoint
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To point to the mapped image, and to tell its length.
+  const char*			imageCPtr;
+  size_t			numBytes;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  Checkpoint			();
+
+  //  No copy constructor:
+  Checkpoint			(const Checkpoint&);
+
+  //  No copy assignment op:
+  Checkpoint&			operator=
+				(const Checkpoint&);
+
+protected :
+  //  III.  Protected methods:
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To map the checkpoint image in file 'pathCPtr' read-only,
+  //	after checking that it is one and that every array it claims lies
+  //	within it.  No return value.
+  Checkpoint			(const char*	pathCPtr
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~Checkpoint			()
+				throw();
+
+  //  PURPOSE:  To write to file 'pathCPtr' the image of 'numImageBytes'
+  //	bytes at 'imagePtr', as built by 'EventSimulator::writeCheckpoint()'.
+  //	No return value.
+  static
+  void		write		(const char*	pathCPtr,
+				 const void*	imagePtr,
+				 size_t		numImageBytes
+				)
+				throw(const char*);
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the header of the image.  No parameters.
+  const CheckpointHeader&
+		getHeader	()
+				const
+				throw()
+				{ return(*(const CheckpointHeader*)imageCPtr); }
+
+  //  PURPOSE:  To return the record of each Train, by id.  No parameters.
+  const CheckpointTrain*
+		getTrainArray	()
+				const
+				throw()
+  {
+    return( (const CheckpointTrain*)(imageCPtr + getHeader().trainOffset) );
+  }
+
+  //  PURPOSE:  To return the record of each line.  No parameters.
+  const CheckpointLine*
+		getLineArray	()
+				const
+				throw()
+  {
+    return( (const CheckpointLine*)(imageCPtr + getHeader().lineOffset) );
+  }
+
+  //  PURPOSE:  To return the record of each TrainLocation, by index.  No
+  //	parameters.
+  const CheckpointLocation*
+		getLocationArray()
+				const
+				throw()
+  {
+    return( (const CheckpointLocation*)(imageCPtr
+					+ getHeader().locationOffset
+				       )
+	  );
+  }
+
+  //  PURPOSE:  To return the pending events.  No parameters.
+  const CheckpointEvent*
+		getEventArray	()
+				const
+				throw()
+  {
+    return( (const CheckpointEvent*)(imageCPtr + getHeader().eventOffset) );
+  }
+
+  //  PURPOSE:  To return the Train ids that the TrainLocation records
+  //	index.  No parameters.
+  const uint*	getIdArray	()
+				const
+				throw()
+  {
+    return( (const uint*)(imageCPtr + getHeader().idOffset) );
+  }
+
+  //  PURPOSE:  To return the length of the image in bytes.  No parameters.
+  size_t	getNumBytes	()
+				const
+				throw()
+				{ return(numBytes); }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+
+};
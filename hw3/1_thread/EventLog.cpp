@@ -0,0 +1,278 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		EventLog.cpp						---*
+ *---									---*
+ *---	    This file defines a class that writes every arrival and	---*
+ *---	departure of a threaded MassTransit run to a file, and that	---*
+ *---	replays such a file at full speed.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To tell the format of the header line of an event log.
+static
+const char*	LOG_HEADER_FORMAT	=
+  "massTransitLog 2 seed %u trains %u capacity %u fair %u blocks %u "
+  "stations %u tracks %u\n";
+
+
+//  PURPOSE:  To hold the text of the last error thrown by an EventLog.
+static
+char		errorText[MAX_STRING_LEN];
+
+
+//  PURPOSE:  To read into 'header' the header of the event log in file
+//	'pathCPtr', so that the MassTransit it describes may be built.  No
+//	return value.
+void		EventLog::readHeader	(const char*	pathCPtr,
+					 LogHeader&	header
+					)
+					throw(const char*)
+{
+  //  I.  Application validity check:
+  FILE*	filePtr	= fopen(pathCPtr,"r");
+
+  if  (filePtr == NULL)
+  {
+    snprintf(errorText,MAX_STRING_LEN,"Cannot open event log %s",pathCPtr);
+    throw (const char*)errorText;
+  }
+
+  //  II.  Read header:
+  uint	isFair;
+  uint	isBlockSignalled;
+  int	numRead	= fscanf(filePtr,LOG_HEADER_FORMAT,
+			 &header.seed,
+			 &header.numTrains,
+			 &header.trackCapacity,
+			 &isFair,
+			 &isBlockSignalled,
+			 &header.numStations,
+			 &header.numTracks
+			);
+
+  fclose(filePtr);
+
+  if  (numRead != 7)
+  {
+    snprintf(errorText,MAX_STRING_LEN,"%s is not a massTransit event log",
+	     pathCPtr
+	    );
+    throw (const char*)errorText;
+  }
+
+  header.isFairAdmission	= (isFair != 0);
+  header.isBlockSignalled	= (isBlockSignalled != 0);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To write the events that the Train instances of
+//	'massTransit' logged during 'MassTransit::simulate()' to file
+//	'pathCPtr', in the order they happened.  No return value.
+void		EventLog::write	(const char*	pathCPtr
+				)
+				throw(const char*)
+{
+  //  I.  Application validity check:
+  FILE*	filePtr	= fopen(pathCPtr,"w");
+
+  if  (filePtr == NULL)
+  {
+    snprintf(errorText,MAX_STRING_LEN,"Cannot write event log %s",pathCPtr);
+    throw (const char*)errorText;
+  }
+
+  //  II.  Write log:
+  //  II.A.  Gather the records that each Train kept for itself:
+  std::vector<LogRecord>	recordVector;
+
+  for  (uint i = 0;  i < massTransit.getNumTrains();  i++)
+  {
+    const std::vector<LogRecord>&	trainVector
+				= massTransit.getTrainPtr(i)->getLogVector();
+
+    recordVector.insert(recordVector.end(),trainVector.begin(),trainVector.end());
+  }
+
+  std::sort(recordVector.begin(),recordVector.end());
+
+  //  II.B.  Write them:
+  fprintf(filePtr,LOG_HEADER_FORMAT,
+	  massTransit.getSeed(),
+	  massTransit.getNumTrains(),
+	  massTransit.getTrackCapacity(),
+	  massTransit.getIsFairAdmission() ? 1 : 0,
+	  massTransit.getIsBlockSignalled() ? 1 : 0,
+	  massTransit.getNumStations(),
+	  massTransit.getNumTracks()
+	 );
+
+  for  (size_t i = 0;  i < recordVector.size();  i++)
+  {
+    const LogRecord&	record	= recordVector[i];
+
+    fprintf(filePtr,"%llu %llu %u %c %u\n",
+	    record.sequence,
+	    record.nsecs,
+	    record.trainId,
+	    (record.kind == LOG_ARRIVE) ? 'A' : 'L',
+	    record.locIndex
+	   );
+  }
+
+  numEvents	= recordVector.size();
+  fclose(filePtr);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To apply the events of the log in file 'pathCPtr' to
+//	'massTransit', which must have been built as its header describes
+//	and not yet run, checking that each is possible.  No return value.
+void		EventLog::replay(const char*	pathCPtr
+				)
+				throw(const char*)
+{
+  //  I.  Application validity check:
+  FILE*	filePtr	= fopen(pathCPtr,"r");
+
+  if  (filePtr == NULL)
+  {
+    snprintf(errorText,MAX_STRING_LEN,"Cannot open event log %s",pathCPtr);
+    throw (const char*)errorText;
+  }
+
+  //  II.  Replay log:
+  //  II.A.  Remember where each Train last was, to check that each arrival
+  //	     is where it would go next:
+  unsigned long long		startNsecs	= getMonotonicNsecs();
+  std::vector<TrainLocation*>	lastLocPtrVector(massTransit.getNumTrains());
+  char				line[MAX_STRING_LEN];
+  uint				lineNum		= 1;
+  bool				isFirstRecord	= true;
+  unsigned long long		lastSequence	= 0;
+
+  for  (uint i = 0;  i < massTransit.getNumTrains();  i++)
+    lastLocPtrVector[i]	= massTransit.getTrainPtr(i)->getLocPtr();
+
+  if  (fgets(line,MAX_STRING_LEN,filePtr) == NULL)
+  {
+    fclose(filePtr);
+    snprintf(errorText,MAX_STRING_LEN,"Event log %s is empty",pathCPtr);
+    throw (const char*)errorText;
+  }
+
+  //  II.B.  Apply each event:
+  numEvents	= 0;
+  numMoves	= 0;
+
+  while  (fgets(line,MAX_STRING_LEN,filePtr) != NULL)
+  {
+    LogRecord	record;
+    char	kind;
+
+    lineNum++;
+
+    if  ( (sscanf(line,"%llu %llu %u %c %u",
+		  &record.sequence,
+		  &record.nsecs,
+		  &record.trainId,
+		  &kind,
+		  &record.locIndex
+		 )
+	   != 5
+	  )						||
+	  ( (kind != 'A')  &&  (kind != 'L') )		||
+	  (record.trainId  >= massTransit.getNumTrains())	||
+	  (record.locIndex >= massTransit.getNumLocations())	||
+	  ( !isFirstRecord  &&  (record.sequence <= lastSequence) )
+	)
+    {
+      fclose(filePtr);
+      snprintf(errorText,MAX_STRING_LEN,"Event log line %u is malformed",
+	       lineNum
+	      );
+      throw (const char*)errorText;
+    }
+
+    Train*		trainPtr	= massTransit.getTrainPtr(record.trainId);
+    TrainLocation*	locPtr		= massTransit.getLocPtr(record.locIndex);
+    bool		isPossible;
+
+    if  (kind == 'L')
+    {
+      isPossible	= (trainPtr->getLocPtr() == locPtr);
+
+      if  (isPossible)
+	locPtr->leave(trainPtr);
+    }
+    else
+    {
+      TrainLocation*	lastLocPtr	= lastLocPtrVector[record.trainId];
+
+      isPossible	= (trainPtr->getLocPtr() == NULL)		&&
+			  (lastLocPtr != NULL)				&&
+			  (lastLocPtr->nextLocPtr(trainPtr) == locPtr)	&&
+			  locPtr->tryArrive(trainPtr);
+
+      if  (isPossible)
+      {
+	lastLocPtrVector[record.trainId]	= locPtr;
+	trainPtr->noteMove();
+	numMoves++;
+      }
+    }
+
+    if  ( !isPossible )
+    {
+      fclose(filePtr);
+      snprintf(errorText,MAX_STRING_LEN,
+	       "Event log line %u is impossible for this topology and seed",
+	       lineNum
+	      );
+      throw (const char*)errorText;
+    }
+
+    isFirstRecord	= false;
+    lastSequence	= record.sequence;
+    numEvents++;
+  }
+
+  fclose(filePtr);
+  wallSecs	= (double)(getMonotonicNsecs() - startNsecs) / NSECS_PER_SEC;
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To print a summary of the last 'replay()' to 'filePtr'.  No
+//	return value.
+void		EventLog::printSummary
+				(FILE*		filePtr
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Print summary:
+  fprintf(filePtr,
+	  "Replayed %llu events (%llu train moves) in %.3f wall secs "
+	  "(%.0f events/sec)\n",
+	  numEvents,
+	  numMoves,
+	  wallSecs,
+	  (wallSecs > 0.0) ? (numEvents / wallSecs) : 0.0
+	 );
+
+  //  III.  Finished:
+}
@@ -0,0 +1,163 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		EventLog.h						---*
+ *---									---*
+ *---	    This file declares a class that writes every arrival and	---*
+ *---	departure of a threaded MassTransit run to a file, and that	---*
+ *---	replays such a file at full speed.  Together with the seed,	---*
+ *---	which decides where each Train starts, the file reproduces	---*
+ *---	the run exactly even though the order in which pthreads got	---*
+ *---	their locks cannot be.  The file is text: one header line	---*
+ *---									---*
+ *---	massTransitLog 1 seed <s> trains <n> capacity <c> fair <0|1>	---*
+ *---		stations <numStations> tracks <numTracks>		---*
+ *---									---*
+ *---	then one line per event in the order they happened:		---*
+ *---									---*
+ *---	<sequence> <nsecs> <trainId> <A|L> <locationIndex>		---*
+ *---									---*
+ *---	where 'A' is an arrival, 'L' a departure, and locations are	---*
+ *---	numbered as by 'MassTransit::getLocPtr()'.			---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To tell what happened in one LogRecord.
+typedef		enum
+		{
+		  LOG_ARRIVE,
+		  LOG_LEAVE
+		}
+		logKind_t;
+
+
+//  PURPOSE:  To describe one arrival or departure.  'sequence' orders all
+//	records of a run.  It is taken under the lock of a Track, and at a
+//	Station before the change shows to other Train instances, so
+//	records of a Train that waited on another come after the record
+//	it waited for.
+struct	LogRecord
+{
+  unsigned long long		sequence;
+  unsigned long long		nsecs;
+  uint				trainId;
+  uint				locIndex;
+  logKind_t			kind;
+
+  //  PURPOSE:  To return 'true' if '*this' happened before 'rhs', or 'false'
+  //	otherwise.
+  bool		operator<	(const LogRecord&	rhs
+				)
+				const
+				throw()
+				{ return(sequence < rhs.sequence); }
+};
+
+
+//  PURPOSE:  To describe the run that an event log records.
+struct	LogHeader
+{
+  uint				seed;
+  uint				numTrains;
+  uint				trackCapacity;
+  bool				isFairAdmission;
+  bool				isBlockSignalled;
+  uint				numStations;
+  uint				numTracks;
+};
+
+
+class	EventLog
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To refer to the MassTransit system whose events are logged or
+  //	replayed.
+  MassTransit&			massTransit;
+
+  //  PURPOSE:  To count the events written or replayed.
+  unsigned long long		numEvents;
+
+  //  PURPOSE:  To count the moves replayed.
+  unsigned long long		numMoves;
+
+  //  PURPOSE:  To tell how many wall-clock seconds 'replay()' took.
+  double			wallSecs;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  EventLog			();
+
+  //  No copy constructor:
+  EventLog			(const EventLog&);
+
+  //  No copy assignment op:
+  EventLog&			operator=
+				(const EventLog&);
+
+protected :
+  //  III.  Protected methods:
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to log or replay the events of
+  //	'newMassTransit'.  No return value.
+  EventLog			(MassTransit&	newMassTransit
+				)
+				throw() :
+				massTransit(newMassTransit),
+				numEvents(0),
+				numMoves(0),
+				wallSecs(0.0)
+				{ }
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~EventLog			()
+				throw()
+				{ }
+
+  //  PURPOSE:  To read into 'header' the header of the event log in file
+  //	'pathCPtr', so that the MassTransit it describes may be built.  No
+  //	return value.
+  static
+  void		readHeader	(const char*	pathCPtr,
+				 LogHeader&	header
+				)
+				throw(const char*);
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of events written or replayed.  No
+  //	parameters.
+  unsigned long long
+		getNumEvents	()
+				const
+				throw()
+				{ return(numEvents); }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To write the events that the Train instances of
+  //	'massTransit' logged during 'MassTransit::simulate()' to file
+  //	'pathCPtr', in the order they happened.  No return value.
+  void		write		(const char*	pathCPtr
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To apply the events of the log in file 'pathCPtr' to
+  //	'massTransit', which must have been built as its header describes
+  //	and not yet run, checking that each is possible.  No return value.
+  void		replay		(const char*	pathCPtr
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To print a summary of the last 'replay()' to 'filePtr'.  No
+  //	return value.
+  void		printSummary	(FILE*		filePtr
+				)
+				const
+				throw();
+
+};
@@ -0,0 +1,971 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		EventSimulator.cpp					---*
+ *---									---*
+ *---	    This file defines a class that runs a MassTransit system	---*
+ *---	in virtual time: instead of one sleeping pthread per Train, a	---*
+ *---	single thread pops timestamped events off a priority queue and	---*
+ *---	applies them with the same Station and Track methods that the	---*
+ *---	threaded simulation uses.					---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To initialize '*this' to simulate 'newMassTransit', whose
+//	Train instances must already be placed and whose pthreads must not
+//	have been started.  No return value.
+EventSimulator::EventSimulator	(MassTransit&	newMassTransit
+				)
+				throw() :
+				massTransit(newMassTransit),
+				eventQueue(),
+				waiterMap(),
+				headWaiterSet(),
+				now(0),
+				nextSequence(0),
+				numEvents(0),
+				numMoves(0),
+				numTrackWaits(0),
+				arrivalTimeVector(newMassTransit.getNumTrains(),0),
+				waitStartVector(newMassTransit.getNumTrains(),0),
+				lineDelayVector(newMassTransit.getNumLines(),0),
+				lineNumMovesVector(newMassTransit.getNumLines(),0),
+				trainDelayVector(newMassTransit.getNumTrains(),0),
+				trainNumMovesVector(newMassTransit.getNumTrains(),0),
+				trackBusyUsecs(0),
+				wallSecs(0.0),
+				hasStarted(false),
+				timetablePtr(NULL),
+				startUsecs(0),
+				tripVector(newMassTransit.getNumTrains(),0),
+				dueVector(newMassTransit.getNumTrains(),0),
+				readyVector(newMassTransit.getNumTrains(),0),
+				ownLateVector(newMassTransit.getNumTrains(),0),
+				lineNumDeparturesVector(newMassTransit.getNumLines(),0),
+				lineNumOnTimeVector(newMassTransit.getNumLines(),0),
+				lineLateUsecsVector(newMassTransit.getNumLines(),0),
+				lineMaxLateUsecsVector(newMassTransit.getNumLines(),0),
+				lineOwnLateUsecsVector(newMassTransit.getNumLines(),0),
+				lineKnockOnUsecsVector(newMassTransit.getNumLines(),0),
+				trackKnockOnUsecsVector(newMassTransit.getNumTracks(),0)
+{
+  //  I.  Application validity check:
+
+  //  II.  Initialize members:
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To schedule '*trainPtr' to attempt to leave its location
+//	'delay' microseconds from 'now'.  No return value.
+void		EventSimulator::schedule
+				(Train*		trainPtr,
+				 simTime_t	delay
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Schedule event:
+  SimEvent	event;
+
+  event.time	 = now + delay;
+  event.sequence = nextSequence++;
+  event.trainPtr = trainPtr;
+  eventQueue.push(event);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To schedule '*trainPtr' to attempt to leave where it just
+//	got to: after a random pause or, by a Timetable, once it has dwelt
+//	at a Station and its trip is due, or has run over a Track.  No
+//	return value.
+void		EventSimulator::scheduleStay
+				(Train*		trainPtr
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  line_t	line		= trainPtr->getLine();
+
+  if  ( (timetablePtr == NULL)  ||  (timetablePtr->getHeadwayUsecs(line) == 0) )
+  {
+    schedule(trainPtr,massTransit.getRandomPauseUsecs(*trainPtr));
+    return;
+  }
+
+  //  II.  Schedule by the Timetable:
+  uint		locIndex	= trainPtr->getLocPtr()->getIndex();
+  uint		numStations	= massTransit.getNumStations();
+  uint		id		= trainPtr->getIdentity();
+
+  //  II.A.  Run over a Track in the time it takes, having left the Station
+  //	     before it:
+  if  (locIndex >= numStations)
+  {
+    noteDeparture(trainPtr,locIndex - numStations);
+    schedule(trainPtr,timetablePtr->getRunUsecs(locIndex - numStations));
+    return;
+  }
+
+  //  II.B.  Dwell at a Station, making the same trip, which becomes the
+  //	     trip a round trip later on getting back to the north terminus:
+  direction_t	dir		= trainPtr->getDirection();
+  unsigned long long&
+		trip		= tripVector[id];
+  simTime_t	dueByArrival;
+
+  readyVector[id]	= now + TIMETABLE_DWELL_USECS
+			  + massTransit.getRandomPauseUsecs(*trainPtr);
+
+  if  (timetablePtr->getDepartureUsecs(line,locIndex,dir,trip)
+       <= startUsecs + dueVector[id]
+      )
+    trip	+= timetablePtr->getLineNumTrains(line);
+
+  //  II.C.  Hold until the trip is due, noting how much of any lateness
+  //	     comes from staying longer than due past getting here:
+  dueVector[id]		= timetablePtr->getDepartureUsecs(line,locIndex,dir,trip)
+			  - startUsecs;
+  dueByArrival		= std::max(dueVector[id],
+				   now + timetablePtr->getStayUsecs()
+				  );
+  ownLateVector[id]	= (readyVector[id] > dueByArrival)
+			  ? (readyVector[id] - dueByArrival)
+			  : 0;
+  schedule(trainPtr,std::max(dueVector[id],readyVector[id]) - now);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To move every Train that the Timetable runs to where its
+//	trip is due to be when the run starts, arriving in the order the
+//	Timetable has them get there, and to schedule when each is due to
+//	leave.  No return value.
+void		EventSimulator::placeByTimetable
+				()
+				throw()
+{
+  //  I.  Application validity check:
+  uint		numTrains	= massTransit.getNumTrains();
+  uint		numStations	= massTransit.getNumStations();
+
+  //  II.  Place Train instances:
+  //  II.A.  Find where each is due, the 'i'-th of each line making the trip
+  //	     'i' headways behind the latest, and take it off where it is:
+  std::vector<uint>		lineCountVector(massTransit.getNumLines(),0);
+  std::vector<const TimetableStop*>
+				stopPtrVector(numTrains,NULL);
+  std::vector<std::pair<long long,uint> >
+				arrivalVector;
+
+  for  (uint i = 0;  i < numTrains;  i++)
+  {
+    Train*	trainPtr	= massTransit.getTrainPtr(i);
+    line_t	line		= trainPtr->getLine();
+    uint	id		= trainPtr->getIdentity();
+    simTime_t	sinceUsecs;
+
+    if  (timetablePtr->getHeadwayUsecs(line) == 0)
+      continue;
+
+    stopPtrVector[id]	= &timetablePtr->getStartStop(line,
+						      lineCountVector[line]++,
+						      tripVector[id],
+						      sinceUsecs
+						     );
+    arrivalVector.push_back(std::make_pair(-(long long)sinceUsecs,i));
+
+    if  (trainPtr->getLocPtr() != NULL)
+      trainPtr->getLocPtr()->leave(trainPtr);
+  }
+
+  //  II.B.  Put each where it is due, the earliest to get there first, as
+  //	     a Station lets them leave in that order, heading the way its
+  //	     trip next takes it, until it is due to leave:
+  std::sort(arrivalVector.begin(),arrivalVector.end());
+
+  for  (size_t j = 0;  j < arrivalVector.size();  j++)
+  {
+    Train*		trainPtr	= massTransit.getTrainPtr(arrivalVector[j].second);
+    uint		id		= trainPtr->getIdentity();
+    const TimetableStop&
+			stop		= *stopPtrVector[id];
+    TrainLocation*	locPtr		= massTransit.getLocPtr(stop.locIndex);
+    simTime_t		untilUsecs	= stop.endUsecs - stop.startUsecs
+					  + (simTime_t)arrivalVector[j].first;
+
+    if  (trainPtr->getDirection() != stop.direction)
+      trainPtr->switchDiretion();
+
+    if  ( !locPtr->tryArrive(trainPtr) )
+    {
+      numTrackWaits++;
+      addWaiter(trainPtr,locPtr);
+      continue;
+    }
+
+    arrivalTimeVector[id]	= now;
+    dueVector[id]		= 0;
+    readyVector[id]		= now;
+    ownLateVector[id]		= 0;
+
+    if  (stop.locIndex < numStations)
+    {
+      if  (timetablePtr->getDepartureUsecs(trainPtr->getLine(),
+					   stop.locIndex,
+					   stop.direction,
+					   tripVector[id]
+					  )
+	   <= startUsecs
+	  )
+	tripVector[id]	+= timetablePtr->getLineNumTrains(trainPtr->getLine());
+
+      dueVector[id]	= now + untilUsecs;
+    }
+
+    schedule(trainPtr,untilUsecs);
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To note how late '*trainPtr' left its Station for Track
+//	'track', by the Timetable, and why.  No return value.
+void		EventSimulator::noteDeparture
+				(Train*		trainPtr,
+				 uint		track
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  uint		id		= trainPtr->getIdentity();
+  simTime_t	due		= dueVector[id];
+  simTime_t	ready		= readyVector[id];
+
+  //  II.  Note departure.  Lateness gained while able to leave is knock-on
+  //	   from waiting for other Train instances:
+  line_t	line		= trainPtr->getLine();
+  simTime_t	lateUsecs	= now - due;
+  simTime_t	knockOnUsecs	= now - std::max(due,ready);
+
+  lineNumDeparturesVector[line]++;
+  lineLateUsecsVector[line]	+= lateUsecs;
+  lineMaxLateUsecsVector[line]	= std::max(lineMaxLateUsecsVector[line],
+					   lateUsecs
+					  );
+  lineOwnLateUsecsVector[line]	+= ownLateVector[id];
+  lineKnockOnUsecsVector[line]	+= knockOnUsecs;
+  trackKnockOnUsecsVector[track]+= knockOnUsecs;
+
+  if  (lateUsecs <= TIMETABLE_ON_TIME_USECS)
+    lineNumOnTimeVector[line]++;
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To put '*trainPtr' onto '*locPtr' if it has room, and to
+//	schedule its next departure attempt.  Returns 'true' on success or
+//	'false' if '*trainPtr' must wait for '*locPtr'.
+bool		EventSimulator::tryToPlace
+				(Train*		trainPtr,
+				 TrainLocation*	locPtr
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Attempt to place '*trainPtr':
+  if  ( !locPtr->tryArrive(trainPtr) )
+    return(false);
+
+  numMoves++;
+  lineNumMovesVector[trainPtr->getLine()]++;
+  trainNumMovesVector[trainPtr->getIdentity()]++;
+  arrivalTimeVector[trainPtr->getIdentity()]	= now;
+  scheduleStay(trainPtr);
+
+  //  III.  Finished:
+  return(true);
+}
+
+
+//  PURPOSE:  To handle event 'event'.  No return value.
+void		EventSimulator::handle
+				(const SimEvent&	event
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  Train*		trainPtr	= event.trainPtr;
+  TrainLocation*	currentPtr	= trainPtr->getLocPtr();
+
+  if  (currentPtr == NULL)
+    return;
+
+  //  II.  Handle event:
+  //  II.A.  Wait for the Train ahead to leave if '*trainPtr' may not leave
+  //	     yet:
+  if  ( !currentPtr->canLeave(trainPtr) )
+  {
+    headWaiterSet.insert(trainPtr);
+    startWait(trainPtr);
+    return;
+  }
+
+  //  II.B.  Leave current location, let the Train behind, and the first
+  //	     express one if it may now leave ahead of it, go at once if
+  //	     ready, and let the longest-waiting Train instances whose class
+  //	     has its turn that fit (if any) onto it:
+  TrainLocation*	nextPtr		= currentPtr->nextLocPtr(trainPtr);
+
+  if  (currentPtr->getIndex() >= massTransit.getNumStations())
+    trackBusyUsecs	+= now - arrivalTimeVector[trainPtr->getIdentity()];
+
+  currentPtr->leave(trainPtr);
+
+  Train*		firstPtr	= currentPtr->getFirstTrain();
+  Train*		expressPtr	= currentPtr->getFirstExpressTrain();
+
+  if  ( (firstPtr != NULL)  &&  (headWaiterSet.erase(firstPtr) > 0) )
+  {
+    endWait(firstPtr);
+    schedule(firstPtr,0);
+  }
+
+  if  ( (expressPtr != NULL)				&&
+	currentPtr->canLeave(expressPtr)		&&
+	(headWaiterSet.erase(expressPtr) > 0)
+      )
+  {
+    endWait(expressPtr);
+    schedule(expressPtr,0);
+  }
+
+  std::map<TrainLocation*,std::list<Train*> >::iterator
+			iter		= waiterMap.find(currentPtr);
+
+  if  (iter != waiterMap.end())
+  {
+    //  Several may get onto a block-signalled Track once the last Train
+    //  heading the other way leaves it:
+    while  ( !iter->second.empty() )
+    {
+      std::list<Train*>::iterator
+			waiterIter	= currentPtr->pickWaiter(iter->second);
+
+      if  ( !tryToPlace(*waiterIter,currentPtr) )
+	break;
+
+      currentPtr->noteWaiting(*waiterIter,false);
+      endWait(*waiterIter);
+      iter->second.erase(waiterIter);
+    }
+  }
+
+  //  II.C.  Arrive at next location, or wait for it:
+  if  ( !tryToPlace(trainPtr,nextPtr) )
+  {
+    numTrackWaits++;
+    addWaiter(trainPtr,nextPtr);
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To make Train instances run by '*newTimetablePtr' from now
+//	on, or pause at random if it is 'NULL'.  No return value.
+void		EventSimulator::setTimetablePtr
+				(const Timetable*	newTimetablePtr
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Set timetable, with no trip given yet:
+  timetablePtr	= newTimetablePtr;
+  startUsecs	= (timetablePtr == NULL) ? 0 : (timetablePtr->getStartUsecs() - now);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To resume the run held by 'checkpoint', which must have
+//	been written for a MassTransit system of the same topology, fleet
+//	and Track instances and seed as that of '*this', before it has
+//	started.  The random number streams go on from where they were,
+//	drawing as they would have if 'seed' is the one the checkpointed
+//	run drew from, or else drawing from 'seed' instead.  No return
+//	value.
+void		EventSimulator::restore
+				(const Checkpoint&	checkpoint,
+				 uint			seed
+				)
+				throw(const char*)
+{
+  //  I.  Application validity check:
+  const CheckpointHeader&	header		= checkpoint.getHeader();
+  const CheckpointTrain*	trainArray	= checkpoint.getTrainArray();
+  const CheckpointLine*		lineArray	= checkpoint.getLineArray();
+  const CheckpointLocation*	locationArray	= checkpoint.getLocationArray();
+  const CheckpointEvent*	eventArray	= checkpoint.getEventArray();
+  const uint*			idArray		= checkpoint.getIdArray();
+  uint		numTrains	= massTransit.getNumTrains();
+  uint		numLines	= massTransit.getNumLines();
+  uint		numLocations	= massTransit.getNumLocations();
+
+  if  (hasStarted  ||  (timetablePtr != NULL))
+    throw "Only a run that has not started, without a timetable, may be "
+	  "restored";
+
+  if  ( (header.numStations	!= massTransit.getNumStations())	||
+	(header.numTracks	!= massTransit.getNumTracks())		||
+	(header.numLines	!= numLines)				||
+	(header.numTrains	!= numTrains)				||
+	(header.trackCapacity	!= massTransit.getTrackCapacity())	||
+	(header.seed		!= massTransit.getSeed())		||
+	(header.expressPercent	!= massTransit.getExpressPercent())	||
+	((header.isBlockSignalled != 0)
+	 != massTransit.getIsBlockSignalled()
+	)
+      )
+    throw "Checkpoint was written for a different MassTransit system";
+
+  for  (uint i = 0;  i < numLocations;  i++)
+  {
+    const CheckpointLocation&	location	= locationArray[i];
+
+    if  ( (unsigned long long)location.firstId + location.numTrains
+	  + location.numWaiters > header.numIds
+	)
+      throw "Checkpoint is corrupt";
+
+    for  (uint j = 0;  j < location.numTrains + location.numWaiters;  j++)
+      if  (idArray[location.firstId + j] >= numTrains)
+	throw "Checkpoint is corrupt";
+  }
+
+  for  (uint i = 0;  i < header.numPendingEvents;  i++)
+    if  (eventArray[i].trainId >= numTrains)
+      throw "Checkpoint is corrupt";
+
+  for  (uint i = 0;  i < numTrains;  i++)
+    if  ( (trainArray[i].direction >= NUM_DIRECTIONS)  ||
+	  (trainArray[i].line != massTransit.getTrainPtr(i)->getLine())
+	)
+      throw "Checkpoint is corrupt";
+
+  //  II.  Restore run:
+  //  II.A.  Take each Train off wherever it is:
+  for  (uint i = 0;  i < numTrains;  i++)
+  {
+    Train*	trainPtr	= massTransit.getTrainPtr(i);
+
+    if  (trainPtr->getLocPtr() != NULL)
+      trainPtr->getLocPtr()->leave(trainPtr);
+  }
+
+  //  II.B.  Put them back where they were, first one first and heading
+  //	     as they did, and line up those waiting for room in the order
+  //	     they began to:
+  for  (uint i = 0;  i < numLocations;  i++)
+  {
+    const CheckpointLocation&	location	= locationArray[i];
+    TrainLocation*		locPtr		= massTransit.getLocPtr(i);
+
+    for  (uint j = 0;  j < location.numTrains;  j++)
+    {
+      Train*	trainPtr = massTransit.getTrainPtr(idArray[location.firstId + j]);
+
+      if  (trainPtr->getDirection()
+	   != (direction_t)trainArray[trainPtr->getIdentity()].direction
+	  )
+	trainPtr->switchDiretion();
+
+      if  ( (trainPtr->getLocPtr() != NULL)  ||  !locPtr->tryArrive(trainPtr) )
+	throw "Checkpoint is corrupt";
+    }
+
+    for  (uint j = 0;  j < location.numWaiters;  j++)
+    {
+      Train*	trainPtr = massTransit.getTrainPtr
+			     (idArray[location.firstId + location.numTrains + j]);
+
+      locPtr->noteWaiting(trainPtr,true);
+      waiterMap[locPtr].push_back(trainPtr);
+    }
+
+    if  (i >= massTransit.getNumStations())
+      massTransit.getTrackPtr(i - massTransit.getNumStations())
+		 ->setNumExpressPasses(location.numExpressPasses);
+  }
+
+  //  II.C.  Restore each Train, and check it is where it was:
+  for  (uint i = 0;  i < numTrains;  i++)
+  {
+    Train*			trainPtr	= massTransit.getTrainPtr(i);
+    const CheckpointTrain&	train		= trainArray[i];
+    uint			locIndex	= (trainPtr->getLocPtr() == NULL)
+						  ? ~0U
+						  : trainPtr->getLocPtr()->getIndex();
+
+    if  (locIndex != train.locIndex)
+      throw "Checkpoint is corrupt";
+
+    if  (trainPtr->getDirection() != (direction_t)train.direction)
+      trainPtr->switchDiretion();
+
+    trainPtr->getRandom().setCounter(train.randomCounter);
+
+    if  (seed != header.seed)
+      trainPtr->getRandom().reseed(seed,i + 1);
+
+    arrivalTimeVector[i]	= train.arrivalTime;
+    waitStartVector[i]		= train.waitStart;
+    trainDelayVector[i]		= train.delayUsecs;
+    trainNumMovesVector[i]	= train.numMoves;
+
+    if  (train.isHeadWaiter != 0)
+      headWaiterSet.insert(trainPtr);
+  }
+
+  //  II.D.  Restore the pending events and the counts so far:
+  for  (uint i = 0;  i < header.numPendingEvents;  i++)
+  {
+    SimEvent	event;
+
+    event.time		= eventArray[i].time;
+    event.sequence	= eventArray[i].sequence;
+    event.trainPtr	= massTransit.getTrainPtr(eventArray[i].trainId);
+    eventQueue.push(event);
+  }
+
+  for  (line_t line = 0;  line < numLines;  line++)
+  {
+    lineDelayVector[line]	= lineArray[line].delayUsecs;
+    lineNumMovesVector[line]	= lineArray[line].numMoves;
+  }
+
+  now		= header.now;
+  nextSequence	= header.nextSequence;
+  numEvents	= header.numEvents;
+  numMoves	= header.numMoves;
+  numTrackWaits	= header.numTrackWaits;
+  trackBusyUsecs= header.trackBusyUsecs;
+  hasStarted	= true;
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To run the simulation for 'numSecs' more seconds of virtual
+//	time, leaving each Train where it is.  No return value.
+void		EventSimulator::advance
+				(uint		numSecs
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Run simulation:
+  //  II.A.  Give each Train its initial pause, as 'simulateTrain()' does,
+  //	     or put it where the Timetable has it be, unless it has started:
+  unsigned long long	startNsecs	= getMonotonicNsecs();
+  simTime_t		endTime		= now + (simTime_t)numSecs * USECS_PER_SEC;
+  uint			numTrains	= massTransit.getNumTrains();
+
+  if  ( !hasStarted )
+  {
+    if  (timetablePtr != NULL)
+      placeByTimetable();
+
+    for  (uint i = 0;  i < numTrains;  i++)
+      if  ( (timetablePtr == NULL)  ||
+	    (timetablePtr->getHeadwayUsecs(massTransit.getTrainPtr(i)->getLine())
+	     == 0
+	    )
+	  )
+	scheduleStay(massTransit.getTrainPtr(i));
+
+    hasStarted	= true;
+  }
+
+  //  II.B.  Process events in time order until 'endTime':
+  while  ( !eventQueue.empty()  &&  (eventQueue.top().time <= endTime) )
+  {
+    SimEvent	event	= eventQueue.top();
+
+    eventQueue.pop();
+    now	= event.time;
+    numEvents++;
+    handle(event);
+  }
+
+  now		= endTime;
+  wallSecs	+= (double)(getMonotonicNsecs() - startNsecs) / NSECS_PER_SEC;
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To end the run, counting the waits and Track stays still
+//	going on, after which each Train leaves wherever it is.  No
+//	parameters.  No return value.
+void		EventSimulator::finish
+				()
+				throw()
+{
+  //  I.  Application validity check:
+  uint		numTrains	= massTransit.getNumTrains();
+
+  //  II.  End run:
+  //  II.A.  Count the waits and Track stays still going on at the end:
+  for  (std::set<Train*>::iterator iter = headWaiterSet.begin();
+	iter != headWaiterSet.end();
+	iter++
+       )
+    endWait(*iter);
+
+  for  (std::map<TrainLocation*,std::list<Train*> >::iterator
+	  iter = waiterMap.begin();
+	iter != waiterMap.end();
+	iter++
+       )
+    for  (std::list<Train*>::iterator waiterIter = iter->second.begin();
+	  waiterIter != iter->second.end();
+	  waiterIter++
+	 )
+    {
+      endWait(*waiterIter);
+      iter->first->noteWaiting(*waiterIter,false);
+    }
+
+  //  II.B.  Take each Train off of the system:
+  for  (uint i = 0;  i < numTrains;  i++)
+  {
+    Train*		trainPtr	= massTransit.getTrainPtr(i);
+    TrainLocation*	locPtr		= trainPtr->getLocPtr();
+
+    if  (locPtr == NULL)
+      continue;
+
+    if  (locPtr->getIndex() >= massTransit.getNumStations())
+      trackBusyUsecs	+= now - arrivalTimeVector[trainPtr->getIdentity()];
+
+    locPtr->leave(trainPtr);
+  }
+
+  waiterMap.clear();
+  headWaiterSet.clear();
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To write to file 'pathCPtr' a checkpoint image of the run
+//	so far, from which 'restore()' may resume it.  Runs by a Timetable
+//	cannot be checkpointed.  Returns the length of the image in bytes.
+size_t		EventSimulator::writeCheckpoint
+				(const char*	pathCPtr
+				)
+				const
+				throw(const char*)
+{
+  //  I.  Application validity check:
+  if  (timetablePtr != NULL)
+    throw "Runs by a timetable cannot be checkpointed";
+
+  //  II.  Write checkpoint:
+  //  II.A.  Gather the records:
+  uint		numTrains	= massTransit.getNumTrains();
+  uint		numLines	= massTransit.getNumLines();
+  uint		numLocations	= massTransit.getNumLocations();
+  std::vector<CheckpointTrain>	trainVector(numTrains);
+  std::vector<CheckpointLine>	lineVector(numLines);
+  std::vector<CheckpointLocation>
+				locationVector(numLocations);
+  std::vector<CheckpointEvent>	eventVector;
+  std::vector<uint>		idVector;
+  std::vector<Train*>		trainPtrVector;
+
+  for  (uint i = 0;  i < numTrains;  i++)
+  {
+    Train*		trainPtr	= massTransit.getTrainPtr(i);
+    CheckpointTrain&	train		= trainVector[i];
+
+    memset(&train,0,sizeof(train));
+    train.randomCounter	= trainPtr->getRandom().getCounter();
+    train.arrivalTime	= arrivalTimeVector[i];
+    train.waitStart	= waitStartVector[i];
+    train.delayUsecs	= trainDelayVector[i];
+    train.numMoves	= trainNumMovesVector[i];
+    train.locIndex	= (trainPtr->getLocPtr() == NULL)
+			  ? ~0U
+			  : trainPtr->getLocPtr()->getIndex();
+    train.direction	= trainPtr->getDirection();
+    train.isHeadWaiter	= headWaiterSet.count(trainPtr);
+    train.line		= trainPtr->getLine();
+  }
+
+  for  (line_t line = 0;  line < numLines;  line++)
+  {
+    lineVector[line].delayUsecs	= lineDelayVector[line];
+    lineVector[line].numMoves	= lineNumMovesVector[line];
+  }
+
+  for  (uint i = 0;  i < numLocations;  i++)
+  {
+    TrainLocation*	locPtr		= massTransit.getLocPtr(i);
+    CheckpointLocation&	location	= locationVector[i];
+    std::map<TrainLocation*,std::list<Train*> >::const_iterator
+			iter		= waiterMap.find(locPtr);
+
+    memset(&location,0,sizeof(location));
+    location.firstId	= idVector.size();
+    locPtr->copyTrains(trainPtrVector);
+
+    for  (size_t j = 0;  j < trainPtrVector.size();  j++)
+      idVector.push_back(trainPtrVector[j]->getIdentity());
+
+    location.numTrains	= trainPtrVector.size();
+
+    if  (i >= massTransit.getNumStations())
+      location.numExpressPasses
+		= massTransit.getTrackPtr(i - massTransit.getNumStations())
+			     ->getNumExpressPasses();
+
+    if  (iter == waiterMap.end())
+      continue;
+
+    for  (std::list<Train*>::const_iterator waiterIter = iter->second.begin();
+	  waiterIter != iter->second.end();
+	  waiterIter++
+	 )
+      idVector.push_back((*waiterIter)->getIdentity());
+
+    location.numWaiters	= iter->second.size();
+  }
+
+  std::priority_queue<SimEvent,std::vector<SimEvent>,std::greater<SimEvent> >
+		queue(eventQueue);
+
+  for  ( ;  !queue.empty();  queue.pop())
+  {
+    CheckpointEvent	event;
+
+    memset(&event,0,sizeof(event));
+    event.time		= queue.top().time;
+    event.sequence	= queue.top().sequence;
+    event.trainId	= queue.top().trainPtr->getIdentity();
+    eventVector.push_back(event);
+  }
+
+  //  II.B.  Lay the header and the records out in an image, each array
+  //	     starting on an 8-byte boundary:
+  CheckpointHeader	header;
+
+  memset(&header,0,sizeof(header));
+  memcpy(header.magic,CHECKPOINT_MAGIC,sizeof(header.magic));
+  header.version		= CHECKPOINT_VERSION;
+  header.seed			= massTransit.getSeed();
+  header.numTrains		= numTrains;
+  header.trackCapacity		= massTransit.getTrackCapacity();
+  header.isFairAdmission	= massTransit.getIsFairAdmission();
+  header.isBlockSignalled	= massTransit.getIsBlockSignalled();
+  header.maxPauseUsecs		= massTransit.getMaxPauseUsecs();
+  header.expressPercent		= massTransit.getExpressPercent();
+  header.numStations		= massTransit.getNumStations();
+  header.numTracks		= massTransit.getNumTracks();
+  header.numLines		= numLines;
+  header.numPendingEvents	= eventVector.size();
+  header.numIds			= idVector.size();
+  header.now			= now;
+  header.nextSequence		= nextSequence;
+  header.numEvents		= numEvents;
+  header.numMoves		= numMoves;
+  header.numTrackWaits		= numTrackWaits;
+  header.trackBusyUsecs		= trackBusyUsecs;
+  header.trainOffset		= sizeof(CheckpointHeader);
+  header.lineOffset		= header.trainOffset
+				  + numTrains * sizeof(CheckpointTrain);
+  header.locationOffset		= header.lineOffset
+				  + numLines * sizeof(CheckpointLine);
+  header.eventOffset		= header.locationOffset
+				  + numLocations * sizeof(CheckpointLocation);
+  header.idOffset		= header.eventOffset
+				  + eventVector.size() * sizeof(CheckpointEvent);
+  header.numBytes		= (header.idOffset
+				   + idVector.size() * sizeof(uint)
+				   + sizeof(unsigned long long) - 1
+				  )
+				  / sizeof(unsigned long long)
+				  * sizeof(unsigned long long);
+
+  std::vector<unsigned long long>
+		imageVector(header.numBytes / sizeof(unsigned long long),0);
+  char*		imageCPtr	= (char*)&imageVector[0];
+
+  memcpy(imageCPtr,&header,sizeof(header));
+  memcpy(imageCPtr + header.trainOffset,&trainVector[0],
+	 numTrains * sizeof(CheckpointTrain)
+	);
+  memcpy(imageCPtr + header.lineOffset,&lineVector[0],
+	 numLines * sizeof(CheckpointLine)
+	);
+  memcpy(imageCPtr + header.locationOffset,&locationVector[0],
+	 numLocations * sizeof(CheckpointLocation)
+	);
+
+  if  ( !eventVector.empty() )
+    memcpy(imageCPtr + header.eventOffset,&eventVector[0],
+	   eventVector.size() * sizeof(CheckpointEvent)
+	  );
+
+  if  ( !idVector.empty() )
+    memcpy(imageCPtr + header.idOffset,&idVector[0],
+	   idVector.size() * sizeof(uint)
+	  );
+
+  //  II.C.  Write the image:
+  Checkpoint::write(pathCPtr,imageCPtr,header.numBytes);
+
+  //  III.  Finished:
+  return(header.numBytes);
+}
+
+
+//  PURPOSE:  To print a summary of the run to 'filePtr'.  No return
+//	value.
+void		EventSimulator::printSummary
+				(FILE*		filePtr
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Print summary:
+  double	virtualSecs	= (double)now / USECS_PER_SEC;
+
+  fprintf(filePtr,
+	  "Simulated %.0f virtual secs in %.3f wall secs (%.0fx real time)\n"
+	  "%llu events, %llu train moves, %llu waits for a full track\n",
+	  virtualSecs,
+	  wallSecs,
+	  (wallSecs > 0.0) ? (virtualSecs / wallSecs) : 0.0,
+	  numEvents,
+	  numMoves,
+	  numTrackWaits
+	 );
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To print to 'filePtr' how punctual each line was by the
+//	Timetable, and how lateness spread from Train to Train and where.
+//	No return value.
+void		EventSimulator::printPunctuality
+				(FILE*		filePtr
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+  if  (timetablePtr == NULL)
+    return;
+
+  //  II.  Print punctuality:
+  //  II.A.  Print each line, and all of them:
+  uint		numLines	= massTransit.getNumLines();
+  simTime_t	ownUsecs	= 0;
+  simTime_t	knockOnUsecs	= 0;
+
+  fprintf(filePtr,
+	  "Punctuality, on time if under %.0f secs late:\n"
+	  "  %-8s %10s %8s %10s %10s %10s %10s\n",
+	  (double)TIMETABLE_ON_TIME_USECS / USECS_PER_SEC,
+	  "line","departures","on time","mean late","max late","own","knock-on"
+	 );
+
+  for  (line_t line = 0;  line <= numLines;  line++)
+  {
+    bool		isTotal		= (line == numLines);
+    unsigned long long	numDepartures	= 0;
+    unsigned long long	numOnTime	= 0;
+    simTime_t		lateUsecs	= 0;
+    simTime_t		maxLateUsecs	= 0;
+    simTime_t		lineOwnUsecs	= 0;
+    simTime_t		lineKnockOnUsecs= 0;
+
+    for  (line_t i = 0;  i < numLines;  i++)
+      if  ( isTotal  ||  (i == line) )
+      {
+	numDepartures	+= lineNumDeparturesVector[i];
+	numOnTime	+= lineNumOnTimeVector[i];
+	lateUsecs	+= lineLateUsecsVector[i];
+	maxLateUsecs	=  std::max(maxLateUsecs,lineMaxLateUsecsVector[i]);
+	lineOwnUsecs	+= lineOwnLateUsecsVector[i];
+	lineKnockOnUsecs+= lineKnockOnUsecsVector[i];
+      }
+
+    if  (isTotal)
+    {
+      ownUsecs		= lineOwnUsecs;
+      knockOnUsecs	= lineKnockOnUsecs;
+    }
+
+    fprintf(filePtr,"  %-8s %10llu %7.1f%% %10.1f %10.1f %10.0f %10.0f\n",
+	    isTotal ? "all" : massTransit.getLineNameCPtr(line),
+	    numDepartures,
+	    (numDepartures > 0) ? (100.0 * numOnTime / numDepartures) : 0.0,
+	    (numDepartures > 0)
+	    ? ((double)lateUsecs / numDepartures / USECS_PER_SEC)
+	    : 0.0,
+	    (double)maxLateUsecs / USECS_PER_SEC,
+	    (double)lineOwnUsecs / USECS_PER_SEC,
+	    (double)lineKnockOnUsecs / USECS_PER_SEC
+	   );
+  }
+
+  //  II.B.  Tell how much lateness Train instances caught from others per
+  //	     second they caused themselves, and where they caught it:
+  const char*	separatorCPtr	= "";
+
+  fprintf(filePtr,
+	  "Delay propagation: %.2f secs of knock-on per sec of own lateness;"
+	  " knock-on by Track entered:",
+	  (ownUsecs > 0) ? ((double)knockOnUsecs / ownUsecs) : 0.0
+	 );
+
+  for  (uint i = 0;  i < massTransit.getNumTracks();  i++)
+    if  (trackKnockOnUsecsVector[i] > 0)
+    {
+      fprintf(filePtr,"%s %s %.0f secs",
+	      separatorCPtr,
+	      massTransit.getTrackPtr(i)->getNameCPtr(),
+	      (double)trackKnockOnUsecsVector[i] / USECS_PER_SEC
+	     );
+      separatorCPtr	= ",";
+    }
+
+  if  (*separatorCPtr == '\0')
+    fprintf(filePtr," none");
+
+  fputc('\n',filePtr);
+
+  //  III.  Finished:
+}
@@ -0,0 +1,375 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		EventSimulator.h					---*
+ *---									---*
+ *---	    This file declares a class that runs a MassTransit system	---*
+ *---	in virtual time: instead of one sleeping pthread per Train, a	---*
+ *---	single thread pops timestamped events off a priority queue and	---*
+ *---	applies them with the same Station and Track methods that the	---*
+ *---	threaded simulation uses.					---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To represent one scheduled event: 'trainPtr' attempts to leave
+//	its current location at virtual time 'time'.
+struct	SimEvent
+{
+  //  PURPOSE:  To tell when the event happens.
+  simTime_t			time;
+
+  //  PURPOSE:  To break ties between events scheduled for the same 'time' so
+  //	that runs are repeatable.
+  unsigned long long		sequence;
+
+  //  PURPOSE:  To tell the Train instance to which the event happens.
+  Train*			trainPtr;
+
+  //  PURPOSE:  To return 'true' if '*this' happens after 'rhs', or 'false'
+  //	otherwise.  (Makes std::priority_queue pop the earliest event.)
+  bool		operator>	(const SimEvent&	rhs
+				)
+				const
+				throw()
+				{
+				  return( (time > rhs.time)  ||
+					  ( (time == rhs.time)  &&
+					    (sequence > rhs.sequence)
+					  )
+					);
+				}
+};
+
+
+class	EventSimulator
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To refer to the MassTransit system being simulated.
+  MassTransit&			massTransit;
+
+  //  PURPOSE:  To hold the pending events, earliest first.
+  std::priority_queue<SimEvent,std::vector<SimEvent>,std::greater<SimEvent> >
+				eventQueue;
+
+  //  PURPOSE:  To hold, for each full Track, the Train instances that have
+  //	left their Station and are waiting to get onto it.
+  std::map<TrainLocation*,std::list<Train*> >
+				waiterMap;
+
+  //  PURPOSE:  To hold the Train instances that are ready to leave their
+  //	Station but are not first there.  Each is scheduled when the Train
+  //	ahead of it leaves, rather than trying again after a pause.
+  std::set<Train*>		headWaiterSet;
+
+  //  PURPOSE:  To tell the current virtual time.
+  simTime_t			now;
+
+  //  PURPOSE:  To tell the sequence number to give the next event.
+  unsigned long long		nextSequence;
+
+  //  PURPOSE:  To count the events processed.
+  unsigned long long		numEvents;
+
+  //  PURPOSE:  To count the times a Train moved from one TrainLocation to
+  //	the next.
+  unsigned long long		numMoves;
+
+  //  PURPOSE:  To count the times a Train had to wait for a full Track.
+  unsigned long long		numTrackWaits;
+
+  //  PURPOSE:  To tell, for each Train, when it got to where it is, and
+  //	when it started waiting if it waits.
+  std::vector<simTime_t>	arrivalTimeVector;
+  std::vector<simTime_t>	waitStartVector;
+
+  //  PURPOSE:  To tell, for each line, the virtual microseconds that its
+  //	Train instances spent waiting for the Train ahead or for a full
+  //	Track, and the moves they made.
+  std::vector<simTime_t>	lineDelayVector;
+  std::vector<unsigned long long>
+				lineNumMovesVector;
+
+  //  PURPOSE:  To tell, for each Train, the virtual microseconds that it
+  //	spent waiting for the Train ahead or for a full Track, and the moves
+  //	it made.
+  std::vector<simTime_t>	trainDelayVector;
+  std::vector<unsigned long long>
+				trainNumMovesVector;
+
+  //  PURPOSE:  To tell the virtual microseconds that Train instances spent
+  //	on Track instances, summed over Train instances.
+  simTime_t			trackBusyUsecs;
+
+  //  PURPOSE:  To tell how many wall-clock seconds 'advance()' took.
+  double			wallSecs;
+
+  //  PURPOSE:  To tell whether each Train has been given its first event,
+  //	by 'advance()' or by 'restore()'.
+  bool				hasStarted;
+
+  //  PURPOSE:  To refer to the Timetable by which Train instances run, or
+  //	to be 'NULL' if each pauses at random instead.
+  const Timetable*		timetablePtr;
+
+  //  PURPOSE:  To tell how much later by the Timetable than virtual time
+  //	'0' the run started.
+  simTime_t			startUsecs;
+
+  //  PURPOSE:  To tell, for each Train, which trip of the Timetable it
+  //	makes.
+  std::vector<unsigned long long>
+				tripVector;
+
+  //  PURPOSE:  To tell, for each Train given a trip, when the Timetable
+  //	has it leave its Station, when its stay there is over, and how much
+  //	later than due it was over because it stayed too long.
+  std::vector<simTime_t>	dueVector;
+  std::vector<simTime_t>	readyVector;
+  std::vector<simTime_t>	ownLateVector;
+
+  //  PURPOSE:  To tell, for each line, how many of its Train instances left
+  //	a Station by the Timetable, how many on time, by how many
+  //	virtual microseconds late in all and at most, and how much of that
+  //	lateness each gained by staying longer than due itself and by
+  //	waiting for other Train instances.
+  std::vector<unsigned long long>
+				lineNumDeparturesVector;
+  std::vector<unsigned long long>
+				lineNumOnTimeVector;
+  std::vector<simTime_t>	lineLateUsecsVector;
+  std::vector<simTime_t>	lineMaxLateUsecsVector;
+  std::vector<simTime_t>	lineOwnLateUsecsVector;
+  std::vector<simTime_t>	lineKnockOnUsecsVector;
+
+  //  PURPOSE:  To tell, for each Track, how many virtual microseconds Train
+  //	instances spent waiting on other Train instances to get onto it.
+  std::vector<simTime_t>	trackKnockOnUsecsVector;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  EventSimulator		();
+
+  //  No copy constructor:
+  EventSimulator		(const EventSimulator&);
+
+  //  No copy assignment op:
+  EventSimulator&		operator=
+				(const EventSimulator&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To schedule '*trainPtr' to attempt to leave its location
+  //	'delay' microseconds from 'now'.  No return value.
+  void		schedule	(Train*		trainPtr,
+				 simTime_t	delay
+				)
+				throw();
+
+  //  PURPOSE:  To schedule '*trainPtr' to attempt to leave where it just
+  //	got to: after a random pause or, by a Timetable, once it has dwelt
+  //	at a Station and its trip is due, or has run over a Track.  No
+  //	return value.
+  void		scheduleStay	(Train*		trainPtr
+				)
+				throw();
+
+  //  PURPOSE:  To move every Train that the Timetable runs to where its
+  //	trip is due to be when the run starts, arriving in the order the
+  //	Timetable has them get there, and to schedule when each is due to
+  //	leave.  No return value.
+  void		placeByTimetable()
+				throw();
+
+  //  PURPOSE:  To note how late '*trainPtr' left its Station for Track
+  //	'track', by the Timetable, and why.  No return value.
+  void		noteDeparture	(Train*		trainPtr,
+				 uint		track
+				)
+				throw();
+
+  //  PURPOSE:  To put '*trainPtr' onto '*locPtr' if it has room, and to
+  //	schedule its next departure attempt.  Returns 'true' on success or
+  //	'false' if '*trainPtr' must wait for '*locPtr'.
+  bool		tryToPlace	(Train*		trainPtr,
+				 TrainLocation*	locPtr
+				)
+				throw();
+
+  //  PURPOSE:  To note that '*trainPtr' starts waiting.  No return value.
+  void		startWait	(Train*		trainPtr
+				)
+				throw()
+				{ waitStartVector[trainPtr->getIdentity()] = now; }
+
+  //  PURPOSE:  To note that '*trainPtr' stops waiting.  No return value.
+  void		endWait		(Train*		trainPtr
+				)
+				throw()
+  {
+    simTime_t	delayUsecs	= now - waitStartVector[trainPtr->getIdentity()];
+
+    lineDelayVector[trainPtr->getLine()]	+= delayUsecs;
+    trainDelayVector[trainPtr->getIdentity()]	+= delayUsecs;
+  }
+
+  //  PURPOSE:  To make '*trainPtr' wait for room on '*locPtr', longest-
+  //	waiting last.  No return value.
+  void		addWaiter	(Train*		trainPtr,
+				 TrainLocation*	locPtr
+				)
+				throw()
+  {
+    startWait(trainPtr);
+    locPtr->noteWaiting(trainPtr,true);
+    waiterMap[locPtr].push_back(trainPtr);
+  }
+
+  //  PURPOSE:  To handle event 'event'.  No return value.
+  void		handle		(const SimEvent&	event
+				)
+				throw();
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to simulate 'newMassTransit', whose
+  //	Train instances must already be placed and whose pthreads must not
+  //	have been started.  No return value.
+  EventSimulator		(MassTransit&	newMassTransit
+				)
+				throw();
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~EventSimulator		()
+				throw()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the current virtual time.  No parameters.
+  simTime_t	getNow		()
+				const
+				throw()
+				{ return(now); }
+
+  //  PURPOSE:  To return the number of Train moves so far.  No parameters.
+  unsigned long long
+		getNumMoves	()
+				const
+				throw()
+				{ return(numMoves); }
+
+  //  PURPOSE:  To return the number of moves made by the Train instances of
+  //	line 'line'.
+  unsigned long long
+		getLineNumMoves	(line_t		line
+				)
+				const
+				throw()
+				{ return(lineNumMovesVector[line]); }
+
+  //  PURPOSE:  To return the virtual microseconds that the Train instances
+  //	of line 'line' spent waiting to leave a Station or to get onto a
+  //	Track.
+  simTime_t	getLineDelayUsecs
+				(line_t		line
+				)
+				const
+				throw()
+				{ return(lineDelayVector[line]); }
+
+  //  PURPOSE:  To return the moves made by the Train with id 'id'.
+  unsigned long long
+		getTrainNumMoves(uint		id
+				)
+				const
+				throw()
+				{ return(trainNumMovesVector[id]); }
+
+  //  PURPOSE:  To return the virtual microseconds that the Train with id
+  //	'id' spent waiting to leave a Station or to get onto a Track.
+  simTime_t	getTrainDelayUsecs
+				(uint		id
+				)
+				const
+				throw()
+				{ return(trainDelayVector[id]); }
+
+  //  PURPOSE:  To return the fraction of the room on all Track instances
+  //	that was taken, averaged over the run.  No parameters.
+  double	getTrackUtilization
+				()
+				const
+				throw()
+  {
+    double	room	= (double)massTransit.getNumTracks()	*
+			  massTransit.getTrackCapacity()	*
+			  now;
+
+    return( (room > 0.0) ? (trackBusyUsecs / room) : 0.0 );
+  }
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To make Train instances run by '*newTimetablePtr' from now
+  //	on, or pause at random if it is 'NULL'.  No return value.
+  void		setTimetablePtr	(const Timetable*	newTimetablePtr
+				)
+				throw();
+
+  //  PURPOSE:  To resume the run held by 'checkpoint', which must have
+  //	been written for a MassTransit system of the same topology, fleet
+  //	and Track instances and seed as that of '*this', before it has
+  //	started.  The random number streams go on from where they were,
+  //	drawing as they would have if 'seed' is the one the checkpointed
+  //	run drew from, or else drawing from 'seed' instead.  No return
+  //	value.
+  void		restore		(const Checkpoint&	checkpoint,
+				 uint			seed
+				)
+				throw(const char*);
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To run the simulation for 'numSecs' more seconds of virtual
+  //	time, leaving each Train where it is.  No return value.
+  void		advance		(uint		numSecs
+				)
+				throw();
+
+  //  PURPOSE:  To end the run, counting the waits and Track stays still
+  //	going on, after which each Train leaves wherever it is.  No
+  //	parameters.  No return value.
+  void		finish		()
+				throw();
+
+  //  PURPOSE:  To run the simulation for 'numSecs' seconds of virtual time,
+  //	after which each Train leaves wherever it is.  No return value.
+  void		run		(uint		numSecs
+				)
+				throw()
+				{ advance(numSecs);  finish(); }
+
+  //  PURPOSE:  To write to file 'pathCPtr' a checkpoint image of the run
+  //	so far, from which 'restore()' may resume it.  Runs by a Timetable
+  //	cannot be checkpointed.  Returns the length of the image in bytes.
+  size_t	writeCheckpoint	(const char*	pathCPtr
+				)
+				const
+				throw(const char*);
+
+  //  PURPOSE:  To print a summary of the run to 'filePtr'.  No return
+  //	value.
+  void		printSummary	(FILE*		filePtr
+				)
+				const
+				throw();
+
+  //  PURPOSE:  To print to 'filePtr' how punctual each line was by the
+  //	Timetable, and how lateness spread from Train to Train and where.
+  //	No return value.
+  void		printPunctuality(FILE*		filePtr
+				)
+				const
+				throw();
+
+};
@@ -0,0 +1,436 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		InvariantChecker.cpp					---*
+ *---									---*
+ *---	    This file defines a class that checks, from its own	---*
+ *---	pthread while the Train threads run, that a MassTransit system	---*
+ *---	stays safe, within a budget of CPU time.			---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To return the CPU time used so far by the calling pthread, in
+//	nanoseconds.  No parameters.
+static
+unsigned long long
+		getThreadCpuNsecs
+				()
+{
+  struct timespec	now;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID,&now);
+  return( (unsigned long long)now.tv_sec * NSECS_PER_SEC + now.tv_nsec );
+}
+
+
+//  PURPOSE:  To initialize '*this' to check 'newMassTransit' once started,
+//	using at most 'newCpuBudget' of one CPU.  No return value.
+InvariantChecker::InvariantChecker
+				(MassTransit&	newMassTransit,
+				 double		newCpuBudget
+				)
+				throw(const char*) :
+				massTransit(newMassTransit),
+				cpuBudget(newCpuBudget),
+				snapshot(),
+				locOfTrainVector(newMassTransit.getNumTrains()),
+				missingSinceNsecsVector
+					(newMassTransit.getNumTrains(),0),
+				isTrainReportedVector
+					(newMassTransit.getNumTrains(),false),
+				isTrackReportedVector
+					(newMassTransit.getNumTracks(),false),
+				reportVector(),
+				numViolations(0),
+				numChecks(0),
+				numTornSnapshots(0),
+				checkCpuNsecs(0),
+				startNsecs(0),
+				stopNsecs(0),
+				shouldContinue(false)
+{
+  //  I.  Application validity check:
+  if  ( (cpuBudget <= 0.0)  ||  (cpuBudget > 1.0) )
+    throw "The CPU budget of invariant checks must be above 0% and at most 100%";
+
+  //  II.  Initialize members:
+  pthread_condattr_t	attr;
+
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr,CLOCK_MONOTONIC);
+  pthread_mutex_init(&lock,NULL);
+  pthread_cond_init(&cond,&attr);
+  pthread_condattr_destroy(&attr);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To release resources.  No parameters.  No return value.
+InvariantChecker::~InvariantChecker
+				()
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Release resources:
+  stop();
+  pthread_cond_destroy(&cond);
+  pthread_mutex_destroy(&lock);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To be the function that the pthread runs: checks
+//	'*(InvariantChecker*)vPtr' until told to stop.  Returns 'NULL'.
+void*		InvariantChecker::run
+				(void*		vPtr
+				)
+{
+  //  I.  Application validity check:
+  InvariantChecker*	checkerPtr	= (InvariantChecker*)vPtr;
+
+  //  II.  Check, then sleep in proportion to the CPU time the check took:
+  //	A check that took 'c' nanoseconds followed by a sleep of
+  //	'c * (1/budget - 1)' uses exactly 'budget' of the CPU, however
+  //	long checks take on this system:
+  bool			isStopping	= false;
+
+  while  ( !isStopping )
+  {
+    unsigned long long	cpuNsecs	= getThreadCpuNsecs();
+
+    checkerPtr->check();
+    cpuNsecs			 = getThreadCpuNsecs() - cpuNsecs;
+    checkerPtr->checkCpuNsecs	+= cpuNsecs;
+
+    unsigned long long	sleepNsecs
+		= (unsigned long long)(cpuNsecs * (1.0/checkerPtr->cpuBudget - 1.0));
+
+    if  (sleepNsecs > MAX_INVARIANT_CHECK_PERIOD_NSECS)
+      sleepNsecs	= MAX_INVARIANT_CHECK_PERIOD_NSECS;
+
+    //  II.A.  Sleep, unless told to stop meanwhile:
+    struct timespec	deadline;
+    unsigned long long	wakeNsecs	= getMonotonicNsecs() + sleepNsecs;
+
+    deadline.tv_sec	= wakeNsecs / NSECS_PER_SEC;
+    deadline.tv_nsec	= wakeNsecs % NSECS_PER_SEC;
+
+    pthread_mutex_lock(&checkerPtr->lock);
+
+    while  ( checkerPtr->shouldContinue  &&
+	     (pthread_cond_timedwait(&checkerPtr->cond,
+				     &checkerPtr->lock,
+				     &deadline
+				    )
+	      == 0
+	     )
+	   );
+
+    isStopping	= !checkerPtr->shouldContinue;
+    pthread_mutex_unlock(&checkerPtr->lock);
+  }
+
+  //  III.  Finished:
+  return(NULL);
+}
+
+
+//  PURPOSE:  To note violation 'text' of Train instances 'trainPtrVector',
+//	with their recent arrivals and departures.  No return value.
+void		InvariantChecker::report
+				(const char*			text,
+				 const std::vector<Train*>&	trainPtrVector
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  numViolations++;
+
+  if  (reportVector.size() >= MAX_NUM_INVARIANT_REPORTS)
+    return;
+
+  //  II.  Note violation:
+  //  II.A.  Describe it:
+  char		line[2*MAX_STRING_LEN];
+  std::string	reportText;
+
+  snprintf(line,sizeof(line),"  at %.3f secs: %s\n",
+	   (double)(snapshot.getNsecs() - massTransit.getLogStartNsecs())
+	   / NSECS_PER_SEC,
+	   text
+	  );
+  reportText	= line;
+
+  //  II.B.  Merge the recent records of the Train instances involved, in the
+  //	     order they happened:
+  std::vector<LogRecord>	historyVector;
+  std::vector<LogRecord>	recordVector;
+
+  for  (size_t i = 0;  i < trainPtrVector.size();  i++)
+  {
+    trainPtrVector[i]->copyRecentRecords(recordVector);
+    historyVector.insert(historyVector.end(),
+			 recordVector.begin(),
+			 recordVector.end()
+			);
+  }
+
+  std::sort(historyVector.begin(),historyVector.end());
+
+  if  ( historyVector.empty() )
+    reportText	+= "    (no recent arrivals or departures)\n";
+
+  for  (size_t i = 0;  i < historyVector.size();  i++)
+  {
+    const LogRecord&	record	= historyVector[i];
+    Train*		trainPtr= massTransit.getTrainPtr(record.trainId);
+
+    snprintf(line,sizeof(line),"    %llu %.6f %s%u %s %s\n",
+	     record.sequence,
+	     (double)record.nsecs / NSECS_PER_SEC,
+	     massTransit.getLineNameCPtr(trainPtr->getLine()),
+	     record.trainId,
+	     (record.kind == LOG_ARRIVE) ? "arrived at" : "left",
+	     massTransit.getLocPtr(record.locIndex)->getNameCPtr()
+	    );
+    reportText	+= line;
+  }
+
+  reportVector.push_back(reportText);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To take a Snapshot and check every invariant on it.  No
+//	parameters.  No return value.
+void		InvariantChecker::check
+				()
+				throw()
+{
+  //  I.  Application validity check:
+  numChecks++;
+  snapshot.take(massTransit);
+
+  if  ( !snapshot.getIsConsistent() )
+  {
+    numTornSnapshots++;
+    return;
+  }
+
+  //  II.  Check invariants:
+  uint			numStations	= massTransit.getNumStations();
+  uint			numTrains	= massTransit.getNumTrains();
+  char			text[2*MAX_STRING_LEN];
+
+  //  II.A.  Check that no Track holds more Train instances than it allows,
+  //	     nor, if block-signalled, Train instances heading both ways:
+  for  (uint i = 0;  i < massTransit.getNumTracks();  i++)
+  {
+    const Track*		trackPtr	= massTransit.getTrackPtr(i);
+    const std::vector<Train*>&	trainPtrVector
+		= snapshot.getLocation(numStations + i).trainPtrVector;
+    bool			isOverfull
+		= (trainPtrVector.size() > trackPtr->getCapacity());
+    bool			isHeadOn	= false;
+
+    if  ( trackPtr->getIsBlockSignalled() )
+      for  (size_t j = 1;  j < trainPtrVector.size();  j++)
+	if  (trainPtrVector[j]->getDirection()
+	     != trainPtrVector[0]->getDirection()
+	    )
+	  isHeadOn	= true;
+
+    if  ( (isOverfull  ||  isHeadOn)  &&  !isTrackReportedVector[i] )
+    {
+      if  (isOverfull)
+	snprintf(text,sizeof(text),
+		 "%s holds %u Train instances but allows %u",
+		 trackPtr->getNameCPtr(),
+		 (uint)trainPtrVector.size(),
+		 trackPtr->getCapacity()
+		);
+      else
+	snprintf(text,sizeof(text),
+		 "%s holds Train instances heading both ways",
+		 trackPtr->getNameCPtr()
+		);
+
+      report(text,trainPtrVector);
+    }
+
+    isTrackReportedVector[i]	= isOverfull  ||  isHeadOn;
+  }
+
+  //  II.B.  Check that each Train is at one TrainLocation at most:
+  std::vector<bool>	isFaultyVector(numTrains,false);
+
+  std::fill(locOfTrainVector.begin(),locOfTrainVector.end(),~0U);
+
+  for  (uint i = 0;  i < massTransit.getNumLocations();  i++)
+  {
+    const std::vector<Train*>&	trainPtrVector
+				= snapshot.getLocation(i).trainPtrVector;
+
+    for  (size_t j = 0;  j < trainPtrVector.size();  j++)
+    {
+      Train*	trainPtr	= trainPtrVector[j];
+      uint	id		= trainPtr->getIdentity();
+
+      if  (locOfTrainVector[id] == ~0U)
+      {
+	locOfTrainVector[id]	= i;
+	continue;
+      }
+
+      isFaultyVector[id]	= true;
+
+      if  ( !isTrainReportedVector[id] )
+      {
+	snprintf(text,sizeof(text),"%s%u is at both %s and %s",
+		 massTransit.getLineNameCPtr(trainPtr->getLine()),
+		 id,
+		 massTransit.getLocPtr(locOfTrainVector[id])->getNameCPtr(),
+		 massTransit.getLocPtr(i)->getNameCPtr()
+		);
+	report(text,std::vector<Train*>(1,trainPtr));
+	isTrainReportedVector[id]	= true;
+      }
+    }
+  }
+
+  //  II.C.  Check that no Train stays at no TrainLocation for long.  Moving
+  //	     between two takes a moment, so only a long absence is lost:
+  unsigned long long	nowNsecs	= snapshot.getNsecs();
+
+  for  (uint id = 0;  id < numTrains;  id++)
+  {
+    if  (locOfTrainVector[id] != ~0U)
+    {
+      missingSinceNsecsVector[id]	= 0;
+
+      if  ( !isFaultyVector[id] )
+	isTrainReportedVector[id]	= false;
+
+      continue;
+    }
+
+    if  (missingSinceNsecsVector[id] == 0)
+      missingSinceNsecsVector[id]	= nowNsecs;
+    else
+    if  ( (nowNsecs - missingSinceNsecsVector[id] > INVARIANT_LOST_TRAIN_NSECS)
+	  &&  !isTrainReportedVector[id]
+	)
+    {
+      Train*	trainPtr	= massTransit.getTrainPtr(id);
+
+      snprintf(text,sizeof(text),"%s%u has been at no location for %.3f secs",
+	       massTransit.getLineNameCPtr(trainPtr->getLine()),
+	       id,
+	       (double)(nowNsecs - missingSinceNsecsVector[id]) / NSECS_PER_SEC
+	      );
+      report(text,std::vector<Train*>(1,trainPtr));
+      isTrainReportedVector[id]	= true;
+    }
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To start the pthread that checks.  No parameters.  No return
+//	value.
+void		InvariantChecker::start
+				()
+				throw(const char*)
+{
+  //  I.  Application validity check:
+  if  (shouldContinue)
+    throw "InvariantChecker::start() called twice";
+
+  //  II.  Start pthread:
+  shouldContinue	= true;
+  startNsecs		= getMonotonicNsecs();
+
+  if  (pthread_create(&threadId,NULL,run,(void*)this) != 0)
+  {
+    shouldContinue	= false;
+    throw "Could not create InvariantChecker pthread";
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To stop the pthread, and wait for it.  Must be called before
+//	the Train instances stop and leave the system.  No parameters.  No
+//	return value.
+void		InvariantChecker::stop
+				()
+				throw()
+{
+  //  I.  Application validity check:
+  pthread_mutex_lock(&lock);
+
+  if  ( !shouldContinue )
+  {
+    pthread_mutex_unlock(&lock);
+    return;
+  }
+
+  //  II.  Stop pthread:
+  shouldContinue	= false;
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&lock);
+  pthread_join(threadId,NULL);
+  stopNsecs		= getMonotonicNsecs();
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To print how the checks went, and every violation reported,
+//	to 'filePtr'.  No return value.
+void		InvariantChecker::printSummary
+				(FILE*		filePtr
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+  double	secs	= (stopNsecs > startNsecs)
+			  ? ((double)(stopNsecs - startNsecs) / NSECS_PER_SEC)
+			  : 0.0;
+
+  //  II.  Print summary:
+  fprintf(filePtr,
+	  "Invariant checks: %llu in %.1f secs (%.1f/sec, %llu torn snapshots "
+	  "skipped), %.2f%% of one CPU (budget %.2f%%): %llu violations\n",
+	  numChecks,
+	  secs,
+	  (secs > 0.0) ? (numChecks / secs) : 0.0,
+	  numTornSnapshots,
+	  (secs > 0.0) ? (100.0 * checkCpuNsecs / NSECS_PER_SEC / secs) : 0.0,
+	  100.0 * cpuBudget,
+	  numViolations
+	 );
+
+  for  (size_t i = 0;  i < reportVector.size();  i++)
+    fputs(reportVector[i].c_str(),filePtr);
+
+  if  (numViolations > reportVector.size())
+    fprintf(filePtr,"  and %llu more violations\n",
+	    numViolations - reportVector.size()
+	   );
+
+  //  III.  Finished:
+}
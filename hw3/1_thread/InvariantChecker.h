@@ -0,0 +1,158 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		InvariantChecker.h					---*
+ *---									---*
+ *---	    This file declares a class that checks, from its own	---*
+ *---	pthread while the Train threads run, that a MassTransit system	---*
+ *---	stays safe: no Track holds more Train instances than it		---*
+ *---	allows, no Train is at two places at once, and no Train stays	---*
+ *---	at no place for long.  It checks consistent Snapshot instances	---*
+ *---	and so never blocks a Train.  After each check it sleeps long	---*
+ *---	enough that its CPU time stays within a given fraction of one	---*
+ *---	CPU.  Each violation is reported with the recent arrivals and	---*
+ *---	departures of the Train instances involved.			---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+class	InvariantChecker
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To refer to the MassTransit system to check.
+  MassTransit&			massTransit;
+
+  //  PURPOSE:  To tell the fraction of one CPU that checking may use.
+  double			cpuBudget;
+
+  //  PURPOSE:  To hold the Snapshot of the current check.
+  Snapshot			snapshot;
+
+  //  PURPOSE:  To tell, for each Train, the index of the TrainLocation at
+  //	which the current check found it, or '~0U' if none.
+  std::vector<uint>		locOfTrainVector;
+
+  //  PURPOSE:  To tell, for each Train, since when on the monotonic clock in
+  //	nanoseconds the checks found it at no TrainLocation, or 0 if the
+  //	last check found it somewhere.
+  std::vector<unsigned long long>
+				missingSinceNsecsVector;
+
+  //  PURPOSE:  To tell, for each Train and for each Track, whether the
+  //	violation it is part of was already reported, so that a violation
+  //	is reported once however many checks find it.
+  std::vector<bool>		isTrainReportedVector;
+  std::vector<bool>		isTrackReportedVector;
+
+  //  PURPOSE:  To hold the first 'MAX_NUM_INVARIANT_REPORTS' reports, and
+  //	to count every violation.
+  std::vector<std::string>	reportVector;
+  unsigned long long		numViolations;
+
+  //  PURPOSE:  To count the checks, and the Snapshot instances too torn by
+  //	changes to check.
+  unsigned long long		numChecks;
+  unsigned long long		numTornSnapshots;
+
+  //  PURPOSE:  To tell the CPU time that checking took, and when 'start()'
+  //	and 'stop()' were called, on the monotonic clock, in nanoseconds.
+  unsigned long long		checkCpuNsecs;
+  unsigned long long		startNsecs;
+  unsigned long long		stopNsecs;
+
+  //  PURPOSE:  To hold 'true' while the pthread should keep checking, or
+  //	'false' otherwise.  Protected by 'lock'.
+  bool				shouldContinue;
+
+  //  PURPOSE:  To hold the pthread that checks.
+  pthread_t			threadId;
+
+  //  PURPOSE:  To protect 'shouldContinue' and to let 'stop()' wake the
+  //	pthread between checks.  'cond' uses the monotonic clock, as check
+  //	pacing is measured on it.
+  pthread_mutex_t		lock;
+  pthread_cond_t		cond;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  InvariantChecker		();
+
+  //  No copy constructor:
+  InvariantChecker		(const InvariantChecker&);
+
+  //  No copy assignment op:
+  InvariantChecker&		operator=
+				(const InvariantChecker&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To be the function that the pthread runs: checks
+  //	'*(InvariantChecker*)vPtr' until told to stop.  Returns 'NULL'.
+  static
+  void*		run		(void*		vPtr
+				);
+
+  //  PURPOSE:  To note violation 'text' of Train instances 'trainPtrVector',
+  //	with their recent arrivals and departures.  No return value.
+  void		report		(const char*			text,
+				 const std::vector<Train*>&	trainPtrVector
+				)
+				throw();
+
+  //  PURPOSE:  To take a Snapshot and check every invariant on it.  No
+  //	parameters.  No return value.
+  void		check		()
+				throw();
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to check 'newMassTransit' once started,
+  //	using at most 'newCpuBudget' of one CPU.  No return value.
+  InvariantChecker		(MassTransit&	newMassTransit,
+				 double		newCpuBudget
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~InvariantChecker		()
+				throw();
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of violations found.  No parameters.
+  unsigned long long
+		getNumViolations()
+				const
+				throw()
+				{ return(numViolations); }
+
+  //  PURPOSE:  To return the number of checks made.  No parameters.
+  unsigned long long
+		getNumChecks	()
+				const
+				throw()
+				{ return(numChecks); }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To start the pthread that checks.  No parameters.  No return
+  //	value.
+  void		start		()
+				throw(const char*);
+
+  //  PURPOSE:  To stop the pthread, and wait for it.  Must be called before
+  //	the Train instances stop and leave the system.  No parameters.  No
+  //	return value.
+  void		stop		()
+				throw();
+
+  //  PURPOSE:  To print how the checks went, and every violation reported,
+  //	to 'filePtr'.  No return value.
+  void		printSummary	(FILE*		filePtr
+				)
+				const
+				throw();
+
+};
@@ -0,0 +1,449 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		KinematicSimulator.cpp					---*
+ *---									---*
+ *---	    This file defines a class that runs a MassTransit system	---*
+ *---	in virtual time with Train instances that move continuously	---*
+ *---	along Track instances of given length and speed limit, kept	---*
+ *---	apart by their safe-braking distance.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To tell that a Train is on no lane but at a Station.
+static
+const uint	NO_LANE			= ~0U;
+
+//  PURPOSE:  To tell where the Train ahead of one that has none stands, in
+//	meters: farther than any lane is long.
+static
+const double	NO_LEADER_METERS	= 1e18;
+
+
+//  PURPOSE:  To initialize '*this' to simulate 'newMassTransit', whose
+//	Train instances must already be placed and whose pthreads must not
+//	have been started, with updates 'newTickMsecs' virtual milliseconds
+//	apart.  Each Train starts stopped at its Station, or at the Station
+//	behind it if it is on a Track.  No return value.
+KinematicSimulator::KinematicSimulator
+				(MassTransit&	newMassTransit,
+				 uint		newTickMsecs
+				)
+				throw(const char*) :
+				massTransit(newMassTransit),
+				numTrains(newMassTransit.getNumTrains()),
+				tickSecs((double)newTickMsecs / 1000.0),
+				posVector(numTrains+1,0.0),
+				speedVector(numTrains,0.0),
+				limitVector(numTrains,0.0),
+				maxSpeedVector(numTrains,0.0),
+				authorityVector(numTrains,0.0),
+				leaderVector(numTrains,numTrains),
+				laneVector(numTrains,NO_LANE),
+				stationVector(numTrains,0),
+				directionVector(numTrains,NORTH),
+				departureSecsVector(numTrains,0.0),
+				waitStartSecsVector(numTrains,-1.0),
+				laneQueueVector(newMassTransit.getNumTracks()
+						* NUM_DIRECTIONS
+					       ),
+				laneNumEntriesVector(laneQueueVector.size(),0),
+				laneFirstEntrySecsVector(laneQueueVector.size(),
+							 0.0
+							),
+				laneLastEntrySecsVector(laneQueueVector.size(),
+							0.0
+						       ),
+				laneMostTrainsVector(laneQueueVector.size(),0),
+				lineNumMovesVector(newMassTransit.getNumLines(),0),
+				now(0.0),
+				numTicks(0),
+				numMoves(0),
+				numEntryWaits(0),
+				entryWaitSecs(0.0),
+				minSpareMeters(NO_LEADER_METERS),
+				numSeparationViolations(0),
+				wallSecs(0.0),
+				kernelSecs(0.0)
+{
+  //  I.  Application validity check:
+  if  (newTickMsecs == 0)
+    throw "A KinematicSimulator needs a tick of at least 1 millisecond";
+
+  //  II.  Stop each Train at its Station, or at the one behind it if it is
+  //	   on a Track, ready to leave at once:
+  posVector[numTrains]	= NO_LEADER_METERS;
+
+  for  (uint i = 0;  i < numTrains;  i++)
+  {
+    Train*		trainPtr	= massTransit.getTrainPtr(i);
+    TrainLocation*	locPtr		= trainPtr->getLocPtr();
+    direction_t		direction	= trainPtr->getDirection();
+
+    if  (locPtr->getIndex() < massTransit.getNumStations())
+      stationVector[i]	= locPtr->getIndex();
+    else
+      stationVector[i]	= ((Track*)locPtr)->getTerminus
+				((direction == NORTH) ? SOUTH : NORTH)
+			  .getIndex();
+
+    if  (massTransit.getStationPtr(stationVector[i])
+		->getTrackPtr(trainPtr->getLine(),direction)
+	 == NULL
+	)
+      direction	= (direction == NORTH) ? SOUTH : NORTH;
+
+    directionVector[i]	= direction;
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To advance every Train one tick: first to find how far each
+//	may go, from where the Train ahead stood, then to move each as fast
+//	as its speed limit, its acceleration and the distance in which it can
+//	brake allow.  No parameters.  No return value.
+void		KinematicSimulator::updateKinematics
+				()
+				throw()
+{
+  //  I.  Application validity check:
+  const uint		n		= numTrains;
+  double* __restrict	posArray	= &posVector[0];
+  double* __restrict	speedArray	= &speedVector[0];
+  double* __restrict	authorityArray	= &authorityVector[0];
+  const double* __restrict
+			limitArray	= &limitVector[0];
+  const double* __restrict
+			maxSpeedArray	= &maxSpeedVector[0];
+  const uint* __restrict
+			leaderArray	= &leaderVector[0];
+  const double		dt		= tickSecs;
+  const double		brake		= KINEMATIC_BRAKE_MPS2;
+  const double		speedGain	= KINEMATIC_ACCEL_MPS2 * tickSecs;
+  const double		spacing		= KINEMATIC_TRAIN_LENGTH_METERS
+					  + KINEMATIC_STANDSTILL_GAP_METERS;
+
+  //  II.  Update Train instances:
+  //  II.A.  Let each go no farther than the end of its lane, nor than the
+  //	     place behind where the Train ahead stood.  A Train at a Station
+  //	     has a limit of 0 and so goes nowhere:
+  for  (uint i = 0;  i < n;  i++)
+    authorityArray[i]	= std::min(limitArray[i],
+				   posArray[leaderArray[i]] - spacing
+				  );
+
+  //  II.B.  Move each as fast as it may while still able to brake to a stop
+  //	     by its authority after this tick: the largest 'v' with
+  //	     'v*dt + v*v/(2*brake) <= room'.  The Train ahead only moves
+  //	     forward, so this holds whatever it does meanwhile:
+  for  (uint i = 0;  i < n;  i++)
+  {
+    double	pos		= posArray[i];
+    double	authority	= authorityArray[i];
+    double	room		= authority - pos;
+    double	safeSpeed;
+    double	speed		= speedArray[i] + speedGain;
+    double	nextPos;
+
+    room	= (room > 0.0) ? room : 0.0;
+    safeSpeed	= std::sqrt(brake*brake*dt*dt + 2.0*brake*room) - brake*dt;
+    speed	= (speed < maxSpeedArray[i]) ? speed : maxSpeedArray[i];
+    speed	= (speed < safeSpeed)	     ? speed : safeSpeed;
+    nextPos	= pos + speed*dt;
+    speedArray[i]	= speed;
+    posArray[i]		= (nextPos < authority) ? nextPos : authority;
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To have Train 'i' stop at Station 'station', heading
+//	'direction' unless it must turn back there.  No return value.
+void		KinematicSimulator::stopAt
+				(uint		i,
+				 uint		station,
+				 direction_t	direction
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  Train*	trainPtr	= massTransit.getTrainPtr(i);
+
+  //  II.  Stop:
+  if  (massTransit.getStationPtr(station)->getTrackPtr(trainPtr->getLine(),
+						       direction
+						      )
+       == NULL
+      )
+    direction	= (direction == NORTH) ? SOUTH : NORTH;
+
+  laneVector[i]		= NO_LANE;
+  stationVector[i]	= station;
+  directionVector[i]	= direction;
+  leaderVector[i]	= numTrains;
+  posVector[i]		= 0.0;
+  speedVector[i]	= 0.0;
+  limitVector[i]	= 0.0;
+  maxSpeedVector[i]	= 0.0;
+  departureSecsVector[i]= now + (double)massTransit.getRandomPauseUsecs(*trainPtr)
+				/ USECS_PER_SEC;
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To have Train 'i' leave its Station onto its next lane if that
+//	lane has room behind its last Train.  No return value.
+void		KinematicSimulator::tryToDepart
+				(uint		i
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  Train*	trainPtr	= massTransit.getTrainPtr(i);
+  Track*	trackPtr	= massTransit.getStationPtr(stationVector[i])
+				  ->getTrackPtr(trainPtr->getLine(),
+						directionVector[i]
+					       );
+  uint		lane		= (trackPtr->getIndex()
+				   - massTransit.getNumStations()
+				  )
+				  * NUM_DIRECTIONS + directionVector[i];
+  std::deque<uint>&
+		queue		= laneQueueVector[lane];
+
+  //  II.  Enter the lane, unless the last Train on it is not yet far
+  //	   enough along:
+  if  ( !queue.empty()  &&
+	( posVector[queue.back()]
+	  < KINEMATIC_TRAIN_LENGTH_METERS + KINEMATIC_STANDSTILL_GAP_METERS
+	)
+      )
+  {
+    if  (waitStartSecsVector[i] < 0.0)
+    {
+      waitStartSecsVector[i]	= now;
+      numEntryWaits++;
+    }
+
+    return;
+  }
+
+  if  (waitStartSecsVector[i] >= 0.0)
+  {
+    entryWaitSecs		+= now - waitStartSecsVector[i];
+    waitStartSecsVector[i]	= -1.0;
+  }
+
+  leaderVector[i]	= queue.empty() ? numTrains : queue.back();
+  queue.push_back(i);
+  laneVector[i]		= lane;
+  limitVector[i]	= trackPtr->getLengthMeters();
+  maxSpeedVector[i]	= trackPtr->getMaxSpeedMps();
+
+  if  (laneNumEntriesVector[lane]++ == 0)
+    laneFirstEntrySecsVector[lane]	= now;
+
+  laneLastEntrySecsVector[lane]	= now;
+
+  if  (laneMostTrainsVector[lane] < queue.size())
+    laneMostTrainsVector[lane]	= queue.size();
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To have every Train that reached the end of its lane stop at
+//	the Station there, to have every Train whose stop is over leave, and
+//	to check the separation of the others.  No parameters.  No return
+//	value.
+void		KinematicSimulator::handleStops
+				()
+				throw()
+{
+  //  I.  Application validity check:
+  const double	spacing		= KINEMATIC_TRAIN_LENGTH_METERS
+				  + KINEMATIC_STANDSTILL_GAP_METERS;
+
+  //  II.  Handle each Train:
+  for  (uint i = 0;  i < numTrains;  i++)
+  {
+    uint	lane	= laneVector[i];
+
+    //  II.A.  Leave a Station when the stop is over:
+    if  (lane == NO_LANE)
+    {
+      if  (departureSecsVector[i] <= now)
+	tryToDepart(i);
+
+      continue;
+    }
+
+    //  II.B.  Arrive at the Station at the end of the lane.  Only the
+    //	     first Train on a lane can have reached its end, so the one
+    //	     behind it now has none ahead:
+    if  (posVector[i] >= limitVector[i] - KINEMATIC_ARRIVAL_METERS)
+    {
+      std::deque<uint>&	queue		= laneQueueVector[lane];
+      direction_t	direction	= (direction_t)(lane % NUM_DIRECTIONS);
+
+      queue.pop_front();
+
+      if  ( !queue.empty() )
+	leaderVector[queue.front()]	= numTrains;
+
+      numMoves++;
+      lineNumMovesVector[massTransit.getTrainPtr(i)->getLine()]++;
+      stopAt(i,getLaneTrackPtr(lane)->getTerminus(direction).getIndex(),
+	     direction
+	    );
+      continue;
+    }
+
+    //  II.C.  Check that a Train still on its lane could stop behind where
+    //	     the Train ahead stands:
+    if  (leaderVector[i] < numTrains)
+    {
+      double	spare	= posVector[leaderVector[i]] - spacing - posVector[i]
+			  - speedVector[i] * speedVector[i]
+			    / (2.0 * KINEMATIC_BRAKE_MPS2);
+
+      if  (spare < minSpareMeters)
+	minSpareMeters	= spare;
+
+      if  (spare < -KINEMATIC_ARRIVAL_METERS)
+	numSeparationViolations++;
+    }
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To run the simulation for 'numSecs' virtual seconds.  No
+//	return value.
+void		KinematicSimulator::run
+				(uint		numSecs
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  unsigned long long	startNsecs	= getMonotonicNsecs();
+  unsigned long long	endTick		= numTicks
+					  + (unsigned long long)
+					    (numSecs / tickSecs + 0.5);
+
+  //  II.  Run simulation:
+  //  II.A.  Run a tick at a time:
+  handleStops();
+
+  while  (numTicks < endTick)
+  {
+    unsigned long long	kernelStartNsecs	= getMonotonicNsecs();
+
+    updateKinematics();
+    kernelSecs	+= (double)(getMonotonicNsecs() - kernelStartNsecs)
+		   / NSECS_PER_SEC;
+    numTicks++;
+    now		= numTicks * tickSecs;
+    handleStops();
+  }
+
+  //  II.B.  Count the waits still going on at the end:
+  for  (uint i = 0;  i < numTrains;  i++)
+    if  (waitStartSecsVector[i] >= 0.0)
+    {
+      entryWaitSecs		+= now - waitStartSecsVector[i];
+      waitStartSecsVector[i]	= now;
+    }
+
+  //  III.  Finished:
+  wallSecs	= (double)(getMonotonicNsecs() - startNsecs) / NSECS_PER_SEC;
+}
+
+
+//  PURPOSE:  To print a summary of the run to 'filePtr'.  No return value.
+void		KinematicSimulator::printSummary
+				(FILE*		filePtr
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+  double	numUpdates	= (double)numTicks * numTrains;
+  uint		busiestLane	= 0;
+  uint		quickestLane	= 0;
+  double	quickestHeadway	= 0.0;
+
+  for  (uint lane = 0;  lane < laneQueueVector.size();  lane++)
+  {
+    if  (laneMostTrainsVector[busiestLane] < laneMostTrainsVector[lane])
+      busiestLane	= lane;
+
+    if  (laneNumEntriesVector[lane] < 2)
+      continue;
+
+    double	headway	= (laneLastEntrySecsVector[lane]
+			   - laneFirstEntrySecsVector[lane]
+			  )
+			  / (laneNumEntriesVector[lane] - 1);
+
+    if  ( (quickestHeadway == 0.0)  ||  (headway < quickestHeadway) )
+    {
+      quickestLane	= lane;
+      quickestHeadway	= headway;
+    }
+  }
+
+  //  II.  Print summary:
+  fprintf(filePtr,
+	  "Simulated %.0f virtual secs in %.3f wall secs (%.0fx real time), "
+	  "%llu ticks of %g secs\n"
+	  "%.0f train updates in %.3f kernel secs (%.1f million/sec)\n"
+	  "%llu station arrivals, %llu waits for a clear track entry "
+	  "(%.1f secs each)\n",
+	  now,
+	  wallSecs,
+	  (wallSecs > 0.0) ? (now / wallSecs) : 0.0,
+	  numTicks,
+	  tickSecs,
+	  numUpdates,
+	  kernelSecs,
+	  (kernelSecs > 0.0) ? (numUpdates / kernelSecs / 1e6) : 0.0,
+	  numMoves,
+	  numEntryWaits,
+	  (numEntryWaits > 0) ? (entryWaitSecs / numEntryWaits) : 0.0
+	 );
+  fprintf(filePtr,
+	  "Most trains at once on one track heading one way: %u on %s "
+	  "(capacity %u without kinematics)\n",
+	  laneMostTrainsVector[busiestLane],
+	  getLaneTrackPtr(busiestLane)->getNameCPtr(),
+	  getLaneTrackPtr(busiestLane)->getCapacity()
+	 );
+
+  if  (quickestHeadway > 0.0)
+    fprintf(filePtr,
+	    "Shortest mean headway: %.1f secs on %s heading %s\n",
+	    quickestHeadway,
+	    getLaneTrackPtr(quickestLane)->getNameCPtr(),
+	    (quickestLane % NUM_DIRECTIONS == NORTH) ? "north" : "south"
+	   );
+
+  fprintf(filePtr,
+	  "Least safe-braking margin: %.2f meters, %llu violations\n",
+	  (minSpareMeters < NO_LEADER_METERS) ? minSpareMeters : 0.0,
+	  numSeparationViolations
+	 );
+
+  //  III.  Finished:
+}
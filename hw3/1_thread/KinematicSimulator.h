@@ -0,0 +1,202 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		KinematicSimulator.h					---*
+ *---									---*
+ *---	    This file declares a class that runs a MassTransit system	---*
+ *---	in virtual time with Train instances that move continuously	---*
+ *---	rather than hop from one TrainLocation to the next.  Each	---*
+ *---	Track has a length and a speed limit, and each direction of it	---*
+ *---	is a lane that may hold as many Train instances as fit.		---*
+ *---	Instead of one Train per Track, a Train keeps far enough behind	---*
+ *---	the one ahead that it could stop short of where that one stands	---*
+ *---	(the safe-braking distance of a moving block).  Positions and	---*
+ *---	speeds are held as arrays, one element per Train, that a	---*
+ *---	branch-free loop updates every tick so that the compiler may	---*
+ *---	vectorize it (given -fno-math-errno -fno-trapping-math, so	---*
+ *---	that 'sqrt()' and the selects need no branches); stops at	---*
+ *---	Station instances are handled apart.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+class	KinematicSimulator
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To refer to the MassTransit system being simulated.
+  MassTransit&			massTransit;
+
+  //  PURPOSE:  To tell the number of Train instances, and the virtual
+  //	seconds between updates.
+  uint				numTrains;
+  double			tickSecs;
+
+  //  PURPOSE:  To tell, for each Train, how far its front is along its lane
+  //	in meters, its speed in meters per second, where its lane ends (or
+  //	0 while at a Station), its speed limit, and how far it may go this
+  //	tick.  'posVector' has one more element, far ahead of any Train,
+  //	that stands for the Train ahead of one that has none.
+  std::vector<double>		posVector;
+  std::vector<double>		speedVector;
+  std::vector<double>		limitVector;
+  std::vector<double>		maxSpeedVector;
+  std::vector<double>		authorityVector;
+
+  //  PURPOSE:  To tell, for each Train, the index of the Train ahead of it
+  //	on its lane, or 'numTrains' if there is none.
+  std::vector<uint>		leaderVector;
+
+  //  PURPOSE:  To tell, for each Train, its lane or 'NO_LANE' while at a
+  //	Station, its Station while at one, the direction it heads, and when
+  //	it may leave its Station.
+  std::vector<uint>		laneVector;
+  std::vector<uint>		stationVector;
+  std::vector<direction_t>	directionVector;
+  std::vector<double>		departureSecsVector;
+
+  //  PURPOSE:  To tell, for each Train, when it started waiting for its
+  //	lane to clear, or a negative number if it does not wait.
+  std::vector<double>		waitStartSecsVector;
+
+  //  PURPOSE:  To hold, for each lane 'track * NUM_DIRECTIONS + direction',
+  //	the Train instances on it, first one first.
+  std::vector<std::deque<uint> >
+				laneQueueVector;
+
+  //  PURPOSE:  To tell, for each lane, how many Train instances entered it,
+  //	when the first and the last did, and the most at once on it.
+  std::vector<unsigned long long>
+				laneNumEntriesVector;
+  std::vector<double>		laneFirstEntrySecsVector;
+  std::vector<double>		laneLastEntrySecsVector;
+  std::vector<uint>		laneMostTrainsVector;
+
+  //  PURPOSE:  To tell, for each line, how many times its Train instances
+  //	arrived at a Station.
+  std::vector<unsigned long long>
+				lineNumMovesVector;
+
+  //  PURPOSE:  To tell the current virtual time in seconds, and the ticks
+  //	run so far.
+  double			now;
+  unsigned long long		numTicks;
+
+  //  PURPOSE:  To count arrivals at Station instances, and the times that a
+  //	Train had to wait for its lane to clear and for how long in all.
+  unsigned long long		numMoves;
+  unsigned long long		numEntryWaits;
+  double			entryWaitSecs;
+
+  //  PURPOSE:  To tell the least distance, in meters, by which any Train
+  //	could have stopped short of the place behind the Train ahead, and
+  //	how many times one could not have.
+  double			minSpareMeters;
+  unsigned long long		numSeparationViolations;
+
+  //  PURPOSE:  To tell how many wall-clock seconds 'run()' took, and how
+  //	many of them 'updateKinematics()' took.
+  double			wallSecs;
+  double			kernelSecs;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  KinematicSimulator		();
+
+  //  No copy constructor:
+  KinematicSimulator		(const KinematicSimulator&);
+
+  //  No copy assignment op:
+  KinematicSimulator&		operator=
+				(const KinematicSimulator&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To return the Track of lane 'lane'.
+  Track*	getLaneTrackPtr	(uint		lane
+				)
+				const
+				throw()
+				{ return(massTransit.getTrackPtr(lane / NUM_DIRECTIONS)); }
+
+  //  PURPOSE:  To advance every Train one tick: first to find how far each
+  //	may go, from where the Train ahead stood, then to move each as fast
+  //	as its speed limit, its acceleration and the distance in which it
+  //	can brake allow.  No parameters.  No return value.
+  void		updateKinematics()
+				throw();
+
+  //  PURPOSE:  To have Train 'i' stop at Station 'station', heading
+  //	'direction' unless it must turn back there.  No return value.
+  void		stopAt		(uint		i,
+				 uint		station,
+				 direction_t	direction
+				)
+				throw();
+
+  //  PURPOSE:  To have Train 'i' leave its Station onto its next lane if
+  //	that lane has room behind its last Train.  No return value.
+  void		tryToDepart	(uint		i
+				)
+				throw();
+
+  //  PURPOSE:  To have every Train that reached the end of its lane stop
+  //	at the Station there, to have every Train whose stop is over leave,
+  //	and to check the separation of the others.  No parameters.  No
+  //	return value.
+  void		handleStops	()
+				throw();
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to simulate 'newMassTransit', whose
+  //	Train instances must already be placed and whose pthreads must not
+  //	have been started, with updates 'newTickMsecs' virtual milliseconds
+  //	apart.  Each Train starts stopped at its Station, or at the Station
+  //	behind it if it is on a Track.  No return value.
+  KinematicSimulator		(MassTransit&	newMassTransit,
+				 uint		newTickMsecs
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~KinematicSimulator		()
+				throw()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of arrivals at Station instances so
+  //	far.  No parameters.
+  unsigned long long
+		getNumMoves	()
+				const
+				throw()
+				{ return(numMoves); }
+
+  //  PURPOSE:  To return the number of arrivals at Station instances made
+  //	so far by the Train instances of line 'line'.
+  unsigned long long
+		getLineNumMoves	(line_t		line
+				)
+				const
+				throw()
+				{ return(lineNumMovesVector[line]); }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To run the simulation for 'numSecs' virtual seconds.  No
+  //	return value.
+  void		run		(uint		numSecs
+				)
+				throw();
+
+  //  PURPOSE:  To print a summary of the run to 'filePtr'.  No return
+  //	value.
+  void		printSummary	(FILE*		filePtr
+				)
+				const
+				throw();
+
+};
@@ -15,158 +15,257 @@
 
 #include	"headers.h"
 
+
+//  PURPOSE:  To write 'cPtr' to 'filePtr' in double quotes, escaped for JSON
+//	if 'isJson' or else for CSV.  No return value.
+void		writeQuoted	(FILE*		filePtr,
+				 const char*	cPtr,
+				 bool		isJson
+				)
+{
+  fputc('"',filePtr);
+
+  for  ( ;  *cPtr != '\0';  cPtr++)
+  {
+    if  (*cPtr == '"')
+      fputc(isJson ? '\\' : '"',filePtr);
+    else
+    if  (isJson  &&  (*cPtr == '\\'))
+      fputc('\\',filePtr);
+
+    fputc(*cPtr,filePtr);
+  }
+
+  fputc('"',filePtr);
+}
+
 //  PURPOSE:  To initialize '*this' to the beginning state of the mass
-//	transit simulator.  Defines 'Track'-and-'Station' instance topology and 
-MassTransit::MassTransit	()
+//	transit simulator.  Builds the 'Track'-and-'Station' instance topology
+//	described by 'topology', with at most 'newTrackCapacity' trains per
+//	Track admitted in arrival order if 'newIsFairAdmission', and all
+//	heading the same way if 'newIsBlockSignalled', and places
+//	'newNumTrains' 'Train' instances on it that pause up to
+//	'newMaxPauseUsecs' microseconds between moves.  Where they start and
+//	how long they pause are decided by random number streams derived
+//	from 'newSeed'.
+MassTransit::MassTransit	(const TopologyFile&	topology,
+   uint			newNumTrains,
+   uint			newTrackCapacity,
+   uint			newMaxPauseUsecs,
+   bool			newIsFairAdmission,
+   bool			newIsBlockSignalled,
+   uint			newSeed
+  )
 throw() :
-redlineNorth("N Red Station"),
-brownlineNorth("N Brown Station"),
-northTunnel("N Tunnel Station"),
-southTunnel("S Tunnel Station"),
-redlineSouth("S Red Station"),
-brownlineSouth("S Brown Station"),
-redlineNorthTrack
-("N Red Track",
-  &redlineNorth,
-  &northTunnel
-  ),
-brownlineNorthTrack
-("N Brown Track",
-  &brownlineNorth,
-  &northTunnel
-  ),
-tunnelTrack	("Tunnel Track",
-  &northTunnel,
-  &southTunnel
-  ),
-redlineSouthTrack
-("S Red Track",
-  &southTunnel,
-  &redlineSouth
-  ),
-brownlineSouthTrack
-("S Brown Track",
-  &southTunnel,
-  &brownlineSouth
-  ),
-shouldContinue(true)
+numLines(topology.getNumLines()),
+lineNameCPtrArray((char**)calloc(numLines,sizeof(char*))),
+numStations(topology.getNumStations()),
+stationArray(allocCacheAligned<Station>(numStations)),
+stationTrackPtrArray
+  ((Track**)calloc(numStations * numLines * NUM_DIRECTIONS,sizeof(Track*))),
+numTracks(topology.getNumTracks()),
+trackArray(allocCacheAligned<Track>(numTracks)),
+textVector(),
+crashRow(0),
+numTrains(newNumTrains),
+trackCapacity(newTrackCapacity),
+isFairAdmission(newIsFairAdmission),
+isBlockSignalled(newIsBlockSignalled),
+expressPercent(0),
+seed(newSeed),
+placementRandom(newSeed,0),
+maxPauseUsecs(newMaxPauseUsecs),
+framesPerSec(DEFAULT_FRAMES_PER_SEC),
+simulatedSecs(0.0),
+stopSecs(0.0),
+statsPathCPtr(NULL),
+eventLogPathCPtr(NULL),
+isLogging(false),
+checkCpuBudget(0.0),
+checkerPtr(NULL),
+isKeepingHistory(false),
+tracePathCPtr(NULL),
+isTracing(false),
+actorSchedulerPtr(NULL),
+nextLogSequence(0),
+logStartNsecs(0),
+shouldContinue(true),
+stopFd(eventfd(0,EFD_CLOEXEC)),
+trainPool(allocCacheAligned<Train>(numTrains)),
+trainPtrArray((Train**)calloc(numTrains,sizeof(Train*))),
+numStartedThreads(0),
+numJoinedThreads(0),
+trainId((pthread_t*)calloc(numTrains,sizeof(pthread_t)))
 {
 //  I.  Application validity check:
 
 //  II.  Initialize other member vars:
-//  II.A.  Tell 'Station' instances to which 'Track' instances they are
+//  II.A.  Name the lines:
+  for  (line_t line = 0;  line < numLines;  line++)
+    lineNameCPtrArray[line] = strndup(topology.getLine(line).name,
+				      MAX_STRING_LEN-1
+				     );
+
+//  II.B.  Build the 'Station' instances in place in 'stationArray[]'.
+//	     Their ticket rings are made once the lines of the 'Train'
+//	     instances are known:
+  for  (uint i = 0;  i < numStations;  i++)
+  {
+    const StationSpec&	spec	= topology.getStation(i);
+
+    new(&stationArray[i]) Station(spec.name,
+				  &stationTrackPtrArray[i*numLines*NUM_DIRECTIONS],
+				  numLines,
+				  *this
+				 );
+    stationArray[i].setIndex(i);
+    stationArray[i].setScreenPos(spec.row,spec.col);
+
+    if  (crashRow <= spec.row)
+      crashRow	= spec.row + 1;
+  }
+
+//  II.C.  Build the 'Track' instances in place in 'trackArray[]':
+  for  (uint i = 0;  i < numTracks;  i++)
+  {
+    const TrackSpec&	spec	= topology.getTrack(i);
+
+    new(&trackArray[i]) Track(spec.name,
+			      &stationArray[spec.termini[NORTH]],
+			      &stationArray[spec.termini[SOUTH]],
+			      trackCapacity,
+			      numTrains,
+			      isFairAdmission,
+			      isBlockSignalled
+			     );
+    trackArray[i].setIndex(numStations + i);
+    trackArray[i].setScreenPos(spec.row,spec.col);
+    trackArray[i].setProfile(spec.lengthMeters,spec.maxSpeedMps);
+
+    if  (crashRow <= spec.row)
+      crashRow	= spec.row + 1;
+  }
+
+//  II.D.  Tell 'Station' instances to which 'Track' instances they are
 //	     connected:
-  redlineNorth.  setTrackPtr(REDLINE,  SOUTH,&redlineNorthTrack);
-  brownlineNorth.setTrackPtr(BROWNLINE,SOUTH,&brownlineNorthTrack);
+  for  (line_t line = 0;  line < numLines;  line++)
+  {
+    const std::vector<uint>&	trackIndexVector
+				= topology.getLine(line).trackIndexVector;
 
-  northTunnel.   setTrackPtr(REDLINE,  NORTH,&redlineNorthTrack);
-  northTunnel.   setTrackPtr(BROWNLINE,NORTH,&brownlineNorthTrack);
-  northTunnel.   setTrackPtr(REDLINE,  SOUTH,&tunnelTrack);
-  northTunnel.   setTrackPtr(BROWNLINE,SOUTH,&tunnelTrack);
+    for  (uint i = 0;  i < trackIndexVector.size();  i++)
+    {
+      Track*	trackPtr	= &trackArray[trackIndexVector[i]];
 
-  southTunnel.   setTrackPtr(REDLINE,  SOUTH,&redlineSouthTrack);
-  southTunnel.   setTrackPtr(BROWNLINE,SOUTH,&brownlineSouthTrack);
-  southTunnel.   setTrackPtr(REDLINE,  NORTH,&tunnelTrack);
-  southTunnel.   setTrackPtr(BROWNLINE,NORTH,&tunnelTrack);
+      trackPtr->getTerminus(NORTH).setTrackPtr(line,SOUTH,trackPtr);
+      trackPtr->getTerminus(SOUTH).setTrackPtr(line,NORTH,trackPtr);
+    }
+  }
 
-  redlineSouth.  setTrackPtr(REDLINE,  NORTH,&redlineSouthTrack);
-  brownlineSouth.setTrackPtr(BROWNLINE,NORTH,&brownlineSouthTrack);
+//  II.E.  Copy the decoration:
+  for  (uint i = 0;  i < topology.getNumTexts();  i++)
+  {
+    textVector.push_back(topology.getText(i));
 
-//  II.B.  Initialize mutex for 'print()':
+    if  (crashRow <= topology.getText(i).row)
+      crashRow	= topology.getText(i).row + 1;
+  }
+
+//  II.F.  Initialize mutex for 'print()':
 //  YOUR CODE HERE TO INITIALIZE YOUR MUTEX:
   pthread_mutex_init(&printLock, NULL);
 
-//  II.C.  Create 'NUM_TRAINS' 'Train' instances and pthreads that operate
-//	       them:
-  Train*		trainPtrArray[NUM_TRAINS];
-
-  for  (uint i = 0;  i < NUM_TRAINS;  i++)
+//  II.G.  Create 'numTrains' 'Train' instances.  The pthreads that
+//	     operate them are made by 'simulate()' so that an EventSimulator
+//	     may run them instead:
+  for  (uint i = 0;  i < numTrains;  i++)
   {
-    bool		haveFoundGoodPlace	= false;
     TrainLocation*	locPtr;
     line_t		newLine;
     direction_t		newDir;
+    bool		haveFoundGoodPlace;
 
-//  II.C.1.  Each iteration attempts to create a 'Train' instance with
+//  II.G.1.  Each iteration attempts to create a 'Train' instance with
 //	   randomly-chosen parameters, subject to the constraint that
-//	   at most 'MAX_ALLOWED_NUM_TRAINS_ON_TRACK' 'Train' instances
-//	   are allowed on any one 'Track' instance:
+//	   at most 'trackCapacity' 'Train' instances, all heading the same
+//	   way if 'isBlockSignalled', are allowed on any one 'Track'
+//	   instance:
     do
     {
-      switch  (rand() % 11)
+      uint	locIndex	= placementRandom.nextBelow(getNumLocations());
+      uint	numLinesHere	= 0;
+
+      locPtr	= getLocPtr(locIndex);
+
+      for  (line_t line = 0;  line < numLines;  line++)
+	if  (isOnLine(locIndex,line))
+	  numLinesHere++;
+
+      if  (numLinesHere == 0)
       {
-        case  0 :
-        locPtr	= &redlineNorth;
-        newLine	= REDLINE;
-        newDir	= SOUTH;
-        break;
-        case  1 :
-        locPtr	= &brownlineNorth;
-        newLine	= BROWNLINE;
-        newDir	= SOUTH;
-        break;
-        case  2 :
-        locPtr	= &northTunnel;
-        newLine	= (rand() % 2) ? REDLINE : BROWNLINE;
-        newDir	= (rand() % 2) ? NORTH : SOUTH;
-        break;
-        case  3 :
-        locPtr	= &southTunnel;
-        newLine	= (rand() % 2) ? REDLINE : BROWNLINE;
-        newDir	= (rand() % 2) ? NORTH : SOUTH;
-        break;
-        case  4 :
-        locPtr	= &redlineSouth;
-        newLine	= REDLINE;
-        newDir	= NORTH;
-        break;
-        case  5 :
-        locPtr	= &brownlineSouth;
-        newLine	= BROWNLINE;
-        newDir	= NORTH;
-        break;
-        case  6 :
-        locPtr	= &redlineNorthTrack;
-        newLine	= REDLINE;
-        newDir	= (rand() % 2) ? NORTH : SOUTH;
-        break;
-        case  7 :
-        locPtr	= &brownlineNorthTrack;
-        newLine	= BROWNLINE;
-        newDir	= (rand() % 2) ? NORTH : SOUTH;
-        break;
-        case  8 :
-        locPtr	= &tunnelTrack;
-        newLine	= (rand() % 2) ? REDLINE : BROWNLINE;
-        newDir	= (rand() % 2) ? NORTH : SOUTH;
-        break;
-        case  9 :
-        locPtr	= &redlineSouthTrack;
-        newLine	= REDLINE;
-        newDir	= (rand() % 2) ? NORTH : SOUTH;
-        break;
-        case 10 :
-        locPtr	= &brownlineSouthTrack;
-        newLine	= BROWNLINE;
-        newDir	= (rand() % 2) ? NORTH : SOUTH;
-        break;
+	haveFoundGoodPlace	= false;
+	continue;
       }
 
+      uint	lineChoice	= (numLinesHere > 1)
+				  ? placementRandom.nextBelow(numLinesHere)
+				  : 0;
+
+      for  (newLine = 0;  newLine < numLines;  newLine++)
+	if  ( isOnLine(locIndex,newLine)  &&  (lineChoice-- == 0) )
+	  break;
+
+      Station*	stationPtr	= dynamic_cast<Station*>(locPtr);
+
+      if  ( (stationPtr != NULL)  &&
+	    (stationPtr->getTrackPtr(newLine,NORTH) == NULL)
+	  )
+	newDir	= SOUTH;
+      else
+      if  ( (stationPtr != NULL)  &&
+	    (stationPtr->getTrackPtr(newLine,SOUTH) == NULL)
+	  )
+	newDir	= NORTH;
+      else
+	newDir	= placementRandom.nextBelow(2) ? NORTH : SOUTH;
+
+      haveFoundGoodPlace =
+		(stationPtr != NULL)  ||
+		((Track*)locPtr)->hasRoomHeading(newDir);
     }
-    while  ( ((dynamic_cast<Track*>(locPtr)) != NULL)	 &&
-      (locPtr->getNumTrains() >= MAX_ALLOWED_NUM_TRAINS_ON_TRACK)
-      );
+    while  ( !haveFoundGoodPlace );
 
-//  II.C.2.  Create 'Train' instance:
-      trainPtrArray[i]	= new Train(i,newLine,newDir,locPtr,*this);
-    locPtr->arrive(trainPtrArray[i]);
+//  II.G.2.  Create 'Train' instance in place in 'trainPool[]':
+    trainPtrArray[i]	= new(&trainPool[i]) Train(i,newLine,newDir,locPtr,
+						   *this,seed
+						  );
 
-//  II.C.3.  Create pthread for 'Train' instance:
-//  YOUR CODE HERE TO INITIALIZE THE i-th pthread TO RUN
-//  'simulateTrain()' GIVEN 'trainPtrArray[i]' AS A PARAMETER
-    pthread_create(&trainId[i], NULL, simulateTrain, (void*)trainPtrArray[i]);
+    if  (dynamic_cast<Station*>(locPtr) == NULL)
+      locPtr->arrive(trainPtrArray[i]);
+  }
+
+//  II.H.  Give each 'Station' room for the 'Train' instances of the lines
+//	     through it, then let those placed at one arrive, in order:
+  std::vector<uint>	numOnLineVector(numLines,0);
+
+  for  (uint i = 0;  i < numTrains;  i++)
+    numOnLineVector[trainPtrArray[i]->getLine()]++;
+
+  for  (uint i = 0;  i < numStations;  i++)
+  {
+    uint	maxHere	= 0;
+
+    for  (line_t line = 0;  line < numLines;  line++)
+      if  ( isOnLine(i,line) )
+	maxHere	+= numOnLineVector[line];
+
+    stationArray[i].setMaxNumTrains(maxHere);
   }
 
+  for  (uint i = 0;  i < numTrains;  i++)
+    if  (trainPtrArray[i]->getLocPtr()->getIndex() < numStations)
+      trainPtrArray[i]->getLocPtr()->arrive(trainPtrArray[i]);
+
 //  III.  Finished:
 }
 
@@ -178,25 +277,72 @@ throw()
 //  I.  Application validity check:
 
 //  II.  Release resources:
-//	II.A.  Wait for thread and destroy 'Train' instances they give back:
-  for  (uint i = 0;  i < NUM_TRAINS;  i++)
-  {
-    Train*	trainPtr;
+//	II.A.  Wait for threads (if any) and destroy 'Train' instances:
+  stopTrains();
+  joinTrains();
+  safeDelete(checkerPtr);
 
-//  YOUR CODE HERE TO WAIT FOR THE i-th pthread AND TO SET 'trainPtr' TO
-//  THE 'Train' INSTANCE THAT IT GIVES BACK
-    pthread_join(trainId[i], (void**)&trainPtr);
+  for  (uint i = 0;  i < numTrains;  i++)
+    trainPool[i].~Train();
 
-    safeDelete(trainPtr);
-  }
+  safeFree(trainPool);
+  safeFree(trainPtrArray);
+  safeFree(trainId);
 
 //  II.B.  Destroy 'print()' mutex:
 //  YOUR CODE HERE TO DESTROY YOUR MUTEX:
   pthread_mutex_destroy(&printLock);
+
+//  II.C.  Destroy the 'Track' and 'Station' instances built in place:
+  for  (uint i = 0;  i < numTracks;  i++)
+    trackArray[i].~Track();
+
+  for  (uint i = 0;  i < numStations;  i++)
+    stationArray[i].~Station();
+
+  safeFree(trackArray);
+  safeFree(stationArray);
+  safeFree(stationTrackPtrArray);
+
+  for  (line_t line = 0;  line < numLines;  line++)
+    safeFree(lineNameCPtrArray[line]);
+
+  safeFree(lineNameCPtrArray);
+
+  if  (stopFd >= 0)
+    close(stopFd);
+
 //  III.  Finished:
 }
 
 
+//  PURPOSE:  To return 'true' if line 'line' runs through the 'locIndex'-th
+//	TrainLocation instance, or 'false' otherwise.
+bool		MassTransit::isOnLine
+				(uint		locIndex,
+				 line_t		line
+				)
+				const
+				throw()
+{
+//  I.  Application validity check:
+
+//  II.  Return value:
+  if  (locIndex < numStations)
+  {
+    const Station&	station	= stationArray[locIndex];
+
+    return( (station.getTrackPtr(line,NORTH) != NULL)  ||
+	    (station.getTrackPtr(line,SOUTH) != NULL)
+	  );
+  }
+
+  Track*	trackPtr	= &trackArray[locIndex - numStations];
+
+  return(trackPtr->getTerminus(NORTH).getTrackPtr(line,SOUTH) == trackPtr);
+}
+
+
 //  PURPOSE:  To display the current state of '*this' MassTransit system.
 //	No parameters.  No return value.
 //  YOUR CODE SOMEWHERE IN HERE TO LOCK AND UNLOCK YOUR MUTEX.
@@ -210,77 +356,256 @@ throw()
 //  II.  Display system:
   clear();
 
-  move( 1, 0);	brownlineNorth.print();
-  move( 2, 6);	addstr("|");
-  move( 3, 0);	brownlineNorthTrack.print();
-  move( 4, 6);	addstr("|");
-
-  move( 2,23);	redlineNorth.print();
-  move( 3,29);	addstr("|");
-  move( 4,23);	redlineNorthTrack.print();
+  for  (uint i = 0;  i < textVector.size();  i++)
+  {
+    move(textVector[i].row,textVector[i].col);
+    addstr(textVector[i].text);
+  }
 
-  move( 5, 7);	addstr("\\");	move( 5,28);	addstr("/");
-  move( 6, 8);	addstr("\\");	move( 6,27);	addstr("/");
-  move( 7, 9);	addstr("\\");	move( 7,26);	addstr("/");
+  Snapshot	snapshot;
 
-  move( 8, 9);	northTunnel.print();
-  move( 9,18);	addstr("|");
-  move(10, 9);	tunnelTrack.print();
-  move(11,18);	addstr("|");
-  move(12, 9);	southTunnel.print();
+  snapshot.take(*this);
 
-  move(13, 9);	addstr("/");	move(13,26);	addstr("\\");
-  move(14, 8);	addstr("/");	move(14,27);	addstr("\\");
-  move(15, 7);	addstr("/");	move(15,28);	addstr("\\");
+  for  (uint i = 0;  i < getNumLocations();  i++)
+  {
+    TrainLocation*	locPtr	= getLocPtr(i);
 
-  move(16, 6);	addstr("|");
-  move(17, 0);	brownlineSouthTrack.print();
-  move(18, 6);	addstr("|");
-  move(19, 0);	brownlineSouth.print();
+    move(locPtr->getScreenRow(),locPtr->getScreenCol());
+    locPtr->print(snapshot.getLocation(i).trainPtrVector);
+  }
 
-  move(16,23);	redlineSouthTrack.print();
-  move(17,29);	addstr("|");
-  move(18,23);	redlineSouth.print();
+  uint		overfullIndex	= snapshot.findOverfullTrack(*this);
 
-  if  (redlineNorthTrack.getNumTrains() > MAX_ALLOWED_NUM_TRAINS_ON_TRACK)
+  if  (overfullIndex < numTracks)
   {
-    move(20,10);
-    addstr("CRASH!  Redline North  ");
-  }
+    char	text[MAX_STRING_LEN];
 
-  if  (brownlineNorthTrack.getNumTrains() > MAX_ALLOWED_NUM_TRAINS_ON_TRACK)
-  {
-    move(20,10);
-    addstr("CRASH!  Brownline North");
+    snprintf(text,MAX_STRING_LEN,"CRASH!  %-23s",
+	     trackArray[overfullIndex].getNameCPtr()
+	    );
+    move(crashRow,10);
+    addstr(text);
   }
 
-  if  (tunnelTrack.getNumTrains() > MAX_ALLOWED_NUM_TRAINS_ON_TRACK)
+refresh();	// Makes changes visible
+
+//  III.  Finished:
+pthread_mutex_unlock(&printLock);
+}
+
+
+//  PURPOSE:  To return the total number of moves by all Train instances.
+//	Approximate while their pthreads run.  No parameters.
+unsigned long long
+		MassTransit::getNumMoves
+				()
+				const
+				throw()
+{
+//  I.  Application validity check:
+
+//  II.  Return value:
+  unsigned long long	sum	= 0;
+
+  for  (uint i = 0;  i < numTrains;  i++)
+    sum	+= trainPtrArray[i]->getNumMoves();
+
+  return(sum);
+}
+
+
+//  PURPOSE:  To return the number of moves made by the Train instances of
+//	line 'line'.  Approximate while their pthreads run.
+unsigned long long
+		MassTransit::getLineNumMoves
+				(line_t		line
+				)
+				const
+				throw()
+{
+//  I.  Application validity check:
+
+//  II.  Return value:
+  unsigned long long	sum	= 0;
+
+  for  (uint i = 0;  i < numTrains;  i++)
+    if  (trainPtrArray[i]->getLine() == line)
+      sum	+= trainPtrArray[i]->getNumMoves();
+
+  return(sum);
+}
+
+
+//  PURPOSE:  To return the total nanoseconds that all Train instances have
+//	spent waiting for locks and Track instances.  Approximate while their
+//	pthreads run.  No parameters.
+unsigned long long
+		MassTransit::getLockWaitNsecs
+				()
+				const
+				throw()
+{
+//  I.  Application validity check:
+
+//  II.  Return value:
+  unsigned long long	sum	= 0;
+
+  for  (uint i = 0;  i < numTrains;  i++)
+    sum	+= trainPtrArray[i]->getLockWaitNsecs();
+
+  return(sum);
+}
+
+
+//  PURPOSE:  To start one pthread per 'Train' instance.  No parameters.
+//	No return value.
+void		MassTransit::startTrains
+				()
+				throw(const char*)
+{
+//  I.  Application validity check:
+  if  (numStartedThreads > 0)
+    throw "MassTransit::startTrains() may only be called once";
+
+//  II.  Start pthreads:
+//  YOUR CODE HERE TO INITIALIZE THE i-th pthread TO RUN
+//  'simulateTrain()' GIVEN 'trainPtrArray[i]' AS A PARAMETER
+  pthread_attr_t	attr;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr,TRAIN_STACK_SIZE);
+
+  for  ( ;  numStartedThreads < numTrains;  numStartedThreads++)
+    if  (pthread_create(&trainId[numStartedThreads],
+			&attr,
+			simulateTrain,
+			(void*)trainPtrArray[numStartedThreads]
+		       )
+	 != 0
+	)
+    {
+      //  II.A.  Stop the pthreads that did start, and take the Train
+      //	     instances that have none off of the system so that none
+      //	     waits for them:
+      pthread_attr_destroy(&attr);
+      stopTrains();
+
+      for  (uint i = numStartedThreads;  i < numTrains;  i++)
+	if  (trainPtrArray[i]->getLocPtr() != NULL)
+	  trainPtrArray[i]->getLocPtr()->leave(trainPtrArray[i]);
+
+      throw "Could not create a pthread for every Train";
+    }
+
+  pthread_attr_destroy(&attr);
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To tell the pthreads started by 'startTrains()' to stop, and
+//	to cut short the pause or the wait of each, so that they all finish
+//	within moments.  'joinTrains()' or the destructor waits for them.  No
+//	parameters.  No return value.
+void		MassTransit::stopTrains
+				()
+				throw()
+{
+//  I.  Application validity check:
+  if  ( !__atomic_exchange_n(&shouldContinue,false,__ATOMIC_ACQ_REL) )
+    return;
+
+//  II.  Stop Train pthreads:
+//  II.A.  Wake those that pause.  The eventfd stays readable, so one that
+//	     starts to pause afterwards returns at once too:
+  if  (stopFd >= 0)
   {
-    move(20,10);
-    addstr("CRASH!  Tunnel         ");
+    unsigned long long	one	= 1;
+
+    if  (write(stopFd,&one,sizeof(one)) != (ssize_t)sizeof(one))
+      perror("Cannot wake pausing trains");
   }
 
-  if  (redlineSouthTrack.getNumTrains() > MAX_ALLOWED_NUM_TRAINS_ON_TRACK)
+//  II.B.  Wake those that wait for room on a Track or to become first at
+//	     a Station.  Each looks at 'shouldContinue' under the lock taken
+//	     here before it waits, so none misses the wake-up.  Train instances
+//	     run as actors have no pthread of their own to wake:
+  if  (numStartedThreads == numJoinedThreads)
+    return;
+
+  for  (uint i = 0;  i < numTracks;  i++)
+    trackArray[i].interruptWaiters();
+
+  for  (uint i = 0;  i < numTrains;  i++)
   {
-    move(20,10);
-    addstr("CRASH!  Redline South  ");
+    Train*	trainPtr	= trainPtrArray[i];
+
+    pthread_mutex_lock(trainPtr->getHeadLockPtr());
+
+    if  ( trainPtr->getIsWaitingForHead() )
+      pthread_cond_signal(trainPtr->getHeadCondPtr());
+
+    pthread_mutex_unlock(trainPtr->getHeadLockPtr());
   }
 
-  if  (brownlineSouthTrack.getNumTrains() > MAX_ALLOWED_NUM_TRAINS_ON_TRACK)
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To pause the calling Train pthread for 'usecs' microseconds,
+//	or until 'stopTrains()' is called if sooner.  Returns 'true' if the
+//	simulation should continue, or 'false' otherwise.
+bool		MassTransit::pauseUnlessStopped
+				(uint		usecs
+				)
+				const
+				throw()
+{
+//  I.  Application validity check:
+  if  (stopFd < 0)
   {
-    move(20,10);
-    addstr("CRASH!  Brownline South");
+    usleep(usecs);
+    return(getShouldContinue());
   }
 
-refresh();	// Makes changes visible
+//  II.  Pause, waking early if the eventfd becomes readable.  A signal
+//	   may end it early too, which only shortens one pause:
+  struct pollfd	pollFd;
+  struct timespec	timeout;
+
+  pollFd.fd		= stopFd;
+  pollFd.events	= POLLIN;
+  pollFd.revents	= 0;
+  timeout.tv_sec	= usecs / 1000000;
+  timeout.tv_nsec	= (long)(usecs % 1000000) * 1000;
+  ppoll(&pollFd,1,&timeout,NULL);
 
 //  III.  Finished:
-pthread_mutex_unlock(&printLock);
+  return(getShouldContinue());
 }
 
 
-//  PURPOSE:  To run '*this' MassTransit simulation for 'numSecs' seconds.
-//	No return value.
+//  PURPOSE:  To wait for the pthreads started by 'startTrains()' to
+//	finish.  No parameters.  No return value.
+void		MassTransit::joinTrains
+				()
+				throw()
+{
+//  I.  Application validity check:
+
+//  II.  Wait for pthreads:
+//  YOUR CODE HERE TO WAIT FOR THE i-th pthread AND TO SET 'trainPtr' TO
+//  THE 'Train' INSTANCE THAT IT GIVES BACK
+  for  ( ;  numJoinedThreads < numStartedThreads;  numJoinedThreads++)
+    pthread_join(trainId[numJoinedThreads], NULL);
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To run '*this' MassTransit simulation for 'numSecs' seconds,
+//	one pthread per 'Train' instance, drawn by a Renderer unless headless.
+//	Returns once every pthread has finished.  No return value.
 void		MassTransit::simulate
 (uint		numSecs
   )
@@ -289,22 +614,442 @@ throw(const char*)
 //  I.  Application validity check:
 
 //  II.  Do simulution:
-  print();
+//  II.A.  Create pthread for each 'Train' instance, one to draw them
+//	     unless headless, and one to check them if asked:
+  Renderer		renderer(*this,framesPerSec);
+
+  beginRecording();
+
+  unsigned long long	startNsecs	= getLogStartNsecs();
+
+  startTrains();
+
+  if  (framesPerSec > 0)
+    renderer.start();
+
+//  II.B.  Let them run.  Stop checking first, as stopped Train instances
+//	   leave the system:
   sleep(numSecs);
-  shouldContinue	= false;
+  stopChecking();
+
+  unsigned long long	stopNsecs	= getMonotonicNsecs();
+
+  stopTrains();
+  joinTrains();
+  stopSecs		= (double)(getMonotonicNsecs() - stopNsecs) / NSECS_PER_SEC;
+  renderer.stop();
+
+//  II.C.  Write what was recorded:
+  endRecording((double)(stopNsecs - startNsecs) / NSECS_PER_SEC);
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To get ready to record a run of the Train instances, however
+//	they are run: to reset the statistics of each TrainLocation, and to
+//	start logging, tracing and checking them as asked.  No parameters.
+//	No return value.
+void		MassTransit::beginRecording
+				()
+				throw(const char*)
+{
+//  I.  Application validity check:
+
+//  II.  Begin recording:
+  safeDelete(checkerPtr);
+
+  if  (checkCpuBudget > 0.0)
+    checkerPtr	= new InvariantChecker(*this,checkCpuBudget);
+
+  for  (uint i = 0;  i < getNumLocations();  i++)
+    getLocPtr(i)->resetStats();
+
+  logStartNsecs		= getMonotonicNsecs();
+  isLogging		= (eventLogPathCPtr != NULL);
+  isKeepingHistory	= (checkerPtr != NULL);
+  isTracing		= (tracePathCPtr != NULL);
+
+  if  (checkerPtr != NULL)
+    checkerPtr->start();
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To stop the checks begun by 'beginRecording()', before the
+//	Train instances stop and leave the system.  No parameters.  No
+//	return value.
+void		MassTransit::stopChecking
+				()
+				throw()
+{
+//  I.  Application validity check:
+
+//  II.  Stop checking:
+  if  (checkerPtr != NULL)
+    checkerPtr->stop();
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To stop recording a run of 'secs' seconds begun by
+//	'beginRecording()', once the Train instances have stopped, and to
+//	write the statistics, EventLog and TraceLog asked for.  No return
+//	value.
+void		MassTransit::endRecording
+				(double		secs
+				)
+				throw(const char*)
+{
+//  I.  Application validity check:
+
+//  II.  End recording:
+//  II.A.  Stop recording:
+  simulatedSecs		= secs;
+  isLogging		= false;
+  isKeepingHistory	= false;
+  isTracing		= false;
+
+//  II.B.  Write the statistics of each TrainLocation if asked:
+  if  (statsPathCPtr != NULL)
+  {
+    FILE*	filePtr	= fopen(statsPathCPtr,"w");
+    size_t	length	= strlen(statsPathCPtr);
+
+    if  (filePtr == NULL)
+      throw "Cannot open statistics file";
+
+    writeStats(filePtr,
+	       (length >= 5)  &&  (strcmp(statsPathCPtr + length - 5,".json") == 0)
+	      );
+    fclose(filePtr);
+  }
+
+//  II.C.  Write the EventLog if asked:
+  if  (eventLogPathCPtr != NULL)
+  {
+    EventLog	eventLog(*this);
+
+    eventLog.write(eventLogPathCPtr);
+  }
+
+//  II.D.  Write the TraceLog if asked:
+  if  (tracePathCPtr != NULL)
+  {
+    TraceLog	traceLog(*this);
+
+    traceLog.write(tracePathCPtr);
+  }
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To write the contention statistics of each TrainLocation
+//	gathered by the last 'simulate()' to 'filePtr', as JSON if 'isJson'
+//	or else as CSV.  No return value.
+void		MassTransit::writeStats
+				(FILE*		filePtr,
+				 bool		isJson
+				)
+				const
+				throw()
+{
+//  I.  Application validity check:
+
+//  II.  Write one record per TrainLocation:
+  Snapshot		snapshot;
+  double		totalNsecs	= simulatedSecs * NSECS_PER_SEC;
+
+  snapshot.take(*this);
+
+  if  (isJson)
+    fprintf(filePtr,"{\"secs\": %.3f, \"locations\": [\n",simulatedSecs);
+  else
+    fprintf(filePtr,
+	    "kind,name,capacity,arrivals,meanOccupancy,utilization,waits,"
+	    "waitP50Usecs,waitP99Usecs,waitMaxUsecs,lockHolds,"
+	    "meanLockHoldNsecs,maxLockHoldNsecs\n"
+	   );
+
+  for  (uint i = 0;  i < getNumLocations();  i++)
+  {
+    const TrainLocation*	locPtr		= getLocPtr(i);
+    bool			isTrack		= (i >= numStations);
+    const WaitHistogram&	waits		= locPtr->getWaitHistogram();
+    double			meanOccupancy	= (totalNsecs > 0.0)
+						  ? (snapshot.getLocation(i).occupancyNsecs
+						     / totalNsecs
+						    )
+						  : 0.0;
+    unsigned long long		numHolds	= locPtr->getNumLockHolds();
+    double			meanHoldNsecs	= (numHolds > 0)
+						  ? ((double)locPtr->getLockHoldNsecs()
+						     / numHolds
+						    )
+						  : 0.0;
+
+    if  (isJson)
+    {
+      fprintf(filePtr,"  {\"kind\": \"%s\", \"name\": ",
+	      isTrack ? "track" : "station"
+	     );
+      writeQuoted(filePtr,locPtr->getNameCPtr(),true);
+
+      if  (isTrack)
+	fprintf(filePtr,", \"capacity\": %u",trackCapacity);
+      else
+	fprintf(filePtr,", \"capacity\": null");
+
+      fprintf(filePtr,
+	      ", \"arrivals\": %llu, \"meanOccupancy\": %.4f",
+	      snapshot.getLocation(i).numArrivals,
+	      meanOccupancy
+	     );
+
+      if  (isTrack)
+	fprintf(filePtr,", \"utilization\": %.4f",meanOccupancy / trackCapacity);
+      else
+	fprintf(filePtr,", \"utilization\": null");
+
+      fprintf(filePtr,
+	      ", \"waits\": %llu, \"waitP50Usecs\": %llu, "
+	      "\"waitP99Usecs\": %llu, \"waitMaxUsecs\": %llu, "
+	      "\"lockHolds\": %llu, \"meanLockHoldNsecs\": %.1f, "
+	      "\"maxLockHoldNsecs\": %llu}%s\n",
+	      waits.getNumWaits(),
+	      waits.getPercentileUsecs(50.0),
+	      waits.getPercentileUsecs(99.0),
+	      waits.getMaxUsecs(),
+	      numHolds,
+	      meanHoldNsecs,
+	      locPtr->getMaxLockHoldNsecs(),
+	      (i + 1 < getNumLocations()) ? "," : ""
+	     );
+    }
+    else
+    {
+      fprintf(filePtr,"%s,",isTrack ? "track" : "station");
+      writeQuoted(filePtr,locPtr->getNameCPtr(),false);
+
+      if  (isTrack)
+	fprintf(filePtr,",%u,%llu,%.4f,%.4f",
+		trackCapacity,
+		snapshot.getLocation(i).numArrivals,
+		meanOccupancy,
+		meanOccupancy / trackCapacity
+	       );
+      else
+	fprintf(filePtr,",,%llu,%.4f,",snapshot.getLocation(i).numArrivals,meanOccupancy);
+
+      fprintf(filePtr,",%llu,%llu,%llu,%llu,%llu,%.1f,%llu\n",
+	      waits.getNumWaits(),
+	      waits.getPercentileUsecs(50.0),
+	      waits.getPercentileUsecs(99.0),
+	      waits.getMaxUsecs(),
+	      numHolds,
+	      meanHoldNsecs,
+	      locPtr->getMaxLockHoldNsecs()
+	     );
+    }
+  }
+
+  if  (isJson)
+    fprintf(filePtr,"]}\n");
 
 //  III.  Finished:
 }
 
 
-//  PURPOSE:  To update '*this' MassTransit system after a 'Train' instance
-//	has moved.  No parameters.  No return value.
-void		MassTransit::update		()
+//  PURPOSE:  To make 'newExpressPercent' percent of the Train instances,
+//	spread evenly over their ids, run express and the others local.  No
+//	return value.
+void		MassTransit::setExpressPercent
+				(uint		newExpressPercent
+				)
+				throw()
 {
 //  I.  Application validity check:
+  expressPercent	= std::min(newExpressPercent,100U);
+
+//  II.  Set classes.  Train 'i' runs express when the running share of
+//	 express Train instances passes a whole one at it:
+  for  (uint i = 0;  i < numTrains;  i++)
+    trainPtrArray[i]->setTrainClass
+	( ((i + 1ULL) * expressPercent / 100 > (i * 1ULL) * expressPercent / 100)
+	  ? EXPRESS_TRAIN
+	  : LOCAL_TRAIN
+	);
 
-//  II.  Update:
-  print();
+//  III.  Let each Station find its express Train instances at once:
+  for  (uint i = 0;  i < numStations;  i++)
+    stationArray[i].indexExpressTrains();
+
+//  IV.  Finished:
+}
+
+
+//  PURPOSE:  To print summary statistics of the last 'simulate()' to
+//	'filePtr'.  No return value.
+void		MassTransit::printSummary
+				(FILE*		filePtr
+				)
+				const
+				throw()
+{
+//  I.  Application validity check:
+
+//  II.  Print summary:
+//  II.A.  Print totals:
+  unsigned long long	numMoves	= getNumMoves();
+  double		waitSecs	= (double)getLockWaitNsecs() / NSECS_PER_SEC;
+
+  fprintf(filePtr,
+	  "%u trains for %.1f secs: %llu train moves (%.1f/sec), "
+	  "%.1f usecs lock wait per move, all stopped in %.1f msecs\n",
+	  numTrains,
+	  simulatedSecs,
+	  numMoves,
+	  (simulatedSecs > 0.0) ? (numMoves / simulatedSecs) : 0.0,
+	  (numMoves > 0) ? (waitSecs * 1e6 / numMoves) : 0.0,
+	  stopSecs * 1e3
+	 );
+
+//  II.B.  Print the spread of Track waits over all arrivals, and the p99
+//	     of the Train that fared worst:
+  WaitHistogram		allWaits;
+  unsigned long long	worstP99Usecs	= 0;
+
+  for  (uint i = 0;  i < numTrains;  i++)
+  {
+    const WaitHistogram&	trainWaits
+				= trainPtrArray[i]->getTrackWaitHistogram();
+    unsigned long long		p99Usecs
+				= trainWaits.getPercentileUsecs(99.0);
+
+    allWaits.merge(trainWaits);
+
+    if  (worstP99Usecs < p99Usecs)
+      worstP99Usecs	= p99Usecs;
+  }
+
+  fprintf(filePtr,
+	  "%s track admission: %llu waits, usecs p50 %llu, p90 %llu, "
+	  "p99 %llu, p99.9 %llu, max %llu; worst train p99 %llu\n",
+	  isFairAdmission ? "Fair" : "Unfair",
+	  allWaits.getNumWaits(),
+	  allWaits.getPercentileUsecs(50.0),
+	  allWaits.getPercentileUsecs(90.0),
+	  allWaits.getPercentileUsecs(99.0),
+	  allWaits.getPercentileUsecs(99.9),
+	  allWaits.getMaxUsecs(),
+	  worstP99Usecs
+	 );
+
+//  II.C.  Print the Track that was occupied the most:
+  Snapshot		snapshot;
+  const Track*		busiestPtr	= NULL;
+  unsigned long long	busiestNsecs	= 0;
+
+  snapshot.take(*this);
+
+  for  (uint i = 0;  i < numTracks;  i++)
+  {
+    unsigned long long	occupancyNsecs
+			= snapshot.getLocation(numStations + i).occupancyNsecs;
+
+    if  ( (busiestPtr == NULL)  ||  (busiestNsecs < occupancyNsecs) )
+    {
+      busiestPtr	= &trackArray[i];
+      busiestNsecs	= occupancyNsecs;
+    }
+  }
+
+  if  ( (busiestPtr != NULL)  &&  (simulatedSecs > 0.0) )
+    fprintf(filePtr,
+	    "Busiest track: %s, %.1f%% occupied, %llu waits (p99 %llu usecs)\n",
+	    busiestPtr->getNameCPtr(),
+	    100.0 * busiestNsecs / (simulatedSecs * NSECS_PER_SEC * trackCapacity),
+	    busiestPtr->getWaitHistogram().getNumWaits(),
+	    busiestPtr->getWaitHistogram().getPercentileUsecs(99.0)
+	   );
+
+//  II.D.  Print how each class of service fared, and how the invariant
+//	     checks went, if any ran:
+  printClassSummary(filePtr,simulatedSecs);
+  printCheckSummary(filePtr);
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To print to 'filePtr' how the invariant checks of the last
+//	run went, if any ran.  No return value.
+void		MassTransit::printCheckSummary
+				(FILE*		filePtr
+				)
+				const
+				throw()
+{
+//  I.  Application validity check:
+  if  (checkerPtr == NULL)
+    return;
+
+//  II.  Print summary:
+  checkerPtr->printSummary(filePtr);
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To print to 'filePtr', if some Train instances run express,
+//	how often the Train instances of each class moved during a run of
+//	'secs' seconds, and how long they waited for room on Track
+//	instances.  No return value.
+void		MassTransit::printClassSummary
+				(FILE*		filePtr,
+				 double		secs
+				)
+				const
+				throw()
+{
+//  I.  Application validity check:
+  if  ( (expressPercent == 0)  ||  (secs <= 0.0) )
+    return;
+
+//  II.  Print each class:
+  fprintf(filePtr,
+	  "Service classes, express first onto tracks and out of stations:\n"
+	  "  %-8s %8s %16s %15s %15s\n",
+	  "class","trains","moves/train/hr","wait p50 usecs","wait p99 usecs"
+	 );
+
+  for  (uint trainClass = 0;  trainClass < NUM_TRAIN_CLASSES;  trainClass++)
+  {
+    uint		numClassTrains	= 0;
+    unsigned long long	numClassMoves	= 0;
+    WaitHistogram	classWaits;
+
+    for  (uint i = 0;  i < numTrains;  i++)
+      if  (trainPtrArray[i]->getTrainClass() == (trainClass_t)trainClass)
+      {
+	numClassTrains++;
+	numClassMoves	+= trainPtrArray[i]->getNumMoves();
+	classWaits.merge(trainPtrArray[i]->getTrackWaitHistogram());
+      }
+
+    fprintf(filePtr,"  %-8s %8u %16.1f %15llu %15llu\n",
+	    TRAIN_CLASS_NAME_ARRAY[trainClass],
+	    numClassTrains,
+	    (numClassTrains > 0)
+	    ? (numClassMoves * 3600.0 / secs / numClassTrains)
+	    : 0.0,
+	    classWaits.getPercentileUsecs(50.0),
+	    classWaits.getPercentileUsecs(99.0)
+	   );
+  }
 
 //  III.  Finished:
 }
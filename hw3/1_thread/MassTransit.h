@@ -16,35 +16,155 @@
 class	MassTransit
 {
 //  I.  Member vars:
-//  PURPOSE:  To represent the Station instances in '*this' MassTransit
-//	system.
-  Station		redlineNorth;
-  Station		brownlineNorth;
-  Station		northTunnel;
-  Station		southTunnel;
-  Station		redlineSouth;
-  Station		brownlineSouth;
-
-//  PURPOSE:  To represent the Track instances in '*this' MassTransit
-//	system.
-  Track			redlineNorthTrack;
-  Track			brownlineNorthTrack;
-  Track			tunnelTrack;
-  Track			redlineSouthTrack;
-  Track			brownlineSouthTrack;
+//  PURPOSE:  To hold the names of the lines of '*this' MassTransit system,
+//	indexed by 'line_t'.
+  uint			numLines;
+  char**		lineNameCPtrArray;
 
-//  PURPOSE:  To hold 'true' while the simulation should continue or 'false'
+//  PURPOSE:  To hold the Station instances in '*this' MassTransit system
+//	in one contiguous, index-addressed array, each starting a cache line
+//	so no two share one.
+  uint			numStations;
+  Station*		stationArray;
+
+//  PURPOSE:  To hold, for every Station, the Track leading away from it
+//	for each line and direction.  Station 'i' uses the
+//	'numLines*NUM_DIRECTIONS' entries starting at
+//	'i*numLines*NUM_DIRECTIONS'.
+  Track**		stationTrackPtrArray;
+
+//  PURPOSE:  To hold the Track instances in '*this' MassTransit system in
+//	one contiguous, index-addressed array, each starting a cache line.
+  uint			numTracks;
+  Track*		trackArray;
+
+//  PURPOSE:  To hold the decoration that 'print()' draws between the
+//	Station and Track instances.
+  std::vector<TextSpec>	textVector;
+
+//  PURPOSE:  To tell the screen row on which 'print()' reports crashes.
+  int			crashRow;
+
+//  PURPOSE:  To tell the number of Train instances.
+  uint			numTrains;
+
+//  PURPOSE:  To tell the maximum number of Train instances simultaneously
+//	allowed on each Track.
+  uint			trackCapacity;
+
+//  PURPOSE:  To tell whether each Track admits waiting Train instances in
+//	the order they asked for it ('true') or in any order ('false').
+  bool			isFairAdmission;
+
+//  PURPOSE:  To tell whether each Track is split into 'trackCapacity'
+//	blocks that hold Train instances heading only one way at a time
+//	('true'), or holds any 'trackCapacity' Train instances ('false').
+  bool			isBlockSignalled;
+
+//  PURPOSE:  To tell what percent of the Train instances run express,
+//	spread evenly over their ids; the others run local.
+  uint			expressPercent;
+
+//  PURPOSE:  To tell the seed from which the random number streams of
+//	'*this' and of each Train are derived.
+  uint			seed;
+
+//  PURPOSE:  To give the random numbers with which the constructor places
+//	the Train instances.
+  RandomStream		placementRandom;
+
+//  PURPOSE:  To tell the longest time a Train pauses between attempts to
+//	move, in microseconds.
+  uint			maxPauseUsecs;
+
+//  PURPOSE:  To tell how many times a second 'simulate()' redraws the
+//	screen, or 0 if '*this' runs headless, without ncurses.
+  uint			framesPerSec;
+
+//  PURPOSE:  To tell how many seconds 'simulate()' ran for, and how many
+//	it then took to stop every Train pthread.
+  double		simulatedSecs;
+  double		stopSecs;
+
+//  PURPOSE:  To name the file to which 'simulate()' writes the contention
+//	statistics of each TrainLocation, or to be 'NULL' if it writes none.
+//	Written as JSON if the name ends in ".json", or else as CSV.
+  const char*		statsPathCPtr;
+
+//  PURPOSE:  To name the file to which 'simulate()' writes an EventLog of
+//	every arrival and departure, or to be 'NULL' if it writes none.
+  const char*		eventLogPathCPtr;
+
+//  PURPOSE:  To hold 'true' while Train instances should log their
+//	arrivals and departures, or 'false' otherwise.
+  bool			isLogging;
+
+//  PURPOSE:  To tell the fraction of one CPU that 'simulate()' lets an
+//	InvariantChecker use, or 0 if it runs none.
+  double		checkCpuBudget;
+
+//  PURPOSE:  To point to the InvariantChecker of the last 'simulate()', or
+//	to be 'NULL' if it ran none.
+  InvariantChecker*	checkerPtr;
+
+//  PURPOSE:  To hold 'true' while each Train should keep its recent
+//	arrivals and departures for 'checkerPtr' to report, or 'false'
 //	otherwise.
+  bool			isKeepingHistory;
+
+//  PURPOSE:  To name the file to which 'simulate()' writes a TraceLog of
+//	what each Train did, or to be 'NULL' if it writes none.
+  const char*		tracePathCPtr;
+
+//  PURPOSE:  To hold 'true' while Train instances should trace what they
+//	do, or 'false' otherwise.
+  bool			isTracing;
+
+//  PURPOSE:  To point to the ActorScheduler that runs the Train instances
+//	instead of one pthread each, or to be 'NULL' if none does.
+  ActorScheduler*	actorSchedulerPtr;
+
+//  PURPOSE:  To tell the sequence number of the next logged event.  Taken
+//	atomically by whichever Train thread logs.
+  unsigned long long	nextLogSequence;
+
+//  PURPOSE:  To tell when logging started, on the monotonic clock in
+//	nanoseconds.
+  unsigned long long	logStartNsecs;
+
+//  PURPOSE:  To hold 'true' while the simulation should continue or 'false'
+//	otherwise.  Only changed atomically.
   bool			shouldContinue;
 
+//  PURPOSE:  To hold an eventfd that 'stopTrains()' makes readable, so that
+//	every Train pthread pausing in 'pauseUnlessStopped()' wakes at once,
+//	or -1 if none could be made, when pauses run their full length.
+  int			stopFd;
+
+//  PURPOSE:  To hold the 'numTrains' Train instances, built in place in
+//	'trainPool[]' on cache lines of their own, and ptrs to them.
+  Train*		trainPool;
+  Train**		trainPtrArray;
+
+//  PURPOSE:  To tell how many of the pthreads of 'trainId[]' have been
+//	started.
+  uint			numStartedThreads;
+
+//  PURPOSE:  To tell how many of the pthreads of 'trainId[]' have been
+//	joined.
+  uint			numJoinedThreads;
+
 //  PURPOSE:  To hold the array of pthreads.
-//  YOUR CODE HERE TO DEFINE AN ARRAY OF 'NUM_TRAINS' pthreads
-  pthread_t trainId[NUM_TRAINS];
+//  YOUR CODE HERE TO DEFINE AN ARRAY OF 'numTrains' pthreads
+  pthread_t*		trainId;
 //  PURPOSE:  To hold the lock that controls which thread can execute
-//  	'print()'.
+//  	'print()'.  Only the Renderer takes it while Train threads run.
 //  YOUR CODE HERE TO DEFINE A MUTEX FOR 'print()' METHOD:
   pthread_mutex_t printLock;
 //  II.  Disallowed auto-generated methods:
+//  No default constructor:
+  MassTransit			();
+
 //  No copy constructor:
   MassTransit			(const MassTransit&
     );
@@ -54,14 +174,25 @@ class	MassTransit
   (const MassTransit&
     );
 
-  protected :
-//  III.  Protected methods:
-
   public :
 //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
 //  PURPOSE:  To initialize '*this' to the beginning state of the mass
-//	transit simulator.  Defines 'Track'-and-'Station' instance topology and 
-  MassTransit			()
+//	transit simulator.  Builds the 'Track'-and-'Station' instance topology
+//	described by 'topology', with at most 'newTrackCapacity' trains per
+//	Track admitted in arrival order if 'newIsFairAdmission', and all
+//	heading the same way if 'newIsBlockSignalled', and places
+//	'newNumTrains' 'Train' instances on it that pause up to
+//	'newMaxPauseUsecs' microseconds between moves.  Where they start and
+//	how long they pause are decided by random number streams derived
+//	from 'newSeed'.
+  MassTransit			(const TopologyFile&	topology,
+   uint			newNumTrains,
+   uint			newTrackCapacity,
+   uint			newMaxPauseUsecs,
+   bool			newIsFairAdmission,
+   bool			newIsBlockSignalled,
+   uint			newSeed
+    )
   throw();
 
 //  PURPOSE:  To release resources.  No parameters.  No return value.
@@ -75,9 +206,359 @@ class	MassTransit
   ()
   const
   throw()
-  { return(shouldContinue); }
+  { return(__atomic_load_n(&shouldContinue,__ATOMIC_ACQUIRE)); }
+
+//  PURPOSE:  To return the number of lines.  No parameters.
+  uint		getNumLines
+  ()
+  const
+  throw()
+  { return(numLines); }
+
+//  PURPOSE:  To return the name of line 'line'.
+  const char*	getLineNameCPtr
+  (line_t	line
+    )
+  const
+  throw()
+  { return(lineNameCPtrArray[line]); }
+
+//  PURPOSE:  To return the number of Station instances.  No parameters.
+  uint		getNumStations
+  ()
+  const
+  throw()
+  { return(numStations); }
+
+//  PURPOSE:  To return a pointer to the 'i'-th Station instance.
+  Station*	getStationPtr
+  (uint		i
+    )
+  const
+  throw()
+  { return(&stationArray[i]); }
+
+//  PURPOSE:  To return the number of Track instances.  No parameters.
+  uint		getNumTracks
+  ()
+  const
+  throw()
+  { return(numTracks); }
+
+//  PURPOSE:  To return a pointer to the 'i'-th Track instance.
+  Track*	getTrackPtr
+  (uint		i
+    )
+  const
+  throw()
+  { return(&trackArray[i]); }
+
+//  PURPOSE:  To return the number of TrainLocation instances: all Station
+//	instances followed by all Track instances.  No parameters.
+  uint		getNumLocations
+  ()
+  const
+  throw()
+  { return(numStations + numTracks); }
+
+//  PURPOSE:  To return a pointer to the 'i'-th TrainLocation instance.
+  TrainLocation*
+		getLocPtr
+  (uint		i
+    )
+  const
+  throw()
+  {
+    return( (i < numStations)
+	    ? (TrainLocation*)&stationArray[i]
+	    : (TrainLocation*)&trackArray[i - numStations]
+	  );
+  }
+
+//  PURPOSE:  To return the number of Train instances.  No parameters.
+  uint		getNumTrains
+  ()
+  const
+  throw()
+  { return(numTrains); }
+
+//  PURPOSE:  To return the maximum number of Train instances simultaneously
+//	allowed on each Track.  No parameters.
+  uint		getTrackCapacity
+  ()
+  const
+  throw()
+  { return(trackCapacity); }
+
+//  PURPOSE:  To return 'true' if each Track admits waiting Train instances
+//	in the order they asked for it, or 'false' otherwise.  No parameters.
+  bool		getIsFairAdmission
+  ()
+  const
+  throw()
+  { return(isFairAdmission); }
+
+//  PURPOSE:  To return 'true' if each Track is split into
+//	'getTrackCapacity()' blocks that hold Train instances heading only
+//	one way at a time, or 'false' otherwise.  No parameters.
+  bool		getIsBlockSignalled
+  ()
+  const
+  throw()
+  { return(isBlockSignalled); }
+
+//  PURPOSE:  To return what percent of the Train instances run express.
+//	No parameters.
+  uint		getExpressPercent
+  ()
+  const
+  throw()
+  { return(expressPercent); }
+
+//  PURPOSE:  To return the seed from which the random number streams are
+//	derived.  No parameters.
+  uint		getSeed
+  ()
+  const
+  throw()
+  { return(seed); }
+
+//  PURPOSE:  To return the longest time a Train pauses between attempts to
+//	move, in microseconds.  No parameters.
+  uint		getMaxPauseUsecs
+  ()
+  const
+  throw()
+  { return(maxPauseUsecs); }
+
+//  PURPOSE:  To return how many seconds the last 'simulate()' ran for.  No
+//	parameters.
+  double	getSimulatedSecs
+  ()
+  const
+  throw()
+  { return(simulatedSecs); }
+
+//  PURPOSE:  To return a random number of microseconds for 'train' to pause
+//	before trying to move again, drawn from its own stream.
+  uint		getRandomPauseUsecs
+  (Train&	train
+    )
+  const
+  throw()
+  {
+    return( (uint)((unsigned long long)train.getRandom().nextBelow(1000)
+		   * maxPauseUsecs / 1000
+		  )
+	  );
+  }
+
+//  PURPOSE:  To return 'true' while Train instances should log their
+//	arrivals and departures, or 'false' otherwise.  No parameters.
+  bool		getIsLogging
+  ()
+  const
+  throw()
+  { return(isLogging); }
+
+//  PURPOSE:  To return 'true' while Train instances should trace what they
+//	do, or 'false' otherwise.  No parameters.
+  bool		getIsTracing
+  ()
+  const
+  throw()
+  { return(isTracing); }
+
+//  PURPOSE:  To return when the last 'simulate()' started, on the monotonic
+//	clock in nanoseconds; logged times count from it.  No parameters.
+  unsigned long long
+		getLogStartNsecs
+  ()
+  const
+  throw()
+  { return(logStartNsecs); }
+
+//  PURPOSE:  To return 'true' while Train instances should keep their
+//	recent arrivals and departures, or 'false' otherwise.  No parameters.
+  bool		getIsKeepingHistory
+  ()
+  const
+  throw()
+  { return(isKeepingHistory); }
+
+//  PURPOSE:  To return the ActorScheduler that runs the Train instances, or
+//	'NULL' if each runs on its own pthread.  No parameters.
+  ActorScheduler*
+		getActorSchedulerPtr
+  ()
+  const
+  throw()
+  { return(actorSchedulerPtr); }
+
+//  PURPOSE:  To return the total number of moves by all Train instances.
+//	Approximate while their pthreads run.  No parameters.
+  unsigned long long
+		getNumMoves
+  ()
+  const
+  throw();
+
+//  PURPOSE:  To return the total nanoseconds that all Train instances have
+//	spent waiting for locks and Track instances.  Approximate while their
+//	pthreads run.  No parameters.
+  unsigned long long
+		getLockWaitNsecs
+  ()
+  const
+  throw();
+
+//  PURPOSE:  To return a pointer to the 'i'-th Train instance.
+  Train*	getTrainPtr
+  (uint		i
+    )
+  const
+  throw()
+  { return(trainPtrArray[i]); }
+
+//  PURPOSE:  To return the number of moves made by the Train instances of
+//	line 'line'.  Approximate while their pthreads run.
+  unsigned long long
+		getLineNumMoves
+  (line_t	line
+    )
+  const
+  throw();
+
+//  PURPOSE:  To return 'true' if line 'line' runs through the 'locIndex'-th
+//	TrainLocation instance, or 'false' otherwise.
+  bool		isOnLine
+  (uint		locIndex,
+   line_t	line
+    )
+  const
+  throw();
 
 //  VI.  Mutators:
+//  PURPOSE:  To make 'newExpressPercent' percent of the Train instances,
+//	spread evenly over their ids, run express and the others local.  No
+//	return value.
+  void		setExpressPercent
+  (uint		newExpressPercent
+    )
+  throw();
+
+//  PURPOSE:  To make 'simulate()' redraw the screen 'newFramesPerSec'
+//	times a second, or run headless if 'newFramesPerSec' is 0.  No return
+//	value.
+  void		setFramesPerSec
+  (uint		newFramesPerSec
+    )
+  throw()
+  { framesPerSec = newFramesPerSec; }
+
+//  PURPOSE:  To make 'simulate()' write the contention statistics of each
+//	TrainLocation to file 'newStatsPathCPtr', or to no file if it is
+//	'NULL'.  No return value.
+  void		setStatsPath
+  (const char*	newStatsPathCPtr
+    )
+  throw()
+  { statsPathCPtr = newStatsPathCPtr; }
+
+//  PURPOSE:  To make 'simulate()' write an EventLog of every arrival and
+//	departure to file 'newEventLogPathCPtr', or to no file if it is
+//	'NULL'.  No return value.
+  void		setEventLogPath
+  (const char*	newEventLogPathCPtr
+    )
+  throw()
+  { eventLogPathCPtr = newEventLogPathCPtr; }
+
+//  PURPOSE:  To make 'simulate()' write a TraceLog of what each Train did
+//	to file 'newTracePathCPtr', or to no file if it is 'NULL'.  No
+//	return value.
+  void		setTracePath
+  (const char*	newTracePathCPtr
+    )
+  throw()
+  { tracePathCPtr = newTracePathCPtr; }
+
+//  PURPOSE:  To have '*newActorSchedulerPtr' run the Train instances, or
+//	none if it is 'NULL'.  No return value.
+  void		setActorSchedulerPtr
+  (ActorScheduler*	newActorSchedulerPtr
+    )
+  throw()
+  { actorSchedulerPtr = newActorSchedulerPtr; }
+
+//  PURPOSE:  To make 'simulate()' check the safety invariants from an
+//	InvariantChecker using at most 'newCheckCpuBudget' of one CPU, or
+//	check none if it is 0.  No return value.
+  void		setCheckCpuBudget
+  (double	newCheckCpuBudget
+    )
+  throw()
+  { checkCpuBudget = newCheckCpuBudget; }
+
+//  PURPOSE:  To log that event 'kind' happened to '*trainPtr' at the
+//	'locIndex'-th TrainLocation at 'nsecs' on the monotonic clock, in the
+//	EventLog if logging and among its recent records if keeping history.
+//	The lock of that TrainLocation must be held, so that the events of
+//	each TrainLocation are numbered in the order they happened.  No
+//	return value.
+  void		logEvent
+  (Train*		trainPtr,
+   uint			locIndex,
+   unsigned long long	nsecs,
+   logKind_t		kind
+    )
+  throw()
+  {
+    LogRecord	record;
+
+    record.sequence	= __sync_fetch_and_add(&nextLogSequence,1);
+    record.nsecs	= nsecs - logStartNsecs;
+    record.trainId	= trainPtr->getIdentity();
+    record.locIndex	= locIndex;
+    record.kind		= kind;
+
+    if  (isLogging)
+      trainPtr->addLogRecord(record);
+
+    if  (isKeepingHistory)
+      trainPtr->addRecentRecord(record);
+  }
+
+
+//  PURPOSE:  To trace that '*trainPtr' did 'kind' at the 'locIndex'-th
+//	TrainLocation from 'startNsecs' to 'endNsecs' on the monotonic
+//	clock or, for 'TRACE_OCCUPANCY', that 'numTrains' Train instances
+//	were there from 'startNsecs' on.  Only the thread of '*trainPtr' may
+//	call it.  No return value.
+  void		traceEvent
+  (Train*		trainPtr,
+   traceKind_t		kind,
+   uint			locIndex,
+   unsigned long long	startNsecs,
+   unsigned long long	endNsecs,
+   uint			numTrains
+    )
+  throw()
+  {
+    TraceRecord	record;
+
+    record.startNsecs	= (startNsecs > logStartNsecs)
+			  ? (startNsecs - logStartNsecs)
+			  : 0;
+    record.endNsecs	= (endNsecs > logStartNsecs)
+			  ? (endNsecs - logStartNsecs)
+			  : 0;
+    record.trainId	= trainPtr->getIdentity();
+    record.locIndex	= locIndex;
+    record.numTrains	= numTrains;
+    record.kind		= kind;
+    trainPtr->addTraceRecord(record);
+  }
 
 
 //  VII.  Methods that do main and misc. work of class.
@@ -88,14 +569,93 @@ class	MassTransit
   void		print		()
   throw();
 
-//  PURPOSE:  To run '*this' MassTransit simulation for 'numSecs' seconds.
+//  PURPOSE:  To start one pthread per 'Train' instance.  No parameters.
 //	No return value.
+  void		startTrains	()
+  throw(const char*);
+
+//  PURPOSE:  To tell the pthreads started by 'startTrains()' to stop, and
+//	to cut short the pause or the wait of each, so that they all finish
+//	within moments.  'joinTrains()' or the destructor waits for them.  No
+//	parameters.  No return value.
+  void		stopTrains	()
+  throw();
+
+//  PURPOSE:  To pause the calling Train pthread for 'usecs' microseconds,
+//	or until 'stopTrains()' is called if sooner.  Returns 'true' if the
+//	simulation should continue, or 'false' otherwise.
+  bool		pauseUnlessStopped
+  (uint		usecs
+    )
+  const
+  throw();
+
+//  PURPOSE:  To wait for the pthreads started by 'startTrains()' to
+//	finish.  No parameters.  No return value.
+  void		joinTrains	()
+  throw();
+
+//  PURPOSE:  To run '*this' MassTransit simulation for 'numSecs' seconds,
+//	one pthread per 'Train' instance, drawn by a Renderer unless headless.
+//	Returns once every pthread has finished.  No return value.
   void		simulate	(uint		numSecs
     )
   throw(const char*);
 
-//  PURPOSE:  To update '*this' MassTransit system after a 'Train' instance
-//	has moved.  No parameters.  No return value.
-  void		update		();
+//  PURPOSE:  To get ready to record a run of the Train instances, however
+//	they are run: to reset the statistics of each TrainLocation, and to
+//	start logging, tracing and checking them as asked.  No parameters.
+//	No return value.
+  void		beginRecording	()
+  throw(const char*);
+
+//  PURPOSE:  To stop the checks begun by 'beginRecording()', before the
+//	Train instances stop and leave the system.  No parameters.  No
+//	return value.
+  void		stopChecking	()
+  throw();
+
+//  PURPOSE:  To stop recording a run of 'secs' seconds begun by
+//	'beginRecording()', once the Train instances have stopped, and to
+//	write the statistics, EventLog and TraceLog asked for.  No return
+//	value.
+  void		endRecording	(double		secs
+    )
+  throw(const char*);
+
+//  PURPOSE:  To write the contention statistics of each TrainLocation
+//	gathered by the last 'simulate()' to 'filePtr', as JSON if 'isJson'
+//	or else as CSV.  No return value.
+  void		writeStats	(FILE*		filePtr,
+				 bool		isJson
+    )
+  const
+  throw();
+
+//  PURPOSE:  To print summary statistics of the last 'simulate()' to
+//	'filePtr'.  No return value.
+  void		printSummary	(FILE*		filePtr
+    )
+  const
+  throw();
+
+//  PURPOSE:  To print to 'filePtr', if some Train instances run express,
+//	how often the Train instances of each class moved during a run of
+//	'secs' seconds, and how long they waited for room on Track
+//	instances.  No return value.
+  void		printClassSummary
+				(FILE*		filePtr,
+				 double		secs
+    )
+  const
+  throw();
+
+//  PURPOSE:  To print to 'filePtr' how the invariant checks of the last
+//	run went, if any ran.  No return value.
+  void		printCheckSummary
+				(FILE*		filePtr
+    )
+  const
+  throw();
 
 };
@@ -0,0 +1,347 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		ParallelSimulator.cpp					---*
+ *---									---*
+ *---	    This file defines a class that runs a MassTransit system	---*
+ *---	in virtual time on several worker pthreads, one Partition of	---*
+ *---	its Station and Track instances each, using the time a move	---*
+ *---	takes as lookahead.						---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To initialize '*this' to simulate 'newMassTransit', whose
+//	Train instances must already be placed and whose pthreads must not
+//	have been started, on 'newNumWorkers' workers with moves taking
+//	'newTraversalUsecs' microseconds.  No return value.
+ParallelSimulator::ParallelSimulator
+				(MassTransit&	newMassTransit,
+				 uint		newNumWorkers,
+				 simTime_t	newTraversalUsecs
+				)
+				throw(const char*) :
+				massTransit(newMassTransit),
+				numWorkers(newNumWorkers),
+				traversalUsecs(newTraversalUsecs),
+				partitionOfLocVector(),
+				partitionPtrVector(),
+				endTime(0),
+				numWindows(0),
+				wallSecs(0.0),
+				digest(0)
+{
+  //  I.  Application validity check:
+  if  (numWorkers == 0)
+    throw "The number of workers must be positive";
+
+  if  (traversalUsecs == 0)
+    throw "The traversal time must be positive, it is the lookahead";
+
+  //  II.  Initialize members:
+  partition();
+
+  for  (uint i = 0;  i < numWorkers;  i++)
+    partitionPtrVector.push_back(new Partition(*this,i,numWorkers));
+
+  pthread_barrier_init(&barrier,NULL,numWorkers);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To release resources.  No parameters.  No return value.
+ParallelSimulator::~ParallelSimulator
+				()
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Release resources:
+  pthread_barrier_destroy(&barrier);
+
+  for  (uint i = 0;  i < partitionPtrVector.size();  i++)
+    safeDelete(partitionPtrVector[i]);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To split the TrainLocation instances into 'numWorkers'
+//	Partition instances of nearly equal size, each a run of a
+//	breadth-first walk of the network so that most moves stay within
+//	one Partition.  No parameters.  No return value.
+void		ParallelSimulator::partition
+				()
+				throw()
+{
+  //  I.  Application validity check:
+  uint			numLocations	= massTransit.getNumLocations();
+  uint			numStations	= massTransit.getNumStations();
+  uint			numLines	= massTransit.getNumLines();
+
+  //  II.  Partition locations:
+  //  II.A.  Walk the network breadth-first, from every Station not yet
+  //	     reached so that disconnected parts are walked too:
+  std::vector<uint>	orderVector;
+  std::vector<bool>	isReachedVector(numLocations,false);
+  std::queue<uint>	toVisitQueue;
+
+  orderVector.reserve(numLocations);
+
+  for  (uint start = 0;  start < numLocations;  start++)
+  {
+    if  (isReachedVector[start])
+      continue;
+
+    isReachedVector[start]	= true;
+    toVisitQueue.push(start);
+
+    while  ( !toVisitQueue.empty() )
+    {
+      uint		index	= toVisitQueue.front();
+      std::vector<uint>	neighborVector;
+
+      toVisitQueue.pop();
+      orderVector.push_back(index);
+
+      if  (index < numStations)
+      {
+	Station*	stationPtr	= massTransit.getStationPtr(index);
+
+	for  (uint line = 0;  line < numLines;  line++)
+	  for  (uint dir = MIN_DIRECTION;  dir <= MAX_DIRECTION;  dir++)
+	  {
+	    Track*	trackPtr = stationPtr->getTrackPtr((line_t)line,
+							   (direction_t)dir
+							  );
+
+	    if  (trackPtr != NULL)
+	      neighborVector.push_back(trackPtr->getIndex());
+	  }
+      }
+      else
+      {
+	Track*		trackPtr	= massTransit.getTrackPtr(index-numStations);
+
+	for  (uint dir = MIN_DIRECTION;  dir <= MAX_DIRECTION;  dir++)
+	  neighborVector.push_back
+		(trackPtr->getTerminus((direction_t)dir).getIndex());
+      }
+
+      for  (size_t i = 0;  i < neighborVector.size();  i++)
+	if  ( !isReachedVector[neighborVector[i]] )
+	{
+	  isReachedVector[neighborVector[i]]	= true;
+	  toVisitQueue.push(neighborVector[i]);
+	}
+    }
+  }
+
+  //  II.B.  Give each Partition an equal run of the walk:
+  partitionOfLocVector.resize(numLocations);
+
+  for  (uint i = 0;  i < numLocations;  i++)
+    partitionOfLocVector[orderVector[i]]
+		= (uint)( (unsigned long long)i * numWorkers / numLocations );
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To be the function that each worker pthread runs: runs the
+//	windows of the Partition given by
+//	'*(std::pair<ParallelSimulator*,uint>*)vPtr' until 'endTime'.
+//	Returns 'NULL'.
+void*		ParallelSimulator::work
+				(void*		vPtr
+				)
+{
+  //  I.  Application validity check:
+  if  (vPtr == NULL)
+    return(NULL);
+
+  //  II.  Run windows:
+  std::pair<ParallelSimulator*,uint>*	argPtr
+		= (std::pair<ParallelSimulator*,uint>*)vPtr;
+
+  argPtr->first->workOn(argPtr->second);
+
+  //  III.  Finished:
+  return(NULL);
+}
+
+
+//  PURPOSE:  To run the windows of Partition 'id' until 'endTime'.  No
+//	return value.
+void		ParallelSimulator::workOn
+				(uint		id
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  Partition&	part	= getPartition(id);
+
+  //  II.  Run windows:
+  //	Every worker computes the same earliest time from the same values,
+  //	so all agree on each window and on when to stop without more
+  //	communication.  Between the two barriers no worker writes what
+  //	another reads.
+  while  (true)
+  {
+    //  II.A.  Take the arrivals sent to 'part' during the last window:
+    part.collectArrivals();
+    pthread_barrier_wait(&barrier);
+
+    //  II.B.  Find the earliest pending event anywhere:
+    simTime_t	earliest	= SIM_TIME_NEVER;
+
+    for  (uint i = 0;  i < numWorkers;  i++)
+      earliest	= std::min(earliest,getPartition(i).getNextEventTime());
+
+    if  ( (earliest == SIM_TIME_NEVER)  ||  (earliest > endTime) )
+      break;
+
+    if  (id == 0)
+      numWindows++;
+
+    //  II.C.  No event can reach another Partition sooner than
+    //	       'traversalUsecs' after it happens, so everything before
+    //	       'earliest + traversalUsecs' is safe to handle now:
+    part.processWindow(earliest + traversalUsecs,endTime);
+    pthread_barrier_wait(&barrier);
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To run the simulation for 'numSecs' seconds of virtual time,
+//	after which each Train leaves wherever it is.  No return value.
+void		ParallelSimulator::run
+				(uint		numSecs
+				)
+				throw(const char*)
+{
+  //  I.  Application validity check:
+  unsigned long long	startNsecs	= getMonotonicNsecs();
+  uint			numTrains	= massTransit.getNumTrains();
+
+  endTime	= (simTime_t)numSecs * USECS_PER_SEC;
+  numWindows	= 0;
+
+  //  II.  Run simulation:
+  //  II.A.  Give each Train its initial pause, in the Partition where it
+  //	     starts:
+  for  (uint i = 0;  i < numTrains;  i++)
+  {
+    Train*	trainPtr	= massTransit.getTrainPtr(i);
+
+    getPartition(getPartitionOf(trainPtr->getLocPtr())).start(trainPtr);
+  }
+
+  //  II.B.  Run one worker pthread per Partition:
+  std::vector<pthread_t>			threadVector(numWorkers);
+  std::vector< std::pair<ParallelSimulator*,uint> >
+						argVector(numWorkers);
+  uint					numStarted	= 0;
+
+  for  (  ;  numStarted < numWorkers;  numStarted++)
+  {
+    argVector[numStarted]	= std::make_pair(this,numStarted);
+
+    if  ( pthread_create(&threadVector[numStarted],
+			 NULL,
+			 work,
+			 &argVector[numStarted]
+			)
+	  != 0
+	)
+      break;
+  }
+
+  if  (numStarted < numWorkers)
+  {
+    //  Workers already started would wait forever at the barrier:
+    fprintf(stderr,"Could not start worker %u\n",numStarted);
+    exit(EXIT_FAILURE);
+  }
+
+  for  (uint i = 0;  i < numWorkers;  i++)
+    pthread_join(threadVector[i],NULL);
+
+  //  II.C.  Digest where each Train ended up, then take it off the system:
+  const unsigned long long	FNV_PRIME	= 1099511628211ULL;
+
+  digest	= 14695981039346656037ULL;
+
+  for  (uint i = 0;  i < numTrains;  i++)
+  {
+    Train*		trainPtr	= massTransit.getTrainPtr(i);
+    TrainLocation*	locPtr		= trainPtr->getLocPtr();
+
+    digest	= (digest ^ ((locPtr == NULL) ? ~0U : locPtr->getIndex()))
+		  * FNV_PRIME;
+    digest	= (digest ^ (uint)trainPtr->getDirection()) * FNV_PRIME;
+    digest	= (digest ^ trainPtr->getNumMoves()) * FNV_PRIME;
+
+    if  (locPtr != NULL)
+      locPtr->leave(trainPtr);
+  }
+
+  for  (uint i = 0;  i < numWorkers;  i++)
+    getPartition(i).clear();
+
+  wallSecs	= (double)(getMonotonicNsecs() - startNsecs) / NSECS_PER_SEC;
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To print a summary of the last 'run()' to 'filePtr'.  No
+//	return value.
+void		ParallelSimulator::printSummary
+				(FILE*		filePtr
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Print summary:
+  unsigned long long	numEvents	= 0;
+  unsigned long long	numMoves	= 0;
+  unsigned long long	numTrackWaits	= 0;
+  double		virtualSecs	= (double)endTime / USECS_PER_SEC;
+
+  for  (uint i = 0;  i < numWorkers;  i++)
+  {
+    numEvents	  += getPartition(i).getNumEvents();
+    numMoves	  += getPartition(i).getNumMoves();
+    numTrackWaits += getPartition(i).getNumTrackWaits();
+  }
+
+  fprintf(filePtr,
+	  "Simulated %.0f virtual secs on %u workers in %.3f wall secs "
+	  "(%.0fx real time)\n"
+	  "%llu events, %llu train moves, %llu waits for a full track\n"
+	  "%llu windows of %llu usecs lookahead, digest %016llx\n",
+	  virtualSecs,
+	  numWorkers,
+	  wallSecs,
+	  (wallSecs > 0.0) ? (virtualSecs / wallSecs) : 0.0,
+	  numEvents,
+	  numMoves,
+	  numTrackWaits,
+	  numWindows,
+	  traversalUsecs,
+	  digest
+	 );
+
+  //  III.  Finished:
+}
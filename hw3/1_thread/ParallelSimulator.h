@@ -0,0 +1,165 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		ParallelSimulator.h					---*
+ *---									---*
+ *---	    This file declares a class that runs a MassTransit system	---*
+ *---	in virtual time on several worker pthreads.  The Station and	---*
+ *---	Track instances are split into one connected Partition per	---*
+ *---	worker.  Every move takes 'traversalUsecs' of virtual time, so	---*
+ *---	no event made at time 't' can affect another Partition before	---*
+ *---	't + traversalUsecs'.  Workers use that as lookahead: each	---*
+ *---	window runs every event earlier than the earliest pending one	---*
+ *---	plus 'traversalUsecs', then the workers exchange arrivals at a	---*
+ *---	barrier.  Since events are ordered by time, kind and Train id	---*
+ *---	alone, a run gives the same result for any number of workers.	---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+class	ParallelSimulator
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To refer to the MassTransit system being simulated.
+  MassTransit&			massTransit;
+
+  //  PURPOSE:  To tell the number of worker pthreads, and of Partition
+  //	instances.
+  uint				numWorkers;
+
+  //  PURPOSE:  To tell how long every move takes, in microseconds of
+  //	virtual time.  Always positive.
+  simTime_t			traversalUsecs;
+
+  //  PURPOSE:  To tell, for each TrainLocation index, the Partition that
+  //	owns it.
+  std::vector<uint>		partitionOfLocVector;
+
+  //  PURPOSE:  To hold the Partition instances.
+  std::vector<Partition*>	partitionPtrVector;
+
+  //  PURPOSE:  To make the workers wait for each other between the phases
+  //	of each window.
+  pthread_barrier_t		barrier;
+
+  //  PURPOSE:  To tell the virtual time at which the current 'run()' ends.
+  simTime_t			endTime;
+
+  //  PURPOSE:  To count the windows of the last 'run()'.
+  unsigned long long		numWindows;
+
+  //  PURPOSE:  To tell how many wall-clock seconds the last 'run()' took.
+  double			wallSecs;
+
+  //  PURPOSE:  To hold a digest of where each Train was, which way it
+  //	headed and how often it moved at the end of the last 'run()'.
+  unsigned long long		digest;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  ParallelSimulator		();
+
+  //  No copy constructor:
+  ParallelSimulator		(const ParallelSimulator&);
+
+  //  No copy assignment op:
+  ParallelSimulator&		operator=
+				(const ParallelSimulator&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To split the TrainLocation instances into 'numWorkers'
+  //	Partition instances of nearly equal size, each a run of a
+  //	breadth-first walk of the network so that most moves stay within
+  //	one Partition.  No parameters.  No return value.
+  void		partition	()
+				throw();
+
+  //  PURPOSE:  To be the function that each worker pthread runs: runs the
+  //	windows of the Partition given by
+  //	'*(std::pair<ParallelSimulator*,uint>*)vPtr' until 'endTime'.
+  //	Returns 'NULL'.
+  static
+  void*		work		(void*		vPtr
+				);
+
+  //  PURPOSE:  To run the windows of Partition 'id' until 'endTime'.  No
+  //	return value.
+  void		workOn		(uint		id
+				)
+				throw();
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to simulate 'newMassTransit', whose
+  //	Train instances must already be placed and whose pthreads must not
+  //	have been started, on 'newNumWorkers' workers with moves taking
+  //	'newTraversalUsecs' microseconds.  No return value.
+  ParallelSimulator		(MassTransit&	newMassTransit,
+				 uint		newNumWorkers,
+				 simTime_t	newTraversalUsecs
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~ParallelSimulator		()
+				throw();
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the MassTransit system being simulated.  No
+  //	parameters.
+  MassTransit&	getMassTransit	()
+				const
+				throw()
+				{ return(massTransit); }
+
+  //  PURPOSE:  To return how long every move takes, in microseconds of
+  //	virtual time.  No parameters.
+  simTime_t	getTraversalUsecs
+				()
+				const
+				throw()
+				{ return(traversalUsecs); }
+
+  //  PURPOSE:  To return the index of the Partition that owns '*locPtr'.
+  uint		getPartitionOf	(const TrainLocation*	locPtr
+				)
+				const
+				throw()
+				{ return(partitionOfLocVector[locPtr->getIndex()]); }
+
+  //  PURPOSE:  To return a reference to the 'i'-th Partition.
+  Partition&	getPartition	(uint		i
+				)
+				const
+				throw()
+				{ return(*partitionPtrVector[i]); }
+
+  //  PURPOSE:  To return a digest of where each Train was, which way it
+  //	headed and how often it moved at the end of the last 'run()'.  Equal
+  //	digests mean equal runs.  No parameters.
+  unsigned long long
+		getDigest	()
+				const
+				throw()
+				{ return(digest); }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To run the simulation for 'numSecs' seconds of virtual time,
+  //	after which each Train leaves wherever it is.  No return value.
+  void		run		(uint		numSecs
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To print a summary of the last 'run()' to 'filePtr'.  No
+  //	return value.
+  void		printSummary	(FILE*		filePtr
+				)
+				const
+				throw();
+
+};
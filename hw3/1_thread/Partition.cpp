@@ -0,0 +1,302 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Partition.cpp						---*
+ *---									---*
+ *---	    This file defines a class that simulates, in virtual	---*
+ *---	time, the Train instances at one part of the TrainLocation	---*
+ *---	instances of a MassTransit system, for a ParallelSimulator.	---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To initialize '*this' to be Partition 'newId' of the
+//	'numPartitions' of 'newSimulator'.  No return value.
+Partition::Partition		(ParallelSimulator&	newSimulator,
+				 uint			newId,
+				 uint			numPartitions
+				)
+				throw() :
+				simulator(newSimulator),
+				id(newId),
+				eventQueue(),
+				outboxVector(numPartitions),
+				waiterMap(),
+				headWaiterSet(),
+				now(0),
+				nextEventTime(SIM_TIME_NEVER),
+				numEvents(0),
+				numMoves(0),
+				numTrackWaits(0)
+{
+  //  I.  Application validity check:
+
+  //  II.  Initialize members:
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To schedule '*trainPtr' to attempt to leave its location
+//	'delay' microseconds from 'now'.  No return value.
+void		Partition::scheduleDeparture
+				(Train*		trainPtr,
+				 simTime_t	delay
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Schedule event:
+  PartitionEvent	event;
+
+  event.time	= now + delay;
+  event.kind	= EVENT_DEPART;
+  event.trainPtr= trainPtr;
+  event.locPtr	= NULL;
+  eventQueue.push(event);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To put '*trainPtr' onto '*locPtr' if it has room, and to
+//	schedule its next departure attempt.  Returns 'true' on success or
+//	'false' if '*trainPtr' must wait for '*locPtr'.
+bool		Partition::tryToPlace
+				(Train*		trainPtr,
+				 TrainLocation*	locPtr
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Attempt to place '*trainPtr':
+  if  ( !locPtr->tryArrive(trainPtr) )
+    return(false);
+
+  numMoves++;
+  trainPtr->noteMove();
+  scheduleDeparture(trainPtr,
+		    simulator.getMassTransit().getRandomPauseUsecs(*trainPtr)
+		   );
+
+  //  III.  Finished:
+  return(true);
+}
+
+
+//  PURPOSE:  To handle departure attempt 'event'.  No return value.
+void		Partition::handleDeparture
+				(const PartitionEvent&	event
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  Train*		trainPtr	= event.trainPtr;
+  TrainLocation*	currentPtr	= trainPtr->getLocPtr();
+
+  if  (currentPtr == NULL)
+    return;
+
+  //  II.  Handle event:
+  //  II.A.  Wait for the Train ahead to leave if '*trainPtr' may not leave
+  //	     yet:
+  if  ( !currentPtr->canLeave(trainPtr) )
+  {
+    headWaiterSet.insert(trainPtr);
+    return;
+  }
+
+  //  II.B.  Leave current location, let the Train behind, and the first
+  //	     express one if it may now leave ahead of it, go at once if
+  //	     ready, and let the longest-waiting Train instances whose class
+  //	     has its turn that fit (if any) onto it:
+  TrainLocation*	nextPtr		= currentPtr->nextLocPtr(trainPtr);
+
+  currentPtr->leave(trainPtr);
+
+  Train*		firstPtr	= currentPtr->getFirstTrain();
+  Train*		expressPtr	= currentPtr->getFirstExpressTrain();
+
+  if  ( (firstPtr != NULL)  &&  (headWaiterSet.erase(firstPtr) > 0) )
+    scheduleDeparture(firstPtr,0);
+
+  if  ( (expressPtr != NULL)				&&
+	currentPtr->canLeave(expressPtr)		&&
+	(headWaiterSet.erase(expressPtr) > 0)
+      )
+    scheduleDeparture(expressPtr,0);
+
+  std::map<TrainLocation*,std::list<Train*> >::iterator
+			iter		= waiterMap.find(currentPtr);
+
+  if  (iter != waiterMap.end())
+  {
+    //  Several may get onto a block-signalled Track once the last Train
+    //  heading the other way leaves it:
+    while  ( !iter->second.empty() )
+    {
+      std::list<Train*>::iterator
+			waiterIter	= currentPtr->pickWaiter(iter->second);
+
+      if  ( !tryToPlace(*waiterIter,currentPtr) )
+	break;
+
+      currentPtr->noteWaiting(*waiterIter,false);
+      iter->second.erase(waiterIter);
+    }
+  }
+
+  //  II.C.  Cross to next location, in whichever Partition owns it:
+  PartitionEvent	arrival;
+  uint			destination	= simulator.getPartitionOf(nextPtr);
+
+  arrival.time		= now + simulator.getTraversalUsecs();
+  arrival.kind		= EVENT_ARRIVE;
+  arrival.trainPtr	= trainPtr;
+  arrival.locPtr	= nextPtr;
+
+  if  (destination == id)
+    eventQueue.push(arrival);
+  else
+    outboxVector[destination].push_back(arrival);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To handle arrival 'event'.  No return value.
+void		Partition::handleArrival
+				(const PartitionEvent&	event
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Arrive, or wait for room:
+  if  ( !tryToPlace(event.trainPtr,event.locPtr) )
+  {
+    numTrackWaits++;
+    event.locPtr->noteWaiting(event.trainPtr,true);
+    waiterMap[event.locPtr].push_back(event.trainPtr);
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To schedule the first departure attempt of '*trainPtr', which
+//	must be at a TrainLocation of '*this'.  No return value.
+void		Partition::start(Train*		trainPtr
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Schedule departure:
+  scheduleDeparture(trainPtr,
+		    simulator.getMassTransit().getRandomPauseUsecs(*trainPtr)
+		   );
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To move into '*this' the arrival events that every Partition
+//	made for it during the last window, and to note the time of the
+//	earliest pending event.  No parameters.  No return value.
+void		Partition::collectArrivals
+				()
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Collect arrivals:
+  uint	numPartitions	= outboxVector.size();
+
+  for  (uint i = 0;  i < numPartitions;  i++)
+  {
+    std::vector<PartitionEvent>&	inbox
+				= simulator.getPartition(i).outboxVector[id];
+
+    for  (size_t j = 0;  j < inbox.size();  j++)
+      eventQueue.push(inbox[j]);
+
+    inbox.clear();
+  }
+
+  nextEventTime	= eventQueue.empty() ? SIM_TIME_NEVER : eventQueue.top().time;
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To handle, in order, every pending event before
+//	'windowEnd' and no later than 'endTime'.  No return value.
+void		Partition::processWindow
+				(simTime_t	windowEnd,
+				 simTime_t	endTime
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Handle events:
+  while  ( !eventQueue.empty()			&&
+	   (eventQueue.top().time < windowEnd)	&&
+	   (eventQueue.top().time <= endTime)
+	 )
+  {
+    PartitionEvent	event	= eventQueue.top();
+
+    eventQueue.pop();
+    now	= event.time;
+    numEvents++;
+
+    if  (event.kind == EVENT_DEPART)
+      handleDeparture(event);
+    else
+      handleArrival(event);
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To forget the pending events and waiting Train instances.  No
+//	parameters.  No return value.
+void		Partition::clear()
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Forget state:
+  while  ( !eventQueue.empty() )
+    eventQueue.pop();
+
+  for  (size_t i = 0;  i < outboxVector.size();  i++)
+    outboxVector[i].clear();
+
+  for  (std::map<TrainLocation*,std::list<Train*> >::iterator
+	  iter = waiterMap.begin();
+	iter != waiterMap.end();
+	iter++
+       )
+    for  (std::list<Train*>::iterator waiterIter = iter->second.begin();
+	  waiterIter != iter->second.end();
+	  waiterIter++
+	 )
+      iter->first->noteWaiting(*waiterIter,false);
+
+  waiterMap.clear();
+  headWaiterSet.clear();
+  nextEventTime	= SIM_TIME_NEVER;
+
+  //  III.  Finished:
+}
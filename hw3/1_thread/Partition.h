@@ -0,0 +1,222 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Partition.h						---*
+ *---									---*
+ *---	    This file declares a class that simulates, in virtual	---*
+ *---	time, the Train instances at one part of the TrainLocation	---*
+ *---	instances of a MassTransit system, for a ParallelSimulator.	---*
+ *---	Each Partition alone touches its TrainLocation instances and	---*
+ *---	the Train instances at them.  A Train that moves to another	---*
+ *---	Partition is sent there as an arrival event.			---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To tell what a PartitionEvent does.  Departures come before
+//	arrivals at the same time.
+typedef		enum
+		{
+		  EVENT_DEPART,
+		  EVENT_ARRIVE
+		}
+		eventKind_t;
+
+
+//  PURPOSE:  To represent one scheduled event: at virtual time 'time'
+//	'trainPtr' either attempts to leave where it is, or arrives at
+//	'locPtr' after crossing from its last location.
+struct	PartitionEvent
+{
+  //  PURPOSE:  To tell when the event happens.
+  simTime_t			time;
+
+  //  PURPOSE:  To tell what the event does.
+  eventKind_t			kind;
+
+  //  PURPOSE:  To tell the Train instance to which the event happens.
+  Train*			trainPtr;
+
+  //  PURPOSE:  To tell where '*trainPtr' arrives, for 'EVENT_ARRIVE'.
+  TrainLocation*		locPtr;
+
+  //  PURPOSE:  To return 'true' if '*this' happens after 'rhs', or 'false'
+  //	otherwise.  A Train has at most one pending event, so the order is
+  //	total and depends only on the events themselves, never on which
+  //	Partition made them or when.
+  bool		operator>	(const PartitionEvent&	rhs
+				)
+				const
+				throw()
+  {
+    if  (time != rhs.time)
+      return(time > rhs.time);
+
+    if  (kind != rhs.kind)
+      return(kind > rhs.kind);
+
+    return(trainPtr->getIdentity() > rhs.trainPtr->getIdentity());
+  }
+};
+
+
+class	Partition
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To refer to the ParallelSimulator of which '*this' is part.
+  ParallelSimulator&		simulator;
+
+  //  PURPOSE:  To tell the index of '*this' among the Partition instances.
+  uint				id;
+
+  //  PURPOSE:  To hold the pending events of the TrainLocation instances of
+  //	'*this', earliest first.
+  std::priority_queue<PartitionEvent,
+		      std::vector<PartitionEvent>,
+		      std::greater<PartitionEvent>
+		     >
+				eventQueue;
+
+  //  PURPOSE:  To hold the arrival events for other Partition instances
+  //	made during the current window, indexed by Partition.  Only
+  //	written by the worker of '*this' during a window, and only read by
+  //	the worker of the destination between windows.
+  std::vector< std::vector<PartitionEvent> >
+				outboxVector;
+
+  //  PURPOSE:  To hold, for each full Track, the Train instances that have
+  //	crossed to it and are waiting to get onto it, in arrival order.
+  std::map<TrainLocation*,std::list<Train*> >
+				waiterMap;
+
+  //  PURPOSE:  To hold the Train instances that are ready to leave their
+  //	Station but are not first there.
+  std::set<Train*>		headWaiterSet;
+
+  //  PURPOSE:  To tell the time of the event being handled.
+  simTime_t			now;
+
+  //  PURPOSE:  To tell the time of the earliest pending event, or
+  //	'SIM_TIME_NEVER' if none, as of the start of the current window.
+  simTime_t			nextEventTime;
+
+  //  PURPOSE:  To count the events handled, the moves made and the times a
+  //	Train had to wait for a full Track.
+  unsigned long long		numEvents;
+  unsigned long long		numMoves;
+  unsigned long long		numTrackWaits;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  Partition			();
+
+  //  No copy constructor:
+  Partition			(const Partition&);
+
+  //  No copy assignment op:
+  Partition&			operator=
+				(const Partition&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To schedule '*trainPtr' to attempt to leave its location
+  //	'delay' microseconds from 'now'.  No return value.
+  void		scheduleDeparture
+				(Train*		trainPtr,
+				 simTime_t	delay
+				)
+				throw();
+
+  //  PURPOSE:  To put '*trainPtr' onto '*locPtr' if it has room, and to
+  //	schedule its next departure attempt.  Returns 'true' on success or
+  //	'false' if '*trainPtr' must wait for '*locPtr'.
+  bool		tryToPlace	(Train*		trainPtr,
+				 TrainLocation*	locPtr
+				)
+				throw();
+
+  //  PURPOSE:  To handle departure attempt 'event'.  No return value.
+  void		handleDeparture	(const PartitionEvent&	event
+				)
+				throw();
+
+  //  PURPOSE:  To handle arrival 'event'.  No return value.
+  void		handleArrival	(const PartitionEvent&	event
+				)
+				throw();
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to be Partition 'newId' of the
+  //	'numPartitions' of 'newSimulator'.  No return value.
+  Partition			(ParallelSimulator&	newSimulator,
+				 uint			newId,
+				 uint			numPartitions
+				)
+				throw();
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~Partition			()
+				throw()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the time of the earliest pending event, or
+  //	'SIM_TIME_NEVER' if none, as of the start of the current window.  No
+  //	parameters.
+  simTime_t	getNextEventTime()
+				const
+				throw()
+				{ return(nextEventTime); }
+
+  //  PURPOSE:  To return the number of events handled.  No parameters.
+  unsigned long long
+		getNumEvents	()
+				const
+				throw()
+				{ return(numEvents); }
+
+  //  PURPOSE:  To return the number of moves made.  No parameters.
+  unsigned long long
+		getNumMoves	()
+				const
+				throw()
+				{ return(numMoves); }
+
+  //  PURPOSE:  To return the number of times a Train had to wait for a
+  //	full Track.  No parameters.
+  unsigned long long
+		getNumTrackWaits()
+				const
+				throw()
+				{ return(numTrackWaits); }
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To schedule the first departure attempt of '*trainPtr', which
+  //	must be at a TrainLocation of '*this'.  No return value.
+  void		start		(Train*		trainPtr
+				)
+				throw();
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To move into '*this' the arrival events that every Partition
+  //	made for it during the last window, and to note the time of the
+  //	earliest pending event.  No parameters.  No return value.
+  void		collectArrivals	()
+				throw();
+
+  //  PURPOSE:  To handle, in order, every pending event before
+  //	'windowEnd' and no later than 'endTime'.  No return value.
+  void		processWindow	(simTime_t	windowEnd,
+				 simTime_t	endTime
+				)
+				throw();
+
+  //  PURPOSE:  To forget the pending events and waiting Train instances.  No
+  //	parameters.  No return value.
+  void		clear		()
+				throw();
+
+};
@@ -0,0 +1,82 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		PerfCounter.cpp						---*
+ *---									---*
+ *---	    This file defines a class that counts one hardware event,	---*
+ *---	such as a cache miss, in this process and in every pthread it	---*
+ *---	creates after the count is opened.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To start counting the user-space events of perf type 'type'
+//	and config 'config' in this process and the pthreads it goes on to
+//	create.  No return value.
+PerfCounter::PerfCounter	(uint			type,
+				 unsigned long long	config
+				)
+				throw() :
+				fd(-1)
+{
+  //  I.  Application validity check:
+
+  //  II.  Open count:
+  struct perf_event_attr	attr;
+
+  memset(&attr,'\0',sizeof(attr));
+  attr.size		= sizeof(attr);
+  attr.type		= type;
+  attr.config		= config;
+  attr.inherit		= 1;
+  attr.exclude_kernel	= 1;
+  attr.exclude_hv	= 1;
+
+  fd	= (int)syscall(__NR_perf_event_open,&attr,0,-1,-1,0);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To release resources.  No parameters.  No return value.
+PerfCounter::~PerfCounter	()
+				throw()
+{
+  //  I.  Application validity check:
+  if  (fd < 0)
+    return;
+
+  //  II.  Close count:
+  close(fd);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To return the events counted so far, or 0 if the count is
+//	not open.  Those of a created pthread are only added once it has
+//	exited.  No parameters.
+unsigned long long
+		PerfCounter::read
+				()
+				const
+				throw()
+{
+  //  I.  Application validity check:
+  unsigned long long	count	= 0;
+
+  if  (fd < 0)
+    return(0);
+
+  //  II.  Read count:
+  if  (::read(fd,&count,sizeof(count)) != (ssize_t)sizeof(count))
+    count	= 0;
+
+  //  III.  Finished:
+  return(count);
+}
@@ -0,0 +1,72 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		PerfCounter.h						---*
+ *---									---*
+ *---	    This file declares a class that counts one hardware event,	---*
+ *---	such as a cache miss, in this process and in every pthread it	---*
+ *---	creates after the count is opened, by way of the Linux		---*
+ *---	perf_event_open() system call.  Where the kernel or the machine	---*
+ *---	does not allow the count it is simply not open.			---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+class	PerfCounter
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To hold the file descriptor of the count, or -1 if it could
+  //	not be opened.
+  int				fd;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  PerfCounter			();
+
+  //  No copy constructor:
+  PerfCounter			(const PerfCounter&);
+
+  //  No copy assignment op:
+  PerfCounter&			operator=
+				(const PerfCounter&);
+
+protected :
+  //  III.  Protected methods:
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To start counting the user-space events of perf type 'type'
+  //	and config 'config' in this process and the pthreads it goes on to
+  //	create.  No return value.
+  PerfCounter			(uint			type,
+				 unsigned long long	config
+				)
+				throw();
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~PerfCounter			()
+				throw();
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return 'true' if the count could be opened, or 'false'
+  //	otherwise.  No parameters.
+  bool		isOpen		()
+				const
+				throw()
+				{ return(fd >= 0); }
+
+  //  PURPOSE:  To return the events counted so far, or 0 if the count is
+  //	not open.  Those of a created pthread are only added once it has
+  //	exited.  No parameters.
+  unsigned long long
+		read		()
+				const
+				throw();
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+
+};
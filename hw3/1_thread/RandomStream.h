@@ -0,0 +1,107 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		RandomStream.h						---*
+ *---									---*
+ *---	    This file declares a class that gives one independent,	---*
+ *---	reproducible stream of pseudo-random numbers.  It is counter-	---*
+ *---	based: the 'n'-th number is a hash of the stream's key and 'n',	---*
+ *---	so each Train may own a stream without sharing state, or a	---*
+ *---	lock, with any other.						---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+class	RandomStream
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To tell which stream '*this' is, as derived from the seed
+  //	and the stream id.
+  unsigned long long		key;
+
+  //  PURPOSE:  To count the numbers given so far.
+  unsigned long long		counter;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  RandomStream			();
+
+  //  No copy constructor:
+  RandomStream			(const RandomStream&);
+
+  //  No copy assignment op:
+  RandomStream&			operator=
+				(const RandomStream&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To return a well-mixed 64-bit hash of 'z' (the finalizer of
+  //	SplitMix64).
+  static
+  unsigned long long
+		mix		(unsigned long long	z
+				)
+				throw()
+  {
+    z	= (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z	= (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return(z ^ (z >> 31));
+  }
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To make '*this' stream 'streamId' of those given by 'seed'.
+  //	No return value.
+  RandomStream			(uint		seed,
+				 uint		streamId
+				)
+				throw() :
+				key(mix( ((unsigned long long)seed << 32) ^ streamId )),
+				counter(0)
+				{ }
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~RandomStream			()
+				throw()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return how many numbers '*this' has given.  No parameters.
+  unsigned long long
+		getCounter	()
+				const
+				throw()
+				{ return(counter); }
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To make '*this' stream 'streamId' of those given by 'seed',
+  //	keeping its count of numbers given.  No return value.
+  void		reseed		(uint		seed,
+				 uint		streamId
+				)
+				throw()
+				{ key = mix( ((unsigned long long)seed << 32) ^ streamId ); }
+
+  //  PURPOSE:  To make '*this' go on as if it had given 'newCounter'
+  //	numbers.  No return value.
+  void		setCounter	(unsigned long long	newCounter
+				)
+				throw()
+				{ counter = newCounter; }
+
+  //  PURPOSE:  To return the next 64-bit number.  No parameters.
+  unsigned long long
+		next		()
+				throw()
+				{ return(mix(key + 0x9E3779B97F4A7C15ULL * ++counter)); }
+
+  //  PURPOSE:  To return the next number from 0 to 'limit'-1.  'limit' must
+  //	be positive.
+  uint		nextBelow	(uint		limit
+				)
+				throw()
+				{ return( (uint)(next() % limit) ); }
+
+};
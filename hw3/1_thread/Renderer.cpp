@@ -0,0 +1,159 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Renderer.cpp						---*
+ *---									---*
+ *---	    This file defines a class that redraws a MassTransit	---*
+ *---	system on the ncurses-controlled screen from its own pthread	---*
+ *---	at a fixed frame rate, so that Train threads never wait on	---*
+ *---	the screen.							---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To initialize '*this' to draw 'newMassTransit'
+//	'newFramesPerSec' times a second once started.  No return value.
+Renderer::Renderer		(MassTransit&	newMassTransit,
+				 uint		newFramesPerSec
+				)
+				throw() :
+				massTransit(newMassTransit),
+				framesPerSec(newFramesPerSec),
+				shouldContinue(false),
+				numFrames(0)
+{
+  //  I.  Application validity check:
+
+  //  II.  Initialize members:
+  pthread_condattr_t	attr;
+
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr,CLOCK_MONOTONIC);
+  pthread_mutex_init(&lock,NULL);
+  pthread_cond_init(&cond,&attr);
+  pthread_condattr_destroy(&attr);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To release resources.  No parameters.  No return value.
+Renderer::~Renderer		()
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Release resources:
+  stop();
+  pthread_cond_destroy(&cond);
+  pthread_mutex_destroy(&lock);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To be the function that the pthread runs: draws
+//	'*(Renderer*)vPtr' until told to stop.  Returns 'NULL'.
+void*		Renderer::run	(void*		vPtr
+				)
+{
+  //  I.  Application validity check:
+  Renderer*	rendererPtr	= (Renderer*)vPtr;
+
+  //  II.  Draw a frame, then wait for the next one or to be stopped:
+  unsigned long long	frameNsecs	= NSECS_PER_SEC / rendererPtr->framesPerSec;
+  unsigned long long	nextNsecs	= getMonotonicNsecs();
+  bool			isLastFrame	= false;
+
+  while  ( !isLastFrame )
+  {
+    rendererPtr->massTransit.print();
+    rendererPtr->numFrames++;
+
+    //  II.A.  Wait until the monotonic clock reaches the next frame time,
+    //	     or from now if that has passed:
+    struct timespec	deadline;
+    unsigned long long	nowNsecs	= getMonotonicNsecs();
+
+    nextNsecs	+= frameNsecs;
+
+    if  (nextNsecs < nowNsecs)
+      nextNsecs	= nowNsecs;
+
+    deadline.tv_sec	= nextNsecs / NSECS_PER_SEC;
+    deadline.tv_nsec	= nextNsecs % NSECS_PER_SEC;
+
+    pthread_mutex_lock(&rendererPtr->lock);
+
+    while  ( rendererPtr->shouldContinue  &&
+	     (pthread_cond_timedwait(&rendererPtr->cond,
+				     &rendererPtr->lock,
+				     &deadline
+				    )
+	      == 0
+	     )
+	   );
+
+    isLastFrame	= !rendererPtr->shouldContinue;
+    pthread_mutex_unlock(&rendererPtr->lock);
+  }
+
+  //  III.  Finished:
+  rendererPtr->massTransit.print();
+  rendererPtr->numFrames++;
+  return(NULL);
+}
+
+
+//  PURPOSE:  To start the pthread that draws.  No parameters.  No return
+//	value.
+void		Renderer::start	()
+				throw(const char*)
+{
+  //  I.  Application validity check:
+  if  (shouldContinue)
+    throw "Renderer::start() called twice";
+
+  if  (framesPerSec == 0)
+    throw "Renderer needs a positive frame rate";
+
+  //  II.  Start pthread:
+  shouldContinue	= true;
+
+  if  (pthread_create(&threadId,NULL,run,(void*)this) != 0)
+  {
+    shouldContinue	= false;
+    throw "Could not create Renderer pthread";
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To stop the pthread after it draws one last frame, and wait
+//	for it.  No parameters.  No return value.
+void		Renderer::stop	()
+				throw()
+{
+  //  I.  Application validity check:
+  pthread_mutex_lock(&lock);
+
+  if  ( !shouldContinue )
+  {
+    pthread_mutex_unlock(&lock);
+    return;
+  }
+
+  //  II.  Stop pthread:
+  shouldContinue	= false;
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&lock);
+  pthread_join(threadId,NULL);
+
+  //  III.  Finished:
+}
@@ -0,0 +1,93 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Renderer.h						---*
+ *---									---*
+ *---	    This file declares a class that redraws a MassTransit	---*
+ *---	system on the ncurses-controlled screen from its own pthread	---*
+ *---	at a fixed frame rate, so that Train threads never wait on	---*
+ *---	the screen.							---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+class	Renderer
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To refer to the MassTransit system to draw.
+  MassTransit&			massTransit;
+
+  //  PURPOSE:  To tell how many frames to draw per second.
+  uint				framesPerSec;
+
+  //  PURPOSE:  To hold 'true' while the pthread should keep drawing, or
+  //	'false' otherwise.  Protected by 'lock'.
+  bool				shouldContinue;
+
+  //  PURPOSE:  To count the frames drawn.
+  uint				numFrames;
+
+  //  PURPOSE:  To hold the pthread that draws.
+  pthread_t			threadId;
+
+  //  PURPOSE:  To protect 'shouldContinue' and to let 'stop()' wake the
+  //	pthread between frames.  'cond' uses the monotonic clock, as frames
+  //	are paced by it.
+  pthread_mutex_t		lock;
+  pthread_cond_t		cond;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  Renderer			();
+
+  //  No copy constructor:
+  Renderer			(const Renderer&);
+
+  //  No copy assignment op:
+  Renderer&			operator=
+				(const Renderer&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To be the function that the pthread runs: draws
+  //	'*(Renderer*)vPtr' until told to stop.  Returns 'NULL'.
+  static
+  void*		run		(void*		vPtr
+				);
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to draw 'newMassTransit'
+  //	'newFramesPerSec' times a second once started.  No return value.
+  Renderer			(MassTransit&	newMassTransit,
+				 uint		newFramesPerSec
+				)
+				throw();
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~Renderer			()
+				throw();
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of frames drawn.  No parameters.
+  uint		getNumFrames	()
+				const
+				throw()
+				{ return(numFrames); }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To start the pthread that draws.  No parameters.  No return
+  //	value.
+  void		start		()
+				throw(const char*);
+
+  //  PURPOSE:  To stop the pthread after it draws one last frame, and wait
+  //	for it.  No parameters.  No return value.
+  void		stop		()
+				throw();
+
+};
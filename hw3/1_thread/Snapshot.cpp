@@ -0,0 +1,112 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Snapshot.cpp						---*
+ *---									---*
+ *---	    This file defines a class that holds a copy of where every	---*
+ *---	Train of a MassTransit system is, taken without stopping or	---*
+ *---	blocking any Train thread.					---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To copy every TrainLocation of 'massTransit' once.  Returns
+//	'true' if no TrainLocation changed meanwhile, or 'false' otherwise.
+bool		Snapshot::copy	(const MassTransit&	massTransit
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  uint		numLocations	= massTransit.getNumLocations();
+
+  //  II.  Copy:
+  //  II.A.  Note the changes done everywhere before copying anything:
+  for  (uint i = 0;  i < numLocations;  i++)
+    numChangesDoneVector[i]	= massTransit.getLocPtr(i)->getNumChangesDone();
+
+  nsecs	= getMonotonicNsecs();
+
+  //  II.B.  Copy each TrainLocation.  What is read may be torn, but is only
+  //	     used if II.C finds it was not:
+  for  (uint i = 0;  i < numLocations;  i++)
+  {
+    const TrainLocation*	locPtr	= massTransit.getLocPtr(i);
+    LocationSnapshot&		loc	= locationVector[i];
+
+    locPtr->copyTrains(loc.trainPtrVector);
+    loc.occupancyNsecs	= locPtr->getOccupancyNsecs(nsecs,
+						    loc.trainPtrVector.size()
+						   );
+    loc.numArrivals	= locPtr->getNumArrivals();
+  }
+
+  //  II.C.  The copy is a consistent cut if no change began anywhere
+  //	     since II.A, nor was under way then:
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  for  (uint i = 0;  i < numLocations;  i++)
+    if  (massTransit.getLocPtr(i)->getNumChangesBegun()
+	 != numChangesDoneVector[i]
+	)
+      return(false);
+
+  //  III.  Finished:
+  return(true);
+}
+
+
+//  PURPOSE:  To copy where every Train of 'massTransit' is, trying up to
+//	'SNAPSHOT_MAX_NUM_ATTEMPTS' times for a consistent cut.  Never
+//	blocks a Train thread.  No return value.
+void		Snapshot::take	(const MassTransit&	massTransit
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  locationVector.resize(massTransit.getNumLocations());
+  numChangesDoneVector.resize(massTransit.getNumLocations());
+
+  //  II.  Copy until consistent, or out of attempts:
+  isConsistent	= false;
+
+  for  (numAttempts = 1;  numAttempts <= SNAPSHOT_MAX_NUM_ATTEMPTS;  numAttempts++)
+    if  ( (isConsistent = copy(massTransit)) )
+      break;
+
+  if  (numAttempts > SNAPSHOT_MAX_NUM_ATTEMPTS)
+    numAttempts	= SNAPSHOT_MAX_NUM_ATTEMPTS;
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To return the index of the first Track of 'massTransit' that
+//	'*this' shows holding more Train instances than it allows, or
+//	'~0U' if there is none or '*this' is not consistent.
+uint		Snapshot::findOverfullTrack
+				(const MassTransit&	massTransit
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+  if  ( !isConsistent )
+    return(~0U);
+
+  //  II.  Look at each Track:
+  uint		numStations	= massTransit.getNumStations();
+
+  for  (uint i = 0;  i < massTransit.getNumTracks();  i++)
+    if  (getNumTrains(numStations + i)
+	 > massTransit.getTrackPtr(i)->getCapacity()
+	)
+      return(i);
+
+  //  III.  Finished:
+  return(~0U);
+}
@@ -0,0 +1,150 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Snapshot.h						---*
+ *---									---*
+ *---	    This file declares a class that holds a copy of where every	---*
+ *---	Train of a MassTransit system is, taken without stopping or	---*
+ *---	blocking any Train thread.  Each TrainLocation counts the	---*
+ *---	changes to its Train instances begun and those done.  A		---*
+ *---	Snapshot reads every count of changes done, copies every	---*
+ *---	TrainLocation, then reads every count of changes begun: if	---*
+ *---	each pair is equal no change was under way at any location	---*
+ *---	during the copy, so the copy is a consistent cut of the whole	---*
+ *---	system.  Otherwise it copies again, a bounded number of times.	---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To hold what a Snapshot copied of one TrainLocation.
+struct	LocationSnapshot
+{
+  //  PURPOSE:  To hold the Train instances there, first one first.
+  std::vector<Train*>		trainPtrVector;
+
+  //  PURPOSE:  To tell the number of Train instances there summed over time,
+  //	in Train-nanoseconds, from 'resetStats()' to the Snapshot.
+  unsigned long long		occupancyNsecs;
+
+  //  PURPOSE:  To tell the number of arrivals there since 'resetStats()'.
+  unsigned long long		numArrivals;
+};
+
+
+class	Snapshot
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To hold the copy of each TrainLocation, by index.
+  std::vector<LocationSnapshot>	locationVector;
+
+  //  PURPOSE:  To hold, while copying, the count of changes done at each
+  //	TrainLocation before the copy began.
+  std::vector<unsigned long long>
+				numChangesDoneVector;
+
+  //  PURPOSE:  To tell when the last copy was taken, on the monotonic clock
+  //	in nanoseconds.
+  unsigned long long		nsecs;
+
+  //  PURPOSE:  To tell whether the last copy is a consistent cut.
+  bool				isConsistent;
+
+  //  PURPOSE:  To tell how many copies the last 'take()' made.
+  uint				numAttempts;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No copy constructor:
+  Snapshot			(const Snapshot&);
+
+  //  No copy assignment op:
+  Snapshot&			operator=
+				(const Snapshot&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To copy every TrainLocation of 'massTransit' once.  Returns
+  //	'true' if no TrainLocation changed meanwhile, or 'false' otherwise.
+  bool		copy		(const MassTransit&	massTransit
+				)
+				throw();
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To make '*this' empty.  No parameters.  No return value.
+  Snapshot			()
+				throw() :
+				locationVector(),
+				numChangesDoneVector(),
+				nsecs(0),
+				isConsistent(false),
+				numAttempts(0)
+				{ }
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~Snapshot			()
+				throw()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return what was copied of TrainLocation 'i'.
+  const LocationSnapshot&
+		getLocation	(uint		i
+				)
+				const
+				throw()
+				{ return(locationVector[i]); }
+
+  //  PURPOSE:  To return the number of Train instances copied at
+  //	TrainLocation 'i'.
+  uint		getNumTrains	(uint		i
+				)
+				const
+				throw()
+				{ return(locationVector[i].trainPtrVector.size()); }
+
+  //  PURPOSE:  To return when '*this' was taken, on the monotonic clock in
+  //	nanoseconds.  No parameters.
+  unsigned long long
+		getNsecs	()
+				const
+				throw()
+				{ return(nsecs); }
+
+  //  PURPOSE:  To return 'true' if '*this' is a consistent cut of its
+  //	MassTransit system, or 'false' if every attempt overlapped a change
+  //	and '*this' only holds the last, possibly torn, copy.  No
+  //	parameters.
+  bool		getIsConsistent	()
+				const
+				throw()
+				{ return(isConsistent); }
+
+  //  PURPOSE:  To return how many copies the last 'take()' made.  No
+  //	parameters.
+  uint		getNumAttempts	()
+				const
+				throw()
+				{ return(numAttempts); }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To copy where every Train of 'massTransit' is, trying up to
+  //	'SNAPSHOT_MAX_NUM_ATTEMPTS' times for a consistent cut.  Never
+  //	blocks a Train thread.  No return value.
+  void		take		(const MassTransit&	massTransit
+				)
+				throw();
+
+  //  PURPOSE:  To return the index of the first Track of 'massTransit' that
+  //	'*this' shows holding more Train instances than it allows, or
+  //	'~0U' if there is none or '*this' is not consistent.
+  uint		findOverfullTrack
+				(const MassTransit&	massTransit
+				)
+				const
+				throw();
+
+};
@@ -3,7 +3,8 @@
 *---		Station.cpp						---*
 *---									---*
 *---	    This file defines a class that represents a Station:	---*
-*---	where several Train instances may be without incident. 		---*
+*---	where several Train instances may be without incident, kept	---*
+*---	in arrival order without a lock.				---*
 *---									---*
 *---	----	----	----	----	----	----	----	----	---*
 *---									---*
@@ -21,12 +22,212 @@ throw()
 {
 //  I.  Application validity check:
 //  II.  Release resources:
+  safeFree(expressSlotArray);
+  safeFree(slotArray);
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To make room in '*this' Station for up to 'newMaxNumTrains'
+//	Train instances at once.  Must be called once, before any Train
+//	arrives.  No return value.
+void		Station::setMaxNumTrains
+(uint		newMaxNumTrains
+  )
+throw()
+{
+//  I.  Application validity check:
+
+//  II.  Make both rings:
+  unsigned long long	length	= 2;
+
+  maxNumTrains	= newMaxNumTrains;
+
+  while  (length < 4ULL * maxNumTrains)
+    length	*= 2;
+
+  //  A zeroed slot has state 0, so looks like one whose Train arrives:
+  slotArray
+	= (unsigned long long*)calloc(length,sizeof(unsigned long long));
+  expressSlotArray
+	= (unsigned long long*)calloc(length,sizeof(unsigned long long));
+  mask	= length - 1;
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To return the Train whose slot has state 'state', or 'NULL'
+//	if 'state' is not that of a Train.
+Train*		Station::getTrainOfState
+(uint		state
+  )
+const
+throw()
+{
+//  I.  Application validity check:
+  if  (state < SLOT_FIRST_ID)
+    return(NULL);
+
+//  II.  Return value:
+  return(massTransit.getTrainPtr(state - SLOT_FIRST_ID));
+}
+
+
+//  PURPOSE:  To wake '*trainPtr', if it waits to leave '*this', or to
+//	resume it, if it is parked by an ActorScheduler.  Taking its
+//	'headLock' means it either has not yet looked whether it can leave,
+//	or is waiting, and only one caller finds it waiting.  No return
+//	value.
+void		Station::wakeIfWaiting
+(Train*		trainPtr
+  )
+throw()
+{
+//  I.  Application validity check:
+  if  (trainPtr == NULL)
+    return;
+
+//  II.  Wake or resume '*trainPtr':
+  ActorScheduler*	schedulerPtr	= massTransit.getActorSchedulerPtr();
+  bool			shouldResume	= false;
+
+  pthread_mutex_lock(trainPtr->getHeadLockPtr());
+
+  if  ( trainPtr->getIsWaitingForHead() )
+  {
+    if  (schedulerPtr == NULL)
+      pthread_cond_signal(trainPtr->getHeadCondPtr());
+    else
+    {
+      trainPtr->setIsWaitingForHead(false);
+      shouldResume	= true;
+    }
+  }
+
+  pthread_mutex_unlock(trainPtr->getHeadLockPtr());
+
+  if  (shouldResume)
+    schedulerPtr->resume(trainPtr);
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To move '*headPtr', the first ticket of ring 'ringPtr[]',
+//	past the tickets whose Train left, helping any other Train doing
+//	the same.  No return value.
+void		Station::skipDeparted
+(unsigned long long*		headPtr,
+ const unsigned long long*	ringPtr
+  )
+throw()
+{
+//  I.  Application validity check:
+
+//  II.  Step past each ticket whose Train left.  If the step fails,
+//	 another Train took it, so just look again:
+  unsigned long long	ticket;
+
+  while  ( getStateIn(ringPtr,
+		       ticket = __atomic_load_n(headPtr,__ATOMIC_SEQ_CST)
+		      )
+	   == SLOT_DEPARTED
+	 )
+    __atomic_compare_exchange_n(headPtr,&ticket,ticket + 1,false,
+				__ATOMIC_SEQ_CST,__ATOMIC_SEQ_CST
+			       );
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To move 'head' past the tickets of Train instances that left,
+//	helping any other Train doing the same, and then to wake or resume
+//	the new first Train and the new first express one if they wait.  No
+//	parameters.  No return value.
+void		Station::advanceHead
+()
+throw()
+{
+//  I.  Application validity check:
+
+//  II.  Advance 'head':
+//  II.A.  Step past each ticket whose Train left, in both rings:
+  skipDeparted(&head,slotArray);
+  skipDeparted(&expressHead,expressSlotArray);
+
+//  II.B.  Wake the new first Train if it waits, or resume it if it is
+//	   parked by an ActorScheduler, and the new first express one too
+//	   if it may now leave ahead of it:
+  Train*	firstPtr	= getFirstTrain();
+  Train*	expressPtr	= getFirstExpressTrain();
+
+  wakeIfWaiting(firstPtr);
+
+  if  ( (expressPtr != NULL)  &&
+	(expressPtr != firstPtr)  &&
+	canLeave(expressPtr)
+      )
+    wakeIfWaiting(expressPtr);
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To return 'true' if '*trainPtr' is the first 'Train' instance,
+//	or 'false' otherwise.  Never waits.
+bool		Station::isFirstTrain
+(const Train*	trainPtr
+  )
+const
+throw()
+{
+//  I.  Application validity check:
+
+//  II.  Return value:
+  return( getState(__atomic_load_n(&head,__ATOMIC_SEQ_CST))
+	  == trainPtr->getIdentity() + SLOT_FIRST_ID
+	);
+}
+
+
+//  PURPOSE:  To copy the Train instances at '*this', first one first, into
+//	'trainPtrVector'.  Never waits.  The copy may be torn by a change
+//	made meanwhile.  No return value.
+void		Station::copyTrains
+(std::vector<Train*>&	trainPtrVector
+  )
+const
+throw()
+{
+//  I.  Application validity check:
+  unsigned long long	first	= __atomic_load_n(&head,__ATOMIC_SEQ_CST);
+  unsigned long long	end	= __atomic_load_n(&tail,__ATOMIC_SEQ_CST);
+
+  if  (end - first > mask + 1)
+    end	= first + mask + 1;
+
+//  II.  Copy Train instances:
+  trainPtrVector.clear();
+
+  for  (unsigned long long ticket = first;  ticket < end;  ticket++)
+  {
+    Train*	trainPtr	= getTrainOfState(getState(ticket));
+
+    if  (trainPtr != NULL)
+      trainPtrVector.push_back(trainPtr);
+  }
+
 //  III.  Finished:
 }
 
 
 //  PURPOSE:  To return 'true' if '*trainPtr' can leave '*this'
-//	TrainLocation, or 'false' otherwise.
+//	TrainLocation: if it is the first Train, or if it is the first
+//	express one, which leaves ahead of the local ones before it while
+//	the slots of those that did so leave room, or 'false' otherwise.
 bool		Station::canLeave
 (Train*		trainPtr
   )
@@ -34,9 +235,117 @@ const
 throw()
 {
 //  I.  Application validity check:
+  if  ( isFirstTrain(trainPtr) )
+    return(true);
 
 //  II.  Return value:
-  return( isFirstTrain(trainPtr) );
+  return( (trainPtr->getTrainClass() == EXPRESS_TRAIN)		&&
+	  ( __atomic_load_n(&tail,__ATOMIC_SEQ_CST)
+	    - __atomic_load_n(&head,__ATOMIC_SEQ_CST)
+	    + 2ULL * maxNumTrains
+	    <= mask + 1
+	  )							&&
+	  (getFirstExpressTrain() == trainPtr)
+	);
+}
+
+
+//  PURPOSE:  To block until '*trainPtr' can leave '*this' Station, without
+//	polling: 'leave()' wakes the next first Train and the next first
+//	express one itself.  Returns 'true' if '*trainPtr' can leave, or
+//	'false' if the simulation stopped first.
+bool		Station::waitUntilCanLeave
+(Train*		trainPtr
+  )
+throw()
+{
+//  I.  Application validity check:
+  MassTransit&	massTransit	= trainPtr->getMassTransit();
+
+  if  ( !massTransit.getShouldContinue() )
+    return(false);
+
+  if  ( canLeave(trainPtr) )
+    return(true);
+
+//  II.  Wait until '*trainPtr' can leave:
+  unsigned long long	startNsecs	= getMonotonicNsecs();
+  bool			canGo;
+
+  pthread_mutex_lock(trainPtr->getHeadLockPtr());
+
+  while  ( (canGo = massTransit.getShouldContinue())  &&
+	   !canLeave(trainPtr)
+	 )
+  {
+    trainPtr->setIsWaitingForHead(true);
+    pthread_cond_wait(trainPtr->getHeadCondPtr(),trainPtr->getHeadLockPtr());
+    trainPtr->setIsWaitingForHead(false);
+  }
+
+  pthread_mutex_unlock(trainPtr->getHeadLockPtr());
+
+  unsigned long long	endNsecs	= getMonotonicNsecs();
+
+  noteWaitUnlocked(endNsecs - startNsecs);
+  trace(trainPtr,TRACE_HEAD_WAIT,startNsecs,endNsecs,0);
+
+//  III.  Finished:
+  return(canGo);
+}
+
+
+//  PURPOSE:  To return 'true' at once if '*trainPtr' can leave '*this'
+//	Station or, if not, to park it, run by an ActorScheduler, so that
+//	'leave()' resumes it once it can, and to return 'false'.  Never
+//	blocks.
+bool		Station::parkUntilCanLeave
+(Train*		trainPtr
+  )
+throw()
+{
+//  I.  Application validity check:
+  if  ( canLeave(trainPtr) )
+    return(true);
+
+//  II.  Park, unless '*trainPtr' became able to leave meanwhile.
+//	 'advanceHead()' looks for parked Train instances under the same
+//	 'headLock':
+  bool		canGo;
+
+  pthread_mutex_lock(trainPtr->getHeadLockPtr());
+
+  if  ( !(canGo = canLeave(trainPtr)) )
+  {
+    trainPtr->setActorState(ACTOR_WAITING_FOR_HEAD,getMonotonicNsecs());
+    trainPtr->setIsWaitingForHead(true);
+  }
+
+  pthread_mutex_unlock(trainPtr->getHeadLockPtr());
+
+//  III.  Finished:
+  return(canGo);
+}
+
+
+//  PURPOSE:  To note that '*trainPtr', parked by 'parkUntilCanLeave()'
+//	since 'trainPtr->getActorSinceNsecs()', was resumed as one that can
+//	leave.  Only the worker that runs '*trainPtr' may call it.  No
+//	return value.
+void		Station::noteUnparked
+(Train*		trainPtr
+  )
+throw()
+{
+//  I.  Application validity check:
+  unsigned long long	startNsecs	= trainPtr->getActorSinceNsecs();
+  unsigned long long	endNsecs	= getMonotonicNsecs();
+
+//  II.  Note wait:
+  noteWaitUnlocked(endNsecs - startNsecs);
+  trace(trainPtr,TRACE_HEAD_WAIT,startNsecs,endNsecs,0);
+
+//  III.  Finished:
 }
 
 
@@ -49,46 +358,158 @@ TrainLocation*	Station::nextLocPtr
 //  I.  Application validity check:
 
 //  II.  Return track:
-  return(trackArray[trainPtr->getLine()][trainPtr->getDirection()]);
+  return(getTrackPtr(trainPtr->getLine(),trainPtr->getDirection()));
 }
 
 
-//  PURPOSE:  To make '*trainPtr' arrive at '*this'.  No return value.
-//  YOUR CODE SOMEWHERE IN HERE TO LOCK AND UNLOCK 'getLockPtr()'
-//  WHAT NEEDS TO BE PROTECTED?
+//  PURPOSE:  To put the express Train instances at '*this', first one
+//	first, into the express ring, after their classes changed.  Only
+//	call while no Train moves.  No parameters.  No return value.
+void		Station::indexExpressTrains
+()
+throw()
+{
+//  I.  Application validity check:
+
+//  II.  Refill the express ring:
+  memset(expressSlotArray,0,(mask + 1) * sizeof(unsigned long long));
+  expressHead	= expressTail	= 0;
+
+  for  (unsigned long long ticket = head;  ticket < tail;  ticket++)
+  {
+    uint	state		= getState(ticket);
+    Train*	trainPtr	= getTrainOfState(state);
+
+    if  ( (trainPtr != NULL)  &&
+	  (trainPtr->getTrainClass() == EXPRESS_TRAIN)
+	)
+    {
+      expressSlotArray[expressTail & mask]	= makeSlot(expressTail,state);
+      expressTail++;
+    }
+  }
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To make '*trainPtr' arrive at '*this', behind every Train that
+//	took a ticket before it.  No return value.
 void		Station::arrive	(Train*		trainPtr
   )
 throw()
 {
-  pthread_mutex_lock(&trainLocLock);
 //  I.  Application validity check:
 
 //  II.  Switch '*trainPtr' direction if it cannot go any further in its
 //  	   current direction:
+  beginChange();
+
   if  (getTrackPtr(trainPtr->getLine(),trainPtr->getDirection()) == NULL)
     trainPtr->switchDiretion();
 
-  enqueue(trainPtr);
+//  III.  Take a ticket, then fill its slot to show '*trainPtr' is here:
+  unsigned long long	ticket	= __atomic_fetch_add(&tail,1,__ATOMIC_SEQ_CST);
+
+  if  (ticket - __atomic_load_n(&head,__ATOMIC_SEQ_CST) > mask)
+  {
+    fprintf(stderr,"Station %s holds more than %u trains\n",
+	    getNameCPtr(),maxNumTrains
+	   );
+    exit(EXIT_FAILURE);
+  }
+
+  unsigned long long	nowNsecs= getMonotonicNsecs();
+  uint			state	= trainPtr->getIdentity() + SLOT_FIRST_ID;
+  uint			count;
+
   trainPtr->setLocPtr(this);
+  trainPtr->setStationTicket(ticket);
+  count	= __atomic_add_fetch(&numTrains,1,__ATOMIC_SEQ_CST);
+  noteArrival(trainPtr,nowNsecs);
+  __atomic_store_n(&slotArray[ticket & mask],
+		   makeSlot(ticket,state),
+		   __ATOMIC_SEQ_CST
+		  );
+
+//  IV.  An express Train takes a ticket in the express ring too, after
+//	 its slot above shows, so it is never found there first:
+  if  (trainPtr->getTrainClass() == EXPRESS_TRAIN)
+  {
+    unsigned long long	expressTicket
+		= __atomic_fetch_add(&expressTail,1,__ATOMIC_SEQ_CST);
+
+    __atomic_store_n(&expressSlotArray[expressTicket & mask],
+		     makeSlot(expressTicket,state),
+		     __ATOMIC_SEQ_CST
+		    );
+  }
+
+  endChange();
+  trace(trainPtr,TRACE_OCCUPANCY,nowNsecs,0,count);
 
-  pthread_mutex_unlock(&trainLocLock);
+//  V.  Finished:
 }
 
 
-//  PURPOSE:  To make '*trainPtr' leave '*this'.  No return value.
-//  YOUR CODE SOMEWHERE IN HERE TO LOCK AND UNLOCK 'getLockPtr()'
-//  WHAT NEEDS TO BE PROTECTED?
+//  PURPOSE:  To make '*trainPtr' leave '*this', and wake the Train behind
+//	it if that Train waits to leave.  Usually '*trainPtr' is first; if
+//	not (an express Train, or when the simulation stops) its slot is
+//	marked so that 'head' skips it later.  An express Train is almost
+//	always first in the express ring, so its slot there is found at
+//	once too.  No return value.
 void		Station::leave	(Train*		trainPtr
   )
 throw()
 {
-  pthread_mutex_lock(&trainLocLock);
 //  I.  Application validity check:
+  uint			state	= trainPtr->getIdentity() + SLOT_FIRST_ID;
+  unsigned long long	ticket	= trainPtr->getStationTicket();
 
-//  II.  Make '*trainPtr' leave '*this':
-  dequeue(trainPtr);
+  if  (getState(ticket) != state)
+    return;
+
+  unsigned long long	expressTicket	= 0;
+  bool			isExpress	= false;
+
+  if  (trainPtr->getTrainClass() == EXPRESS_TRAIN)
+  {
+    unsigned long long	end
+		= __atomic_load_n(&expressTail,__ATOMIC_SEQ_CST);
+
+    expressTicket	= __atomic_load_n(&expressHead,__ATOMIC_SEQ_CST);
+
+    while  ( (expressTicket != end)  &&
+	     (getStateIn(expressSlotArray,expressTicket) != state)
+	   )
+      expressTicket++;
+
+    isExpress	= (expressTicket != end);
+  }
+
+//  II.  Make '*trainPtr' leave '*this'.  The departure is logged before
+//	 it shows, so that the Train behind logs its own after it:
+  unsigned long long	nowNsecs	= getMonotonicNsecs();
+  uint			count;
+
+  beginChange();
+  noteDeparture(trainPtr,nowNsecs);
   trainPtr->setLocPtr(NULL);
+  count	= __atomic_sub_fetch(&numTrains,1,__ATOMIC_SEQ_CST);
+  __atomic_store_n(&slotArray[ticket & mask],
+		   makeSlot(ticket,SLOT_DEPARTED),
+		   __ATOMIC_SEQ_CST
+		  );
+
+  if  (isExpress)
+    __atomic_store_n(&expressSlotArray[expressTicket & mask],
+		     makeSlot(expressTicket,SLOT_DEPARTED),
+		     __ATOMIC_SEQ_CST
+		    );
+
+  endChange();
+  advanceHead();
+  trace(trainPtr,TRACE_OCCUPANCY,nowNsecs,0,count);
 
 //  III.  Finished:
-  pthread_mutex_unlock(&trainLocLock);
 }
@@ -3,7 +3,11 @@
  *---		Station.h						---*
  *---									---*
  *---	    This file declares a class that represents a Station:	---*
- *---	where several Train instances may be without incident. 		---*
+ *---	where several Train instances may be without incident.  As a	---*
+ *---	Station has no limit on how many Train instances it holds, it	---*
+ *---	needs no lock: each arriving Train takes the next ticket, and	---*
+ *---	the first Train is the one whose ticket is 'head'.  Every	---*
+ *---	change is a single atomic operation, and readers never wait.	---*
  *---									---*
  *---	----	----	----	----	----	----	----	----	---*
  *---									---*
@@ -14,8 +18,57 @@
 class	Station : public TrainLocation
 {
   //  I.  Member vars:
-  //  PURPOSE:  To keep points to the tracks leading away from '*this' Station.
-  Track*			trackArray[NUM_LINES][NUM_DIRECTIONS];
+  //  PURPOSE:  To point to the tracks leading away from '*this' Station: the
+  //	Track for line 'line' in direction 'dir' is at
+  //	'trackArray[line*NUM_DIRECTIONS + dir]'.  This is a slice of an array
+  //	owned by MassTransit that holds those of every Station.
+  Track**			trackArray;
+
+  //  PURPOSE:  To refer to the MassTransit system of '*this' Station, to
+  //	look up its Train instances by id.
+  MassTransit&			massTransit;
+
+  //  PURPOSE:  To hold, for each ticket 't' from 'head' to 'tail', the word
+  //	'makeSlot(t,state)' at 'slotArray[t & mask]', where 'state' is
+  //	'SLOT_DEPARTED' once its Train left out of turn, or else its Train's
+  //	id plus 'SLOT_FIRST_ID'.  A slot whose ticket is not 't' belongs to a
+  //	Train that has its ticket but is still arriving.  The length,
+  //	'mask + 1', is a power of two at least four times 'maxNumTrains':
+  //	the first express Train only leaves out of turn while 'tail - head'
+  //	leaves room for twice that many, so that however many do so at
+  //	once, and then come back, the tickets from 'head' to 'tail' never
+  //	wrap.
+  unsigned long long*		slotArray;
+  unsigned long long		mask;
+
+  //  PURPOSE:  To tell the most Train instances that may ever be at '*this'
+  //	Station at once: those of the lines through it, as a Train never
+  //	changes its line.  Sizes the rings, rather than the whole fleet, so
+  //	that they take room in proportion to the Train instances that can
+  //	come here.
+  uint				maxNumTrains;
+
+  //  PURPOSE:  To hold, the same way and with the same length, the slots of
+  //	a second ring of tickets taken only by express Train instances, so
+  //	that the first express Train is the one whose ticket is
+  //	'expressHead', found without looking past the local ones.  Express
+  //	Train instances leave this ring out of turn only when they are the
+  //	first Train of all, so it never wraps either.
+  unsigned long long*		expressSlotArray;
+
+  //  PURPOSE:  To tell the ticket of the first Train, and the ticket to give
+  //	the next Train to arrive, and the same for express Train instances.
+  //	Only changed atomically, and on a cache line apart from the members
+  //	above, which are only read once built.
+  alignas(CACHE_LINE_BYTES)
+  unsigned long long		head;
+  unsigned long long		tail;
+  unsigned long long		expressHead;
+  unsigned long long		expressTail;
+
+  //  PURPOSE:  To tell the number of Train instances present.  Only changed
+  //	atomically.
+  uint				numTrains;
 
   //  II.  Disallowed auto-generated methods:
   //  No default constructor:
@@ -30,22 +83,120 @@ class	Station : public TrainLocation
 
 protected :
   //  III.  Protected methods:
+  //  PURPOSE:  To tell the 'state' of a slot whose Train left out of turn,
+  //	and what is added to a Train id to give the 'state' of its slot.
+  static
+  const uint			SLOT_DEPARTED	= 1;
+
+  static
+  const uint			SLOT_FIRST_ID	= 2;
+
+  //  PURPOSE:  To return the slot word of ticket 'ticket' in state 'state'.
+  static
+  unsigned long long
+		makeSlot	(unsigned long long	ticket,
+				 uint			state
+				)
+				throw()
+				{ return( (ticket << 32) | state ); }
+
+  //  PURPOSE:  To return the state that 'slot' gives ticket 'ticket', or
+  //	0 if 'slot' is not yet that of 'ticket'.
+  static
+  uint		getSlotState	(unsigned long long	slot,
+				 unsigned long long	ticket
+				)
+				throw()
+  {
+    return( ((uint)(slot >> 32) == (uint)ticket) ? (uint)slot : 0 );
+  }
+
+  //  PURPOSE:  To return the state of the slot of ticket 'ticket' in the
+  //	ring 'ringPtr[]', or 0 if its Train is still arriving.
+  uint		getStateIn	(const unsigned long long*	ringPtr,
+				 unsigned long long		ticket
+				)
+				const
+				throw()
+  {
+    return(getSlotState(__atomic_load_n(&ringPtr[ticket & mask],
+					__ATOMIC_SEQ_CST
+				       ),
+			ticket
+		       )
+	  );
+  }
+
+  //  PURPOSE:  To return the state of the slot of ticket 'ticket', or 0 if
+  //	its Train is still arriving.
+  uint		getState	(unsigned long long	ticket
+				)
+				const
+				throw()
+				{ return(getStateIn(slotArray,ticket)); }
+
+  //  PURPOSE:  To move '*headPtr', the first ticket of ring 'ringPtr[]',
+  //	past the tickets whose Train left, helping any other Train doing
+  //	the same.  No return value.
+  void		skipDeparted	(unsigned long long*	headPtr,
+				 const unsigned long long*	ringPtr
+				)
+				throw();
+
+  //  PURPOSE:  To return the Train whose slot has state 'state', or 'NULL'
+  //	if 'state' is not that of a Train.
+  Train*	getTrainOfState	(uint		state
+				)
+				const
+				throw();
+
+  //  PURPOSE:  To wake '*trainPtr', if it waits to leave '*this', or to
+  //	resume it, if it is parked by an ActorScheduler.  Taking its
+  //	'headLock' means it either has not yet looked whether it can leave,
+  //	or is waiting, and only one caller finds it waiting.  No return
+  //	value.
+  void		wakeIfWaiting	(Train*		trainPtr
+				)
+				throw();
+
+  //  PURPOSE:  To move 'head' past the tickets of Train instances that left,
+  //	helping any other Train doing the same, and then to wake or resume
+  //	the new first Train and the new first express one if they wait.  No
+  //	parameters.  No return value.
+  void		advanceHead	()
+				throw();
 
 public :
   //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
-  //  PURPOSE:  To create a station named 'newNameCPtr' with no trains, and
-  //	initially no tracks.
-  Station			(const char*	newNameCPtr
+  //  PURPOSE:  To create a station named 'newNameCPtr' of
+  //	'newMassTransit' with no trains, whose tracks are kept in the
+  //	'numLines*NUM_DIRECTIONS' slots starting at 'newTrackArray',
+  //	initially no tracks.  'setMaxNumTrains()' must be called before any
+  //	Train arrives.
+  Station			(const char*	newNameCPtr,
+				 Track**	newTrackArray,
+				 uint		numLines,
+				 MassTransit&	newMassTransit
 				)
 				throw() :
-				TrainLocation(newNameCPtr)
+				TrainLocation(newNameCPtr),
+				trackArray(newTrackArray),
+				massTransit(newMassTransit),
+				slotArray(NULL),
+				mask(0),
+				maxNumTrains(0),
+				expressSlotArray(NULL),
+				head(0),
+				tail(0),
+				expressHead(0),
+				expressTail(0),
+				numTrains(0)
   {
     //  I.  Applicability validity check:
 
     //  II.  Initialize other members:
-    for (uint line = (uint)MIN_LINE;  line <= (uint)MAX_LINE;  line++)
-      for (uint dir = (uint)MIN_DIRECTION;  dir <= (uint)MAX_DIRECTION;  dir++)
-        trackArray[line][dir] = NULL;
+    for (uint i = 0;  i < numLines * NUM_DIRECTIONS;  i++)
+      trackArray[i] = NULL;
 
     //  III.  Finished:
   }
@@ -56,6 +207,40 @@ public :
   				throw();
 
   //  V.  Accessors:
+  //  PURPOSE:  To return the number of trains.  No parameters.
+  uint			getNumTrains
+				()
+				const
+				throw()
+				{ return(__atomic_load_n(&numTrains,__ATOMIC_SEQ_CST)); }
+
+  //  PURPOSE:  To return the first Train, or 'NULL' if there is none or it
+  //	is still arriving.  Never waits.  No parameters.
+  Train*		getFirstTrain
+				()
+				const
+				throw()
+  {
+    return(getTrainOfState(getState(__atomic_load_n(&head,__ATOMIC_SEQ_CST))));
+  }
+
+  //  PURPOSE:  To return the first express Train, which may leave ahead of
+  //	the local ones before it, or 'NULL' if there is none or it is still
+  //	arriving.  Never waits.  No parameters.
+  Train*		getFirstExpressTrain
+				()
+				const
+				throw()
+  {
+    return(getTrainOfState(getStateIn(expressSlotArray,
+				      __atomic_load_n(&expressHead,
+						      __ATOMIC_SEQ_CST
+						     )
+				     )
+			  )
+	  );
+  }
+
   //  PURPOSE:  To return a ptr to the Track leading away from '*this' Station
   //	for line 'line' in direction 'dir'.
   Track*	getTrackPtr	(line_t		line,
@@ -67,11 +252,18 @@ public :
     //  I.  Application validity check:
 
     //  II.  Return value:
-    return(trackArray[(uint)line][(uint)direction]);
+    return(trackArray[(uint)line*NUM_DIRECTIONS + (uint)direction]);
   }
 
 
   //  VI.  Mutators:
+  //  PURPOSE:  To make room in '*this' Station for up to 'newMaxNumTrains'
+  //	Train instances at once.  Must be called once, before any Train
+  //	arrives.  No return value.
+  void		setMaxNumTrains	(uint		newMaxNumTrains
+				)
+				throw();
+
   //  PURPOSE:  To note that Track '*trackPtr' leads out of '*this' Station
   //	for line 'line' in direction 'dir'.  No return value.
   void		setTrackPtr	(line_t		line,
@@ -83,32 +275,86 @@ public :
     //  I.  Application validity check:
 
     //  II.  Set value:
-    trackArray[(uint)line][(uint)direction] = trackPtr;
+    trackArray[(uint)line*NUM_DIRECTIONS + (uint)direction] = trackPtr;
 
     //  III.  Finished:
   }
 
 
   //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To return 'true' if '*trainPtr' is the first 'Train' instance,
+  //	or 'false' otherwise.  Never waits.
+  bool			isFirstTrain
+				(const Train*	trainPtr
+				)
+				const
+				throw();
+
+  //  PURPOSE:  To copy the Train instances at '*this', first one first, into
+  //	'trainPtrVector'.  Never waits.  The copy may be torn by a change
+  //	made meanwhile.  No return value.
+  void			copyTrains
+				(std::vector<Train*>&	trainPtrVector
+				)
+				const
+				throw();
+
   //  PURPOSE:  To return 'true' if '*trainPtr' can leave '*this'
-  //	TrainLocation, or 'false' otherwise.
+  //	TrainLocation: if it is the first Train, or if it is the first
+  //	express one, which leaves ahead of the local ones before it while
+  //	the slots of those that did so leave room, or 'false' otherwise.
   bool			canLeave(Train*		trainPtr
   				)
 				const
 				throw();
 
+  //  PURPOSE:  To block until '*trainPtr' can leave '*this' Station, without
+  //	polling: 'leave()' wakes the next first Train and the next first
+  //	express one itself.  Returns 'true' if '*trainPtr' can leave, or
+  //	'false' if the simulation stopped first.
+  bool			waitUntilCanLeave
+				(Train*		trainPtr
+				)
+				throw();
+
+  //  PURPOSE:  To return 'true' at once if '*trainPtr' can leave '*this'
+  //	Station or, if not, to park it, run by an ActorScheduler, so that
+  //	'leave()' resumes it once it can, and to return 'false'.  Never
+  //	blocks.
+  bool			parkUntilCanLeave
+				(Train*		trainPtr
+				)
+				throw();
+
+  //  PURPOSE:  To note that '*trainPtr', parked by 'parkUntilCanLeave()'
+  //	since 'trainPtr->getActorSinceNsecs()', was resumed as one that can
+  //	leave.  Only the worker that runs '*trainPtr' may call it.  No
+  //	return value.
+  void			noteUnparked
+				(Train*		trainPtr
+				)
+				throw();
+
   //  PURPOSE:  To return a pointer to the next TrainLocation for '*trainPtr'
   //  	after it leaves '*this'.
   TrainLocation*	nextLocPtr
 				(Train*		trainPtr
 				);
 
+  //  PURPOSE:  To put the express Train instances at '*this', first one
+  //	first, into the express ring, after their classes changed.  Only
+  //	call while no Train moves.  No parameters.  No return value.
+  void			indexExpressTrains
+				()
+				throw();
+
   //  PURPOSE:  To make '*trainPtr' arrive at '*this'.  No return value.
   void			arrive	(Train*		trainPtr
   				)
 				throw();
 
-  //  PURPOSE:  To make '*trainPtr' leave '*this'.  No return value.
+  //  PURPOSE:  To make '*trainPtr' leave '*this', and wake the Train behind
+  //	it if that Train waits to leave.  No return value.
   void			leave	(Train*		trainPtr
   				)
 				throw();
@@ -0,0 +1,665 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Timetable.cpp						---*
+ *---									---*
+ *---	    This file defines a class that works out, offline, a	---*
+ *---	timetable by which the Train instances of a MassTransit system	---*
+ *---	may run without ever waiting for one another, and the shortest	---*
+ *---	headway on each line for which it can.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To return the greatest common divisor of 'a' and 'b'.
+static
+simTime_t	getGcd		(simTime_t	a,
+				 simTime_t	b
+				)
+{
+  while  (b != 0)
+  {
+    simTime_t	rest	= a % b;
+
+    a	= b;
+    b	= rest;
+  }
+
+  return(a);
+}
+
+
+//  PURPOSE:  To initialize '*this' to a timetable for 'newMassTransit',
+//	whose Train instances must already be placed, with the shortest
+//	headways found.  No return value.
+Timetable::Timetable		(const MassTransit&	newMassTransit
+				)
+				throw(const char*) :
+				massTransit(newMassTransit),
+				stayUsecs(0),
+				runUsecsVector(newMassTransit.getNumTracks(),0),
+				lineStationVector(newMassTransit.getNumLines()),
+				lineTrackVector(newMassTransit.getNumLines()),
+				lineNumTrainsVector(newMassTransit.getNumLines(),0),
+				lineRunUsecsVector(newMassTransit.getNumLines(),0),
+				headwayUsecsVector(newMassTransit.getNumLines(),0),
+				turnUsecsVector(newMassTransit.getNumLines(),0),
+				phaseUsecsVector(newMassTransit.getNumLines(),0),
+				lineStopVector(newMassTransit.getNumLines()),
+				lineDepartureUsecsVector
+				  (newMassTransit.getNumLines(),
+				   std::vector<simTime_t>
+					(newMassTransit.getNumStations()
+					 * NUM_DIRECTIONS,
+					 SIM_TIME_NEVER
+					)
+				  ),
+				isPlacedVector(newMassTransit.getNumLines(),false),
+				numChecks(0)
+{
+  //  I.  Application validity check:
+  uint		numLines	= massTransit.getNumLines();
+  uint		numStations	= massTransit.getNumStations();
+  uint		numTracks	= massTransit.getNumTracks();
+
+  //  II.  Find timetable:
+  //  II.A.  A Train stays for the dwell plus its mean pause, drawn exactly as
+  //	     'getRandomPauseUsecs()' draws it, and runs each Track at its
+  //	     speed limit:
+  unsigned long long	sumUsecs	= 0;
+
+  for  (uint i = 0;  i < 1000;  i++)
+    sumUsecs	+= (unsigned long long)i * massTransit.getMaxPauseUsecs() / 1000;
+
+  stayUsecs	= TIMETABLE_DWELL_USECS + sumUsecs / 1000;
+
+  for  (uint i = 0;  i < numTracks;  i++)
+  {
+    const Track*	trackPtr	= massTransit.getTrackPtr(i);
+
+    runUsecsVector[i]	= (simTime_t)llround(trackPtr->getLengthMeters()
+					     / trackPtr->getMaxSpeedMps()
+					     * USECS_PER_SEC
+					    );
+  }
+
+  //  II.B.  Walk each line from its north terminus, and count its fleet:
+  for  (line_t line = 0;  line < numLines;  line++)
+  {
+    uint	station;
+
+    for  (station = 0;  station < numStations;  station++)
+    {
+      const Station*	stationPtr	= massTransit.getStationPtr(station);
+
+      if  ( (stationPtr->getTrackPtr(line,NORTH) == NULL)  &&
+	    (stationPtr->getTrackPtr(line,SOUTH) != NULL)
+	  )
+	break;
+    }
+
+    while  (station < numStations)
+    {
+      const Track*	trackPtr
+			= massTransit.getStationPtr(station)->getTrackPtr(line,SOUTH);
+
+      lineStationVector[line].push_back(station);
+
+      if  (trackPtr == NULL)
+	break;
+
+      lineTrackVector[line].push_back(trackPtr->getIndex() - numStations);
+      station	= trackPtr->getTerminus(SOUTH).getIndex();
+    }
+  }
+
+  for  (uint i = 0;  i < massTransit.getNumTrains();  i++)
+    lineNumTrainsVector[massTransit.getTrainPtr(i)->getLine()]++;
+
+  for  (line_t line = 0;  line < numLines;  line++)
+  {
+    for  (uint i = 0;  i < lineTrackVector[line].size();  i++)
+      lineRunUsecsVector[line]
+		+= 2 * (runUsecsVector[lineTrackVector[line][i]] + stayUsecs);
+  }
+
+  //  II.C.  Try headways from the shortest that any fleet allows upward:
+  simTime_t	minHeadwaySecs	= SIM_TIME_NEVER;
+
+  for  (line_t line = 0;  line < numLines;  line++)
+    if  ( isServed(line) )
+    {
+      simTime_t	fleetUsecs	= lineRunUsecsVector[line]
+				  / lineNumTrainsVector[line];
+
+      minHeadwaySecs	= std::min(minHeadwaySecs,
+				   (fleetUsecs + USECS_PER_SEC - 1) / USECS_PER_SEC
+				  );
+    }
+
+  if  (minHeadwaySecs == SIM_TIME_NEVER)
+    throw "No line has Train instances to run by a timetable";
+
+  if  (minHeadwaySecs == 0)
+    minHeadwaySecs	= 1;
+
+  for  (simTime_t headwaySecs = minHeadwaySecs;
+	headwaySecs <= TIMETABLE_MAX_HEADWAY_SECS;
+	headwaySecs++
+       )
+  {
+    //  II.C.1.  Give each line the least multiple of the headway that its
+    //		 fleet can run, unless the timetable would take too long to
+    //		 repeat:
+    simTime_t	beatUsecs	= headwaySecs * USECS_PER_SEC;
+    simTime_t	periodUsecs	= beatUsecs;
+
+    for  (line_t line = 0;  line < numLines;  line++)
+    {
+      isPlacedVector[line]	= false;
+
+      if  ( !isServed(line) )
+	continue;
+
+      simTime_t	numBeats	= (lineRunUsecsVector[line]
+				   + lineNumTrainsVector[line] * beatUsecs - 1
+				  )
+				  / (lineNumTrainsVector[line] * beatUsecs);
+
+      headwayUsecsVector[line]	= std::max(numBeats,(simTime_t)1) * beatUsecs;
+      periodUsecs		= periodUsecs / getGcd(periodUsecs,
+						       headwayUsecsVector[line]
+						      )
+				  * headwayUsecsVector[line];
+    }
+
+    if  (periodUsecs > TIMETABLE_MAX_PERIOD_SECS * (simTime_t)USECS_PER_SEC)
+      continue;
+
+    //  II.C.2.  Skip headways at which some Track is busier than it has room
+    //		 for, however the lines are shifted:
+    bool	isTooBusy	= false;
+
+    for  (uint i = 0;  (i < numTracks) && !isTooBusy;  i++)
+    {
+      double	busyFraction	= 0.0;
+
+      for  (line_t line = 0;  line < numLines;  line++)
+	if  ( isServed(line)  &&  massTransit.isOnLine(numStations + i,line) )
+	  busyFraction	+= 2.0 * runUsecsVector[i] / headwayUsecsVector[line];
+
+      isTooBusy	= (busyFraction > massTransit.getTrackPtr(i)->getCapacity());
+    }
+
+    if  (isTooBusy)
+      continue;
+
+    //  II.C.3.  Place the lines one by one:
+    bool	haveAllFit	= true;
+
+    for  (line_t line = 0;  (line < numLines) && haveAllFit;  line++)
+      if  ( isServed(line) )
+	haveAllFit	= place(line);
+
+    if  (haveAllFit)
+      return;
+  }
+
+  //  III.  Finished:
+  throw "No conflict-free timetable has a headway of an hour or less";
+}
+
+
+//  PURPOSE:  To fill the stops of line 'line' from its headway and turn.
+//	No return value.
+void		Timetable::buildStops
+				(line_t		line
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  const std::vector<uint>&	stationVector	= lineStationVector[line];
+  const std::vector<uint>&	trackVector	= lineTrackVector[line];
+  std::vector<TimetableStop>&	stopVector	= lineStopVector[line];
+  std::vector<simTime_t>&	departureVector	= lineDepartureUsecsVector[line];
+  uint				numStations	= massTransit.getNumStations();
+  uint				numLineTracks	= trackVector.size();
+  simTime_t			cycleUsecs	= lineNumTrainsVector[line]
+						  * headwayUsecsVector[line];
+  simTime_t			t		= 0;
+  TimetableStop			stop;
+
+  stopVector.clear();
+
+  //  II.  Build stops:
+  //  II.A.  Run south, stopping at each Station on the way:
+  for  (uint j = 0;  j < numLineTracks;  j++)
+  {
+    stop.locIndex	= numStations + trackVector[j];
+    stop.direction	= SOUTH;
+    stop.startUsecs	= t;
+    stop.endUsecs	= t += runUsecsVector[trackVector[j]];
+    stopVector.push_back(stop);
+
+    if  (j + 1 < numLineTracks)
+    {
+      stop.locIndex	= stationVector[j+1];
+      stop.startUsecs	= t;
+      stop.endUsecs	= t += stayUsecs;
+      stopVector.push_back(stop);
+    }
+  }
+
+  //  II.B.  Turn at the south terminus:
+  stop.locIndex		= stationVector[numLineTracks];
+  stop.direction	= NORTH;
+  stop.startUsecs	= t;
+  stop.endUsecs		= t += stayUsecs + turnUsecsVector[line];
+  stopVector.push_back(stop);
+
+  //  II.C.  Run north, stopping at each Station on the way:
+  for  (uint j = numLineTracks;  j-- > 0;  )
+  {
+    stop.locIndex	= numStations + trackVector[j];
+    stop.direction	= NORTH;
+    stop.startUsecs	= t;
+    stop.endUsecs	= t += runUsecsVector[trackVector[j]];
+    stopVector.push_back(stop);
+
+    if  (j > 0)
+    {
+      stop.locIndex	= stationVector[j];
+      stop.startUsecs	= t;
+      stop.endUsecs	= t += stayUsecs;
+      stopVector.push_back(stop);
+    }
+  }
+
+  //  II.D.  Turn at the north terminus until the trip 'N' trips later:
+  stop.locIndex		= stationVector[0];
+  stop.direction	= SOUTH;
+  stop.startUsecs	= t;
+  stop.endUsecs		= cycleUsecs;
+  stopVector.push_back(stop);
+
+  //  II.E.  Note when each Station is left, the north terminus at the start
+  //	     of the trip:
+  for  (size_t i = 0;  i < stopVector.size();  i++)
+    if  (stopVector[i].locIndex < numStations)
+      departureVector[stopVector[i].locIndex * NUM_DIRECTIONS
+		      + stopVector[i].direction
+		     ]
+		= stopVector[i].endUsecs % cycleUsecs;
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To return 'true' if no place of line 'line' is ever due to
+//	hold too many Train instances or to let one leave before another
+//	that got there earlier, counting only line 'line' if 'isAlone' or
+//	also every line placed before it otherwise, or 'false' if one is.
+bool		Timetable::isConflictFree
+				(line_t		line,
+				 bool		isAlone
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  const std::vector<TimetableStop>&	stopVector	= lineStopVector[line];
+  uint			numStations	= massTransit.getNumStations();
+  simTime_t		periodUsecs	= headwayUsecsVector[line];
+
+  numChecks++;
+
+  if  ( !isAlone )
+    for  (line_t other = 0;  other < line;  other++)
+      if  (isPlacedVector[other])
+	periodUsecs	= periodUsecs / getGcd(periodUsecs,
+					       headwayUsecsVector[other]
+					      )
+			  * headwayUsecsVector[other];
+
+  //  II.  Check each place of 'line' once:
+  long long	period	= (long long)periodUsecs;
+
+  for  (size_t i = 0;  i < stopVector.size();  i++)
+  {
+    uint	locIndex	= stopVector[i].locIndex;
+    bool	isSeen		= false;
+
+    for  (size_t j = 0;  (j < i) && !isSeen;  j++)
+      isSeen	= (stopVector[j].locIndex == locIndex);
+
+    if  (isSeen)
+      continue;
+
+    //  II.A.  Gather the stops there of every line counted, each repeated
+    //	     every headway.  A Track needs every stay that overlaps one
+    //	     period; a Station needs every arrival up to the longest stay
+    //	     past it, since only a Train that got there less than a stay
+    //	     earlier may still be there:
+    bool	isTrack		= (locIndex >= numStations);
+    long long	longestStay	= 0;
+    std::vector<std::pair<long long,long long> >
+		visitVector;
+    std::vector<direction_t>
+		directionVector;
+
+    for  (line_t other = 0;  other <= line;  other++)
+    {
+      if  ( (other != line)  &&  (isAlone  ||  !isPlacedVector[other]) )
+	continue;
+
+      const std::vector<TimetableStop>&	otherStopVector	= lineStopVector[other];
+
+      for  (size_t j = 0;  j < otherStopVector.size();  j++)
+	if  (otherStopVector[j].locIndex == locIndex)
+	  longestStay	= std::max(longestStay,
+				   (long long)(otherStopVector[j].endUsecs
+					       - otherStopVector[j].startUsecs
+					      )
+				  );
+    }
+
+    for  (line_t other = 0;  other <= line;  other++)
+    {
+      if  ( (other != line)  &&  (isAlone  ||  !isPlacedVector[other]) )
+	continue;
+
+      const std::vector<TimetableStop>&	otherStopVector	= lineStopVector[other];
+      long long	headway	= (long long)headwayUsecsVector[other];
+
+      for  (size_t j = 0;  j < otherStopVector.size();  j++)
+      {
+	const TimetableStop&	stop	= otherStopVector[j];
+
+	if  (stop.locIndex != locIndex)
+	  continue;
+
+	long long	length	= (long long)(stop.endUsecs - stop.startUsecs);
+	long long	start	= (long long)((phaseUsecsVector[other]
+					       + stop.startUsecs
+					      )
+					      % headway
+					     );
+	long long	end	= isTrack ? period : (period + longestStay);
+
+	if  (isTrack)
+	  start	-= (length + headway - 1) / headway * headway;
+
+	for  ( ;  start < end;  start += headway)
+	{
+	  visitVector.push_back(std::make_pair(start,start + length));
+	  directionVector.push_back(stop.direction);
+	}
+      }
+    }
+
+    //  II.B.  A Track may never hold more Train instances than its
+    //	     capacity, nor, if block signalled, ones heading both ways:
+    if  (isTrack)
+    {
+      const Track*	trackPtr	= massTransit.getTrackPtr(locIndex - numStations);
+      std::vector<std::pair<long long,int> >
+			eventVector;
+      uint		numHeadingArray[NUM_DIRECTIONS]	= {0,0};
+      uint		numTrains	= 0;
+
+      for  (size_t j = 0;  j < visitVector.size();  j++)
+      {
+	long long	start	= std::max(visitVector[j].first,0LL);
+	long long	end	= std::min(visitVector[j].second,period);
+	int		dir	= (int)directionVector[j];
+
+	if  (start >= end)
+	  continue;
+
+	//  Leaving ('dir') sorts before arriving ('NUM_DIRECTIONS + dir') at
+	//  the same time, as a Train may enter as another leaves:
+	eventVector.push_back(std::make_pair(start,NUM_DIRECTIONS + dir));
+	eventVector.push_back(std::make_pair(end,dir));
+      }
+
+      std::sort(eventVector.begin(),eventVector.end());
+
+      for  (size_t j = 0;  j < eventVector.size();  j++)
+      {
+	uint	dir	= eventVector[j].second % NUM_DIRECTIONS;
+
+	if  (eventVector[j].second < NUM_DIRECTIONS)
+	{
+	  numHeadingArray[dir]--;
+	  numTrains--;
+	  continue;
+	}
+
+	numHeadingArray[dir]++;
+	numTrains++;
+
+	if  ( (numTrains > trackPtr->getCapacity())  ||
+	      ( trackPtr->getIsBlockSignalled()  &&
+		(numHeadingArray[NORTH] > 0)  &&
+		(numHeadingArray[SOUTH] > 0)
+	      )
+	    )
+	  return(false);
+      }
+
+      continue;
+    }
+
+    //  II.C.  A Station lets Train instances leave in the order they came,
+    //	     so none may be due to leave after one that came later.  Ones
+    //	     that come together must leave together, as either may be
+    //	     first:
+    long long	latestEnd	= -1;
+
+    std::sort(visitVector.begin(),visitVector.end());
+
+    for  (size_t j = 0;  j < visitVector.size();  )
+    {
+      size_t	k	= j;
+
+      for  ( ;
+	    (k < visitVector.size())  &&
+	    (visitVector[k].first == visitVector[j].first);
+	    k++
+	   )
+	if  ( (visitVector[k].second != visitVector[j].second)  ||
+	      (visitVector[k].second < latestEnd)
+	    )
+	  return(false);
+
+      latestEnd	= std::max(latestEnd,visitVector[j].second);
+      j		= k;
+    }
+  }
+
+  //  III.  Finished:
+  return(true);
+}
+
+
+//  PURPOSE:  To try to give line 'line' a turn and a shift that fit
+//	with the lines placed so far, its headway being set.  Returns
+//	'true' on success or 'false' if none does.
+bool		Timetable::place(line_t		line
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  simTime_t	headway		= headwayUsecsVector[line];
+  simTime_t	slackUsecs	= lineNumTrainsVector[line] * headway
+				  - lineRunUsecsVector[line];
+  bool		isSharing	= false;
+
+  for  (line_t other = 0;  (other < line) && !isSharing;  other++)
+    if  (isPlacedVector[other])
+      for  (uint i = 0;  i < massTransit.getNumLocations();  i++)
+	if  ( massTransit.isOnLine(i,line)  &&  massTransit.isOnLine(i,other) )
+	{
+	  isSharing	= true;
+	  break;
+	}
+
+  //  II.  Try each split of the turning time, then each shift against the
+  //	   lines that share a place with 'line'.  Turns a headway apart put
+  //	   the Train instances of 'line' on its Track instances at the same
+  //	   times, so only those shorter than a headway are tried:
+  for  (simTime_t turn = 0;
+	(turn <= slackUsecs)  &&  (turn < headway);
+	turn += TIMETABLE_STEP_USECS
+       )
+  {
+    turnUsecsVector[line]	= turn;
+    phaseUsecsVector[line]	= 0;
+    buildStops(line);
+
+    if  ( !isConflictFree(line,true) )
+      continue;
+
+    if  ( !isSharing )
+    {
+      isPlacedVector[line]	= true;
+      return(true);
+    }
+
+    for  (simTime_t phase = 0;  phase < headway;  phase += TIMETABLE_STEP_USECS)
+    {
+      phaseUsecsVector[line]	= phase;
+
+      if  ( isConflictFree(line,false) )
+      {
+	isPlacedVector[line]	= true;
+	return(true);
+      }
+    }
+  }
+
+  //  III.  Finished:
+  return(false);
+}
+
+
+//  PURPOSE:  To return the time by the timetable at which a run starts:
+//	the longest round trip of any line, so that every trip under way
+//	then left its north terminus at or after time 0.  No parameters.
+simTime_t	Timetable::getStartUsecs
+				()
+				const
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Find longest:
+  simTime_t	startUsecs	= 0;
+
+  for  (line_t line = 0;  line < massTransit.getNumLines();  line++)
+    startUsecs	= std::max(startUsecs,
+			   lineNumTrainsVector[line] * headwayUsecsVector[line]
+			  );
+
+  //  III.  Finished:
+  return(startUsecs);
+}
+
+
+//  PURPOSE:  To return where the 'i'-th Train of line 'line' is due to be
+//	when a run starts, having it make the latest trip to have left the
+//	north terminus by then less 'i' headways.  Sets 'trip' to that trip
+//	and 'sinceUsecs' to how long it has been there by then.
+const TimetableStop&
+		Timetable::getStartStop
+				(line_t		line,
+				 uint		i,
+				 unsigned long long&
+						trip,
+				 simTime_t&	sinceUsecs
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+  const std::vector<TimetableStop>&	stopVector	= lineStopVector[line];
+  simTime_t	headway		= headwayUsecsVector[line];
+  simTime_t	cycleUsecs	= lineNumTrainsVector[line] * headway;
+  simTime_t	leftUsecs	= getStartUsecs() - phaseUsecsVector[line];
+
+  //  II.  Find the stop.  Trip 'trip' is 'leftUsecs - trip*headway' into
+  //	   its round trip at the start, the latest trip less than a round
+  //	   trip:
+  trip	= (leftUsecs < cycleUsecs)
+	  ? 0
+	  : ((leftUsecs - cycleUsecs) / headway + 1);
+  trip	+= i;
+
+  simTime_t	intoUsecs	= leftUsecs - trip * headway;
+  size_t	j;
+
+  for  (j = 0;  j + 1 < stopVector.size();  j++)
+    if  (intoUsecs < stopVector[j].endUsecs)
+      break;
+
+  sinceUsecs	= intoUsecs - stopVector[j].startUsecs;
+
+  //  III.  Finished:
+  return(stopVector[j]);
+}
+
+
+//  PURPOSE:  To print the headway, trains per hour, round trip and
+//	turns of each line to 'filePtr'.  No return value.
+void		Timetable::print(FILE*		filePtr
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Print each line:
+  fprintf(filePtr,
+	  "Timetable, with stays of %.1f secs, found in %llu checks:\n"
+	  "  %-8s %6s %9s %9s %9s %9s %9s %9s\n",
+	  (double)stayUsecs / USECS_PER_SEC,
+	  numChecks,
+	  "line","trains","headway","trains/h","fleet","cycle","turn N","turn S"
+	 );
+
+  for  (line_t line = 0;  line < massTransit.getNumLines();  line++)
+  {
+    if  ( !isServed(line) )
+    {
+      fprintf(filePtr,"  %-8s %6u %9s\n",
+	      massTransit.getLineNameCPtr(line),
+	      lineNumTrainsVector[line],
+	      "-"
+	     );
+      continue;
+    }
+
+    simTime_t	cycleUsecs	= lineNumTrainsVector[line]
+				  * headwayUsecsVector[line];
+    simTime_t	slackUsecs	= cycleUsecs - lineRunUsecsVector[line];
+
+    fprintf(filePtr,"  %-8s %6u %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+	    massTransit.getLineNameCPtr(line),
+	    lineNumTrainsVector[line],
+	    (double)headwayUsecsVector[line] / USECS_PER_SEC,
+	    3600.0 * USECS_PER_SEC / headwayUsecsVector[line],
+	    (double)lineRunUsecsVector[line]
+		/ lineNumTrainsVector[line] / USECS_PER_SEC,
+	    (double)cycleUsecs / USECS_PER_SEC,
+	    (double)(stayUsecs + slackUsecs - turnUsecsVector[line])
+		/ USECS_PER_SEC,
+	    (double)(stayUsecs + turnUsecsVector[line]) / USECS_PER_SEC
+	   );
+  }
+
+  //  III.  Finished:
+}
@@ -0,0 +1,240 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Timetable.h						---*
+ *---									---*
+ *---	    This file declares a class that works out, offline, a	---*
+ *---	timetable by which the Train instances of a MassTransit system	---*
+ *---	may run without ever waiting for one another, and the shortest	---*
+ *---	headway on each line for which it can.  Each Train runs over	---*
+ *---	each Track in the time its length and speed limit take, and	---*
+ *---	stays at each Station for a dwell; a line whose 'N' Train	---*
+ *---	instances leave its north terminus 'H' apart takes 'N*H' for	---*
+ *---	a round trip, the time not spent running or dwelling being	---*
+ *---	spent turning at its two termini.  Every trip of a line keeps	---*
+ *---	the same pattern, shifted by 'H', so the whole timetable	---*
+ *---	repeats after the least common multiple of the headways.	---*
+ *---									---*
+ *---	    The search tries headways from the shortest the fleets	---*
+ *---	allow upward.  For each, every line gets the smallest multiple	---*
+ *---	of it that its fleet can run, so that lines sharing a Track	---*
+ *---	keep a common beat, and then, line by line, a split of its	---*
+ *---	turning time between its termini and a shift of its pattern	---*
+ *---	against the lines placed before it such that no Track ever	---*
+ *---	holds more Train instances than it may (or, if block		---*
+ *---	signalled, ones heading both ways), and no Train is due to	---*
+ *---	leave a Station before one that got there earlier.  The first	---*
+ *---	headway for which every line fits is the answer.		---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To describe one place that every trip of a line is due at, as
+//	the index of its TrainLocation, the way the Train heads when it
+//	leaves, and when it is due to get there and to leave, in
+//	microseconds from when the trip leaves its north terminus.
+struct	TimetableStop
+{
+  uint				locIndex;
+  direction_t			direction;
+  simTime_t			startUsecs;
+  simTime_t			endUsecs;
+};
+
+
+class	Timetable
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To refer to the MassTransit system to be run by '*this'.
+  const MassTransit&		massTransit;
+
+  //  PURPOSE:  To tell how long a Train is due to stay at a Station that
+  //	does not end its line: the dwell plus its mean pause.
+  simTime_t			stayUsecs;
+
+  //  PURPOSE:  To tell, for each Track, how long a Train takes to run over
+  //	it.
+  std::vector<simTime_t>	runUsecsVector;
+
+  //  PURPOSE:  To tell, for each line, its Station instances from north to
+  //	south, and the Track instances between them.
+  std::vector<std::vector<uint> >
+				lineStationVector;
+  std::vector<std::vector<uint> >
+				lineTrackVector;
+
+  //  PURPOSE:  To tell, for each line, how many Train instances serve it,
+  //	and how long a round trip takes if they never turn for longer than
+  //	a stay.
+  std::vector<uint>		lineNumTrainsVector;
+  std::vector<simTime_t>	lineRunUsecsVector;
+
+  //  PURPOSE:  To tell, for each line, the headway, how much longer than a
+  //	stay it turns at its south terminus, and by how much its pattern is
+  //	shifted.
+  std::vector<simTime_t>	headwayUsecsVector;
+  std::vector<simTime_t>	turnUsecsVector;
+  std::vector<simTime_t>	phaseUsecsVector;
+
+  //  PURPOSE:  To tell, for each line, where and when each trip is due.
+  std::vector<std::vector<TimetableStop> >
+				lineStopVector;
+
+  //  PURPOSE:  To tell, for each line, when each trip is due to leave each
+  //	Station 'i' heading 'dir', at index 'i * NUM_DIRECTIONS + dir', or
+  //	'SIM_TIME_NEVER' where none does.
+  std::vector<std::vector<simTime_t> >
+				lineDepartureUsecsVector;
+
+  //  PURPOSE:  To tell, for each line, whether it has a headway yet.
+  std::vector<bool>		isPlacedVector;
+
+  //  PURPOSE:  To tell how many conflict checks the search made.
+  unsigned long long		numChecks;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  Timetable			();
+
+  //  No copy constructor:
+  Timetable			(const Timetable&);
+
+  //  No copy assignment op:
+  Timetable&			operator=
+				(const Timetable&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To return 'true' if line 'line' has Train instances and
+  //	Track instances to run them over, or 'false' otherwise.
+  bool		isServed	(line_t		line
+				)
+				const
+				throw()
+  { return( (lineNumTrainsVector[line] > 0)  &&
+	    !lineTrackVector[line].empty()
+	  );
+  }
+
+  //  PURPOSE:  To fill the stops of line 'line' from its headway and turn.
+  //	No return value.
+  void		buildStops	(line_t		line
+				)
+				throw();
+
+  //  PURPOSE:  To return 'true' if no place of line 'line' is ever due to
+  //	hold too many Train instances or to let one leave before another
+  //	that got there earlier, counting only line 'line' if 'isAlone' or
+  //	also every line placed before it otherwise, or 'false' if one is.
+  bool		isConflictFree	(line_t		line,
+				 bool		isAlone
+				)
+				throw();
+
+  //  PURPOSE:  To try to give line 'line' a turn and a shift that fit
+  //	with the lines placed so far, its headway being set.  Returns
+  //	'true' on success or 'false' if none does.
+  bool		place		(line_t		line
+				)
+				throw();
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to a timetable for 'newMassTransit',
+  //	whose Train instances must already be placed, with the shortest
+  //	headways found.  No return value.
+  Timetable			(const MassTransit&	newMassTransit
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~Timetable			()
+				throw()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return how long a Train is due to stay at a Station that
+  //	does not end its line.  No parameters.
+  simTime_t	getStayUsecs	()
+				const
+				throw()
+				{ return(stayUsecs); }
+
+  //  PURPOSE:  To return how long a Train takes to run over the 'i'-th
+  //	Track.
+  simTime_t	getRunUsecs	(uint		i
+				)
+				const
+				throw()
+				{ return(runUsecsVector[i]); }
+
+  //  PURPOSE:  To return the headway of line 'line', or 0 if it has no
+  //	Train instances.
+  simTime_t	getHeadwayUsecs	(line_t		line
+				)
+				const
+				throw()
+				{ return(headwayUsecsVector[line]); }
+
+  //  PURPOSE:  To return the number of Train instances that serve line
+  //	'line', one for each trip of a round trip.
+  uint		getLineNumTrains(line_t		line
+				)
+				const
+				throw()
+				{ return(lineNumTrainsVector[line]); }
+
+  //  PURPOSE:  To return the time by the timetable at which a run starts:
+  //	the longest round trip of any line, so that every trip under way
+  //	then left its north terminus at or after time 0.  No parameters.
+  simTime_t	getStartUsecs	()
+				const
+				throw();
+
+  //  PURPOSE:  To return where the 'i'-th Train of line 'line' is due to be
+  //	when a run starts, having it make the latest trip to have left the
+  //	north terminus by then less 'i' headways.  Sets 'trip' to that trip
+  //	and 'sinceUsecs' to how long it has been there by then.
+  const TimetableStop&
+		getStartStop	(line_t		line,
+				 uint		i,
+				 unsigned long long&
+						trip,
+				 simTime_t&	sinceUsecs
+				)
+				const
+				throw();
+
+  //  PURPOSE:  To return when trip 'trip' of line 'line' is due to leave
+  //	the Station with index 'station' heading 'dir'.  Trip 'n' leaves the
+  //	north terminus a headway after trip 'n-1' and becomes trip 'n+N'
+  //	when it gets back there, 'N' being the fleet of the line.
+  simTime_t	getDepartureUsecs
+				(line_t		line,
+				 uint		station,
+				 direction_t	dir,
+				 unsigned long long
+						trip
+				)
+				const
+				throw()
+  {
+    return( phaseUsecsVector[line]					+
+	    lineDepartureUsecsVector[line][station*NUM_DIRECTIONS + dir]	+
+	    trip * headwayUsecsVector[line]
+	  );
+  }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To print the headway, trains per hour, round trip and
+  //	turns of each line to 'filePtr'.  No return value.
+  void		print		(FILE*		filePtr
+				)
+				const
+				throw();
+
+};
@@ -0,0 +1,442 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		TopologyFile.cpp					---*
+ *---									---*
+ *---	    This file defines a class that reads the Station, Track	---*
+ *---	and line layout of a MassTransit system from a text file.	---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To tell the topology used when no file is given: the red and
+//	brown lines sharing the tunnel between 'N Tunnel Station' and
+//	'S Tunnel Station'.
+static
+const char*	DEFAULT_TOPOLOGY	=
+  "station NRed     2 23 N Red Station\n"
+  "station NBrown   1  0 N Brown Station\n"
+  "station NTunnel  8  9 N Tunnel Station\n"
+  "station STunnel 12  9 S Tunnel Station\n"
+  "station SRed    18 23 S Red Station\n"
+  "station SBrown  19  0 S Brown Station\n"
+  "track NRedTrack   NRed    NTunnel  4 23 N Red Track\n"
+  "track NBrownTrack NBrown  NTunnel  3  0 N Brown Track\n"
+  "track TunnelTrack NTunnel STunnel 10  9 Tunnel Track\n"
+  "track SRedTrack   STunnel SRed    16 23 S Red Track\n"
+  "track SBrownTrack STunnel SBrown  17  0 S Brown Track\n"
+  "line Red NRedTrack   TunnelTrack SRedTrack\n"
+  "line Brn NBrownTrack TunnelTrack SBrownTrack\n"
+  "profile NRedTrack   1800 25\n"
+  "profile NBrownTrack 1500 25\n"
+  "profile TunnelTrack 2400 15\n"
+  "profile SRedTrack   1800 25\n"
+  "profile SBrownTrack 1500 25\n"
+  "text  2  6 |\n"
+  "text  4  6 |\n"
+  "text  3 29 |\n"
+  "text  5  7 \\\n"
+  "text  6  8 \\\n"
+  "text  7  9 \\\n"
+  "text  5 28 /\n"
+  "text  6 27 /\n"
+  "text  7 26 /\n"
+  "text  9 18 |\n"
+  "text 11 18 |\n"
+  "text 13  9 /\n"
+  "text 14  8 /\n"
+  "text 15  7 /\n"
+  "text 13 26 \\\n"
+  "text 14 27 \\\n"
+  "text 15 28 \\\n"
+  "text 16  6 |\n"
+  "text 18  6 |\n"
+  "text 17 29 |\n";
+
+
+//  PURPOSE:  To hold the text of the last error thrown by a TopologyFile,
+//	with room for a key or name of up to 'MAX_STRING_LEN' and the words
+//	around it.
+static
+char		errorText[2*MAX_STRING_LEN];
+
+
+//  PURPOSE:  To copy the text that follows whitespace at 'cPtr', without
+//	its trailing newline, into 'destCPtr'.  No return value.
+static
+void		copyRestOfLine	(char*		destCPtr,
+				 const char*	cPtr
+				)
+{
+  while  ( (*cPtr == ' ')  ||  (*cPtr == '\t') )
+    cPtr++;
+
+  snprintf(destCPtr,MAX_STRING_LEN,"%s",cPtr);
+
+  char*	endCPtr	= destCPtr + strlen(destCPtr);
+
+  while  ( (endCPtr > destCPtr)  &&
+	   ( (endCPtr[-1] == '\n')  ||  (endCPtr[-1] == '\r')  ||
+	     (endCPtr[-1] == ' ')   ||  (endCPtr[-1] == '\t')
+	   )
+	 )
+    *--endCPtr	= '\0';
+}
+
+
+//  PURPOSE:  To load the topology in file 'pathCPtr', or the built-in
+//	two-line system with the shared tunnel if 'pathCPtr' is 'NULL'.
+//	No return value.
+TopologyFile::TopologyFile	(const char*	pathCPtr
+				)
+				throw(const char*)
+{
+  //  I.  Application validity check:
+
+  //  II.  Parse topology:
+  char*		lineCPtr	= NULL;
+  size_t	lineLen		= 0;
+  uint		lineNum		= 0;
+
+  if  (pathCPtr == NULL)
+  {
+    //  II.A.  Parse the built-in topology:
+    const char*	cPtr	= DEFAULT_TOPOLOGY;
+
+    while  (*cPtr != '\0')
+    {
+      const char*	endCPtr	= strchr(cPtr,'\n');
+
+      lineCPtr	= strndup(cPtr,endCPtr - cPtr);
+      parseLine(lineCPtr,++lineNum);
+      safeFree(lineCPtr);
+      cPtr	= endCPtr + 1;
+    }
+  }
+  else
+  {
+    //  II.B.  Parse file 'pathCPtr', whose lines may be of any length:
+    FILE*	filePtr	= fopen(pathCPtr,"r");
+
+    if  (filePtr == NULL)
+    {
+      snprintf(errorText,sizeof(errorText),"Cannot open topology file %s",
+	       pathCPtr
+	      );
+      throw (const char*)errorText;
+    }
+
+    try
+    {
+      while  (getline(&lineCPtr,&lineLen,filePtr) != -1)
+	parseLine(lineCPtr,++lineNum);
+    }
+    catch  (const char*)
+    {
+      safeFree(lineCPtr);
+      fclose(filePtr);
+      throw;
+    }
+
+    safeFree(lineCPtr);
+    fclose(filePtr);
+  }
+
+  //  II.C.  Make sure the result is usable:
+  validate();
+  stationKeyMap.clear();
+  trackKeyMap.clear();
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To parse 'lineCPtr', which is line 'lineNum' of the input.
+//	No return value.
+void		TopologyFile::parseLine	(char*		lineCPtr,
+					 uint		lineNum
+					)
+					throw(const char*)
+{
+  //  I.  Application validity check:
+  char	keyword[MAX_STRING_LEN];
+  int	numChars;
+
+  if  ( (sscanf(lineCPtr," %255s%n",keyword,&numChars) != 1)  ||
+	(keyword[0] == '#')
+      )
+    return;
+
+  lineCPtr	+= numChars;
+
+  //  II.  Parse line:
+  if  (strcmp(keyword,"station") == 0)
+  {
+    //  II.A.  Parse a Station:
+    char	key[MAX_STRING_LEN];
+    StationSpec	spec;
+
+    if  (sscanf(lineCPtr," %255s %d %d%n",key,&spec.row,&spec.col,&numChars)
+	 != 3
+	)
+    {
+      snprintf(errorText,sizeof(errorText),
+	       "Line %u: expected 'station <key> <row> <col> <name>'",lineNum
+	      );
+      throw (const char*)errorText;
+    }
+
+    copyRestOfLine(spec.name,lineCPtr + numChars);
+
+    if  (stationKeyMap.find(key) != stationKeyMap.end())
+    {
+      snprintf(errorText,sizeof(errorText),"Line %u: station %s defined twice",
+	       lineNum,key
+	      );
+      throw (const char*)errorText;
+    }
+
+    stationKeyMap[key]	= stationVector.size();
+    stationVector.push_back(spec);
+  }
+  else
+  if  (strcmp(keyword,"track") == 0)
+  {
+    //  II.B.  Parse a Track:
+    char	key[MAX_STRING_LEN];
+    char	northKey[MAX_STRING_LEN];
+    char	southKey[MAX_STRING_LEN];
+    TrackSpec	spec;
+
+    if  (sscanf(lineCPtr," %255s %255s %255s %d %d%n",
+		key,northKey,southKey,&spec.row,&spec.col,&numChars
+	       )
+	 != 5
+	)
+    {
+      snprintf(errorText,sizeof(errorText),
+	       "Line %u: expected 'track <key> <northStationKey> "
+	       "<southStationKey> <row> <col> <name>'",
+	       lineNum
+	      );
+      throw (const char*)errorText;
+    }
+
+    copyRestOfLine(spec.name,lineCPtr + numChars);
+
+    std::map<std::string,uint>::const_iterator	northIter;
+    std::map<std::string,uint>::const_iterator	southIter;
+
+    northIter	= stationKeyMap.find(northKey);
+    southIter	= stationKeyMap.find(southKey);
+
+    if  ( (northIter == stationKeyMap.end())  ||
+	  (southIter == stationKeyMap.end())
+	)
+    {
+      snprintf(errorText,sizeof(errorText),
+	       "Line %u: track %s joins undefined station(s)",lineNum,key
+	      );
+      throw (const char*)errorText;
+    }
+
+    if  (trackKeyMap.find(key) != trackKeyMap.end())
+    {
+      snprintf(errorText,sizeof(errorText),"Line %u: track %s defined twice",
+	       lineNum,key
+	      );
+      throw (const char*)errorText;
+    }
+
+    spec.termini[NORTH]	= northIter->second;
+    spec.termini[SOUTH]	= southIter->second;
+    spec.lengthMeters	= DEFAULT_TRACK_LENGTH_METERS;
+    spec.maxSpeedMps	= DEFAULT_TRACK_MAX_SPEED_MPS;
+    trackKeyMap[key]	= trackVector.size();
+    trackVector.push_back(spec);
+  }
+  else
+  if  (strcmp(keyword,"line") == 0)
+  {
+    //  II.C.  Parse a line:
+    LineSpec	spec;
+    char	key[MAX_STRING_LEN];
+
+    if  (sscanf(lineCPtr," %255s%n",spec.name,&numChars) != 1)
+    {
+      snprintf(errorText,sizeof(errorText),
+	       "Line %u: expected 'line <name> <trackKey> ...'",lineNum
+	      );
+      throw (const char*)errorText;
+    }
+
+    for  ( lineCPtr += numChars;
+	   sscanf(lineCPtr," %255s%n",key,&numChars) == 1;
+	   lineCPtr += numChars
+	 )
+    {
+      std::map<std::string,uint>::const_iterator
+		iter	= trackKeyMap.find(key);
+
+      if  (iter == trackKeyMap.end())
+      {
+	snprintf(errorText,sizeof(errorText),"Line %u: undefined track %s",
+		 lineNum,key
+		);
+	throw (const char*)errorText;
+      }
+
+      uint	trackIndex	= iter->second;
+
+      if  ( !spec.trackIndexVector.empty()  &&
+	    ( trackVector[spec.trackIndexVector.back()].termini[SOUTH] !=
+	      trackVector[trackIndex].termini[NORTH]
+	    )
+	  )
+      {
+	snprintf(errorText,sizeof(errorText),
+		 "Line %u: track %s does not start where the previous one "
+		 "ends",
+		 lineNum,key
+		);
+	throw (const char*)errorText;
+      }
+
+      spec.trackIndexVector.push_back(trackIndex);
+    }
+
+    if  (spec.trackIndexVector.empty())
+    {
+      snprintf(errorText,sizeof(errorText),"Line %u: line %s has no tracks",
+	       lineNum,spec.name
+	      );
+      throw (const char*)errorText;
+    }
+
+    lineVector.push_back(spec);
+  }
+  else
+  if  (strcmp(keyword,"profile") == 0)
+  {
+    //  II.D.  Parse the length and speed limit of a Track:
+    char	key[MAX_STRING_LEN];
+    double	lengthMeters;
+    double	maxSpeedMps;
+
+    if  (sscanf(lineCPtr," %255s %lf %lf",key,&lengthMeters,&maxSpeedMps)
+	 != 3
+	)
+    {
+      snprintf(errorText,sizeof(errorText),
+	       "Line %u: expected 'profile <trackKey> <lengthMeters> "
+	       "<maxSpeedMps>'",
+	       lineNum
+	      );
+      throw (const char*)errorText;
+    }
+
+    std::map<std::string,uint>::const_iterator
+		iter	= trackKeyMap.find(key);
+
+    if  (iter == trackKeyMap.end())
+    {
+      snprintf(errorText,sizeof(errorText),"Line %u: undefined track %s",
+	       lineNum,key
+	      );
+      throw (const char*)errorText;
+    }
+
+    if  ( (lengthMeters <= KINEMATIC_TRAIN_LENGTH_METERS
+			   + KINEMATIC_STANDSTILL_GAP_METERS
+	  )  ||
+	  (maxSpeedMps <= 0.0)
+	)
+    {
+      snprintf(errorText,sizeof(errorText),
+	       "Line %u: track %s must be longer than a train and have a "
+	       "positive speed limit",
+	       lineNum,key
+	      );
+      throw (const char*)errorText;
+    }
+
+    trackVector[iter->second].lengthMeters	= lengthMeters;
+    trackVector[iter->second].maxSpeedMps	= maxSpeedMps;
+  }
+  else
+  if  (strcmp(keyword,"text") == 0)
+  {
+    //  II.E.  Parse decoration:
+    TextSpec	spec;
+
+    if  (sscanf(lineCPtr," %d %d%n",&spec.row,&spec.col,&numChars) != 2)
+    {
+      snprintf(errorText,sizeof(errorText),
+	       "Line %u: expected 'text <row> <col> <text>'",lineNum
+	      );
+      throw (const char*)errorText;
+    }
+
+    copyRestOfLine(spec.text,lineCPtr + numChars);
+    textVector.push_back(spec);
+  }
+  else
+  {
+    snprintf(errorText,sizeof(errorText),"Line %u: unknown keyword %s",
+	     lineNum,keyword
+	    );
+    throw (const char*)errorText;
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To check that what was parsed makes a usable system.  No
+//	parameters.  No return value.
+void		TopologyFile::validate	()
+					throw(const char*)
+{
+  //  I.  Application validity check:
+
+  //  II.  Validate:
+  if  (lineVector.empty())
+    throw "Topology has no lines";
+
+  //  II.A.  Each Station may have at most one track per line and direction:
+  for  (uint line = 0;  line < lineVector.size();  line++)
+  {
+    std::vector<bool>	hasTrackArray[NUM_DIRECTIONS];
+
+    hasTrackArray[NORTH].resize(stationVector.size(),false);
+    hasTrackArray[SOUTH].resize(stationVector.size(),false);
+
+    const std::vector<uint>&	trackIndexVector
+				= lineVector[line].trackIndexVector;
+
+    for  (uint i = 0;  i < trackIndexVector.size();  i++)
+    {
+      const TrackSpec&	track	= trackVector[trackIndexVector[i]];
+
+      if  ( hasTrackArray[SOUTH][track.termini[NORTH]]  ||
+	    hasTrackArray[NORTH][track.termini[SOUTH]]
+	  )
+      {
+	snprintf(errorText,sizeof(errorText),"Line %s visits a station twice",
+		 lineVector[line].name
+		);
+	throw (const char*)errorText;
+      }
+
+      hasTrackArray[SOUTH][track.termini[NORTH]]	= true;
+      hasTrackArray[NORTH][track.termini[SOUTH]]	= true;
+    }
+  }
+
+  //  III.  Finished:
+}
@@ -0,0 +1,177 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		TopologyFile.h						---*
+ *---									---*
+ *---	    This file declares a class that reads the Station, Track	---*
+ *---	and line layout of a MassTransit system from a text file.	---*
+ *---	Each non-blank line not starting with '#' is one of:		---*
+ *---									---*
+ *---	station	<key> <row> <col> <name>				---*
+ *---	track	<key> <northStationKey> <southStationKey> <row> <col>	---*
+ *---		<name>							---*
+ *---	line	<name> <trackKey> <trackKey> ...			---*
+ *---	profile	<trackKey> <lengthMeters> <maxSpeedMps>			---*
+ *---	text	<row> <col> <text>					---*
+ *---									---*
+ *---	where a line lists its tracks from north to south, <row> and	---*
+ *---	<col> tell where print() draws the item, and <name> and <text>	---*
+ *---	run to the end of the line.  A Track without a profile has	---*
+ *---	the default length and speed limit.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To describe one Station.
+struct	StationSpec
+{
+  char				name[MAX_STRING_LEN];
+  int				row;
+  int				col;
+};
+
+
+//  PURPOSE:  To describe one Track, with its termini as indices of
+//	StationSpec instances, its length and its speed limit.
+struct	TrackSpec
+{
+  char				name[MAX_STRING_LEN];
+  uint				termini[NUM_DIRECTIONS];
+  int				row;
+  int				col;
+  double			lengthMeters;
+  double			maxSpeedMps;
+};
+
+
+//  PURPOSE:  To describe one line as the indices of its TrackSpec instances
+//	from north to south.
+struct	LineSpec
+{
+  char				name[MAX_STRING_LEN];
+  std::vector<uint>		trackIndexVector;
+};
+
+
+//  PURPOSE:  To describe one piece of decoration that print() draws.
+struct	TextSpec
+{
+  char				text[MAX_STRING_LEN];
+  int				row;
+  int				col;
+};
+
+
+class	TopologyFile
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To hold the Station, Track, line and text descriptions.
+  std::vector<StationSpec>	stationVector;
+  std::vector<TrackSpec>	trackVector;
+  std::vector<LineSpec>		lineVector;
+  std::vector<TextSpec>		textVector;
+
+  //  PURPOSE:  To map Station and Track keys to their indices while
+  //	loading.
+  std::map<std::string,uint>	stationKeyMap;
+  std::map<std::string,uint>	trackKeyMap;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  TopologyFile			();
+
+  //  No copy constructor:
+  TopologyFile			(const TopologyFile&);
+
+  //  No copy assignment op:
+  TopologyFile&			operator=
+				(const TopologyFile&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To parse 'lineCPtr', which is line 'lineNum' of the input.
+  //	No return value.
+  void		parseLine	(char*		lineCPtr,
+				 uint		lineNum
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To check that what was parsed makes a usable system.  No
+  //	parameters.  No return value.
+  void		validate	()
+				throw(const char*);
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To load the topology in file 'pathCPtr', or the built-in
+  //	two-line system with the shared tunnel if 'pathCPtr' is 'NULL'.
+  //	No return value.
+  TopologyFile			(const char*	pathCPtr
+				)
+				throw(const char*);
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~TopologyFile			()
+				throw()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of Station descriptions.  No params.
+  uint		getNumStations	()
+				const
+				throw()
+				{ return(stationVector.size()); }
+
+  //  PURPOSE:  To return the 'i'-th Station description.
+  const StationSpec&
+		getStation	(uint		i
+				)
+				const
+				throw()
+				{ return(stationVector[i]); }
+
+  //  PURPOSE:  To return the number of Track descriptions.  No params.
+  uint		getNumTracks	()
+				const
+				throw()
+				{ return(trackVector.size()); }
+
+  //  PURPOSE:  To return the 'i'-th Track description.
+  const TrackSpec&
+		getTrack	(uint		i
+				)
+				const
+				throw()
+				{ return(trackVector[i]); }
+
+  //  PURPOSE:  To return the number of line descriptions.  No params.
+  uint		getNumLines	()
+				const
+				throw()
+				{ return(lineVector.size()); }
+
+  //  PURPOSE:  To return the 'i'-th line description.
+  const LineSpec&
+		getLine		(uint		i
+				)
+				const
+				throw()
+				{ return(lineVector[i]); }
+
+  //  PURPOSE:  To return the number of text descriptions.  No params.
+  uint		getNumTexts	()
+				const
+				throw()
+				{ return(textVector.size()); }
+
+  //  PURPOSE:  To return the 'i'-th text description.
+  const TextSpec&
+		getText		(uint		i
+				)
+				const
+				throw()
+				{ return(textVector[i]); }
+
+};
@@ -0,0 +1,172 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		TraceLog.cpp						---*
+ *---									---*
+ *---	    This file defines a class that writes what the Train	---*
+ *---	threads of a MassTransit system did, and when, as Chrome	---*
+ *---	trace-event JSON.						---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To tell the trace process id of the Train timelines, and of
+//	the TrainLocation counters.
+static
+const uint	TRAIN_PID		= 1;
+
+static
+const uint	LOCATION_PID		= 2;
+
+
+//  PURPOSE:  To hold the text of the last error thrown by a TraceLog.
+static
+char		errorText[MAX_STRING_LEN];
+
+
+//  PURPOSE:  To write 'record' to 'filePtr' as one trace event, preceded by
+//	a comma unless it is the first.  No return value.
+void		TraceLog::writeRecord
+				(FILE*			filePtr,
+				 const TraceRecord&	record
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  const char*	locNameCPtr	= massTransit.getLocPtr(record.locIndex)
+					     ->getNameCPtr();
+
+  if  (numEvents++ > 0)
+    fputs(",\n",filePtr);
+
+  //  II.  Write event:
+  //  II.A.  Write a change of a TrainLocation counter:
+  if  (record.kind == TRACE_OCCUPANCY)
+  {
+    fputs("{\"name\": ",filePtr);
+    writeQuoted(filePtr,locNameCPtr,true);
+    fprintf(filePtr,
+	    ", \"ph\": \"C\", \"ts\": %.3f, \"pid\": %u, "
+	    "\"args\": {\"trains\": %u}}",
+	    record.startNsecs / 1e3,
+	    LOCATION_PID,
+	    record.numTrains
+	   );
+    return;
+  }
+
+  //  II.B.  Write a span of a Train timeline:
+  const char*	nameCPtr;
+
+  switch  (record.kind)
+  {
+  case TRACE_STAY :
+    nameCPtr	= locNameCPtr;
+    break;
+
+  case TRACE_PAUSE :
+    nameCPtr	= "pause";
+    break;
+
+  case TRACE_LOCK_WAIT :
+    nameCPtr	= "lock wait";
+    break;
+
+  case TRACE_ROOM_WAIT :
+    nameCPtr	= "wait for room";
+    break;
+
+  default :
+    nameCPtr	= "wait to be first";
+    break;
+  }
+
+  fputs("{\"name\": ",filePtr);
+  writeQuoted(filePtr,nameCPtr,true);
+  fprintf(filePtr,
+	  ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+	  "\"pid\": %u, \"tid\": %u, \"args\": {\"location\": ",
+	  (record.kind == TRACE_STAY)  ? "stay"
+	  : (record.kind == TRACE_PAUSE) ? "pause" : "wait",
+	  record.startNsecs / 1e3,
+	  (record.endNsecs - record.startNsecs) / 1e3,
+	  TRAIN_PID,
+	  record.trainId
+	 );
+  writeQuoted(filePtr,locNameCPtr,true);
+  fputs("}}",filePtr);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To write what the Train instances of 'massTransit' traced
+//	during 'MassTransit::simulate()' to file 'pathCPtr'.  No return
+//	value.
+void		TraceLog::write	(const char*	pathCPtr
+				)
+				throw(const char*)
+{
+  //  I.  Application validity check:
+  FILE*	filePtr	= fopen(pathCPtr,"w");
+
+  if  (filePtr == NULL)
+  {
+    snprintf(errorText,MAX_STRING_LEN,"Cannot write trace %s",pathCPtr);
+    throw (const char*)errorText;
+  }
+
+  //  II.  Write trace:
+  //  II.A.  Name the processes, and the timeline of each Train:
+  numEvents	= 0;
+  fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n",filePtr);
+  fprintf(filePtr,
+	  "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %u, "
+	  "\"args\": {\"name\": \"Trains\"}},\n"
+	  "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %u, "
+	  "\"args\": {\"name\": \"Trains at each location\"}}",
+	  TRAIN_PID,
+	  LOCATION_PID
+	 );
+  numEvents	= 2;
+
+  for  (uint i = 0;  i < massTransit.getNumTrains();  i++)
+  {
+    Train*	trainPtr	= massTransit.getTrainPtr(i);
+    char	name[2*MAX_STRING_LEN];
+
+    snprintf(name,sizeof(name),"%s%d",
+	     massTransit.getLineNameCPtr(trainPtr->getLine()),
+	     trainPtr->getIdentity()
+	    );
+    fprintf(filePtr,
+	    ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %u, "
+	    "\"tid\": %d, \"args\": {\"name\": ",
+	    TRAIN_PID,
+	    trainPtr->getIdentity()
+	   );
+    writeQuoted(filePtr,name,true);
+    fputs("}}",filePtr);
+    numEvents++;
+  }
+
+  //  II.B.  Write what each Train traced for itself:
+  for  (uint i = 0;  i < massTransit.getNumTrains();  i++)
+  {
+    const std::vector<TraceRecord>&	traceVector
+				= massTransit.getTrainPtr(i)->getTraceVector();
+
+    for  (size_t j = 0;  j < traceVector.size();  j++)
+      writeRecord(filePtr,traceVector[j]);
+  }
+
+  fputs("\n]}\n",filePtr);
+  fclose(filePtr);
+
+  //  III.  Finished:
+}
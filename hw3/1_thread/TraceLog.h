@@ -0,0 +1,114 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		TraceLog.h						---*
+ *---									---*
+ *---	    This file declares a class that writes what the Train	---*
+ *---	threads of a MassTransit system did, and when, as Chrome	---*
+ *---	trace-event JSON, for chrome://tracing or ui.perfetto.dev.	---*
+ *---	Each Train traces into a buffer of its own, which only its	---*
+ *---	thread writes, so tracing takes no lock; the buffers are	---*
+ *---	gathered once the threads are joined.  Each Train is one	---*
+ *---	timeline, showing where it stayed, paused and waited; each	---*
+ *---	TrainLocation is one counter of the Train instances there, on	---*
+ *---	which convoys show as plateaus.					---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To tell what a TraceRecord describes.
+typedef		enum
+		{
+		  TRACE_STAY,
+		  TRACE_PAUSE,
+		  TRACE_LOCK_WAIT,
+		  TRACE_ROOM_WAIT,
+		  TRACE_HEAD_WAIT,
+		  TRACE_OCCUPANCY
+		}
+		traceKind_t;
+
+
+//  PURPOSE:  To describe one span of what a Train did, from 'startNsecs' to
+//	'endNsecs' after tracing began, at the 'locIndex'-th TrainLocation;
+//	or, for 'TRACE_OCCUPANCY', that 'numTrains' Train instances were
+//	there from 'startNsecs' on.
+struct	TraceRecord
+{
+  unsigned long long		startNsecs;
+  unsigned long long		endNsecs;
+  uint				trainId;
+  uint				locIndex;
+  uint				numTrains;
+  traceKind_t			kind;
+};
+
+
+class	TraceLog
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To refer to the MassTransit system whose Train instances
+  //	traced.
+  MassTransit&			massTransit;
+
+  //  PURPOSE:  To count the trace events written.
+  unsigned long long		numEvents;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  TraceLog			();
+
+  //  No copy constructor:
+  TraceLog			(const TraceLog&);
+
+  //  No copy assignment op:
+  TraceLog&			operator=
+				(const TraceLog&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To write 'record' to 'filePtr' as one trace event, preceded
+  //	by a comma unless it is the first.  No return value.
+  void		writeRecord	(FILE*			filePtr,
+				 const TraceRecord&	record
+				)
+				throw();
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To initialize '*this' to write what the Train instances of
+  //	'newMassTransit' traced.  No return value.
+  TraceLog			(MassTransit&	newMassTransit
+				)
+				throw() :
+				massTransit(newMassTransit),
+				numEvents(0)
+				{ }
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~TraceLog			()
+				throw()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of trace events written.  No
+  //	parameters.
+  unsigned long long
+		getNumEvents	()
+				const
+				throw()
+				{ return(numEvents); }
+
+  //  VI.  Mutators:
+
+  //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To write what the Train instances of 'massTransit' traced
+  //	during 'MassTransit::simulate()' to file 'pathCPtr'.  No return
+  //	value.
+  void		write		(const char*	pathCPtr
+				)
+				throw(const char*);
+
+};
@@ -3,8 +3,8 @@
  *---		Track.cpp						---*
  *---									---*
  *---	    This file defines a class that represents a length of	---*
- *---	Track: where only 'MAX_ALLOWED_NUM_TRAINS_ON_TRACK' Train	---*
- *---	instances may be without incident. 				---*
+ *---	Track: where only 'getCapacity()' Train instances may be	---*
+ *---	without incident. 						---*
  *---									---*
  *---	----	----	----	----	----	----	----	----	---*
  *---									---*
@@ -15,7 +15,6 @@
 #include	"headers.h"
 
 
-
 //  PURPOSE:  To return a pointer to the next TrainLocation for '*trainPtr'
 //  	after it leaves '*this'.
  TrainLocation*	Track::nextLocPtr
@@ -29,9 +28,9 @@
 }
 
 
-//  PURPOSE:  To make '*trainPtr' arrive at '*this'.  No return value.
-//  YOUR CODE SOMEWHERE IN HERE TO LOCK 'getLockPtr()' WAIT FOR SIGNAL
-//  IF TRACK IS IN USE.
+//  PURPOSE:  To make '*trainPtr' arrive at '*this', waiting until there is
+//	room for it and, if '*this' is fair, until every Train that asked
+//	earlier has arrived.  No return value.
 void		Track::arrive	(Train*		trainPtr
   )
 throw()
@@ -39,51 +38,320 @@ throw()
   //  I.  Application validity check:
 
   //  II.  Make '*trainPtr' arrive at '*this':
+  if  ( reserve(trainPtr) )
+    occupy(trainPtr);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To block until '*this' Track has room for '*trainPtr', it is
+//	the turn of its class and, if '*this' is fair, every Train of its
+//	class that asked earlier has got its room, then to hold that room
+//	for it.  The lock is only held while '*this' is examined and
+//	changed, never while '*trainPtr' waits or stays.  Returns 'true' if
+//	the room is held, or 'false' if the simulation stopped first.
+bool		Track::reserve	(Train*		trainPtr
+  )
+throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Hold room for '*trainPtr':
   //  II.A.  Get lock on track:
-  //  ????
-  pthread_mutex_lock(&trainLocLock);
+  lockFor(trainPtr);
 
   if  ( !trainPtr->getMassTransit().getShouldContinue() )
   {
-    //  YOUR CODE HERE TO UNLOCK 
-    //  YOUR CODE HERE TO SIGNAL THAT '*this' IS AVAILABLE
-    pthread_cond_signal(&trackCond);
-    pthread_mutex_unlock(&trainLocLock);
-
-    return;
+    wakeAllWaiters();
+    unlock();
+    return(false);
   }
 
+  //  II.B.  Wait until '*this' Track has room, it is the turn of the class
+  //	     of '*trainPtr', and its own turn if '*this' is fair:
+  unsigned long long	startNsecs	= getLockedNsecs();
+  trainClass_t		trainClass	= trainPtr->getTrainClass();
+  trainClass_t		otherClass	= (trainClass == LOCAL_TRAIN)
+					  ? EXPRESS_TRAIN
+					  : LOCAL_TRAIN;
+  unsigned long long	ticket		= nextTicket[trainClass];
+  bool			didWait		= false;
 
-  //  II.B.  Wait until '*this' Track is clear:
-  while  (getNumTrains() >= MAX_ALLOWED_NUM_TRAINS_ON_TRACK)
+  if  (isFair)
+    nextTicket[trainClass]++;
+
+  while  ( !hasRoomHeading(trainPtr->getDirection())		||
+	   (isFair  &&  (ticket != nowServing[trainClass]))	||
+	   !isTurnOf(trainClass)
+	 )
   {
-    //  ????
-    pthread_cond_wait(&trackCond, &trainLocLock);
+    if  (!didWait)
+      numWaitingArray[trainClass]++;
+
+    waitOn(&trackCondArray[trainClass]);
+    didWait	= true;
 
     if  ( !trainPtr->getMassTransit().getShouldContinue() )
     {
-      //  YOUR CODE HERE TO UNLOCK 
-      //  YOUR CODE HERE TO SIGNAL THAT '*this' IS AVAILABLE
-      pthread_cond_signal(&trackCond);
-      pthread_mutex_unlock(&trainLocLock);
-
-      
-      return;
+      //  Pass the wake-up along so other waiting Train instances see
+      //  that the simulation is over too:
+      numWaitingArray[trainClass]--;
+      wakeAllWaiters();
+      unlock();
+      return(false);
     }
+  }
 
+  //  II.C.  Hold room for '*trainPtr', and let the holder of the next
+  //	     ticket, or a Train of the other class whose turn it may now
+  //	     be, see whether there is room for it too:
+  unsigned long long	waitNsecs	= getLockedNsecs() - startNsecs;
+
+  if  (didWait)
+  {
+    numWaitingArray[trainClass]--;
+    noteWait(waitNsecs);
+    trace(trainPtr,TRACE_ROOM_WAIT,startNsecs,getLockedNsecs(),0);
   }
 
-  //  II.C.  Put '*trainPtr' here:
+  noteAdmitted(trainClass);
+  trainPtr->noteTrackWait(waitNsecs);
+  numReserved++;
+  noteHeading(trainPtr->getDirection(),true);
+
+  if  (isFair)
+    nowServing[trainClass]++;
+
+  if  ( (isFair  &&  (nextTicket[trainClass] != nowServing[trainClass]))  ||
+	( (numWaitingArray[otherClass] > 0)  &&  hasRoom() )
+      )
+    wakeWaiters();
+
+  unlock();
+
+  //  III.  Finished:
+  return(true);
+}
+
+
+//  PURPOSE:  To make '*trainPtr', for which 'reserve()' holds room, arrive
+//	at '*this'.  The room it held becomes the room it takes, so no
+//	waiting Train need be woken.  No return value.
+void		Track::occupy	(Train*		trainPtr
+  )
+throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Make '*trainPtr' arrive at '*this':
+  lockFor(trainPtr);
+
+  numReserved--;
   enqueue(trainPtr);
   trainPtr->setLocPtr(this);
 
+  unlock();
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To make '*trainPtr' arrive at '*this' if '*this' Track has room
+//	now for a Train of its class.  Returns 'true' if '*trainPtr' arrived
+//	or 'false' otherwise.
+bool		Track::tryArrive(Train*		trainPtr
+  )
+throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Make '*trainPtr' arrive at '*this' if it has room, and it is the
+  //	   turn of its class:
+  trainClass_t	trainClass	= trainPtr->getTrainClass();
+  bool		didArrive	= false;
+
+  lockFor(trainPtr);
+
+  if  ( hasRoomHeading(trainPtr->getDirection())			&&
+	( !isFair  ||  (nextTicket[trainClass] == nowServing[trainClass]) )	&&
+	isTurnOf(trainClass)
+      )
+  {
+    noteAdmitted(trainClass);
+    noteHeading(trainPtr->getDirection(),true);
+    enqueue(trainPtr);
+    trainPtr->setLocPtr(this);
+    didArrive	= true;
+  }
+
+  unlock();
+
+  //  III.  Finished:
+  return(didArrive);
+}
+
+
+//  PURPOSE:  To note that '*trainPtr' starts waiting for room on '*this',
+//	if 'isWaiting', or stops, in a simulator that keeps its own list of
+//	waiting Train instances instead of calling 'reserve()'.  No return
+//	value.
+void		Track::noteWaiting
+				(Train*		trainPtr,
+				 bool		isWaiting
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Count waiter:
+  lockFor(trainPtr);
+
+  if  (isWaiting)
+    numWaitingArray[trainPtr->getTrainClass()]++;
+  else
+    numWaitingArray[trainPtr->getTrainClass()]--;
+
+  unlock();
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To hold room on '*this' Track for '*trainPtr' and return
+//	'true' at once if there is some, it is the turn of its class and no
+//	Train of its class is parked for it or, if not, to park '*trainPtr'
+//	behind those parked already and to return 'false'.  'leave()'
+//	holds the room for it and resumes it later.  Never blocks.
+bool		Track::reserveOrPark
+				(Train*		trainPtr
+				)
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Hold room for '*trainPtr', or park it:
+  trainClass_t	trainClass	= trainPtr->getTrainClass();
+  bool		didReserve	= false;
+
+  lockFor(trainPtr);
+
+  if  ( (parkedHeadPtr[trainClass] == NULL)		&&
+	hasRoomHeading(trainPtr->getDirection())	&&
+	isTurnOf(trainClass)
+      )
+  {
+    noteAdmitted(trainClass);
+    trainPtr->noteTrackWait(0);
+    numReserved++;
+    noteHeading(trainPtr->getDirection(),true);
+    didReserve	= true;
+  }
+  else
+  {
+    trainPtr->setActorState(ACTOR_WAITING_FOR_ROOM,getLockedNsecs());
+    trainPtr->setNextParkedPtr(NULL);
+
+    if  (parkedTailPtr[trainClass] == NULL)
+      parkedHeadPtr[trainClass]	= trainPtr;
+    else
+      parkedTailPtr[trainClass]->setNextParkedPtr(trainPtr);
+
+    parkedTailPtr[trainClass]	= trainPtr;
+    numWaitingArray[trainClass]++;
+  }
+
+  unlock();
+
   //  III.  Finished:
+  return(didReserve);
 }
 
 
-//  PURPOSE:  To make '*trainPtr' leave '*this'.  No return value.
-//  YOUR CODE SOMEWHERE IN HERE TO UNLOCK 'getLockPtr()' AND SIGNAL TRACK
-//  IS AVAILABLE.
+//  PURPOSE:  To note that '*trainPtr', parked by 'reserveOrPark()' since
+//	'trainPtr->getActorSinceNsecs()', was resumed with room held for
+//	it.  Only the worker that runs '*trainPtr' may call it.  No return
+//	value.
+void		Track::noteUnparked
+				(Train*		trainPtr
+				)
+				throw()
+{
+  //  I.  Application validity check:
+  unsigned long long	startNsecs	= trainPtr->getActorSinceNsecs();
+  unsigned long long	endNsecs	= getMonotonicNsecs();
+
+  //  II.  Note wait, under the lock like those noted by 'reserve()':
+  lockFor(trainPtr);
+  noteWait(endNsecs - startNsecs);
+  unlock();
+  trainPtr->noteTrackWait(endNsecs - startNsecs);
+  trace(trainPtr,TRACE_ROOM_WAIT,startNsecs,endNsecs,0);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To forget the Train instances parked for '*this' Track and
+//	the room held for Train instances that have yet to arrive, once the
+//	ActorScheduler that ran them has stopped.  No parameters.  No
+//	return value.
+void		Track::clearParked
+				()
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Forget parked Train instances, and count again which way the
+  //	   Train instances still on '*this' head:
+  std::vector<Train*>	trainPtrVector;
+
+  pthread_mutex_lock(&trainLocLock);
+
+  for  (uint i = 0;  i < NUM_TRAIN_CLASSES;  i++)
+  {
+    parkedHeadPtr[i]	= NULL;
+    parkedTailPtr[i]	= NULL;
+    numWaitingArray[i]	= 0;
+  }
+
+  numExpressPasses	= 0;
+  numReserved	= 0;
+  numHeadingArray[NORTH]	= 0;
+  numHeadingArray[SOUTH]	= 0;
+  copyTrains(trainPtrVector);
+
+  for  (size_t i = 0;  i < trainPtrVector.size();  i++)
+    noteHeading(trainPtrVector[i]->getDirection(),true);
+
+  pthread_mutex_unlock(&trainLocLock);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To wake every Train pthread waiting for '*this' Track, so
+//	that each sees that the simulation stopped.  No parameters.  No
+//	return value.
+void		Track::interruptWaiters
+				()
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Wake waiters:
+  pthread_mutex_lock(&trainLocLock);
+  wakeAllWaiters();
+  pthread_mutex_unlock(&trainLocLock);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To make '*trainPtr' leave '*this', and hand the room it
+//	frees to the parked Train instances that it lets on, each the first
+//	of the class whose turn it is, if any, or else wake waiting Train
+//	instances.  No return value.
 void		Track::leave	(Train*		trainPtr
   )
 throw()
@@ -91,13 +359,72 @@ throw()
   //  I.  Application validity check:
 
   //  II.  Make '*trainPtr' leave '*this':
+  Train*	resumedPtr	= NULL;
+
+  lockFor(trainPtr);
+
   dequeue(trainPtr);
+  noteHeading(trainPtr->getDirection(),false);
   trainPtr->setLocPtr(NULL);
 
-  //  III.  Finished:
+  //  II.A.  Hold room for the first parked Train of the class whose turn
+  //	     it is, or else of the other, while it lasts.  More than one
+  //	     may get on once the last Train heading the other way leaves a
+  //	     block-signalled Track.  They are relinked from 'resumedPtr',
+  //	     cut from those still parked:
+  Train*	lastResumedPtr	= NULL;
 
-  pthread_cond_signal(&trackCond);
-  pthread_mutex_unlock(&trainLocLock);
-  
+  while  (true)
+  {
+    trainClass_t	trainClass
+			= ( (parkedHeadPtr[EXPRESS_TRAIN] != NULL)  &&
+			    ( isTurnOf(EXPRESS_TRAIN)  ||
+			      (parkedHeadPtr[LOCAL_TRAIN] == NULL)
+			    )
+			  )
+			  ? EXPRESS_TRAIN
+			  : LOCAL_TRAIN;
+    Train*		parkedPtr	= parkedHeadPtr[trainClass];
+
+    if  ( (parkedPtr == NULL)  ||
+	  !hasRoomHeading(parkedPtr->getDirection())
+	)
+      break;
+
+    parkedHeadPtr[trainClass]	= parkedPtr->getNextParkedPtr();
+
+    if  (parkedHeadPtr[trainClass] == NULL)
+      parkedTailPtr[trainClass]	= NULL;
+
+    parkedPtr->setNextParkedPtr(NULL);
+
+    if  (lastResumedPtr == NULL)
+      resumedPtr	= parkedPtr;
+    else
+      lastResumedPtr->setNextParkedPtr(parkedPtr);
+
+    lastResumedPtr	= parkedPtr;
+    numWaitingArray[trainClass]--;
+    noteAdmitted(trainClass);
+    numReserved++;
+    noteHeading(parkedPtr->getDirection(),true);
+  }
+
+  if  (resumedPtr == NULL)
+    wakeWaiters();
+
+  unlock();
+
+  //  III.  Resume the parked Train instances whose room is now held.  Each
+  //	    may park again as soon as it is resumed, so its link is read
+  //	    first:
+  while  (resumedPtr != NULL)
+  {
+    Train*	nextPtr	= resumedPtr->getNextParkedPtr();
+
+    trainPtr->getMassTransit().getActorSchedulerPtr()->resume(resumedPtr);
+    resumedPtr	= nextPtr;
+  }
 
+  //  IV.  Finished:
 }
@@ -3,8 +3,8 @@
  *---		Track.h							---*
  *---									---*
  *---	    This file declares a class that represents a length of	---*
- *---	Track: where only 'MAX_ALLOWED_NUM_TRAINS_ON_TRACK' Train	---*
- *---	instances may be without incident. 				---*
+ *---	Track: where only 'getCapacity()' Train instances may be	---*
+ *---	without incident. 						---*
  *---									---*
  *---	----	----	----	----	----	----	----	----	---*
  *---									---*
@@ -18,10 +18,71 @@
   //  PURPOSE:  To hold ptrs to the termini of '*this' Track.
   Station*			termini[NUM_DIRECTIONS];
 
-  //  PURPOSE:  To hold the condition to signal the availability of '*this'
-  //	Track.
+  //  PURPOSE:  To tell the maximum number of Train instances simultaneously
+  //	allowed on '*this' Track.
+  uint				capacity;
+
+  //  PURPOSE:  To tell whether '*this' Track is split into 'capacity'
+  //	blocks ('true'), one Train per block, so that it holds Train
+  //	instances heading only one way at a time, or whether any 'capacity'
+  //	Train instances may be on it whichever way they head ('false').
+  bool				isBlockSignalled;
+
+  //  PURPOSE:  To tell whether Train instances get '*this' Track in the
+  //	order they asked for it ('true') or in whatever order 'trackCondArray'
+  //	wakes them ('false').
+  bool				isFair;
+
+  //  PURPOSE:  To tell how long '*this' Track is, in meters, and how fast
+  //	Train instances may run on it, in meters per second.
+  double			lengthMeters;
+  double			maxSpeedMps;
+
+  //  PURPOSE:  To keep track of the trains on '*this' Track, in arrival
+  //	order.  Protected by 'trainLocLock'.  It and the members after it
+  //	change as Train instances come and go, so they start on a cache
+  //	line apart from those above, which are only read once built.
+  alignas(CACHE_LINE_BYTES)
+  TrainRing			trainPtrQueue;
+
+  //  PURPOSE:  To tell how many Train instances are on '*this' Track, or
+  //	hold room on it, heading each way.  Protected by 'trainLocLock'.
+  uint				numHeadingArray[NUM_DIRECTIONS];
+
+  //  PURPOSE:  To tell, when 'isFair', for each class of service, the
+  //	ticket for the next Train of it to ask for '*this' Track and the
+  //	ticket of the next Train of it to get it.  Protected by
+  //	'trainLocLock'.
+  unsigned long long		nextTicket[NUM_TRAIN_CLASSES];
+  unsigned long long		nowServing[NUM_TRAIN_CLASSES];
+
+  //  PURPOSE:  To tell, for each class of service, how many Train
+  //	instances wait for room on '*this' Track, and how many express ones
+  //	in a row got room while a local one waited.  Protected by
+  //	'trainLocLock'.
+  uint				numWaitingArray[NUM_TRAIN_CLASSES];
+  uint				numExpressPasses;
+
+  //  PURPOSE:  To tell how many Train instances hold room on '*this' Track
+  //	by 'reserve()' but have not yet arrived by 'occupy()'.  Protected by
+  //	'trainLocLock'.
+  uint				numReserved;
+
+  //  PURPOSE:  To point, for each class of service, to the first and the
+  //	last of the Train instances that an ActorScheduler runs and that are
+  //	parked by 'reserveOrPark()' until there is room for them, linked by
+  //	'Train::getNextParkedPtr()', or to be 'NULL' if none is.  Room that
+  //	frees while one is parked is handed at once to the first of the
+  //	class whose turn it is, so each class gets '*this' in the order it
+  //	asked for it whether or not it is fair.  Protected by
+  //	'trainLocLock'.
+  Train*			parkedHeadPtr[NUM_TRAIN_CLASSES];
+  Train*			parkedTailPtr[NUM_TRAIN_CLASSES];
+
+  //  PURPOSE:  To hold, for each class of service, the condition to signal
+  //	the availability of '*this' Track to Train instances of it.
   //  YOUR CODE HERE TO DEFINE A pthread_cond_t INSTANCE
-  pthread_cond_t trackCond;
+  pthread_cond_t trackCondArray[NUM_TRAIN_CLASSES];
   //  II.  Disallowed auto-generated methods:
   //  No default constructor:
   Track				();
@@ -35,27 +96,162 @@
 
   protected :
   //  III.  Protected methods:
+  //  PURPOSE:  To wake the Train instances waiting for '*this' Track that
+  //	might now get it, of the class whose turn it is only: all of them
+  //	when 'isFair', so that the one holding the next ticket sees its
+  //	turn, or when 'isBlockSignalled', since one heading the other way
+  //	could not use the room, or else any one.  'trainLocLock' must be
+  //	held.  No parameters.  No return value.
+  void			wakeWaiters
+  ()
+  throw()
+  {
+    for  (uint i = 0;  i < NUM_TRAIN_CLASSES;  i++)
+    {
+      if  ( (numWaitingArray[i] == 0)  ||  !isTurnOf((trainClass_t)i) )
+	continue;
+
+      if  (isFair  ||  isBlockSignalled)
+	pthread_cond_broadcast(&trackCondArray[i]);
+      else
+	pthread_cond_signal(&trackCondArray[i]);
+    }
+  }
+
+  //  PURPOSE:  To wake every Train waiting for '*this' Track, whatever its
+  //	class, so that each sees that the simulation stopped.  'trainLocLock'
+  //	must be held.  No parameters.  No return value.
+  void			wakeAllWaiters
+  ()
+  throw()
+  {
+    for  (uint i = 0;  i < NUM_TRAIN_CLASSES;  i++)
+      pthread_cond_broadcast(&trackCondArray[i]);
+  }
+
+  //  PURPOSE:  To return 'true' if '*this' Track has room for one more
+  //	Train, counting the room held by 'reserve()', or 'false' otherwise.
+  //	'trainLocLock' must be held.  No parameters.
+  bool			hasRoom
+  ()
+  const
+  throw()
+  { return(getNumTrains() + numReserved < getCapacity()); }
+
+  //  PURPOSE:  To note that one more Train heading 'direction' holds room
+  //	on '*this' Track, whether or not it has arrived, if 'isHeading', or
+  //	one less if not.  'trainLocLock' must be held.  No return value.
+  void			noteHeading
+  (direction_t	direction,
+   bool		isHeading
+    )
+  throw()
+  {
+    if  (isHeading)
+      numHeadingArray[direction]++;
+    else
+      numHeadingArray[direction]--;
+  }
+
+  //  PURPOSE:  To note that a Train of class 'trainClass' got room on
+  //	'*this' Track, counting it if it is an express one that passed a
+  //	waiting local one.  'trainLocLock' must be held.  No return value.
+  void			noteAdmitted
+  (trainClass_t	trainClass
+    )
+  throw()
+  {
+    if  (trainClass == LOCAL_TRAIN)
+      numExpressPasses	= 0;
+    else
+    if  (numWaitingArray[LOCAL_TRAIN] > 0)
+      numExpressPasses++;
+  }
+
+  //  PURPOSE:  To put '*trainPtr' into the end of 'trainPtrQueue'.
+  //	'trainLocLock' must have been taken by 'lockFor()'.  Every caller
+  //	first checks 'hasRoom()', so a full 'trainPtrQueue' means the
+  //	capacity was broken, and the program stops.  No return value.
+  void			enqueue	(Train*		trainPtr
+    )
+  throw()
+  {
+    beginChange();
+    noteArrival(trainPtr,getLockedNsecs());
+    bool	didFit	= trainPtrQueue.pushBack(trainPtr);
+    endChange();
+
+    if  ( !didFit )
+    {
+      fprintf(stderr,"Track %s holds more than %u trains\n",
+	      getNameCPtr(),getCapacity()
+	     );
+      exit(EXIT_FAILURE);
+    }
+
+    trace(trainPtr,TRACE_OCCUPANCY,getLockedNsecs(),0,getNumTrains());
+  }
+
+  //  PURPOSE:  To remove 'trainPtr' from 'trainPtrQueue'.  'trainLocLock' must
+  //	have been taken by 'lockFor()'.  No return value.
+  void			dequeue	(Train*		trainPtr
+    )
+  throw()
+  {
+    beginChange();
+    noteDeparture(trainPtr,getLockedNsecs());
+    trainPtrQueue.remove(trainPtr);
+    endChange();
+    trace(trainPtr,TRACE_OCCUPANCY,getLockedNsecs(),0,getNumTrains());
+  }
 
   public :
   //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
   //  PURPOSE:  To create a station named 'newNameCPtr' with no trains that
   //	connects Station instances '*northTerminusPtr' on its northern end
-  //	with '*southTerminusPtr' on its southern end.
+  //	with '*southTerminusPtr' on its southern end, and that allows at most
+  //	'newCapacity' trains at once, admitted in arrival order if
+  //	'newIsFair', and heading only one way at a time if
+  //	'newIsBlockSignalled'.  'numTrains' tells how many trains the whole
+  //	system has, so 'trainPtrQueue' need hold no more than that.
   Track				(const char*	newNameCPtr,
    Station*	northTerminusPtr,
-   Station*	southTerminusPtr
+   Station*	southTerminusPtr,
+   uint		newCapacity,
+   uint		numTrains,
+   bool		newIsFair,
+   bool		newIsBlockSignalled
    )
   throw() :
-  TrainLocation(newNameCPtr)
+  TrainLocation(newNameCPtr),
+  capacity(newCapacity),
+  isBlockSignalled(newIsBlockSignalled),
+  isFair(newIsFair),
+  lengthMeters(DEFAULT_TRACK_LENGTH_METERS),
+  maxSpeedMps(DEFAULT_TRACK_MAX_SPEED_MPS),
+  trainPtrQueue(std::min(newCapacity,numTrains)),
+  numExpressPasses(0),
+  numReserved(0)
   {
     //  I.  Application validity check:
 
     //  II.  Initialize other members:
     termini[NORTH]	= northTerminusPtr;
     termini[SOUTH]	= southTerminusPtr;
+    numHeadingArray[NORTH]	= 0;
+    numHeadingArray[SOUTH]	= 0;
+
+    for  (uint i = 0;  i < NUM_TRAIN_CLASSES;  i++)
+    {
+      nextTicket[i]		= 0;
+      nowServing[i]		= 0;
+      numWaitingArray[i]	= 0;
+      parkedHeadPtr[i]		= NULL;
+      parkedTailPtr[i]		= NULL;
+      //  YOUR CODE HERE TO INITIALIZE YOUR CONDITION
+      pthread_cond_init(&trackCondArray[i], NULL);
+    }
 
-    //  YOUR CODE HERE TO INITIALIZE YOUR CONDITION
-    pthread_cond_init(&trackCond, NULL);
     //  III.  Finished:
   }
 
@@ -76,9 +272,152 @@
   throw()
   { return(*termini[direction]); }
 
+  //  PURPOSE:  To return the number of trains.  No parameters.
+  uint			getNumTrains
+  ()
+  const
+  throw()
+  { return(trainPtrQueue.getCount()); }
+
+  //  PURPOSE:  To return the first Train, or 'NULL' if there is none.  No
+  //	parameters.
+  Train*		getFirstTrain
+  ()
+  const
+  throw()
+  { return(trainPtrQueue.getFront()); }
+
+  //  PURPOSE:  To return the maximum number of Train instances
+  //	simultaneously allowed on '*this' Track.  No parameters.
+  uint			getCapacity
+  ()
+  const
+  throw()
+  { return(capacity); }
+
+  //  PURPOSE:  To return 'true' if Train instances get '*this' Track in the
+  //	order they asked for it, or 'false' otherwise.  No parameters.
+  bool			getIsFair
+  ()
+  const
+  throw()
+  { return(isFair); }
+
+  //  PURPOSE:  To return 'true' if '*this' Track holds Train instances
+  //	heading only one way at a time, one per block, or 'false'
+  //	otherwise.  No parameters.
+  bool			getIsBlockSignalled
+  ()
+  const
+  throw()
+  { return(isBlockSignalled); }
+
+  //  PURPOSE:  To return 'true' if '*this' Track has room for one more
+  //	Train heading 'direction', counting the room held by 'reserve()':
+  //	if it is not full and, when 'isBlockSignalled', no Train on it heads
+  //	the other way.  'trainLocLock' must be held, unless no other thread
+  //	may change '*this'.
+  bool			hasRoomHeading
+  (direction_t	direction
+    )
+  const
+  throw()
+  {
+    return( hasRoom()  &&
+	    ( !isBlockSignalled  ||
+	      (numHeadingArray[(direction == NORTH) ? SOUTH : NORTH] == 0)
+	    )
+	  );
+  }
+
+  //  PURPOSE:  To return 'true' if a waiting Train of class 'trainClass' may
+  //	take room on '*this' Track next, or 'false' if one of the other
+  //	class goes first: an express one goes ahead of local ones, unless
+  //	'MAX_EXPRESS_PASSES' express ones in a row already did.
+  //	'trainLocLock' must be held, unless no other thread may change
+  //	'*this'.
+  bool			isTurnOf
+  (trainClass_t	trainClass
+    )
+  const
+  throw()
+  {
+    if  (trainClass == EXPRESS_TRAIN)
+      return( (numExpressPasses < MAX_EXPRESS_PASSES)  ||
+	      (numWaitingArray[LOCAL_TRAIN] == 0)
+	    );
+
+    return( (numWaitingArray[EXPRESS_TRAIN] == 0)  ||
+	    (numExpressPasses >= MAX_EXPRESS_PASSES)
+	  );
+  }
+
+  //  PURPOSE:  To return how many express Train instances in a row got room
+  //	on '*this' Track while a local one waited.  No parameters.
+  uint			getNumExpressPasses
+  ()
+  const
+  throw()
+  { return(numExpressPasses); }
+
+  //  PURPOSE:  To return how long '*this' Track is, in meters.  No
+  //	parameters.
+  double		getLengthMeters
+  ()
+  const
+  throw()
+  { return(lengthMeters); }
+
+  //  PURPOSE:  To return how fast Train instances may run on '*this' Track,
+  //	in meters per second.  No parameters.
+  double		getMaxSpeedMps
+  ()
+  const
+  throw()
+  { return(maxSpeedMps); }
+
   //  VI.  Mutators:
+  //  PURPOSE:  To make 'newNumExpressPasses' the number of express Train
+  //	instances in a row that got room on '*this' Track while a local one
+  //	waited.  No return value.
+  void			setNumExpressPasses
+  (uint		newNumExpressPasses
+    )
+  throw()
+  { numExpressPasses	= newNumExpressPasses; }
+
+  //  PURPOSE:  To make '*this' Track 'newLengthMeters' long with a speed
+  //	limit of 'newMaxSpeedMps'.  No return value.
+  void			setProfile
+  (double		newLengthMeters,
+   double		newMaxSpeedMps
+    )
+  throw()
+  {
+    lengthMeters	= newLengthMeters;
+    maxSpeedMps		= newMaxSpeedMps;
+  }
 
   //  VII.  Methods that do main and misc. work of class:
+  //  PURPOSE:  To return 'true' if '*trainPtr' is the first 'Train' instance,
+  //	or 'false' otherwise.
+  bool			isFirstTrain
+  (const Train*	trainPtr
+    )
+  const
+  throw()
+  { return(trainPtrQueue.getFront() == trainPtr); }
+
+  //  PURPOSE:  To copy the Train instances on '*this', first one first, into
+  //	'trainPtrVector' without waiting.  The copy may be torn by a change
+  //	made meanwhile.  No return value.
+  void			copyTrains
+  (std::vector<Train*>&	trainPtrVector
+    )
+  const
+  throw()
+  { trainPtrQueue.copyTo(trainPtrVector); }
+
   //  PURPOSE:  To return a pointer to the next TrainLocation for '*trainPtr'
   //  	after it leaves '*this'.
   TrainLocation*	nextLocPtr
@@ -90,7 +429,76 @@
     )
   throw();
 
-  //  PURPOSE:  To make '*trainPtr' leave '*this'.  No return value.
+  //  PURPOSE:  To block until '*this' Track has room for '*trainPtr', it is
+  //	the turn of its class and, if '*this' is fair, every Train of its
+  //	class that asked earlier has got its room, then to hold that room
+  //	for it.  Returns 'true' if the room is held, or 'false' if the
+  //	simulation stopped first.
+  bool			reserve	(Train*		trainPtr
+    )
+  throw();
+
+  //  PURPOSE:  To hold room on '*this' Track for '*trainPtr' and return
+  //	'true' at once if there is some, it is the turn of its class and no
+  //	Train of its class is parked for it or, if not, to park '*trainPtr'
+  //	behind those parked already and to return 'false'.  'leave()'
+  //	holds the room for it and resumes it later.  Never blocks.
+  bool			reserveOrPark
+  (Train*		trainPtr
+    )
+  throw();
+
+  //  PURPOSE:  To note that '*trainPtr', parked by 'reserveOrPark()' since
+  //	'trainPtr->getActorSinceNsecs()', was resumed with room held for
+  //	it.  Only the worker that runs '*trainPtr' may call it.  No return
+  //	value.
+  void			noteUnparked
+  (Train*		trainPtr
+    )
+  throw();
+
+  //  PURPOSE:  To forget the Train instances parked for '*this' Track and
+  //	the room held for Train instances that have yet to arrive, once the
+  //	ActorScheduler that ran them has stopped.  No parameters.  No
+  //	return value.
+  void			clearParked
+  ()
+  throw();
+
+  //  PURPOSE:  To wake every Train pthread waiting for '*this' Track, so
+  //	that each sees that the simulation stopped.  No parameters.  No
+  //	return value.
+  void			interruptWaiters
+  ()
+  throw();
+
+  //  PURPOSE:  To make '*trainPtr', for which 'reserve()' holds room, arrive
+  //	at '*this'.  No return value.
+  void			occupy	(Train*		trainPtr
+    )
+  throw();
+
+  //  PURPOSE:  To make '*trainPtr' arrive at '*this' if '*this' Track is
+  //	clear now for a Train of its class.  Returns 'true' if '*trainPtr'
+  //	arrived or 'false' otherwise.
+  bool			tryArrive
+  (Train*		trainPtr
+    )
+  throw();
+
+  //  PURPOSE:  To note that '*trainPtr' starts waiting for room on '*this',
+  //	if 'isWaiting', or stops, in a simulator that keeps its own list of
+  //	waiting Train instances instead of calling 'reserve()'.  No return
+  //	value.
+  void			noteWaiting
+  (Train*		trainPtr,
+   bool		isWaiting
+    )
+  throw();
+
+  //  PURPOSE:  To make '*trainPtr' leave '*this', and hand the room it
+  //	frees to the first parked Train of the class whose turn it is, if
+  //	any, or else wake waiting Train instances.  No return value.
   void			leave	(Train*		trainPtr
     )
   throw();
@@ -0,0 +1,79 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		Train.cpp						---*
+ *---									---*
+ *---	    This file defines a class that simulates one train for a	---*
+ *---	MassTransit instance.  This class is designed so that each	---*
+ *---	instance is done by its own thread.				---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+#include	"headers.h"
+
+
+//  PURPOSE:  To print the name of '*this' to the ncurses-controlled screen.
+//	No parameters.  No return value.
+void		Train::print	()
+				const
+				throw()
+{
+  //  I.  Application validity check:
+
+  //  II.  Print '*this':
+  char	text[MAX_STRING_LEN];
+
+  snprintf(text,MAX_STRING_LEN,"%s%d ",
+	   getMassTransit().getLineNameCPtr(getLine()),
+	   getIdentity()
+	  );
+  addstr(text);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To copy into 'recordVector' the recent arrivals and departures
+//	of '*this' Train, oldest first, leaving out any that its thread
+//	overwrites meanwhile.  May be called from any thread.  No return
+//	value.
+void		Train::copyRecentRecords
+				(std::vector<LogRecord>&	recordVector
+				)
+				const
+				throw()
+{
+  //  I.  Application validity check:
+  unsigned long long	end	= __atomic_load_n(&numRecentRecords,
+						  __ATOMIC_ACQUIRE
+						 );
+  unsigned long long	first	= (end > NUM_RECENT_LOG_RECORDS)
+				  ? (end - NUM_RECENT_LOG_RECORDS)
+				  : 0;
+
+  //  II.  Copy records:
+  //  II.A.  Copy every record that was recent at the start:
+  std::vector<LogRecord>	copyVector;
+
+  for  (unsigned long long i = first;  i < end;  i++)
+    copyVector.push_back(recentRecordArray[i % NUM_RECENT_LOG_RECORDS]);
+
+  //  II.B.  Keep those whose slots the thread of '*this' has not since
+  //	     started to reuse:
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  unsigned long long	newEnd	= __atomic_load_n(&numRecentRecords,
+						  __ATOMIC_ACQUIRE
+						 );
+
+  recordVector.clear();
+
+  for  (unsigned long long i = first;  i < end;  i++)
+    if  (i + NUM_RECENT_LOG_RECORDS > newEnd)
+      recordVector.push_back(copyVector[i - first]);
+
+  //  III.  Finished:
+}
@@ -12,7 +12,19 @@
  *---									---*
  *-------------------------------------------------------------------------*/
 
-class	Train
+//  PURPOSE:  To tell what a Train run by an ActorScheduler does when it is
+//	next stepped: end its pause, or end its wait to become the first
+//	Train at its Station, or for room on the Track ahead.
+typedef		enum
+		{
+		  ACTOR_PAUSING,
+		  ACTOR_WAITING_FOR_HEAD,
+		  ACTOR_WAITING_FOR_ROOM
+		}
+		actorState_t;
+
+
+class	alignas(CACHE_LINE_BYTES) Train
 {
   //  I.  Member vars:
   //  PURPOSE:  To tell the id of the train.
@@ -21,6 +33,9 @@ class	Train
   //  PURPOSE:  To tell the line that '*this' Train serves.
   line_t			line;
 
+  //  PURPOSE:  To tell the class of service of '*this' Train.
+  trainClass_t			trainClass;
+
   //  PURPOSE:  To tell the direction in which '*this' Train is currently
   //	headed.
   direction_t			direction;
@@ -32,6 +47,76 @@ class	Train
   //	operates.
   MassTransit&			massTransit;
 
+  //  PURPOSE:  To count the times '*this' Train has moved.  Only written by
+  //	the thread that runs '*this' Train.
+  unsigned long long		numMoves;
+
+  //  PURPOSE:  To tell how many nanoseconds '*this' Train has spent waiting
+  //	for TrainLocation locks and for Track instances to clear.  Only
+  //	written by the thread that runs '*this' Train.
+  unsigned long long		lockWaitNsecs;
+
+  //  PURPOSE:  To count how long each arrival of '*this' Train at a Track
+  //	waited for room.  Only written by the thread that runs '*this' Train.
+  WaitHistogram			trackWaitHistogram;
+
+  //  PURPOSE:  To give the random numbers that '*this' Train uses, apart
+  //	from those of every other Train.
+  RandomStream			random;
+
+  //  PURPOSE:  To hold the arrivals and departures of '*this' Train while
+  //	its MassTransit logs events.  Only written by the thread that runs
+  //	'*this' Train.
+  std::vector<LogRecord>	logVector;
+
+  //  PURPOSE:  To hold the last 'NUM_RECENT_LOG_RECORDS' arrivals and
+  //	departures of '*this' Train while its MassTransit keeps history, the
+  //	'i'-th ever at 'recentRecordArray[i % NUM_RECENT_LOG_RECORDS]', so an
+  //	InvariantChecker can tell what led to a violation.  Only written by
+  //	the thread that runs '*this' Train; 'numRecentRecords' counts the
+  //	records ever kept and is only changed atomically, after its record.
+  LogRecord			recentRecordArray[NUM_RECENT_LOG_RECORDS];
+  unsigned long long		numRecentRecords;
+
+  //  PURPOSE:  To hold what '*this' Train traced while its MassTransit
+  //	traces, and when it last arrived somewhere, on the monotonic clock in
+  //	nanoseconds, so that its stay there can be traced when it leaves.
+  //	Only used by the thread that runs '*this' Train.
+  std::vector<TraceRecord>	traceVector;
+  unsigned long long		arrivalNsecs;
+
+  //  PURPOSE:  To tell the ticket '*this' Train took at the Station where it
+  //	last arrived, so that it finds its slot there at once when it
+  //	leaves.  Only used by the thread that runs '*this' Train.
+  unsigned long long		stationTicket;
+
+  //  PURPOSE:  To hold, while an ActorScheduler runs '*this' Train instead
+  //	of a pthread, what it does when next stepped, the TrainLocation it
+  //	waits for room at, and when it began to pause or wait, on the
+  //	monotonic clock in nanoseconds.  Only used by the worker that owns
+  //	'*this' Train.
+  actorState_t			actorState;
+  TrainLocation*		actorNextPtr;
+  unsigned long long		actorSinceNsecs;
+
+  //  PURPOSE:  To let the Station at which '*this' Train waits to become the
+  //	first Train wake it when it does, and to tell that Station whether
+  //	it is waiting.  Stations have no lock, so 'isWaitingForHead' and the
+  //	wait are protected by 'headLock', which only '*this' Train and the
+  //	Train that leaves ahead of it take.
+  //	Other Train instances write these and 'nextParkedPtr', so they start
+  //	on a cache line apart from those that only the thread that runs
+  //	'*this' Train writes.
+  alignas(CACHE_LINE_BYTES)
+  pthread_mutex_t		headLock;
+  pthread_cond_t		headCond;
+  bool				isWaitingForHead;
+
+  //  PURPOSE:  To point to the next Train parked behind '*this' one for
+  //	room on a Track, or to be 'NULL'.  Protected by the lock of that
+  //	Track.
+  Train*			nextParkedPtr;
+
   //  II.  Disallowed auto-generated methods:
   //  No default constructor:
   Train				();
@@ -50,25 +135,49 @@ public :
   //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
   //  PURPOSE:  To initialize '*this' Train instance to have id 'newId', to
   //	run on line 'newLine' in direction 'newDir', to start at location
-  //	'*newLocPtr' on MassTransit system 'newMassTransit'.  No return value.
+  //	'*newLocPtr' on MassTransit system 'newMassTransit', and to draw its
+  //	random numbers from the stream of 'seed' given by its id.  No return
+  //	value.
   Train 			(int    	newId,
   				 line_t	     	newLine,
 				 direction_t	newDir,
 				 TrainLocation*	newLocPtr,
-				 MassTransit&	newMassTransit
+				 MassTransit&	newMassTransit,
+				 uint		seed
 				)
 				throw() :
 				identity(newId),
 				line(newLine),
+				trainClass(LOCAL_TRAIN),
 				direction(newDir),
 				locPtr(newLocPtr),
-				massTransit(newMassTransit)
-				{ }
+				massTransit(newMassTransit),
+				numMoves(0),
+				lockWaitNsecs(0),
+				trackWaitHistogram(),
+				random(seed,newId + 1),
+				logVector(),
+				numRecentRecords(0),
+				traceVector(),
+				arrivalNsecs(0),
+				stationTicket(0),
+				actorState(ACTOR_PAUSING),
+				actorNextPtr(NULL),
+				actorSinceNsecs(0),
+				isWaitingForHead(false),
+				nextParkedPtr(NULL)
+				{
+				  pthread_mutex_init(&headLock,NULL);
+				  pthread_cond_init(&headCond,NULL);
+				}
 
   //  PURPOSE:  To release resources.  No parameters.  No return value.
   ~Train			()
 				throw()
-				{ }
+				{
+				  pthread_cond_destroy(&headCond);
+				  pthread_mutex_destroy(&headLock);
+				}
 
   //  V.  Accessors:
   //  PURPOSE:  To return the id of the train.  No parameters.
@@ -83,6 +192,13 @@ public :
 				throw()
 				{ return(line); }
 
+  //  PURPOSE:  To return the class of service of '*this' Train.  No
+  //	parameters.
+  trainClass_t	getTrainClass	()
+				const
+				throw()
+				{ return(trainClass); }
+
   //  PURPOSE:  To return the direction in which '*this' Train is currently
   //	headed.  No parameters.
   direction_t	getDirection	()
@@ -104,7 +220,184 @@ public :
 				throw()
 				{ return(massTransit); }
 
+  //  PURPOSE:  To return the number of times '*this' Train has moved.  No
+  //	parameters.
+  unsigned long long
+		getNumMoves	()
+				const
+				throw()
+				{ return(numMoves); }
+
+  //  PURPOSE:  To return how many nanoseconds '*this' Train has spent
+  //	waiting for locks and Track instances.  No parameters.
+  unsigned long long
+		getLockWaitNsecs()
+				const
+				throw()
+				{ return(lockWaitNsecs); }
+
+  //  PURPOSE:  To return how long each arrival of '*this' Train at a Track
+  //	waited for room.  No parameters.
+  const WaitHistogram&
+		getTrackWaitHistogram
+				()
+				const
+				throw()
+				{ return(trackWaitHistogram); }
+
+  //  PURPOSE:  To return the arrivals and departures logged by '*this' Train.
+  //	No parameters.
+  const std::vector<LogRecord>&
+		getLogVector	()
+				const
+				throw()
+				{ return(logVector); }
+
+  //  PURPOSE:  To return what '*this' Train traced.  No parameters.
+  const std::vector<TraceRecord>&
+		getTraceVector	()
+				const
+				throw()
+				{ return(traceVector); }
+
+  //  PURPOSE:  To return when '*this' Train last arrived somewhere while
+  //	tracing, on the monotonic clock in nanoseconds, or 0 if it has not.
+  //	No parameters.
+  unsigned long long
+		getArrivalNsecs	()
+				const
+				throw()
+				{ return(arrivalNsecs); }
+
+  //  PURPOSE:  To return the ticket '*this' Train took at the Station where
+  //	it last arrived.  No parameters.
+  unsigned long long
+		getStationTicket()
+				const
+				throw()
+				{ return(stationTicket); }
+
+  //  PURPOSE:  To copy into 'recordVector' the recent arrivals and
+  //	departures of '*this' Train, oldest first, leaving out any that its
+  //	thread overwrites meanwhile.  May be called from any thread.  No
+  //	return value.
+  void		copyRecentRecords
+				(std::vector<LogRecord>&	recordVector
+				)
+				const
+				throw();
+
+  //  PURPOSE:  To return a pointer to the mutex that protects the wait of
+  //	'*this' Train to become the first Train at its Station.  No
+  //	parameters.
+  pthread_mutex_t*
+		getHeadLockPtr	()
+				throw()
+				{ return(&headLock); }
+
+  //  PURPOSE:  To return a pointer to the condition on which '*this' Train
+  //	waits to become the first Train at its Station.  No parameters.
+  pthread_cond_t*
+		getHeadCondPtr	()
+				throw()
+				{ return(&headCond); }
+
+  //  PURPOSE:  To return 'true' if '*this' Train is waiting to become the
+  //	first Train at its Station, or 'false' otherwise.  No parameters.
+  bool		getIsWaitingForHead
+				()
+				const
+				throw()
+				{ return(isWaitingForHead); }
+
+  //  PURPOSE:  To return what '*this' Train does when its ActorScheduler
+  //	next steps it.  No parameters.
+  actorState_t	getActorState	()
+				const
+				throw()
+				{ return(actorState); }
+
+  //  PURPOSE:  To return the TrainLocation at which '*this' Train waits for
+  //	room while run by an ActorScheduler.  No parameters.
+  TrainLocation*
+		getActorNextPtr	()
+				const
+				throw()
+				{ return(actorNextPtr); }
+
+  //  PURPOSE:  To return when '*this' Train began to pause or wait while run
+  //	by an ActorScheduler, on the monotonic clock in nanoseconds.  No
+  //	parameters.
+  unsigned long long
+		getActorSinceNsecs
+				()
+				const
+				throw()
+				{ return(actorSinceNsecs); }
+
+  //  PURPOSE:  To return the next Train parked behind '*this' one for room on
+  //	a Track, or 'NULL'.  No parameters.
+  Train*	getNextParkedPtr()
+				const
+				throw()
+				{ return(nextParkedPtr); }
+
   //  VI.  Mutators:
+  //  PURPOSE:  To return the random number stream of '*this' Train.  No
+  //	parameters.
+  RandomStream&	getRandom	()
+				throw()
+				{ return(random); }
+
+  //  PURPOSE:  To keep 'record' of an arrival or departure of '*this' Train.
+  //	No return value.
+  void		addLogRecord	(const LogRecord&	record
+				)
+				throw()
+				{ logVector.push_back(record); }
+
+  //  PURPOSE:  To keep 'record' of what '*this' Train did.  No return value.
+  void		addTraceRecord	(const TraceRecord&	record
+				)
+				throw()
+				{ traceVector.push_back(record); }
+
+  //  PURPOSE:  To note that '*this' Train arrived somewhere at 'nsecs' on
+  //	the monotonic clock.  No return value.
+  void		setArrivalNsecs	(unsigned long long	nsecs
+				)
+				throw()
+				{ arrivalNsecs = nsecs; }
+
+  //  PURPOSE:  To note that '*this' Train took ticket 'ticket' at the
+  //	Station where it arrives.  No return value.
+  void		setStationTicket(unsigned long long	ticket
+				)
+				throw()
+				{ stationTicket = ticket; }
+
+  //  PURPOSE:  To keep 'record' of an arrival or departure of '*this' Train
+  //	as one of its recent ones, forgetting the oldest.  No return value.
+  void		addRecentRecord	(const LogRecord&	record
+				)
+				throw()
+				{
+				  recentRecordArray[numRecentRecords
+						    % NUM_RECENT_LOG_RECORDS]
+							= record;
+				  __atomic_store_n(&numRecentRecords,
+						   numRecentRecords + 1,
+						   __ATOMIC_RELEASE
+						  );
+				}
+
+  //  PURPOSE:  To make '*this' Train run as class of service
+  //	'newTrainClass'.  No return value.
+  void		setTrainClass	(trainClass_t	newTrainClass
+				)
+				throw()
+				{ trainClass = newTrainClass; }
+
   //  PURPOSE:  To switch directions.  No parameters.  No return value.
   void		switchDiretion	()
 				throw()
@@ -121,20 +414,68 @@ public :
 				throw()
 				{ locPtr = ptr; }
 
+  //  PURPOSE:  To note whether '*this' Train waits to become the first
+  //	Train at its Station.  'headLock' must be held.  No return value.
+  void		setIsWaitingForHead
+				(bool		isWaiting
+				)
+				throw()
+				{ isWaitingForHead = isWaiting; }
+
+  //  PURPOSE:  To note that, while run by an ActorScheduler, '*this' Train
+  //	does 'newState' when next stepped, having begun at 'nsecs' on the
+  //	monotonic clock.  No return value.
+  void		setActorState	(actorState_t		newState,
+				 unsigned long long	nsecs
+				)
+				throw()
+				{
+				  actorState		= newState;
+				  actorSinceNsecs	= nsecs;
+				}
+
+  //  PURPOSE:  To note that, while run by an ActorScheduler, '*this' Train
+  //	moves next to '*newActorNextPtr'.  No return value.
+  void		setActorNextPtr	(TrainLocation*	newActorNextPtr
+				)
+				throw()
+				{ actorNextPtr = newActorNextPtr; }
+
+  //  PURPOSE:  To note that '*newNextParkedPtr' is parked behind '*this'
+  //	Train, or none if it is 'NULL'.  No return value.
+  void		setNextParkedPtr(Train*		newNextParkedPtr
+				)
+				throw()
+				{ nextParkedPtr = newNextParkedPtr; }
+
+  //  PURPOSE:  To note that '*this' Train has moved.  No parameters.  No
+  //	return value.
+  void		noteMove	()
+				throw()
+				{ numMoves++; }
+
+  //  PURPOSE:  To note that '*this' Train waited 'nsecs' nanoseconds for a
+  //	lock or a Track.  No return value.
+  void		addLockWaitNsecs(unsigned long long	nsecs
+				)
+				throw()
+				{ lockWaitNsecs += nsecs; }
+
+  //  PURPOSE:  To note that '*this' Train waited 'nsecs' nanoseconds to
+  //	arrive at a Track.  No return value.
+  void		noteTrackWait	(unsigned long long	nsecs
+				)
+				throw()
+				{
+				  addLockWaitNsecs(nsecs);
+				  trackWaitHistogram.add(nsecs);
+				}
+
   //  VII.  Methods that do main and misc. work of class:
   //  PURPOSE:  To print the name of '*this' to the ncurses-controlled screen.
   //	No parameters.  No return value.
   void		print		()
   				const
-				throw()
-  {
-    char	text[MAX_STRING_LEN];
-
-    snprintf(text,MAX_STRING_LEN,"%s%d ",
-	     (const char*)((getLine() == REDLINE) ? "Red" : "Brn"),
-	     getIdentity()
-	    );
-    addstr(text);
-  }
+				throw();
 
 };
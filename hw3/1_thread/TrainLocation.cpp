@@ -15,26 +15,112 @@
 #include	"headers.h"
 
 
-//  PURPOSE:  To return 'true' if '*trainPtr' is the first 'Train' instance,
-//	or 'false' otherwise.
-bool		TrainLocation::isFirstTrain
-(const Train*	trainPtr
+//  PURPOSE:  To take 'trainLocLock' on behalf of '*trainPtr', charging it
+//	for the time spent waiting.  No return value.
+void		TrainLocation::lockFor
+(Train*		trainPtr
   )
-const
 throw()
 {
 //  I.  Application validity check:
 
-//  II.  Return value:
-  return( (trainPtrQueue.size()  >= 1)  &&
-    (trainPtrQueue.front() == trainPtr)
-    );
+//  II.  Take lock:
+  unsigned long long	startNsecs	= getMonotonicNsecs();
+
+  pthread_mutex_lock(&trainLocLock);
+  lockedNsecs	= getMonotonicNsecs();
+  trainPtr->addLockWaitNsecs(lockedNsecs - startNsecs);
+  trace(trainPtr,TRACE_LOCK_WAIT,startNsecs,lockedNsecs,0);
+
+//  III.  Finished:
 }
 
 
-//  PURPOSE:  To print '*this' and its Train instances.  No parameters.
+//  PURPOSE:  To have the MassTransit system of '*trainPtr' log that event
+//	'kind' happened to it here at 'nsecs' on the monotonic clock, if it
+//	logs events or keeps history.  Events are logged in the order they
+//	happen on each Track, whose lock is held meanwhile, and for each
+//	Train at a Station; as Station tickets are taken without a lock,
+//	two Train instances arriving there at once may be logged out of
+//	ticket order.  No return value.
+void		TrainLocation::logEvent
+(Train*		trainPtr,
+ logKind_t	kind,
+ unsigned long long	nsecs
+  )
+throw()
+{
+//  I.  Application validity check:
+  MassTransit&	massTransit	= trainPtr->getMassTransit();
+
+  if  ( !massTransit.getIsLogging()  &&  !massTransit.getIsKeepingHistory() )
+    return;
+
+//  II.  Log event:
+  massTransit.logEvent(trainPtr,getIndex(),nsecs,kind);
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To have '*trainPtr' trace that it did 'kind' here from
+//	'startNsecs' to 'endNsecs' on the monotonic clock or, for
+//	'TRACE_OCCUPANCY', that 'numTrains' Train instances were here from
+//	'startNsecs' on, if its MassTransit traces.  Only the thread of
+//	'*trainPtr' may call it.  No return value.
+void		TrainLocation::trace
+(Train*			trainPtr,
+ traceKind_t		kind,
+ unsigned long long	startNsecs,
+ unsigned long long	endNsecs,
+ uint			numTrains
+  )
+throw()
+{
+//  I.  Application validity check:
+  MassTransit&	massTransit	= trainPtr->getMassTransit();
+
+  if  ( !massTransit.getIsTracing() )
+    return;
+
+//  II.  Trace:
+  massTransit.traceEvent(trainPtr,kind,getIndex(),startNsecs,endNsecs,numTrains);
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To have '*trainPtr' trace its stay here, which event 'kind' at
+//	'nsecs' on the monotonic clock begins or ends, if its MassTransit
+//	traces.  No return value.
+void		TrainLocation::traceStay
+(Train*			trainPtr,
+ logKind_t		kind,
+ unsigned long long	nsecs
+  )
+throw()
+{
+//  I.  Application validity check:
+  if  ( !trainPtr->getMassTransit().getIsTracing() )
+    return;
+
+//  II.  Trace:
+//	A stay is traced whole when it ends.  A Train that has not arrived
+//	since tracing began stayed since the start:
+  if  (kind == LOG_ARRIVE)
+    trainPtr->setArrivalNsecs(nsecs);
+  else
+    trace(trainPtr,TRACE_STAY,trainPtr->getArrivalNsecs(),nsecs,0);
+
+//  III.  Finished:
+}
+
+
+//  PURPOSE:  To print '*this' holding the Train instances in
+//	'trainPtrVector', as a Snapshot copied them.  No return value.
 void		TrainLocation::print
-()
+(const std::vector<Train*>&	trainPtrVector
+  )
 const
 throw()
 {
@@ -46,16 +132,35 @@ throw()
   snprintf(text,MAX_STRING_LEN,"%s [",getNameCPtr());
     addstr(text);
 
-    std::list<Train*>::const_iterator	end	= trainPtrQueue.end();
-
-    for  (std::list<Train*>::const_iterator
-      iter  = trainPtrQueue.begin();
-      iter != end;
-      iter++
-      )
-      (*iter)->print();
+    for  (size_t i = 0;  i < trainPtrVector.size();  i++)
+      trainPtrVector[i]->print();
 
     addstr("]");
 
 //  III.  Finished:
   }
+
+
+//  PURPOSE:  To return the longest-waiting Train in 'waiterList', which
+//	must not be empty, whose class may take room on '*this' next, or
+//	its front if none may.
+std::list<Train*>::iterator
+		TrainLocation::pickWaiter
+(std::list<Train*>&	waiterList
+  )
+const
+throw()
+{
+//  I.  Application validity check:
+
+//  II.  Find waiter:
+  for  (std::list<Train*>::iterator iter = waiterList.begin();
+	iter != waiterList.end();
+	iter++
+       )
+    if  ( isTurnOf((*iter)->getTrainClass()) )
+      return(iter);
+
+//  III.  Finished:
+  return(waiterList.begin());
+}
@@ -12,14 +12,57 @@
 *---									---*
 *-------------------------------------------------------------------------*/
 
-class	TrainLocation
+class	alignas(CACHE_LINE_BYTES) TrainLocation
 {
 //  I.  Member vars:
+//	Those only read once built come first, then the wait histogram,
+//	which only waits change; those that every arrival or departure
+//	changes start on a cache line of their own, so that Train threads
+//	taking the lock do not evict the others from the caches of threads
+//	that only read them.
 //  PURPOSE:  To point to the name of '*this' TrainLocation:
   char*				nameCPtr;
 
-//  PURPOSE:  To keep track of the trains at '*this' TrainLocation:
-  std::list<Train*>		trainPtrQueue;
+//  PURPOSE:  To tell the index of '*this' among the TrainLocation instances
+//	of its MassTransit system, as given to 'MassTransit::getLocPtr()'.
+  uint				index;
+
+//  PURPOSE:  To tell where 'MassTransit::print()' draws '*this'.
+  int				screenRow;
+  int				screenCol;
+
+//  PURPOSE:  To count how long each wait here since the last
+//	'resetStats()' lasted.  Protected by 'trainLocLock' if changed by
+//	'noteWait()', or only changed atomically if by 'noteWaitUnlocked()',
+//	but never both ways.
+  WaitHistogram			waitHistogram;
+
+//  PURPOSE:  To tell when 'trainLocLock' was last taken by 'lockFor()' or
+//	'waitOn()', on the monotonic clock in nanoseconds.  Protected by
+//	'trainLocLock'.
+  alignas(CACHE_LINE_BYTES)
+  unsigned long long		lockedNsecs;
+
+//  PURPOSE:  To hold the contention statistics of '*this' since the last
+//	'resetStats()': 'occupancyNsecs' is the sum of the departure times
+//	minus the sum of the arrival times of the Train instances that came
+//	and went, so that adding the current time for each Train present
+//	gives the number of Train instances present summed over time;
+//	'numArrivals' counts arrivals; both are only changed atomically, so
+//	need no lock.  'numLockHolds', 'lockHoldNsecs' and
+//	'maxLockHoldNsecs' tell how often and how long 'trainLocLock' was
+//	held, and are protected by it.
+  unsigned long long		occupancyNsecs;
+  unsigned long long		numArrivals;
+  unsigned long long		numLockHolds;
+  unsigned long long		lockHoldNsecs;
+  unsigned long long		maxLockHoldNsecs;
+
+//  PURPOSE:  To count the changes to the Train instances at '*this' begun
+//	and those done, so that a Snapshot can tell whether what it copied
+//	changed meanwhile.  Only changed atomically.
+  unsigned long long		numChangesBegun;
+  unsigned long long		numChangesDone;
 
 //  PURPOSE:  To lock '*this' so only one 'Train' thread instance at a time
 //	may access it.
@@ -39,6 +82,150 @@ public:
 
   protected :
 //  III.  Protected methods:
+//  PURPOSE:  To return when 'trainLocLock' was last taken, on the monotonic
+//	clock in nanoseconds.  'trainLocLock' must be held.  No parameters.
+  unsigned long long	getLockedNsecs
+  ()
+  const
+  throw()
+  { return(lockedNsecs); }
+
+//  PURPOSE:  To take 'trainLocLock' on behalf of '*trainPtr', charging it
+//	for the time spent waiting.  No return value.
+  void			lockFor	(Train*		trainPtr
+    )
+  throw();
+
+//  PURPOSE:  To give up 'trainLocLock', noting how long it was held.  No
+//	parameters.  No return value.
+  void			unlock	()
+  throw()
+  {
+    unsigned long long	holdNsecs	= getMonotonicNsecs() - lockedNsecs;
+
+    numLockHolds++;
+    lockHoldNsecs	+= holdNsecs;
+
+    if  (maxLockHoldNsecs < holdNsecs)
+      maxLockHoldNsecs	= holdNsecs;
+
+    pthread_mutex_unlock(&trainLocLock);
+  }
+
+//  PURPOSE:  To wait on '*condPtr' with 'trainLocLock', which must be held,
+//	counting the time before the wait and after it as separate holds.
+//	No return value.
+  void			waitOn	(pthread_cond_t*	condPtr
+    )
+  throw()
+  {
+    unsigned long long	holdNsecs	= getMonotonicNsecs() - lockedNsecs;
+
+    numLockHolds++;
+    lockHoldNsecs	+= holdNsecs;
+
+    if  (maxLockHoldNsecs < holdNsecs)
+      maxLockHoldNsecs	= holdNsecs;
+
+    pthread_cond_wait(condPtr,&trainLocLock);
+    lockedNsecs	= getMonotonicNsecs();
+  }
+
+//  PURPOSE:  To have the MassTransit system of '*trainPtr' log that event
+//	'kind' happened to it here at 'nsecs' on the monotonic clock, if it
+//	logs events or keeps history.  Events are logged in the order they
+//	happen on each Track, whose lock is held meanwhile, and for each
+//	Train at a Station; as Station tickets are taken without a lock,
+//	two Train instances arriving there at once may be logged out of
+//	ticket order.  No return value.
+  void			logEvent(Train*		trainPtr,
+				 logKind_t	kind,
+				 unsigned long long	nsecs
+    )
+  throw();
+
+//  PURPOSE:  To have '*trainPtr' trace that it did 'kind' here from
+//	'startNsecs' to 'endNsecs' on the monotonic clock or, for
+//	'TRACE_OCCUPANCY', that 'numTrains' Train instances were here from
+//	'startNsecs' on, if its MassTransit traces.  Only the thread of
+//	'*trainPtr' may call it.  No return value.
+  void			trace	(Train*			trainPtr,
+				 traceKind_t		kind,
+				 unsigned long long	startNsecs,
+				 unsigned long long	endNsecs,
+				 uint			numTrains
+    )
+  throw();
+
+//  PURPOSE:  To have '*trainPtr' trace its stay here, which event 'kind' at
+//	'nsecs' on the monotonic clock begins or ends, if its MassTransit
+//	traces.  No return value.
+  void			traceStay
+				(Train*			trainPtr,
+				 logKind_t		kind,
+				 unsigned long long	nsecs
+    )
+  throw();
+
+//  PURPOSE:  To note that a change to the Train instances at '*this' is
+//	begun.  Every change, with the counts it makes, must be between
+//	'beginChange()' and 'endChange()'.  No parameters.  No return value.
+  void			beginChange
+  ()
+  throw()
+  { __atomic_fetch_add(&numChangesBegun,1,__ATOMIC_SEQ_CST); }
+
+//  PURPOSE:  To note that a change begun by 'beginChange()' is done.  No
+//	parameters.  No return value.
+  void			endChange
+  ()
+  throw()
+  { __atomic_fetch_add(&numChangesDone,1,__ATOMIC_SEQ_CST); }
+
+//  PURPOSE:  To note that a Train waited 'nsecs' nanoseconds here.
+//	'trainLocLock' must be held.  No return value.
+  void			noteWait(unsigned long long	nsecs
+    )
+  throw()
+  { waitHistogram.add(nsecs); }
+
+//  PURPOSE:  To note that a Train waited 'nsecs' nanoseconds here, without
+//	holding 'trainLocLock'.  Only for a TrainLocation whose waits never
+//	go through 'noteWait()'.  No return value.
+  void			noteWaitUnlocked
+				(unsigned long long	nsecs
+    )
+  throw()
+  { waitHistogram.addShared(nsecs); }
+
+//  PURPOSE:  To count the arrival of '*trainPtr' at 'nsecs' on the
+//	monotonic clock, and to log and trace it.  May be called without a
+//	lock.  No return value.
+  void			noteArrival
+				(Train*		trainPtr,
+				 unsigned long long	nsecs
+    )
+  throw()
+  {
+    __sync_fetch_and_sub(&occupancyNsecs,nsecs);
+    __sync_fetch_and_add(&numArrivals,1);
+    logEvent(trainPtr,LOG_ARRIVE,nsecs);
+    traceStay(trainPtr,LOG_ARRIVE,nsecs);
+  }
+
+//  PURPOSE:  To count the departure of '*trainPtr' at 'nsecs' on the
+//	monotonic clock, and to log and trace it.  May be called without a
+//	lock.  No return value.
+  void			noteDeparture
+				(Train*		trainPtr,
+				 unsigned long long	nsecs
+    )
+  throw()
+  {
+    __sync_fetch_and_add(&occupancyNsecs,nsecs);
+    logEvent(trainPtr,LOG_LEAVE,nsecs);
+    traceStay(trainPtr,LOG_LEAVE,nsecs);
+  }
 
   public :
 //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
@@ -47,7 +234,19 @@ public:
   TrainLocation			(const char*	newNameCPtr
     )
   throw() :
-  nameCPtr(strndup(newNameCPtr,MAX_STRING_LEN-1))
+  nameCPtr(strndup(newNameCPtr,MAX_STRING_LEN-1)),
+  index(0),
+  screenRow(0),
+  screenCol(0),
+  waitHistogram(),
+  lockedNsecs(0),
+  occupancyNsecs(0),
+  numArrivals(0),
+  numLockHolds(0),
+  lockHoldNsecs(0),
+  maxLockHoldNsecs(0),
+  numChangesBegun(0),
+  numChangesDone(0)
   {
 //  YOUR CODE HERE TO INITIALIZE YOUR MUTEX
     pthread_mutex_init(&trainLocLock, NULL);
@@ -70,12 +269,140 @@ public:
   throw()
   { return(nameCPtr); }
 
+//  PURPOSE:  To return the index of '*this' among the TrainLocation
+//	instances of its MassTransit system.  No parameters.
+  uint			getIndex
+  ()
+  const
+  throw()
+  { return(index); }
+
+//  PURPOSE:  To return the screen row at which '*this' is drawn.  No
+//	parameters.
+  int			getScreenRow
+  ()
+  const
+  throw()
+  { return(screenRow); }
+
+//  PURPOSE:  To return the screen column at which '*this' is drawn.  No
+//	parameters.
+  int			getScreenCol
+  ()
+  const
+  throw()
+  { return(screenCol); }
+
 //  PURPOSE:  To return the number of trains.  No parameters.
+  virtual
   uint			getNumTrains
   ()
   const
   throw()
-  { return(trainPtrQueue.size()); }
+  = 0;
+
+//  PURPOSE:  To return the first Train, or 'NULL' if there is none.  No
+//	parameters.
+  virtual
+  Train*		getFirstTrain
+  ()
+  const
+  throw()
+  = 0;
+
+//  PURPOSE:  To return the first express Train, which may leave '*this'
+//	ahead of the local ones before it, or 'NULL' if there is none or
+//	Train instances leave '*this' strictly in turn.  No parameters.
+  virtual
+  Train*		getFirstExpressTrain
+  ()
+  const
+  throw()
+  { return(NULL); }
+
+//  PURPOSE:  To return the sum over time of the number of Train instances
+//	at '*this', in Train-nanoseconds, up to 'nowNsecs' on the monotonic
+//	clock, if 'numTrains' Train instances are here.  Divided by the time
+//	since 'resetStats()' it gives the mean occupancy.
+  unsigned long long	getOccupancyNsecs
+  (unsigned long long	nowNsecs,
+   uint			numTrains
+    )
+  const
+  throw()
+  {
+    return( __atomic_load_n(&occupancyNsecs,__ATOMIC_RELAXED)
+	    + (unsigned long long)numTrains * nowNsecs
+	  );
+  }
+
+//  PURPOSE:  To return the sum over time of the number of Train instances
+//	at '*this', in Train-nanoseconds, up to 'nowNsecs' on the monotonic
+//	clock.  Only exact while no Train thread runs; a Snapshot gives it
+//	exactly at any time.
+  unsigned long long	getOccupancyNsecs
+  (unsigned long long	nowNsecs
+    )
+  const
+  throw()
+  { return(getOccupancyNsecs(nowNsecs,getNumTrains())); }
+
+//  PURPOSE:  To return the number of arrivals since 'resetStats()'.  No
+//	parameters.
+  unsigned long long	getNumArrivals
+  ()
+  const
+  throw()
+  { return(__atomic_load_n(&numArrivals,__ATOMIC_RELAXED)); }
+
+//  PURPOSE:  To return the number of changes to the Train instances at
+//	'*this' begun so far.  No parameters.
+  unsigned long long	getNumChangesBegun
+  ()
+  const
+  throw()
+  { return(__atomic_load_n(&numChangesBegun,__ATOMIC_SEQ_CST)); }
+
+//  PURPOSE:  To return the number of changes to the Train instances at
+//	'*this' done so far.  No parameters.
+  unsigned long long	getNumChangesDone
+  ()
+  const
+  throw()
+  { return(__atomic_load_n(&numChangesDone,__ATOMIC_SEQ_CST)); }
+
+//  PURPOSE:  To return how long each wait at '*this' since 'resetStats()'
+//	lasted: for a Track the waits for room, and for a Station the waits
+//	of ready Train instances to become first.  No parameters.
+  const WaitHistogram&	getWaitHistogram
+  ()
+  const
+  throw()
+  { return(waitHistogram); }
+
+//  PURPOSE:  To return the number of times 'trainLocLock' was held since
+//	'resetStats()'.  No parameters.
+  unsigned long long	getNumLockHolds
+  ()
+  const
+  throw()
+  { return(numLockHolds); }
+
+//  PURPOSE:  To return the total nanoseconds 'trainLocLock' was held since
+//	'resetStats()'.  No parameters.
+  unsigned long long	getLockHoldNsecs
+  ()
+  const
+  throw()
+  { return(lockHoldNsecs); }
+
+//  PURPOSE:  To return the longest 'trainLocLock' was held at once since
+//	'resetStats()', in nanoseconds.  No parameters.
+  unsigned long long	getMaxLockHoldNsecs
+  ()
+  const
+  throw()
+  { return(maxLockHoldNsecs); }
 
 //  PURPOSE:  To return a pointer to 'lock'.  No parameters.
   pthread_mutex_t*	getLockPtr
@@ -84,31 +411,99 @@ public:
 { return(&trainLocLock /* YOUR CODE HERE TO RETURN PTR TO YOUR MUTEX */ ); }
 
 //  VI.  Mutators:
-
-//  VII.  Methods that do main & misc work of class:
-//  PURPOSE:  To put '*trainPtr' into the end of 'trainPtrQueue'.  No return
-//	value.
-  void			enqueue	(Train*		trainPtr
+//  PURPOSE:  To note that '*this' is TrainLocation 'newIndex' of its
+//	MassTransit system.  No return value.
+  void			setIndex
+  (uint			newIndex
     )
   throw()
-  { trainPtrQueue.push_back(trainPtr); }
+  { index = newIndex; }
 
-//  PURPOSE:  To remove 'trainPtr' from 'trainPtrQueue'.  No return value.
-  void			dequeue	(Train*		trainPtr
+//  PURPOSE:  To draw '*this' at screen row 'row' and column 'col'.  No
+//	return value.
+  void			setScreenPos
+  (int			row,
+   int			col
     )
   throw()
-  { trainPtrQueue.remove(trainPtr); }
+  { screenRow = row;  screenCol = col; }
+
+//  PURPOSE:  To zero the contention statistics, starting the occupancy sum
+//	now.  No Train thread may run.  No parameters.  No return value.
+  void			resetStats
+  ()
+  throw()
+  {
+    occupancyNsecs	= - (unsigned long long)getNumTrains()
+			    * getMonotonicNsecs();
+    numArrivals		= 0;
+    waitHistogram.clear();
+    numLockHolds	= 0;
+    lockHoldNsecs	= 0;
+    maxLockHoldNsecs	= 0;
+  }
 
+//  VII.  Methods that do main & misc work of class:
 //  PURPOSE:  To return 'true' if '*trainPtr' is the first 'Train' instance,
 //	or 'false' otherwise.
+  virtual
   bool			isFirstTrain
   (const Train*	trainPtr
     )
   const
+  throw()
+  = 0;
+
+//  PURPOSE:  To copy the Train instances at '*this', first one first, into
+//	'trainPtrVector' without waiting.  The copy may be torn by a change
+//	made meanwhile; a Snapshot tells, by 'getNumChangesBegun()' and
+//	'getNumChangesDone()', whether it was.  No return value.
+  virtual
+  void			copyTrains
+  (std::vector<Train*>&	trainPtrVector
+    )
+  const
+  throw()
+  = 0;
+
+//  PURPOSE:  To print '*this' holding the Train instances in
+//	'trainPtrVector', as a Snapshot copied them.  No return value.
+  void			print	(const std::vector<Train*>&	trainPtrVector
+    )
+  const
   throw();
 
-//  PURPOSE:  To print '*this' and its Train instances.  No parameters.
-  void			print	()
+//  PURPOSE:  To return 'true' if a waiting Train of class 'trainClass' may
+//	take room on '*this' next, or 'false' if one of the other class
+//	goes first.  A TrainLocation with room for any number of Train
+//	instances favours none.
+  virtual
+  bool			isTurnOf
+  (trainClass_t	trainClass
+    )
+  const
+  throw()
+  { return(true); }
+
+//  PURPOSE:  To note that '*trainPtr' starts waiting for room on '*this',
+//	if 'isWaiting', or stops, in a simulator that keeps its own list of
+//	waiting Train instances instead of calling 'reserve()'.  No return
+//	value.
+  virtual
+  void			noteWaiting
+  (Train*		trainPtr,
+   bool		isWaiting
+    )
+  throw()
+  { }
+
+//  PURPOSE:  To return the longest-waiting Train in 'waiterList', which
+//	must not be empty, whose class may take room on '*this' next, or
+//	its front if none may.
+  std::list<Train*>::iterator
+			pickWaiter
+  (std::list<Train*>&	waiterList
+    )
   const
   throw();
 
@@ -121,6 +516,27 @@ public:
   throw()
   { return(true); }
 
+//  PURPOSE:  To block until '*trainPtr' can leave '*this' TrainLocation or
+//	the simulation stops.  Returns 'true' if '*trainPtr' can leave, or
+//	'false' if the simulation stopped first.
+  virtual
+  bool			waitUntilCanLeave
+  (Train*		trainPtr
+    )
+  throw()
+  { return(canLeave(trainPtr)); }
+
+//  PURPOSE:  To return 'true' at once if '*trainPtr' can leave '*this'
+//	TrainLocation or, if not, to park it, run by an ActorScheduler, so
+//	that it is resumed when it can, and to return 'false'.  Never
+//	blocks.
+  virtual
+  bool			parkUntilCanLeave
+  (Train*		trainPtr
+    )
+  throw()
+  { return(canLeave(trainPtr)); }
+
 //  PURPOSE:  To return a pointer to the next TrainLocation for '*trainPtr'
 //  	after it leaves '*this'.
   virtual
@@ -136,6 +552,56 @@ public:
   throw()
   = 0;
 
+//  PURPOSE:  To block until there is room on '*this' for '*trainPtr', and
+//	to hold that room for it, so that it need not leave where it is
+//	before it is sure to get here.  Returns 'true' if the room is held, or
+//	'false' if the simulation stopped first.  A TrainLocation with room
+//	for any number of Train instances holds nothing.
+  virtual
+  bool			reserve	(Train*		trainPtr
+    )
+  throw()
+  { return(true); }
+
+//  PURPOSE:  To hold room on '*this' for '*trainPtr' and return 'true' at
+//	once if there is some or, if not, to park it, run by an
+//	ActorScheduler, so that it is resumed once room is held for it, and
+//	to return 'false'.  Never blocks.
+  virtual
+  bool			reserveOrPark
+  (Train*		trainPtr
+    )
+  throw()
+  { return(true); }
+
+//  PURPOSE:  To note that '*trainPtr', parked here by 'parkUntilCanLeave()'
+//	or 'reserveOrPark()' since 'trainPtr->getActorSinceNsecs()', was
+//	resumed.  Only the worker that runs '*trainPtr' may call it.  No
+//	return value.
+  virtual
+  void			noteUnparked
+  (Train*		trainPtr
+    )
+  throw()
+  { }
+
+//  PURPOSE:  To make '*trainPtr', for which 'reserve()' holds room, arrive
+//	at '*this'.  No return value.
+  virtual
+  void			occupy	(Train*		trainPtr
+    )
+  throw()
+  { arrive(trainPtr); }
+
+//  PURPOSE:  To make '*trainPtr' arrive at '*this' if it can do so without
+//	waiting.  Returns 'true' if '*trainPtr' arrived or 'false' otherwise.
+  virtual
+  bool			tryArrive
+  (Train*		trainPtr
+    )
+  throw()
+  { arrive(trainPtr);  return(true); }
+
 //  PURPOSE:  To make '*trainPtr' leave '*this'.  No return value.
   virtual
   void			leave	(Train*		trainPtr
@@ -0,0 +1,162 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		TrainRing.h						---*
+ *---									---*
+ *---	    This file declares a class that keeps the Train instances	---*
+ *---	at one TrainLocation in arrival order, in a circular array.	---*
+ *---	Adding at the back and removing from the front take constant	---*
+ *---	time and do not allocate.  The array is sized once, when made,	---*
+ *---	and never grows: adding to a full one fails instead.		---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+class	TrainRing
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To hold the Train pointers.  The 'i'-th from the front is at
+  //	'slotArray[(head + i) & mask]'.
+  Train**			slotArray;
+
+  //  PURPOSE:  To tell the length of 'slotArray[]' minus one.  The length is
+  //	always a power of two.
+  uint				mask;
+
+  //  PURPOSE:  To tell the index in 'slotArray[]' of the front Train.
+  uint				head;
+
+  //  PURPOSE:  To tell how many Train instances are held.
+  uint				count;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No default constructor:
+  TrainRing			();
+
+  //  No copy constructor:
+  TrainRing			(const TrainRing&);
+
+  //  No copy assignment op:
+  TrainRing&			operator=
+				(const TrainRing&);
+
+public :
+  //  III.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To make '*this' empty, with room for at least 'capacity'
+  //	Train instances.  No return value.
+  TrainRing			(uint		capacity
+				)
+				throw() :
+				slotArray(NULL),
+				mask(0),
+				head(0),
+				count(0)
+  {
+    uint	length	= 1;
+
+    while  (length < capacity)
+      length	*= 2;
+
+    slotArray	= (Train**)calloc(length,sizeof(Train*));
+    mask	= length - 1;
+  }
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~TrainRing			()
+				throw()
+				{ safeFree(slotArray); }
+
+  //  IV.  Accessors:
+  //  PURPOSE:  To return the number of Train instances held.  No parameters.
+  uint		getCount	()
+				const
+				throw()
+				{ return(count); }
+
+  //  PURPOSE:  To return the front Train, or 'NULL' if there is none.  No
+  //	parameters.
+  Train*	getFront	()
+				const
+				throw()
+				{ return( (count == 0) ? NULL : slotArray[head] ); }
+
+  //  PURPOSE:  To return the 'i'-th Train from the front.  'i' must be less
+  //	than 'getCount()'.
+  Train*	operator[]	(uint		i
+				)
+				const
+				throw()
+				{ return(slotArray[(head + i) & mask]); }
+
+  //  PURPOSE:  To copy the held Train instances, front first, into
+  //	'trainPtrVector', even while another thread changes '*this'.  The
+  //	copy is then possibly torn, but never reads outside 'slotArray[]',
+  //	which never moves or grows.  No return value.
+  void		copyTo		(std::vector<Train*>&	trainPtrVector
+				)
+				const
+				throw()
+  {
+    uint	first	= __atomic_load_n(&head,__ATOMIC_RELAXED);
+    uint	number	= __atomic_load_n(&count,__ATOMIC_RELAXED);
+
+    if  (number > mask + 1)
+      number	= mask + 1;
+
+    trainPtrVector.clear();
+
+    for  (uint i = 0;  i < number;  i++)
+    {
+      Train*	trainPtr
+		= __atomic_load_n(&slotArray[(first + i) & mask],__ATOMIC_RELAXED);
+
+      if  (trainPtr != NULL)
+	trainPtrVector.push_back(trainPtr);
+    }
+  }
+
+  //  V.  Mutators:
+  //  PURPOSE:  To put 'trainPtr' at the back.  Returns 'true' if it was put
+  //	there, or 'false', leaving '*this' unchanged, if '*this' is full.
+  bool		pushBack	(Train*		trainPtr
+				)
+				throw()
+  {
+    if  (count > mask)
+      return(false);
+
+    slotArray[(head + count) & mask]	= trainPtr;
+    count++;
+    return(true);
+  }
+
+  //  PURPOSE:  To remove 'trainPtr'.  Takes constant time when 'trainPtr' is
+  //	at the front, which is the usual case, and otherwise shifts the
+  //	Train instances behind it forward.  No return value.
+  void		remove		(Train*		trainPtr
+				)
+				throw()
+  {
+    if  ( (count > 0)  &&  (slotArray[head] == trainPtr) )
+    {
+      slotArray[head]	= NULL;
+      head		= (head + 1) & mask;
+      count--;
+      return;
+    }
+
+    for  (uint i = 1;  i < count;  i++)
+      if  ((*this)[i] == trainPtr)
+      {
+	for  ( ;  i < count - 1;  i++)
+	  slotArray[(head + i) & mask]	= (*this)[i + 1];
+
+	count--;
+	slotArray[(head + count) & mask]	= NULL;
+	return;
+      }
+  }
+
+};
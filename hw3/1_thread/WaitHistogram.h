@@ -0,0 +1,215 @@
+/*-------------------------------------------------------------------------*
+ *---									---*
+ *---		WaitHistogram.h						---*
+ *---									---*
+ *---	    This file declares a class that counts wait times in	---*
+ *---	log-scaled buckets so that percentiles can be reported		---*
+ *---	without keeping every sample.  Times under 8 microseconds get	---*
+ *---	their own buckets; longer ones are split four ways per power	---*
+ *---	of two, so a reported percentile is within 25% of the truth.	---*
+ *---									---*
+ *---	----	----	----	----	----	----	----	----	---*
+ *---									---*
+ *---	Version 1.0		2013 May 10		Joseph Phillips	---*
+ *---									---*
+ *-------------------------------------------------------------------------*/
+
+//  PURPOSE:  To tell how many buckets hold waits of under 8 microseconds,
+//	one microsecond each.
+const	uint	WAIT_HISTOGRAM_NUM_LINEAR_BUCKETS	= 8;
+
+//  PURPOSE:  To tell how many buckets split each power of two above that.
+const	uint	WAIT_HISTOGRAM_NUM_SUB_BUCKETS		= 4;
+
+//  PURPOSE:  To tell the number of buckets, enough for waits of up to 2^32
+//	microseconds (over an hour).  Longer waits go in the last one.
+const	uint	WAIT_HISTOGRAM_NUM_BUCKETS
+			= WAIT_HISTOGRAM_NUM_LINEAR_BUCKETS
+			  + (32 - 3) * WAIT_HISTOGRAM_NUM_SUB_BUCKETS;
+
+
+class	WaitHistogram
+{
+  //  I.  Member vars:
+  //  PURPOSE:  To count the waits in each bucket.
+  uint				countArray[WAIT_HISTOGRAM_NUM_BUCKETS];
+
+  //  PURPOSE:  To tell the number of waits counted.
+  unsigned long long		numWaits;
+
+  //  PURPOSE:  To tell the longest wait counted, in microseconds.
+  unsigned long long		maxUsecs;
+
+  //  II.  Disallowed auto-generated methods:
+  //  No copy constructor:
+  WaitHistogram			(const WaitHistogram&);
+
+  //  No copy assignment op:
+  WaitHistogram&		operator=
+				(const WaitHistogram&);
+
+protected :
+  //  III.  Protected methods:
+  //  PURPOSE:  To return the index of the bucket that counts waits of
+  //	'usecs' microseconds.
+  static
+  uint		getBucket	(unsigned long long	usecs
+				)
+				throw()
+  {
+    if  (usecs < WAIT_HISTOGRAM_NUM_LINEAR_BUCKETS)
+      return(usecs);
+
+    uint	exponent	= 63 - __builtin_clzll(usecs);
+    uint	bucket		= WAIT_HISTOGRAM_NUM_LINEAR_BUCKETS
+				  + (exponent - 3) * WAIT_HISTOGRAM_NUM_SUB_BUCKETS
+				  + ( (usecs >> (exponent - 2))
+				      & (WAIT_HISTOGRAM_NUM_SUB_BUCKETS - 1)
+				    );
+
+    return( (bucket < WAIT_HISTOGRAM_NUM_BUCKETS)
+	    ? bucket
+	    : (WAIT_HISTOGRAM_NUM_BUCKETS - 1)
+	  );
+  }
+
+  //  PURPOSE:  To return the longest wait, in microseconds, that bucket
+  //	'bucket' counts.
+  static
+  unsigned long long
+		getBucketMaxUsecs
+				(uint		bucket
+				)
+				throw()
+  {
+    if  (bucket < WAIT_HISTOGRAM_NUM_LINEAR_BUCKETS)
+      return(bucket);
+
+    uint	exponent	= 3 + (bucket - WAIT_HISTOGRAM_NUM_LINEAR_BUCKETS)
+				      / WAIT_HISTOGRAM_NUM_SUB_BUCKETS;
+    uint	subBucket	= (bucket - WAIT_HISTOGRAM_NUM_LINEAR_BUCKETS)
+				  % WAIT_HISTOGRAM_NUM_SUB_BUCKETS;
+
+    return( (1ULL << exponent) + ((subBucket + 1ULL) << (exponent - 2)) - 1 );
+  }
+
+public :
+  //  IV.  Constructor(s), assignment op(s), factory(s) and destructor:
+  //  PURPOSE:  To make '*this' empty.  No parameters.  No return value.
+  WaitHistogram			()
+				throw() :
+				numWaits(0),
+				maxUsecs(0)
+				{ memset(countArray,0,sizeof(countArray)); }
+
+  //  PURPOSE:  To release resources.  No parameters.  No return value.
+  ~WaitHistogram		()
+				throw()
+				{ }
+
+  //  V.  Accessors:
+  //  PURPOSE:  To return the number of waits counted.  No parameters.
+  unsigned long long
+		getNumWaits	()
+				const
+				throw()
+				{ return(numWaits); }
+
+  //  PURPOSE:  To return the longest wait counted, in microseconds.  No
+  //	parameters.
+  unsigned long long
+		getMaxUsecs	()
+				const
+				throw()
+				{ return(maxUsecs); }
+
+  //  PURPOSE:  To return the wait, in microseconds, that 'percent' percent
+  //	of the counted waits do not exceed, or 0 if none were counted.
+  unsigned long long
+		getPercentileUsecs
+				(double		percent
+				)
+				const
+				throw()
+  {
+    unsigned long long	rank	= (unsigned long long)(percent * numWaits / 100.0);
+    unsigned long long	sum	= 0;
+
+    if  (rank >= numWaits)
+      return(maxUsecs);
+
+    for  (uint bucket = 0;  bucket < WAIT_HISTOGRAM_NUM_BUCKETS;  bucket++)
+    {
+      sum	+= countArray[bucket];
+
+      if  (sum > rank)
+      {
+	unsigned long long	usecs	= getBucketMaxUsecs(bucket);
+
+	return( (usecs < maxUsecs) ? usecs : maxUsecs );
+      }
+    }
+
+    return(maxUsecs);
+  }
+
+  //  VI.  Mutators:
+  //  PURPOSE:  To make '*this' empty again.  No parameters.  No return value.
+  void		clear		()
+				throw()
+  {
+    memset(countArray,0,sizeof(countArray));
+    numWaits	= 0;
+    maxUsecs	= 0;
+  }
+
+  //  PURPOSE:  To count a wait of 'nsecs' nanoseconds.  No return value.
+  void		add		(unsigned long long	nsecs
+				)
+				throw()
+  {
+    unsigned long long	usecs	= nsecs / (NSECS_PER_SEC / USECS_PER_SEC);
+
+    countArray[getBucket(usecs)]++;
+    numWaits++;
+
+    if  (maxUsecs < usecs)
+      maxUsecs	= usecs;
+  }
+
+  //  PURPOSE:  To count a wait of 'nsecs' nanoseconds, like 'add()', when
+  //	other threads may be calling 'addShared()' on '*this' at the same
+  //	time.  Must not be mixed with 'add()' on the same '*this'.  No
+  //	return value.
+  void		addShared	(unsigned long long	nsecs
+				)
+				throw()
+  {
+    unsigned long long	usecs	= nsecs / (NSECS_PER_SEC / USECS_PER_SEC);
+    unsigned long long	oldMaxUsecs;
+
+    __sync_fetch_and_add(&countArray[getBucket(usecs)],1);
+    __sync_fetch_and_add(&numWaits,1);
+
+    while  ( ((oldMaxUsecs = __atomic_load_n(&maxUsecs,__ATOMIC_RELAXED))
+	      < usecs
+	     )  &&
+	     !__sync_bool_compare_and_swap(&maxUsecs,oldMaxUsecs,usecs)
+	   );
+  }
+
+  //  PURPOSE:  To count the waits counted by 'other' too.  No return value.
+  void		merge		(const WaitHistogram&	other
+				)
+				throw()
+  {
+    for  (uint bucket = 0;  bucket < WAIT_HISTOGRAM_NUM_BUCKETS;  bucket++)
+      countArray[bucket]	+= other.countArray[bucket];
+
+    numWaits	+= other.numWaits;
+
+    if  (maxUsecs < other.maxUsecs)
+      maxUsecs	= other.maxUsecs;
+  }
+
+};
@@ -16,9 +16,32 @@
 #include	<cstdlib>
 #include	<cstdio>
 #include	<cstring>
+#include	<cmath>
+#include	<cerrno>
+#include	<climits>
+#include	<cctype>
 #include	<unistd.h>	// For sleep()
-
+#include	<time.h>	// For clock_gettime()
+#include	<sys/resource.h>	// For getrusage()
+#include	<sys/mman.h>	// For mmap()
+#include	<sys/stat.h>	// For fstat()
+#include	<fcntl.h>	// For open()
+#include	<sys/syscall.h>	// For syscall()
+#include	<sys/ioctl.h>	// For ioctl()
+#include	<linux/perf_event.h>	// For perf_event_open()
+#include	<sys/eventfd.h>	// For eventfd()
+#include	<poll.h>	// For ppoll()
+
+#include	<algorithm>	// For std::sort()
+#include	<deque>
 #include	<list>
+#include	<map>
+#include	<queue>
+#include	<set>
+#include	<vector>
+#include	<functional>
+#include	<string>
+#include	<new>		// For placement new
 
 #include	<ncurses.h>	// For screen control
 #include	<pthread.h>	// For pthreads
@@ -27,16 +50,9 @@
 
 /*---			Common primitive types:				---*/
 
-//  PURPOSE:  To represent one of two transit lines.
-typedef		enum
-		{
-		  REDLINE,
-		  BROWNLINE,
-
-		  NUM_LINES,
-		  MIN_LINE	= REDLINE,
-		  MAX_LINE	= BROWNLINE
-		}
+//  PURPOSE:  To represent one of the transit lines of a MassTransit system,
+//	as an index from 0 to 'MassTransit::getNumLines()-1'.
+typedef		unsigned int
 		line_t;
 
 
@@ -53,22 +69,152 @@ typedef		enum
 		direction_t;
 
 
+//  PURPOSE:  To represent the class of service of a Train: a local one
+//	that gives way, or an express one that Track instances admit first
+//	and that may leave a Station ahead of local ones.
+typedef		enum
+		{
+		  LOCAL_TRAIN,
+		  EXPRESS_TRAIN,
+
+		  NUM_TRAIN_CLASSES
+		}
+		trainClass_t;
+
+
 //  PURPOSE:  To define an abbreviated name integer name.
 typedef		unsigned int
 		uint;
 
 
+//  PURPOSE:  To represent a virtual time in microseconds.
+typedef		unsigned long long
+		simTime_t;
+
+
 /*---			Common constants:				---*/
 
+//  PURPOSE:  To tell the virtual time that never comes, for when no event
+//	is pending.
+const	simTime_t	SIM_TIME_NEVER		= ~0ULL;
+
 //  PURPOSE:  To tell the maximum length of C strings.
 const	uint	MAX_STRING_LEN			= 256;
 
-//  PURPOSE:  To tell maximum number of trains simultaneously allowed on a
-//	single track.
-const	uint	MAX_ALLOWED_NUM_TRAINS_ON_TRACK	= 1;
-
-//  PURPOSE:  To tell the number of Train instances to make.
-const	uint	NUM_TRAINS			= 16;
+//  PURPOSE:  To tell the default maximum number of trains simultaneously
+//	allowed on a single track.
+const	uint	DEFAULT_TRACK_CAPACITY		= 1;
+
+//  PURPOSE:  To tell the default number of Train instances to make.
+const	uint	DEFAULT_NUM_TRAINS		= 16;
+
+//  PURPOSE:  To tell the default longest time a Train pauses between
+//	attempts to move, in microseconds.
+const	uint	DEFAULT_MAX_PAUSE_USECS		= 10000000;
+
+//  PURPOSE:  To tell the stack size of each Train pthread.  'simulateTrain()'
+//	needs little, and the default of several megabytes would limit how
+//	many Train instances may run.
+const	size_t	TRAIN_STACK_SIZE		= 64 * 1024;
+
+//  PURPOSE:  To tell the default seed from which the random number streams
+//	of the MassTransit and of each Train are derived.
+const	uint	DEFAULT_SEED			= 1;
+
+//  PURPOSE:  To tell the default number of times a second to redraw the
+//	screen.
+const	uint	DEFAULT_FRAMES_PER_SEC		= 10;
+
+//  PURPOSE:  To tell the default time a move takes, in microseconds, when
+//	simulating in virtual time on several workers.
+const	uint	DEFAULT_TRAVERSAL_USECS		= 100000;
+
+//  PURPOSE:  To tell how many times a Snapshot copies the system looking
+//	for a consistent cut before it settles for its last copy.
+const	uint	SNAPSHOT_MAX_NUM_ATTEMPTS	= 64;
+
+//  PURPOSE:  To tell how many of its latest arrivals and departures each
+//	Train keeps for an InvariantChecker to report.
+const	uint	NUM_RECENT_LOG_RECORDS		= 16;
+
+//  PURPOSE:  To tell how long a Train may be at no TrainLocation before an
+//	InvariantChecker reports it lost, in nanoseconds.
+const	unsigned long long
+		INVARIANT_LOST_TRAIN_NSECS	= 1000000000ULL;
+
+//  PURPOSE:  To tell the longest an InvariantChecker sleeps between
+//	checks, however small its CPU budget, in nanoseconds.
+const	unsigned long long
+		MAX_INVARIANT_CHECK_PERIOD_NSECS= 1000000000ULL;
+
+//  PURPOSE:  To tell how many violations an InvariantChecker describes in
+//	full; later ones are only counted.
+const	uint	MAX_NUM_INVARIANT_REPORTS	= 8;
+
+//  PURPOSE:  To tell the fraction of its capacity bound above which a
+//	CapacityAnalyzer takes a simulation to be held back by the topology
+//	or fleet rather than by the scheduler.
+const	double	CAPACITY_REACHED_FRACTION	= 0.9;
+
+//  PURPOSE:  To tell the length, in meters, and the speed limit, in meters
+//	per second, of a Track whose topology gives it no profile.
+const	double	DEFAULT_TRACK_LENGTH_METERS	= 1000.0;
+const	double	DEFAULT_TRACK_MAX_SPEED_MPS	= 20.0;
+
+//  PURPOSE:  To tell, for a KinematicSimulator, how long a Train is, how
+//	far behind the one ahead it must stop, and how hard it accelerates
+//	and brakes, in meters and meters per second per second.
+const	double	KINEMATIC_TRAIN_LENGTH_METERS	= 120.0;
+const	double	KINEMATIC_STANDSTILL_GAP_METERS	= 30.0;
+const	double	KINEMATIC_ACCEL_MPS2		= 1.0;
+const	double	KINEMATIC_BRAKE_MPS2		= 1.0;
+
+//  PURPOSE:  To tell how close to the end of a Track a Train of a
+//	KinematicSimulator must be to have arrived at the next Station, in
+//	meters.
+const	double	KINEMATIC_ARRIVAL_METERS	= 0.01;
+
+//  PURPOSE:  To tell the default virtual time between updates of a
+//	KinematicSimulator, in milliseconds.
+const	uint	DEFAULT_KINEMATIC_TICK_MSECS	= 100;
+
+//  PURPOSE:  To tell, for a Timetable, how long a Train dwells at a
+//	Station on top of its random pause, how late it may leave and still
+//	be on time, the step in which turns and shifts are searched, in
+//	microseconds, the longest headway to try and the longest the
+//	timetable may take to repeat, in seconds.
+const	uint	TIMETABLE_DWELL_USECS		= 20000000;
+const	uint	TIMETABLE_ON_TIME_USECS		= 60000000;
+const	uint	TIMETABLE_STEP_USECS		= 5000000;
+const	uint	TIMETABLE_MAX_HEADWAY_SECS	= 3600;
+const	uint	TIMETABLE_MAX_PERIOD_SECS	= 4 * 3600;
+
+//  PURPOSE:  To tell the first bytes of a checkpoint image, and the
+//	version of its layout.
+const	char	CHECKPOINT_MAGIC[8]		= "massTck";
+const	uint	CHECKPOINT_VERSION		= 2;
+
+//  PURPOSE:  To tell how many express Train instances in a row a Track
+//	admits ahead of a waiting local one before the local one gets the
+//	next room, so that neither class starves.
+const	uint	MAX_EXPRESS_PASSES		= 3;
+
+//  PURPOSE:  To tell the name of each class of service.
+const	char* const
+		TRAIN_CLASS_NAME_ARRAY[NUM_TRAIN_CLASSES]
+						= { "local", "express" };
+
+//  PURPOSE:  To tell the length of a cache line, in bytes.  Every
+//	TrainLocation and Train starts on one and fills whole ones, so that
+//	no two, nor the lock of one and the fields of its neighbour, share
+//	one.
+const	size_t	CACHE_LINE_BYTES		= 64;
+
+//  PURPOSE:  To tell the number of microseconds in a second.
+const	uint	USECS_PER_SEC			= 1000000;
+
+//  PURPOSE:  To tell the number of nanoseconds in a second.
+const	uint	NSECS_PER_SEC			= 1000000000;
 
 
 /*---			Common macros and templated fncs:		---*/
@@ -85,6 +231,37 @@ inline
 void	safeDelete	(T*& ptr)	{ delete(ptr); ptr = NULL; }
 
 
+//  PURPOSE:  To return room, starting on a cache line, for 'num' instances
+//	of 'T' to be built in place, or to throw 'std::bad_alloc' if there is
+//	none.  Release it with 'safeFree()'.
+template<class T>
+inline
+T*	allocCacheAligned	(size_t	num)
+{
+  void*	vPtr	= NULL;
+
+  if  (posix_memalign(&vPtr,CACHE_LINE_BYTES,std::max(num,(size_t)1) * sizeof(T))
+       != 0
+      )
+    throw std::bad_alloc();
+
+  return((T*)vPtr);
+}
+
+
+//  PURPOSE:  To return the time on the monotonic clock in nanoseconds.  No
+//	parameters.
+inline
+unsigned long long
+	getMonotonicNsecs	()
+{
+  struct timespec	now;
+
+  clock_gettime(CLOCK_MONOTONIC,&now);
+  return( (unsigned long long)now.tv_sec * NSECS_PER_SEC + now.tv_nsec );
+}
+
+
 
 /*---	Declaration of classes and fncs so compiler doesn't freak:	---*/
 
@@ -94,14 +271,64 @@ class	Track;
 
 class	MassTransit;
 
+class	EventSimulator;
+
+class	Renderer;
+
+class	Partition;
+
+class	ParallelSimulator;
+
+class	BatchRunner;
+
+class	Snapshot;
+
+class	InvariantChecker;
+
+class	CapacityAnalyzer;
+
+class	ActorScheduler;
+
+class	KinematicSimulator;
+
+class	Timetable;
+
+class	Checkpoint;
+
+class	PerfCounter;
+
 void*	simulateTrain	(void*	vPtr);
 
+void	writeQuoted	(FILE*		filePtr,
+			 const char*	cPtr,
+			 bool		isJson
+			);
+
 
 
 /*---		Inclusion of header files unique to this program:	---*/
 
+#include	"TopologyFile.h"
+#include	"PerfCounter.h"
+#include	"TrainRing.h"
+#include	"WaitHistogram.h"
+#include	"RandomStream.h"
+#include	"EventLog.h"
+#include	"TraceLog.h"
 #include	"TrainLocation.h"
 #include	"Station.h"
 #include	"Track.h"
 #include	"Train.h"
+#include	"Snapshot.h"
 #include	"MassTransit.h"
+#include	"Renderer.h"
+#include	"InvariantChecker.h"
+#include	"Timetable.h"
+#include	"Checkpoint.h"
+#include	"EventSimulator.h"
+#include	"Partition.h"
+#include	"ParallelSimulator.h"
+#include	"BatchRunner.h"
+#include	"CapacityAnalyzer.h"
+#include	"ActorScheduler.h"
+#include	"KinematicSimulator.h"
@@ -20,10 +20,151 @@ g++ -c MassTransit.cpp
 g++ -c TrainLocation.cpp
 g++ -c Station.cpp
 g++ -c Track.cpp
-g++ -o massTransit main.o MassTransit.o TrainLocation.o Station.o Track.o -lpthread -lncurses
+g++ -c Train.cpp
+g++ -c EventSimulator.cpp
+g++ -c TopologyFile.cpp
+g++ -c EventLog.cpp
+g++ -c Renderer.cpp
+g++ -c Partition.cpp
+g++ -c ParallelSimulator.cpp
+g++ -c BatchRunner.cpp
+g++ -c Snapshot.cpp
+g++ -c InvariantChecker.cpp
+g++ -c TraceLog.cpp
+g++ -c CapacityAnalyzer.cpp
+g++ -c ActorScheduler.cpp
+g++ -c Timetable.cpp
+g++ -c Checkpoint.cpp
+g++ -c PerfCounter.cpp
+g++ -O3 -fno-math-errno -fno-trapping-math -c KinematicSimulator.cpp
+g++ -o massTransit main.o MassTransit.o TrainLocation.o Station.o Track.o Train.o EventSimulator.o TopologyFile.o Renderer.o EventLog.o Partition.o ParallelSimulator.o BatchRunner.o Snapshot.o InvariantChecker.o TraceLog.o CapacityAnalyzer.o ActorScheduler.o KinematicSimulator.o Timetable.o Checkpoint.o PerfCounter.o -lpthread -lncurses
  *
+ *	Run with:
+massTransit [-e|-b|-H|-R eventLog|-w numWorkers|-M numScenarios] [-F]
+	    [-a numActorWorkers] [-k tickMsecs] [-B numBlocks]
+	    [-X expressPercent]
+	    [-S] [-C checkpointFile] [-I checkpointFile]
+	    [-A] [-V checkPercent] [-s numSecs]
+	    [-f topologyFile] [-n numTrains] [-c trackCapacity]
+	    [-p maxPauseUsecs] [-t traversalUsecs] [-r framesPerSec]
+	    [-o statsFile] [-l eventLog] [-T traceFile] [seed]
+ *	where:
+ *	  -e	runs in virtual time with an EventSimulator instead of one
+ *		pthread per Train,
+ *	  -b	benchmarks the threaded simulation without ncurses for fleets
+ *		of 16 to 100000 Train instances, 'numSecs' (default 2) each,
+ *		with how long each fleet takes to stop, and L1 data and
+ *		last-level cache misses per move where the kernel allows perf
+ *		events,
+ *	  -H	runs the threaded simulation headless: no ncurses, only
+ *		summary statistics at the end,
+ *	  -R	replays at full speed, and checks, the run logged to
+ *		'eventLog' by -l, which must be given the same topologyFile,
+ *	  -w	runs in virtual time on 'numWorkers' pthreads, each
+ *		simulating one part of the network, with every move taking
+ *		'traversalUsecs' (default 100000); the result does not depend
+ *		on 'numWorkers',
+ *	  -M	runs 'numScenarios' scenarios in virtual time, with seeds
+ *		'seed' on, on 'numWorkers' pthreads (default: one per CPU)
+ *		and without ncurses, then prints 95% confidence intervals of
+ *		throughput, track utilization and per-line delay, and
+ *		writes each scenario to 'statsFile' as CSV if given; 'numSecs'
+ *		defaults to 3600,
+ *	  -a	runs the threaded simulation headless with every Train an
+ *		actor stepped by 'numActorWorkers' pthreads (0: one per
+ *		CPU) instead of a pthread of its own; with -b, benchmarks
+ *		that way,
+ *	  -k	runs in virtual time with Train instances that accelerate,
+ *		cruise and brake along each Track, whose profile in the
+ *		topology gives its length and speed limit, updated every
+ *		'tickMsecs' (at least 1) virtual milliseconds, with each Train
+ *		kept a safe-braking distance behind the one ahead instead of
+ *		'trackCapacity' per Track,
+ *	  -F	makes each Track admit waiting Train instances in the order
+ *		they asked for it instead of in whatever order they wake,
+ *	  -X	runs 'expressPercent' percent of the Train instances, spread
+ *		evenly over their ids, as express: a Track lets waiting
+ *		express Train instances on ahead of local ones, though no
+ *		more than 3 in a row while a local one waits, and an express
+ *		Train may leave a Station ahead of those that got there
+ *		first; prints how often each class moved and how long it
+ *		waited and, with -e, its time per move against the same
+ *		fleet admitted first come, first served; not with -b, -M, -R
+ *		or -k,
+ *	  -B	splits each Track into 'numBlocks' blocks, in place of
+ *		'trackCapacity': it holds one Train per block, all heading
+ *		the same way, so several may follow each other through it
+ *		but none may enter against them; with -e, also runs the
+ *		same fleet with one Train per Track and prints the gain in
+ *		moves of each line,
+ *	  -S	runs in virtual time with an EventSimulator by a timetable:
+ *		first finds the shortest headway on each line at which no
+ *		Train need ever wait for another, then starts each Train
+ *		where its trip is due, has it dwell at each Station for 20
+ *		secs plus its pause but not leave before its trip is due,
+ *		and run over each Track at its speed limit; prints the
+ *		timetable, and how punctual each line was and how lateness
+ *		spread; 'numSecs' defaults to 86400,
+ *	  -C	with -e, writes the state of the run at its end, where each
+ *		Train is, which way it heads, how many random numbers it
+ *		drew and what it waits for, and every pending event, to
+ *		'checkpointFile' as a binary image,
+ *	  -I	with -e, maps the image in 'checkpointFile' and resumes the
+ *		run it holds for 'numSecs' more seconds, with its fleet and
+ *		Track instances (so -n, -c, -F, -B and -X are ignored) and,
+ *		unless given, its 'maxPauseUsecs' and 'seed'; the same
+ *		'seed' continues the run exactly, another branches it; the
+ *		topologyFile must be the same,
+ *	  -A	after -e or the threaded simulation, prints how many trains
+ *		per hour each line could carry each way given the topology,
+ *		track capacity, fleet and mean pause (by max-flow and by
+ *		sharing each Track among its lines), how many it carried,
+ *		and whether the topology or the scheduler holds it back,
+ *	  -V	checks, while the threaded simulation runs, that no Track
+ *		holds too many trains and that every Train is at exactly one
+ *		place, using at most 'checkPercent' of one CPU, and reports
+ *		each violation with the recent moves that led to it,
+ *	and 'numSecs' (default 60) is how long to simulate, 'topologyFile'
+ *	(default: the built-in one, also in cta.topology) describes the
+ *	Station instances, Track instances and lines, 'numTrains' (default
+ *	16) is the fleet size, 'trackCapacity' (default 1) is how many
+ *	trains each Track holds, 'maxPauseUsecs' (default 10000000, or
+ *	1000 with -b) is the longest a Train pauses between moves,
+ *	'framesPerSec' (default 10) is how often the screen is redrawn, and
+ *	'statsFile' (default: none) receives the occupancy, waits and lock
+ *	hold times of each Station and Track, as JSON if it ends in ".json"
+ *	or else as CSV, 'eventLog' (default: none) receives every arrival and
+ *	departure for -R to replay, 'traceFile' (default: none) receives,
+ *	as Chrome trace-event JSON for chrome://tracing or
+ *	ui.perfetto.dev, when each Train stayed, paused and waited where
+ *	and how many Train instances each place held over time, and 'seed'
+ *	(default 1) decides where each Train starts and how long it pauses.
  */
 
+
+//  PURPOSE:  To tell the default number of seconds to simulate.
+const	uint	DEFAULT_NUM_SECS		= 60;
+
+//  PURPOSE:  To tell the default number of seconds to run each fleet size
+//	when benchmarking.
+const	uint	DEFAULT_BENCHMARK_NUM_SECS	= 2;
+
+//  PURPOSE:  To tell the default longest pause of a Train when
+//	benchmarking, in microseconds.
+const	uint	DEFAULT_BENCHMARK_MAX_PAUSE_USECS
+						= 1000;
+
+//  PURPOSE:  To tell the default number of virtual seconds that each
+//	scenario of a batch runs.
+const	uint	DEFAULT_BATCH_NUM_SECS		= 3600;
+
+//  PURPOSE:  To tell the default number of virtual seconds to run by a
+//	timetable.
+const	uint	DEFAULT_TIMETABLE_NUM_SECS	= 86400;
+
+//  PURPOSE:  To tell the largest fleet size to benchmark.
+const	uint	MAX_BENCHMARK_NUM_TRAINS	= 100000;
+
 //  PURPOSE:  To be the function that a pthread instance runs to simulate
 //	the train '*(Train*)vPtr'.  Return 'vPtr'.
 void*	simulateTrain	(void*	vPtr)
@@ -39,24 +180,43 @@ void*	simulateTrain	(void*	vPtr)
   //  II.B.  Continue to simulate until MassTransit system signals to stop:
   while  ( trainPtr->getMassTransit().getShouldContinue() )
   {
-    //  II.B.1.  Pause:
-    usleep((rand() % 1000) * 10000);
+    //  II.B.1.  Pause, unless told to stop meanwhile:
+    MassTransit&	massTransit	= trainPtr->getMassTransit();
+    unsigned long long	pauseNsecs	= getMonotonicNsecs();
+    bool		shouldContinue
+			= massTransit.pauseUnlessStopped
+				(massTransit.getRandomPauseUsecs(*trainPtr));
+
+    if  ( massTransit.getIsTracing() )
+      massTransit.traceEvent(trainPtr,
+			     TRACE_PAUSE,
+			     trainPtr->getLocPtr()->getIndex(),
+			     pauseNsecs,
+			     getMonotonicNsecs(),
+			     0
+			    );
 
     //  II.B.2.  Quit if shouldn't continue:
-    if  ( !trainPtr->getMassTransit().getShouldContinue() )
+    if  ( !shouldContinue )
       break;
 
-    //  II.B.3.  Attempt to leave current location to arrive at next:
-    if  ( trainPtr->getLocPtr()->canLeave(trainPtr) )
-    {
-      TrainLocation*	currentPtr	= trainPtr->getLocPtr();
-      TrainLocation*	nextPtr		= currentPtr->nextLocPtr(trainPtr);
+    //  II.B.3.  Wait until allowed to leave current location, rather than
+    //		 pausing and asking again:
+    TrainLocation*	currentPtr	= trainPtr->getLocPtr();
 
-      currentPtr->leave(trainPtr);
-      nextPtr->arrive(trainPtr);
-      trainPtr->getMassTransit().update();
-    }
+    if  ( !currentPtr->waitUntilCanLeave(trainPtr) )
+      break;
+
+    //  II.B.4.  Hold room at next location before leaving current one, so
+    //		 that '*trainPtr' is always somewhere, then move:
+    TrainLocation*	nextPtr		= currentPtr->nextLocPtr(trainPtr);
 
+    if  ( !nextPtr->reserve(trainPtr) )
+      break;
+
+    currentPtr->leave(trainPtr);
+    nextPtr->occupy(trainPtr);
+    trainPtr->noteMove();
   }
 
   if  (trainPtr->getLocPtr() != NULL)
@@ -67,29 +227,982 @@ void*	simulateTrain	(void*	vPtr)
 }
 
 
-//  PURPOSE:  To run the Mass Transit simulator with random number 'argv[1]'
-//	assuming 'argc'.  Returns 'EXIT_SUCCESS' to OS.
+//  PURPOSE:  To set 'value' to the whole number written in 'text', and to
+//	return 'true', if all of 'text' is one from 'minValue' to
+//	'maxValue', or else to return 'false'.
+static
+bool	parseUint	(const char*	text,
+			 uint		minValue,
+			 uint		maxValue,
+			 uint&		value
+			)
+{
+  //  I.  Application validity check:
+  //  'strtoull()' would skip spaces and negate after a '-':
+  if  ( !isdigit((unsigned char)text[0]) )
+    return(false);
+
+  //  II.  Parse 'text':
+  char*			endPtr;
+  unsigned long long	number;
+
+  errno		= 0;
+  number	= strtoull(text,&endPtr,0);
+
+  if  ( (errno != 0)  ||  (*endPtr != '\0')  ||
+	(number < minValue)  ||  (number > maxValue)
+      )
+    return(false);
+
+  //  III.  Finished:
+  value	= (uint)number;
+  return(true);
+}
+
+
+//  PURPOSE:  To set 'value' to the number written in 'text', and to return
+//	'true', if all of 'text' is one above 'minValue' and at most
+//	'maxValue', or else to return 'false'.
+static
+bool	parseDouble	(const char*	text,
+			 double		minValue,
+			 double		maxValue,
+			 double&	value
+			)
+{
+  //  I.  Application validity check:
+
+  //  II.  Parse 'text':
+  char*		endPtr;
+  double	number;
+
+  errno		= 0;
+  number	= strtod(text,&endPtr);
+
+  if  ( (errno != 0)  ||  (endPtr == text)  ||  (*endPtr != '\0')  ||
+	!(number > minValue)  ||  !(number <= maxValue)
+      )
+    return(false);
+
+  //  III.  Finished:
+  value	= number;
+  return(true);
+}
+
+
+//  PURPOSE:  To print how to run the program named 'progNameCPtr' to
+//	'stderr'.  No return value.
+static
+void	printUsage	(const char*	progNameCPtr
+			)
+{
+  fprintf(stderr,
+	  "Usage:\t%s [-e|-b|-H|-R eventLog|-w numWorkers|-M numScenarios]"
+	  "\n\t\t[-a numActorWorkers] [-k tickMsecs] [-F] [-B numBlocks]"
+	  "\n\t\t[-X expressPercent]"
+	  "\n\t\t[-S] [-C checkpointFile] [-I checkpointFile]"
+	  "\n\t\t[-A] [-V checkPercent] [-s numSecs] [-f topologyFile]"
+	  "\n\t\t[-n numTrains] [-c trackCapacity] [-p maxPauseUsecs]"
+	  "\n\t\t[-t traversalUsecs] [-r framesPerSec]"
+	  "\n\t\t[-o statsFile] [-l eventLog] [-T traceFile] [seed]\n",
+	  progNameCPtr
+	 );
+}
+
+
+//  PURPOSE:  To return the seconds of CPU time used by this process so far.
+//	No parameters.
+static
+double	getCpuSecs	()
+{
+  struct rusage	usage;
+
+  getrusage(RUSAGE_SELF,&usage);
+  return( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+	  (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6
+	);
+}
+
+
+//  PURPOSE:  To run the threaded simulation of 'topology' without ncurses
+//	for 'numSecs' seconds for each fleet size from 16 to
+//	'MAX_BENCHMARK_NUM_TRAINS', with 'trackCapacity' trains allowed per
+//	Track (admitted in arrival order if 'isFairAdmission', and heading one
+//	way at a time if 'isBlockSignalled'), pauses of up to 'maxPauseUsecs'
+//	and random number streams derived from 'seed', and
+//	to print a table of moves per second, lock wait time, CPU use, how
+//	long the fleet took to stop and, where the kernel allows counting
+//	them, L1 data cache and last-level cache misses per move.
+//	Each Train runs on a pthread of its own if 'numActorWorkers' is 0, or
+//	else as an actor on 'numActorWorkers' worker pthreads.  No return
+//	value.
+static
+void	runBenchmark	(const TopologyFile&	topology,
+			 uint			trackCapacity,
+			 bool			isFairAdmission,
+			 bool			isBlockSignalled,
+			 uint			maxPauseUsecs,
+			 uint			numSecs,
+			 uint			seed,
+			 uint			numActorWorkers
+			)
+{
+  //  I.  Application validity check:
+
+  //  II.  Run each fleet size:
+  //  II.A.  Open the cache miss counts, before any fleet pthread starts so
+  //	that each one's misses are added as it exits:
+  PerfCounter	l1dMissCounter(PERF_TYPE_HW_CACHE,
+			       PERF_COUNT_HW_CACHE_L1D
+			       | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+			       | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+			      );
+  PerfCounter	llcMissCounter(PERF_TYPE_HARDWARE,PERF_COUNT_HW_CACHE_MISSES);
+
+  if  ( !l1dMissCounter.isOpen()  ||  !llcMissCounter.isOpen() )
+    printf("(Cache misses are not counted: perf events are not allowed"
+	   " here)\n"
+	  );
+
+  printf("%9s %12s %14s %12s %8s %10s %12s %12s\n",
+	 "trains","moves/sec","lockWait/move","lockWait%","CPU%","stop",
+	 "L1Dmiss/move","LLCmiss/move"
+	);
+  printf("%9s %12s %14s %12s %8s %10s %12s %12s\n",
+	 "","","(usecs)","(of trains)","","(msecs)","",""
+	);
+
+  for  (uint numTrains = 16;  ;  numTrains *= 4)
+  {
+    if  (numTrains > MAX_BENCHMARK_NUM_TRAINS)
+      numTrains	= MAX_BENCHMARK_NUM_TRAINS;
+
+    //  II.B.  Start the fleet:
+    unsigned long long	startL1dMisses	= l1dMissCounter.read();
+    unsigned long long	startLlcMisses	= llcMissCounter.read();
+    MassTransit*	ctaPtr	= new MassTransit(topology,
+						  numTrains,
+						  trackCapacity,
+						  maxPauseUsecs,
+						  isFairAdmission,
+						  isBlockSignalled,
+						  seed
+						 );
+
+    ActorScheduler*	schedulerPtr	= NULL;
+
+    try
+    {
+      if  (numActorWorkers > 0)
+      {
+	schedulerPtr	= new ActorScheduler(*ctaPtr,numActorWorkers);
+	schedulerPtr->start();
+      }
+      else
+	ctaPtr->startTrains();
+    }
+    catch  (const char* cPtr)
+    {
+      printf("%9u %s\n",numTrains,cPtr);
+      safeDelete(schedulerPtr);
+      safeDelete(ctaPtr);
+      break;
+    }
+
+    //  II.C.  Measure it once all of its pthreads run:
+    unsigned long long	startMoves	= ctaPtr->getNumMoves();
+    unsigned long long	startWaitNsecs	= ctaPtr->getLockWaitNsecs();
+    unsigned long long	startNsecs	= getMonotonicNsecs();
+    double		startCpuSecs	= getCpuSecs();
+
+    sleep(numSecs);
+
+    double		wallSecs	= (double)(getMonotonicNsecs() - startNsecs)
+					  / NSECS_PER_SEC;
+    double		cpuSecs		= getCpuSecs() - startCpuSecs;
+    double		numMoves	= ctaPtr->getNumMoves() - startMoves;
+    double		waitSecs	= (double)(ctaPtr->getLockWaitNsecs()
+						   - startWaitNsecs
+						  )
+					  / NSECS_PER_SEC;
+
+    //  II.D.  Time how long every pthread of it takes to stop:
+    unsigned long long	stopNsecs	= getMonotonicNsecs();
+
+    if  (schedulerPtr != NULL)
+      schedulerPtr->stop();
+    else
+    {
+      ctaPtr->stopTrains();
+      ctaPtr->joinTrains();
+    }
+
+    double		stopSecs	= (double)(getMonotonicNsecs() - stopNsecs)
+					  / NSECS_PER_SEC;
+
+    //  II.E.  Count the cache misses of the whole run, building and
+    //	tearing down included, once every pthread of it has exited:
+    double		totalMoves	= ctaPtr->getNumMoves();
+
+    safeDelete(schedulerPtr);
+    safeDelete(ctaPtr);
+
+    double		l1dMisses	= l1dMissCounter.read() - startL1dMisses;
+    double		llcMisses	= llcMissCounter.read() - startLlcMisses;
+    char		l1dText[MAX_STRING_LEN]	= "-";
+    char		llcText[MAX_STRING_LEN]	= "-";
+
+    if  (l1dMissCounter.isOpen()  &&  (totalMoves > 0))
+      snprintf(l1dText,MAX_STRING_LEN,"%.1f",l1dMisses / totalMoves);
+
+    if  (llcMissCounter.isOpen()  &&  (totalMoves > 0))
+      snprintf(llcText,MAX_STRING_LEN,"%.1f",llcMisses / totalMoves);
+
+    printf("%9u %12.0f %14.2f %12.1f %8.0f %10.1f %12s %12s\n",
+	   numTrains,
+	   numMoves / wallSecs,
+	   (numMoves > 0) ? (waitSecs * 1e6 / numMoves) : 0.0,
+	   100.0 * waitSecs / (wallSecs * numTrains),
+	   100.0 * cpuSecs / wallSecs,
+	   stopSecs * 1e3,
+	   l1dText,
+	   llcText
+	  );
+    fflush(stdout);
+
+    if  (numTrains == MAX_BENCHMARK_NUM_TRAINS)
+      break;
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To print the capacity of 'cta' next to the throughput of its
+//	last run of 'secs' seconds, by '*simulatorPtr' in virtual time or, if
+//	it is 'NULL', by one pthread per Train.  No return value.
+static
+void	printCapacity	(const MassTransit&	cta,
+			 const EventSimulator*	simulatorPtr,
+			 double			secs
+			)
+{
+  //  I.  Application validity check:
+
+  //  II.  Compare:
+  CapacityAnalyzer			analyzer(cta);
+  std::vector<unsigned long long>	lineNumMovesVector(cta.getNumLines());
+
+  for  (line_t line = 0;  line < cta.getNumLines();  line++)
+    lineNumMovesVector[line]	= (simulatorPtr != NULL)
+				  ? simulatorPtr->getLineNumMoves(line)
+				  : cta.getLineNumMoves(line);
+
+  analyzer.printComparison(stdout,lineNumMovesVector,secs);
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To run the fleet of 'cta' on 'topology' for 'numSecs' virtual
+//	seconds with one Train per Track whichever way it heads, and to print
+//	how many more moves each line made with the blocks of 'cta', as
+//	'simulator' ran it.  No return value.
+static
+void	printBlockGain	(const TopologyFile&	topology,
+			 const MassTransit&	cta,
+			 const EventSimulator&	simulator,
+			 uint			numSecs
+			)
+{
+  //  I.  Application validity check:
+
+  //  II.  Compare:
+  //  II.A.  Run the single-occupancy baseline:
+  MassTransit		baselineCta(topology,
+				    cta.getNumTrains(),
+				    1,
+				    cta.getMaxPauseUsecs(),
+				    cta.getIsFairAdmission(),
+				    false,
+				    cta.getSeed()
+				   );
+  EventSimulator	baseline(baselineCta);
+
+  baseline.run(numSecs);
+
+  //  II.B.  Print the moves of each line, and of all, with both:
+  printf("Block signalling, %u blocks per track, vs one train per track:\n",
+	 cta.getTrackCapacity()
+	);
+  printf("  %-8s %12s %12s %8s\n","line","blocks","single","gain");
+
+  for  (line_t line = 0;  line <= cta.getNumLines();  line++)
+  {
+    bool		isTotal		= (line == cta.getNumLines());
+    double		numMoves	= isTotal
+					  ? simulator.getNumMoves()
+					  : simulator.getLineNumMoves(line);
+    double		numBaselineMoves= isTotal
+					  ? baseline.getNumMoves()
+					  : baseline.getLineNumMoves(line);
+
+    printf("  %-8s %12.0f %12.0f %+7.1f%%\n",
+	   isTotal ? "all" : cta.getLineNameCPtr(line),
+	   numMoves,
+	   numBaselineMoves,
+	   (numBaselineMoves > 0.0)
+	   ? (100.0 * (numMoves - numBaselineMoves) / numBaselineMoves)
+	   : 0.0
+	  );
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To run the fleet of 'cta' on 'topology' for 'numSecs' virtual
+//	seconds with every Train local, so that each Track admits them first
+//	come, first served and each Station lets them leave in turn, and to
+//	print how long a move took the Train instances of each class of
+//	'cta', and how long they waited, as 'simulator' ran it and in that
+//	baseline.  No return value.
+static
+void	printExpressGain(const TopologyFile&	topology,
+			 const MassTransit&	cta,
+			 const EventSimulator&	simulator,
+			 uint			numSecs
+			)
+{
+  //  I.  Application validity check:
+
+  //  II.  Compare:
+  //  II.A.  Run the first-come, first-served baseline:
+  MassTransit		baselineCta(topology,
+				    cta.getNumTrains(),
+				    cta.getTrackCapacity(),
+				    cta.getMaxPauseUsecs(),
+				    cta.getIsFairAdmission(),
+				    cta.getIsBlockSignalled(),
+				    cta.getSeed()
+				   );
+  EventSimulator	baseline(baselineCta);
+
+  baseline.run(numSecs);
+
+  //  II.B.  Print, for each class, the mean time a move took its Train
+  //	     instances, waits and pauses included, and the mean wait:
+  printf("Express priority, %u%% of trains, vs first come, first served:\n",
+	 cta.getExpressPercent()
+	);
+  printf("  %-8s %8s %10s %10s %8s %10s %10s\n",
+	 "class","trains","secs/move","baseline","change","wait/move","baseline"
+	);
+
+  for  (uint trainClass = 0;  trainClass < NUM_TRAIN_CLASSES;  trainClass++)
+  {
+    uint		numClassTrains	= 0;
+    double		numMoves	= 0.0;
+    double		numBaselineMoves= 0.0;
+    double		delaySecs	= 0.0;
+    double		baselineDelaySecs= 0.0;
+
+    for  (uint i = 0;  i < cta.getNumTrains();  i++)
+      if  (cta.getTrainPtr(i)->getTrainClass() == (trainClass_t)trainClass)
+      {
+	numClassTrains++;
+	numMoves		+= simulator.getTrainNumMoves(i);
+	numBaselineMoves	+= baseline.getTrainNumMoves(i);
+	delaySecs		+= (double)simulator.getTrainDelayUsecs(i)
+				   / USECS_PER_SEC;
+	baselineDelaySecs	+= (double)baseline.getTrainDelayUsecs(i)
+				   / USECS_PER_SEC;
+      }
+
+    double	secsPerMove	= (numMoves > 0.0)
+				  ? (numClassTrains * (double)numSecs / numMoves)
+				  : 0.0;
+    double	baselineSecsPerMove
+				= (numBaselineMoves > 0.0)
+				  ? (numClassTrains * (double)numSecs
+				     / numBaselineMoves
+				    )
+				  : 0.0;
+
+    printf("  %-8s %8u %10.1f %10.1f %+7.1f%% %10.1f %10.1f\n",
+	   TRAIN_CLASS_NAME_ARRAY[trainClass],
+	   numClassTrains,
+	   secsPerMove,
+	   baselineSecsPerMove,
+	   (baselineSecsPerMove > 0.0)
+	   ? (100.0 * (secsPerMove - baselineSecsPerMove) / baselineSecsPerMove)
+	   : 0.0,
+	   (numMoves > 0.0) ? (delaySecs / numMoves) : 0.0,
+	   (numBaselineMoves > 0.0) ? (baselineDelaySecs / numBaselineMoves)
+				    : 0.0
+	  );
+  }
+
+  //  III.  Finished:
+}
+
+
+//  PURPOSE:  To run the Mass Transit simulator with the options and random
+//	number seed given in 'argv[]', assuming 'argc'.  Returns
+//	'EXIT_SUCCESS' to OS on success or 'EXIT_FAILURE' otherwise.
 int	main	(int		argc,
-		 const char*	argv[]
+		 char*		argv[]
 		)
 {
   //  I.  Application validity check:
+  bool		shouldUseEvents	= false;
+  bool		shouldBenchmark	= false;
+  uint		numSecs		= 0;
+  const char*	topologyPathCPtr= NULL;
+  const char*	statsPathCPtr	= NULL;
+  const char*	eventLogPathCPtr= NULL;
+  const char*	replayPathCPtr	= NULL;
+  const char*	tracePathCPtr	= NULL;
+  const char*	checkpointPathCPtr	= NULL;
+  const char*	restorePathCPtr	= NULL;
+  uint		numTrains	= DEFAULT_NUM_TRAINS;
+  uint		trackCapacity	= DEFAULT_TRACK_CAPACITY;
+  bool		isFairAdmission	= false;
+  bool		isBlockSignalled= false;
+  uint		expressPercent	= 0;
+  bool		shouldAnalyze	= false;
+  bool		shouldUseTimetable	= false;
+  bool		shouldUseActors	= false;
+  uint		numActorWorkers	= 0;
+  bool		shouldUseKinematics	= false;
+  uint		kinematicTickMsecs	= DEFAULT_KINEMATIC_TICK_MSECS;
+  uint		maxPauseUsecs	= 0;
+  uint		framesPerSec	= DEFAULT_FRAMES_PER_SEC;
+  uint		numWorkers	= 0;
+  uint		traversalUsecs	= DEFAULT_TRAVERSAL_USECS;
+  uint		numScenarios	= 0;
+  double	checkPercent	= 0.0;
+  int		option;
+  bool		isValid;
+
+  while  ( (option = getopt(argc,argv,"ebHFASs:f:n:c:p:r:o:l:R:w:t:M:V:T:a:k:B:C:I:X:")) != -1 )
+  {
+    isValid	= true;
+
+    switch  (option)
+    {
+    case 'e' :
+      shouldUseEvents	= true;
+      break;
+
+    case 'b' :
+      shouldBenchmark	= true;
+      break;
+
+    case 'H' :
+      framesPerSec	= 0;
+      break;
+
+    case 'F' :
+      isFairAdmission	= true;
+      break;
+
+    case 'B' :
+      isBlockSignalled	= true;
+      isValid		= parseUint(optarg,1,UINT_MAX,trackCapacity);
+      break;
+
+    case 'A' :
+      shouldAnalyze	= true;
+      break;
+
+    case 'S' :
+      shouldUseTimetable	= true;
+      break;
+
+    case 'C' :
+      shouldUseEvents	= true;
+      checkpointPathCPtr	= optarg;
+      break;
+
+    case 'I' :
+      shouldUseEvents	= true;
+      restorePathCPtr	= optarg;
+      break;
+
+    case 'X' :
+      isValid		= parseUint(optarg,0,100,expressPercent);
+      break;
+
+    case 'a' :
+      shouldUseActors	= true;
+      isValid		= parseUint(optarg,0,UINT_MAX,numActorWorkers);
+      break;
+
+    case 'k' :
+      shouldUseKinematics	= true;
+      isValid		= parseUint(optarg,1,UINT_MAX,kinematicTickMsecs);
+      break;
+
+    case 'r' :
+      isValid		= parseUint(optarg,0,UINT_MAX,framesPerSec);
+      break;
+
+    case 's' :
+      isValid		= parseUint(optarg,1,UINT_MAX,numSecs);
+      break;
+
+    case 'n' :
+      isValid		= parseUint(optarg,1,UINT_MAX,numTrains);
+      break;
+
+    case 'c' :
+      isValid		= parseUint(optarg,1,UINT_MAX,trackCapacity);
+      break;
+
+    case 'p' :
+      isValid		= parseUint(optarg,1,UINT_MAX,maxPauseUsecs);
+      break;
+
+    case 'f' :
+      topologyPathCPtr	= optarg;
+      break;
+
+    case 'o' :
+      statsPathCPtr	= optarg;
+      break;
+
+    case 'l' :
+      eventLogPathCPtr	= optarg;
+      break;
+
+    case 'R' :
+      replayPathCPtr	= optarg;
+      break;
+
+    case 'T' :
+      tracePathCPtr	= optarg;
+      break;
+
+    case 'w' :
+      isValid		= parseUint(optarg,1,UINT_MAX,numWorkers);
+      break;
+
+    case 't' :
+      isValid		= parseUint(optarg,1,UINT_MAX,traversalUsecs);
+      break;
+
+    case 'M' :
+      isValid		= parseUint(optarg,1,UINT_MAX,numScenarios);
+      break;
+
+    case 'V' :
+      isValid		= parseDouble(optarg,0.0,100.0,checkPercent);
+      break;
+
+    default :
+      printUsage(argv[0]);
+      return(EXIT_FAILURE);
+    }
+
+    if  ( !isValid )
+    {
+      fprintf(stderr,"Bad value for -%c: %s\n",option,optarg);
+      printUsage(argv[0]);
+      return(EXIT_FAILURE);
+    }
+  }
+
+  if  ( (expressPercent > 0)  &&
+	( shouldBenchmark  ||  (numScenarios > 0)  ||
+	  (replayPathCPtr != NULL)  ||  shouldUseKinematics
+	)
+      )
+  {
+    fprintf(stderr,"-X does not apply to -b, -M, -R or -k\n");
+    return(EXIT_FAILURE);
+  }
+
+  if  ( ( (checkpointPathCPtr != NULL)  ||  (restorePathCPtr != NULL) )  &&
+	( shouldUseTimetable  ||  shouldBenchmark  ||  (numScenarios > 0)  ||
+	  (replayPathCPtr != NULL)
+	)
+      )
+  {
+    fprintf(stderr,"-C and -I only apply to -e\n");
+    return(EXIT_FAILURE);
+  }
 
   //  II.  Do simulation:
-  //  II.A.  Reset random number generator if given seed on cmd line:
-  if  (argc > 1)
-    srand(atoi(argv[1]));
+  //  II.A.  Get the seed of the random number streams from cmd line:
+  uint		seed		= DEFAULT_SEED;
+
+  if  ( (optind < argc)  &&  !parseUint(argv[optind],0,UINT_MAX,seed) )
+  {
+    fprintf(stderr,"Bad seed: %s\n",argv[optind]);
+    printUsage(argv[0]);
+    return(EXIT_FAILURE);
+  }
 
   //  II.B.  Create MassTransit simulator:
-  MassTransit		cta;
+  TopologyFile*	topologyPtr;
+
+  try
+  {
+    topologyPtr	= new TopologyFile(topologyPathCPtr);
+  }
+  catch (const char* cPtr)
+  {
+    fprintf(stderr,"%s\n",cPtr);
+    return(EXIT_FAILURE);
+  }
+
+  if  (replayPathCPtr != NULL)
+  {
+    //  Replay a logged run on the MassTransit system it was logged from:
+    LogHeader	header;
+
+    try
+    {
+      EventLog::readHeader(replayPathCPtr,header);
+
+      if  ( (header.numStations != topologyPtr->getNumStations())  ||
+	    (header.numTracks   != topologyPtr->getNumTracks())
+	  )
+	throw "Event log was written for a different topology";
+
+      MassTransit	cta(*topologyPtr,
+			    header.numTrains,
+			    header.trackCapacity,
+			    DEFAULT_MAX_PAUSE_USECS,
+			    header.isFairAdmission,
+			    header.isBlockSignalled,
+			    header.seed
+			   );
+      EventLog		eventLog(cta);
+
+      safeDelete(topologyPtr);
+      eventLog.replay(replayPathCPtr);
+      eventLog.printSummary(stdout);
+    }
+    catch (const char* cPtr)
+    {
+      fprintf(stderr,"%s\n",cPtr);
+      safeDelete(topologyPtr);
+      return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+  }
 
-  //  II.C.  Turn on ncurses:
+  if  (shouldBenchmark)
+  {
+    long	numCpus	= sysconf(_SC_NPROCESSORS_ONLN);
+
+    runBenchmark(*topologyPtr,
+		 trackCapacity,
+		 isFairAdmission,
+		 isBlockSignalled,
+		 (maxPauseUsecs == 0) ? DEFAULT_BENCHMARK_MAX_PAUSE_USECS
+				      : maxPauseUsecs,
+		 (numSecs == 0) ? DEFAULT_BENCHMARK_NUM_SECS : numSecs,
+		 seed,
+		 !shouldUseActors	? 0
+		 : (numActorWorkers > 0) ? numActorWorkers
+		 : (numCpus > 0)	 ? (uint)numCpus : 1
+		);
+    safeDelete(topologyPtr);
+    return(EXIT_SUCCESS);
+  }
+
+  if  (numScenarios > 0)
+  {
+    //  Run a batch of scenarios, each on its own MassTransit system:
+    long	numCpus	= sysconf(_SC_NPROCESSORS_ONLN);
+    FILE*	filePtr	= NULL;
+
+    try
+    {
+      BatchRunner	runner(*topologyPtr,
+			       numScenarios,
+			       numTrains,
+			       trackCapacity,
+			       (maxPauseUsecs == 0) ? DEFAULT_MAX_PAUSE_USECS
+						    : maxPauseUsecs,
+			       isFairAdmission,
+			       isBlockSignalled,
+			       (numSecs == 0) ? DEFAULT_BATCH_NUM_SECS : numSecs,
+			       seed,
+			       (numWorkers > 0) ? numWorkers
+				: (numCpus > 0)  ? (uint)numCpus : 1
+			      );
+
+      runner.run();
+      runner.printSummary(stdout);
+
+      if  (statsPathCPtr != NULL)
+      {
+	if  ( (filePtr = fopen(statsPathCPtr,"w")) == NULL )
+	  throw "Cannot write stats file";
+
+	runner.writeResults(filePtr);
+	fclose(filePtr);
+      }
+    }
+    catch (const char* cPtr)
+    {
+      fprintf(stderr,"%s\n",cPtr);
+      safeDelete(topologyPtr);
+      return(EXIT_FAILURE);
+    }
+
+    safeDelete(topologyPtr);
+    return(EXIT_SUCCESS);
+  }
+
+  //  Resume a checkpointed run with its fleet and Track instances:
+  Checkpoint*	checkpointPtr	= NULL;
+
+  if  (restorePathCPtr != NULL)
+  {
+    try
+    {
+      checkpointPtr	= new Checkpoint(restorePathCPtr);
+
+      const CheckpointHeader&	header	= checkpointPtr->getHeader();
+
+      if  ( (header.numStations != topologyPtr->getNumStations())  ||
+	    (header.numTracks   != topologyPtr->getNumTracks())
+	  )
+	throw "Checkpoint was written for a different topology";
+
+      numTrains		= header.numTrains;
+      trackCapacity	= header.trackCapacity;
+      isFairAdmission	= (header.isFairAdmission != 0);
+      isBlockSignalled	= (header.isBlockSignalled != 0);
+      expressPercent	= header.expressPercent;
+
+      if  (maxPauseUsecs == 0)
+	maxPauseUsecs	= header.maxPauseUsecs;
+    }
+    catch (const char* cPtr)
+    {
+      fprintf(stderr,"%s\n",cPtr);
+      safeDelete(checkpointPtr);
+      safeDelete(topologyPtr);
+      return(EXIT_FAILURE);
+    }
+  }
+
+  MassTransit		cta(*topologyPtr,
+			    numTrains,
+			    trackCapacity,
+			    (maxPauseUsecs == 0) ? DEFAULT_MAX_PAUSE_USECS
+						 : maxPauseUsecs,
+			    isFairAdmission,
+			    isBlockSignalled,
+			    (checkpointPtr != NULL) ? checkpointPtr->getHeader().seed
+						    : seed
+			   );
+
+  cta.setExpressPercent(expressPercent);
+
+  if  (numSecs == 0)
+    numSecs	= shouldUseTimetable ? DEFAULT_TIMETABLE_NUM_SECS
+				     : DEFAULT_NUM_SECS;
+
+  //  II.C.  Do simulation in virtual time, on one or several pthreads, or
+  //	     with Train instances as actors, if requested:
+  if  (shouldUseTimetable)
+  {
+    try
+    {
+      Timetable		timetable(cta);
+      EventSimulator	simulator(cta);
+
+      timetable.print(stdout);
+      simulator.setTimetablePtr(&timetable);
+      simulator.run(numSecs);
+      simulator.printSummary(stdout);
+      simulator.printPunctuality(stdout);
+
+      if  (shouldAnalyze)
+	printCapacity(cta,&simulator,numSecs);
+    }
+    catch (const char* cPtr)
+    {
+      fprintf(stderr,"%s\n",cPtr);
+      safeDelete(topologyPtr);
+      return(EXIT_FAILURE);
+    }
+
+    safeDelete(topologyPtr);
+    return(EXIT_SUCCESS);
+  }
+
+  if  (shouldUseEvents)
+  {
+    try
+    {
+      EventSimulator	simulator(cta);
+      unsigned long long	startNsecs;
+
+      if  (checkpointPtr != NULL)
+      {
+	startNsecs	= getMonotonicNsecs();
+	simulator.restore(*checkpointPtr,
+			  (optind < argc) ? seed : checkpointPtr->getHeader().seed
+			 );
+	printf("Restored %s (%lu bytes) at %.0f virtual secs in %.3f msecs\n",
+	       restorePathCPtr,
+	       (unsigned long)checkpointPtr->getNumBytes(),
+	       (double)simulator.getNow() / USECS_PER_SEC,
+	       (double)(getMonotonicNsecs() - startNsecs) / 1000000.0
+	      );
+	safeDelete(checkpointPtr);
+      }
+
+      simulator.advance(numSecs);
+
+      if  (checkpointPathCPtr != NULL)
+      {
+	startNsecs	= getMonotonicNsecs();
+
+	size_t	numBytes	= simulator.writeCheckpoint(checkpointPathCPtr);
+
+	printf("Wrote %s (%lu bytes) at %.0f virtual secs in %.3f msecs\n",
+	       checkpointPathCPtr,
+	       (unsigned long)numBytes,
+	       (double)simulator.getNow() / USECS_PER_SEC,
+	       (double)(getMonotonicNsecs() - startNsecs) / 1000000.0
+	      );
+      }
+
+      simulator.finish();
+      simulator.printSummary(stdout);
+
+      //  A resumed run has no baseline that ran as long from the start:
+      if  (isBlockSignalled  &&  (restorePathCPtr == NULL))
+	printBlockGain(*topologyPtr,cta,simulator,numSecs);
+
+      if  ( (expressPercent > 0)  &&  (restorePathCPtr == NULL) )
+	printExpressGain(*topologyPtr,cta,simulator,numSecs);
+
+      if  (shouldAnalyze)
+	printCapacity(cta,&simulator,(double)simulator.getNow() / USECS_PER_SEC);
+    }
+    catch (const char* cPtr)
+    {
+      fprintf(stderr,"%s\n",cPtr);
+      safeDelete(checkpointPtr);
+      safeDelete(topologyPtr);
+      return(EXIT_FAILURE);
+    }
+
+    safeDelete(topologyPtr);
+    return(EXIT_SUCCESS);
+  }
+
+  safeDelete(topologyPtr);
+
+  if  (numWorkers > 0)
+  {
+    try
+    {
+      ParallelSimulator	simulator(cta,numWorkers,traversalUsecs);
+
+      simulator.run(numSecs);
+      simulator.printSummary(stdout);
+    }
+    catch (const char* cPtr)
+    {
+      fprintf(stderr,"%s\n",cPtr);
+      return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+  }
+
+  if  (shouldUseKinematics)
+  {
+    try
+    {
+      KinematicSimulator	simulator(cta,kinematicTickMsecs);
+
+      simulator.run(numSecs);
+      simulator.printSummary(stdout);
+    }
+    catch (const char* cPtr)
+    {
+      fprintf(stderr,"%s\n",cPtr);
+      return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+  }
+
+  //  Record and check the run as asked, with actors or pthreads:
+  cta.setStatsPath(statsPathCPtr);
+  cta.setEventLogPath(eventLogPathCPtr);
+  cta.setCheckCpuBudget(checkPercent / 100.0);
+  cta.setTracePath(tracePathCPtr);
+
+  if  (shouldUseActors)
+  {
+    long	numCpus	= sysconf(_SC_NPROCESSORS_ONLN);
+
+    try
+    {
+      ActorScheduler	scheduler(cta,
+				  (numActorWorkers > 0) ? numActorWorkers
+				   : (numCpus > 0)     ? (uint)numCpus : 1
+				 );
+
+      scheduler.run(numSecs);
+      scheduler.printSummary(stdout);
+
+      if  (shouldAnalyze)
+	printCapacity(cta,NULL,scheduler.getRunSecs());
+    }
+    catch (const char* cPtr)
+    {
+      fprintf(stderr,"%s\n",cPtr);
+      return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+  }
+
+  //  II.D.  Do simulation headless if requested:
+  cta.setFramesPerSec(framesPerSec);
+
+  if  (framesPerSec == 0)
+  {
+    try
+    {
+      cta.simulate(numSecs);
+    }
+    catch (const char* cPtr)
+    {
+      fprintf(stderr,"%s\n",cPtr);
+      return(EXIT_FAILURE);
+    }
+
+    cta.printSummary(stdout);
+
+    if  (shouldAnalyze)
+      printCapacity(cta,NULL,cta.getSimulatedSecs());
+
+    return(EXIT_SUCCESS);
+  }
+
+  //  II.E.  Turn on ncurses:
   initscr();
 
-  //  II.D.  Do simulation:
+  //  II.F.  Do simulation:
   try
   {
-    cta.simulate(60);
+    cta.simulate(numSecs);
   }
   catch (const char* cPtr)
   {
@@ -97,9 +1210,13 @@ int	main	(int		argc,
     sleep(10);
   }
 
-  //  II.E.  Turn off ncurses:
+  //  II.G.  Turn off ncurses:
   sleep(5);
   endwin();
+  cta.printSummary(stdout);
+
+  if  (shouldAnalyze)
+    printCapacity(cta,NULL,cta.getSimulatedSecs());
 
   //  III.  Finished:
   return(EXIT_SUCCESS);  